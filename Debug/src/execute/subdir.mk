@@ -5,17 +5,23 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
 ../src/execute/execute.cpp \
+../src/execute/execution_session.cpp \
 ../src/execute/order_leg.cpp \
+../src/execute/order_template.cpp \
 ../src/execute/order_ticket.cpp 
 
 OBJS += \
 ./src/execute/execute.o \
+./src/execute/execution_session.o \
 ./src/execute/order_leg.o \
+./src/execute/order_template.o \
 ./src/execute/order_ticket.o 
 
 CPP_DEPS += \
 ./src/execute/execute.d \
+./src/execute/execution_session.d \
 ./src/execute/order_leg.d \
+./src/execute/order_template.d \
 ./src/execute/order_ticket.d 
 
 
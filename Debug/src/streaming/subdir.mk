@@ -4,19 +4,31 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
+../src/streaming/acct_activity.cpp \
+../src/streaming/order_cache.cpp \
+../src/streaming/quote_book.cpp \
 ../src/streaming/streaming.cpp \
 ../src/streaming/streaming_session.cpp \
-../src/streaming/streaming_subscriptions.cpp 
+../src/streaming/streaming_subscriptions.cpp \
+../src/streaming/subscription_manager.cpp 
 
 OBJS += \
+./src/streaming/acct_activity.o \
+./src/streaming/order_cache.o \
+./src/streaming/quote_book.o \
 ./src/streaming/streaming.o \
 ./src/streaming/streaming_session.o \
-./src/streaming/streaming_subscriptions.o 
+./src/streaming/streaming_subscriptions.o \
+./src/streaming/subscription_manager.o 
 
 CPP_DEPS += \
+./src/streaming/acct_activity.d \
+./src/streaming/order_cache.d \
+./src/streaming/quote_book.d \
 ./src/streaming/streaming.d \
 ./src/streaming/streaming_session.d \
-./src/streaming/streaming_subscriptions.d 
+./src/streaming/streaming_subscriptions.d \
+./src/streaming/subscription_manager.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
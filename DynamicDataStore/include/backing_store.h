@@ -23,14 +23,56 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <fstream>
 #include <memory>
 #include <map>
+#include <vector>
 #include <functional>
+#include <cstdint>
+
+/*
+ * .bars files are a BarFileHeader followed by a raw array of BarRecords,
+ * mmap'd and read in place. FRONT files are appended oldest -> newest,
+ * BACK files newest -> oldest (same as the old .store text files).
+ */
+struct BarRecord {
+    uint64_t min_since_epoch;
+    double open;
+    double high;
+    double low;
+    double close;
+    int64_t volume;
+};
+
+struct BarFileHeader {
+    char magic[8];
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t endian_mark;
+
+    static const char MAGIC[8];
+    static const uint16_t VERSION = 1;
+    static const uint32_t ENDIAN_MARK = 0x01020304;
+
+    static BarFileHeader
+    Build();
+
+    bool
+    is_valid() const;
+};
+
+static_assert( sizeof(BarRecord) == 48, "unexpected BarRecord size" );
+static_assert( sizeof(BarFileHeader) == 16, "unexpected BarFileHeader size" );
 
 
 class BackingStore {
 public:
-    typedef std::function<std::pair<long long, long long>(std::fstream&)>
-        fileio_func_ty;
+    // [begin, end) in file order; -> {records read, elems pushed}
+    typedef std::function<std::pair<long long, long long>(const BarRecord*,
+                                                          const BarRecord*)>
+        read_func_ty;
 
+    // fill w/ records to append; -> {records written, elems pulled}
+    typedef std::function<std::pair<long long, long long>(
+        std::vector<BarRecord>&)>
+        write_func_ty;
 
     BackingStore( const std::string& directory_path );
 
@@ -46,14 +88,14 @@ public:
     // {success, front elems pushed, back elems pushed}
     std::tuple<bool, unsigned long long, unsigned long long>
     read_from_symbol_store( const std::string& symbol,
-                            fileio_func_ty read_func_front,
-                            fileio_func_ty read_func_back );
+                            read_func_ty read_func_front,
+                            read_func_ty read_func_back );
 
     // {success, front elems pulled, back elems pulled}
     std::tuple<bool, unsigned long long, unsigned long long>
     write_to_symbol_store( const std::string& symbol,
-                           fileio_func_ty write_func_front,
-                           fileio_func_ty write_func_back );
+                           write_func_ty write_func_front,
+                           write_func_ty write_func_back );
 
     bool
     remove_symbol_store( const std::string& symbol );
@@ -64,10 +106,14 @@ public:
     static bool
     directory_exists( const std::string& dir_path );
 
+    // one-time conversion of an old (text) .store file to a .bars file
+    static bool
+    convert_text_store( const std::string& text_path,
+                        const std::string& bars_path );
+
 private:
     struct SymbolStore {
         struct Side{
-            std::unique_ptr<std::fstream> file;
             std::string path;
         };
 
@@ -89,11 +135,16 @@ private:
     bool
     _add_store( const std::string& symbol );
 
+    bool
+    _open_side( SymbolStore::Side& side,
+                const std::string& symbol,
+                const std::string& name );
+
     std::tuple<bool, long long, long long>
-    _read_store( SymbolStore::Side& side, fileio_func_ty read_func );
+    _read_store( SymbolStore::Side& side, read_func_ty read_func );
 
     std::tuple<bool, long long, long long>
-    _write_store( SymbolStore::Side& side, fileio_func_ty write_func );
+    _write_store( SymbolStore::Side& side, write_func_ty write_func );
 };
 
 #endif /* INCLUDE_BACKING_STORE_H_ */
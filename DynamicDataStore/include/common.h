@@ -22,6 +22,7 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <string>
 #include <algorithm>
 #include <cctype>
+#include <limits>
 
 
 bool
@@ -0,0 +1,209 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#ifndef INCLUDE_CONTIGUOUS_DEQUE_H_
+#define INCLUDE_CONTIGUOUS_DEQUE_H_
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+/*
+ * Double-ended, growable array that keeps its elements in ONE contiguous
+ * block (free space is kept at both ends). Iterators are raw pointers.
+ *
+ * Like std::vector (unlike std::deque) growing at EITHER end can move the
+ * elements, invalidating all iterators/pointers/references.
+ */
+template<typename T>
+class ContiguousDeque{
+    static const size_t MIN_CAPACITY = 64;
+
+    std::vector<T> _buf;
+    size_t _head; // front
+    size_t _tail; // back + 1
+
+    void
+    _grow(size_t front_room, size_t back_room)
+    {
+        size_t n = size();
+        size_t cap = std::max( _buf.size() * 2,
+                               n + front_room + back_room + MIN_CAPACITY );
+        // split whatever's left over between the two ends
+        size_t head = front_room + (cap - n - front_room - back_room) / 2;
+
+        std::vector<T> buf(cap);
+        std::move( _buf.begin() + _head, _buf.begin() + _tail,
+                   buf.begin() + head );
+        _buf.swap(buf);
+        _head = head;
+        _tail = head + n;
+    }
+
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    ContiguousDeque()
+        :
+            _buf(),
+            _head(0),
+            _tail(0)
+        {}
+
+    size_type
+    size() const
+    { return _tail - _head; }
+
+    bool
+    empty() const
+    { return _tail == _head; }
+
+    // room for 'n' more at the front/back w/o moving
+    void
+    reserve_front(size_type n)
+    {
+        if( _head < n )
+            _grow(n, 0);
+    }
+
+    void
+    reserve_back(size_type n)
+    {
+        if( _buf.size() - _tail < n )
+            _grow(0, n);
+    }
+
+    void
+    clear()
+    {
+        _buf.clear();
+        _head = _tail = 0;
+    }
+
+    T*
+    data()
+    { return _buf.data() + _head; }
+
+    const T*
+    data() const
+    { return _buf.data() + _head; }
+
+    T&
+    operator[](size_type i)
+    { return _buf[_head + i]; }
+
+    const T&
+    operator[](size_type i) const
+    { return _buf[_head + i]; }
+
+    T&
+    front()
+    { return _buf[_head]; }
+
+    const T&
+    front() const
+    { return _buf[_head]; }
+
+    T&
+    back()
+    { return _buf[_tail - 1]; }
+
+    const T&
+    back() const
+    { return _buf[_tail - 1]; }
+
+    void
+    push_front(const T& v)
+    {
+        if( _head == 0 )
+            _grow(1, 0);
+        _buf[--_head] = v;
+    }
+
+    void
+    push_back(const T& v)
+    {
+        if( _tail == _buf.size() )
+            _grow(0, 1);
+        _buf[_tail++] = v;
+    }
+
+    template<typename... Args>
+    void
+    emplace_front(Args&&... args)
+    {
+        if( _head == 0 )
+            _grow(1, 0);
+        _buf[--_head] = T( std::forward<Args>(args)... );
+    }
+
+    template<typename... Args>
+    void
+    emplace_back(Args&&... args)
+    {
+        if( _tail == _buf.size() )
+            _grow(0, 1);
+        _buf[_tail++] = T( std::forward<Args>(args)... );
+    }
+
+    iterator
+    begin()
+    { return data(); }
+
+    iterator
+    end()
+    { return data() + size(); }
+
+    const_iterator
+    begin() const
+    { return data(); }
+
+    const_iterator
+    end() const
+    { return data() + size(); }
+
+    const_iterator
+    cbegin() const
+    { return begin(); }
+
+    const_iterator
+    cend() const
+    { return end(); }
+
+    reverse_iterator
+    rbegin()
+    { return reverse_iterator(end()); }
+
+    reverse_iterator
+    rend()
+    { return reverse_iterator(begin()); }
+
+    const_reverse_iterator
+    rbegin() const
+    { return const_reverse_iterator(end()); }
+
+    const_reverse_iterator
+    rend() const
+    { return const_reverse_iterator(begin()); }
+};
+
+#endif /* INCLUDE_CONTIGUOUS_DEQUE_H_ */
@@ -79,6 +79,25 @@ struct OHLCVData {
 };
 
 
+// raw, contiguous view of bars: newest (data[0]) -> oldest (data[size-1])
+struct OHLCVSpan {
+    const OHLCVData *data;
+    size_t size;
+
+    const OHLCVData*
+    begin() const
+    { return data; }
+
+    const OHLCVData*
+    end() const
+    { return data + size; }
+
+    const OHLCVData&
+    operator[](size_t i) const
+    { return data[i]; }
+};
+
+
 bool
 Initialize( const std::string& dir_path, Credentials& creds );
 
@@ -113,11 +132,17 @@ Contains( const std::string& symbol );
 void
 Update();
 
+std::set<std::string>
+GetBackfillingSymbols();
+
+bool
+WaitForBackfill( std::chrono::milliseconds timeout );
+
 
 
 class DataAccessor {
 public:
-    typedef std::deque<OHLCVData>::const_iterator const_iterator;
+    typedef const OHLCVData* const_iterator; // contiguous
 
     DataAccessor( const std::string& symbol );
 
@@ -198,6 +223,10 @@ public:
                         const_iterator > // oldest + 1
     between() const;
 
+    // SPAN (all bars)
+    OHLCVSpan
+    span() const;
+
     template< typename ContainerTy = std::vector<OHLCVData> >
     static ContainerTy
     ToSequence( const std::pair<const_iterator, const_iterator>& p )
@@ -207,6 +236,10 @@ public:
     ToObject( const std::pair<const_iterator, const_iterator>& p )
     { return (p.first == p.second) ? OHLCVData::null : *p.first; }
 
+    static OHLCVSpan
+    ToSpan( const std::pair<const_iterator, const_iterator>& p )
+    { return {p.first, static_cast<size_t>(p.second - p.first)}; }
+
     static int
     ToMinuteOfHour( std::chrono::minutes min_since_epoch );
 
@@ -20,16 +20,183 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <sys/stat.h>
 #include <iostream>
 #include <cstdio>
+#include <cstring>
 #include <sstream>
 
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
 #include "common.h"
 #include "backing_store.h"
 
 using FFLAG = std::ios_base;
 using std::string;
 
+const char BarFileHeader::MAGIC[8] = {'T','D','D','S','B','A','R','S'};
+
+BarFileHeader
+BarFileHeader::Build()
+{
+    BarFileHeader h;
+    memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.record_size = sizeof(BarRecord);
+    h.endian_mark = ENDIAN_MARK;
+    return h;
+}
+
+bool
+BarFileHeader::is_valid() const
+{
+    return memcmp(magic, MAGIC, sizeof(MAGIC)) == 0
+        && version == VERSION
+        && record_size == sizeof(BarRecord)
+        && endian_mark == ENDIAN_MARK;
+}
+
+
 namespace {
 
+// read-only view of an entire file
+class MappedFile{
+    const char *_data;
+    size_t _size;
+#ifdef _WIN32
+    HANDLE _map;
+#endif
+
+public:
+    MappedFile()
+        :
+            _data(nullptr),
+            _size(0)
+#ifdef _WIN32
+            ,_map(NULL)
+#endif
+        {}
+
+    MappedFile(const MappedFile&) = delete;
+
+    MappedFile&
+    operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    { close(); }
+
+    bool
+    open(const string& path)
+    {
+        close();
+#ifdef _WIN32
+        HANDLE f = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                                NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                                NULL );
+        if( f == INVALID_HANDLE_VALUE )
+            return false;
+        LARGE_INTEGER sz;
+        if( !GetFileSizeEx(f, &sz) ){
+            CloseHandle(f);
+            return false;
+        }
+        _size = static_cast<size_t>(sz.QuadPart);
+        if( _size ){
+            _map = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+            if( _map )
+                _data = reinterpret_cast<const char*>(
+                    MapViewOfFile(_map, FILE_MAP_READ, 0, 0, 0) );
+        }
+        CloseHandle(f);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if( fd < 0 )
+            return false;
+        struct stat info;
+        if( fstat(fd, &info) ){
+            ::close(fd);
+            return false;
+        }
+        _size = static_cast<size_t>(info.st_size);
+        if( _size ){
+            void *p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if( p != MAP_FAILED ){
+                madvise(p, _size, MADV_SEQUENTIAL);
+                _data = reinterpret_cast<const char*>(p);
+            }
+        }
+        ::close(fd);
+#endif
+        if( _size && !_data ){
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void
+    close()
+    {
+#ifdef _WIN32
+        if( _data )
+            UnmapViewOfFile(_data);
+        if( _map )
+            CloseHandle(_map);
+        _map = NULL;
+#else
+        if( _data )
+            munmap(const_cast<char*>(_data), _size);
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+    const char*
+    data() const
+    { return _data; }
+
+    size_t
+    size() const
+    { return _size; }
+};
+
+
+bool
+file_exists( const string& path )
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+
+long long
+file_size( const string& path )
+{
+    struct stat info;
+    return stat(path.c_str(), &info) ? -1LL
+                                     : static_cast<long long>(info.st_size);
+}
+
+
+bool
+truncate_file( const string& path, long long size )
+{
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+    if( fd < 0 )
+        return false;
+    bool ok = _chsize_s(fd, size) == 0;
+    _close(fd);
+    return ok;
+#else
+    return truncate(path.c_str(), static_cast<off_t>(size)) == 0;
+#endif
+}
+
 template<bool IsWrite, bool IsFront>
 void
 log_read_write( bool success,
@@ -165,7 +332,7 @@ BackingStore::delete_symbol_store( const string& symbol )
         return false;
     }
 
-    string front_path = _directory_path + symbol + ".front.store";
+    string front_path = _directory_path + symbol + ".front.bars";
     int result1 = remove(front_path.c_str());
     if( result1 ){
         string err = std::to_string(errno);
@@ -173,13 +340,22 @@ BackingStore::delete_symbol_store( const string& symbol )
 
     }
 
-    string back_path = _directory_path + symbol + ".back.store";
+    string back_path = _directory_path + symbol + ".back.bars";
     int result2 = remove(back_path.c_str());
     if( result2 ){
         string err = std::to_string(errno);
         log_error("FILE", "failed to delete " + back_path + ", errno", err);
     }
 
+    // old text files left behind by conversion
+    for( const char *side : {".front.store", ".back.store"} ){
+        string path = _directory_path + symbol + side;
+        if( file_exists(path) && remove(path.c_str()) ){
+            string err = std::to_string(errno);
+            log_error("FILE", "failed to delete " + path + ", errno", err);
+        }
+    }
+
     return (result1 == 0 and result2 == 0);
 }
 
@@ -187,8 +363,8 @@ BackingStore::delete_symbol_store( const string& symbol )
 // {success, front elems pushed, back elems pushed}
 std::tuple<bool, unsigned long long, unsigned long long>
 BackingStore::read_from_symbol_store( const string& symbol,
-                                      fileio_func_ty read_func_front,
-                                      fileio_func_ty read_func_back )
+                                      read_func_ty read_func_front,
+                                      read_func_ty read_func_back )
 {
     auto f = _stores.find(symbol);
     if( f == _stores.end() ){
@@ -203,18 +379,12 @@ BackingStore::read_from_symbol_store( const string& symbol,
     std::tie(result_front, nlines, nelems_front) = 
         _read_store( f->second.front, read_func_front );
 
-    if( f->second.front.file->eof() )
-        f->second.front.file->clear();
-
     log_read_write<false, true>(result_front, nlines, nelems_front, symbol);
 
     // BACK
     std::tie(result_back, nlines, nelems_back) = 
         _read_store( f->second.back, read_func_back );
 
-    if( f->second.back.file->eof() )
-        f->second.back.file->clear();
-
     log_read_write<false, false>(result_back, nlines, nelems_back, symbol);
 
     return std::make_tuple(
@@ -229,8 +399,8 @@ BackingStore::read_from_symbol_store( const string& symbol,
 // {success, front elems pulled, back elems pulled}
 std::tuple<bool, unsigned long long, unsigned long long>
 BackingStore::write_to_symbol_store( const string& symbol,
-                                     fileio_func_ty write_func_front,
-                                     fileio_func_ty write_func_back )
+                                     write_func_ty write_func_front,
+                                     write_func_ty write_func_back )
 {
     auto f = _stores.find(symbol);
     if( f == _stores.end() ){
@@ -287,24 +457,18 @@ BackingStore::_read_index( )
 bool
 BackingStore::_add_store( const string& symbol )
 {
-    static const auto FLAGS = FFLAG::in | FFLAG::out | FFLAG::app;
-
     if( _stores.count(symbol) )
         return true;
 
     SymbolStore ss;
 
-    ss.back.path = _directory_path + symbol + ".back.store";
-    ss.back.file.reset( new std::fstream(ss.back.path, FLAGS) );
-    if( !(*ss.back.file) ){
+    if( !_open_side(ss.back, symbol, "back") ){
         log_error("BACKING-STORE",
                   "failed to open (back) symbol file", ss.back.path);
         return false;
     }
 
-    ss.front.path= _directory_path + symbol + ".front.store";
-    ss.front.file.reset( new std::fstream(ss.front.path, FLAGS) );
-    if( !(*ss.front.file) ){
+    if( !_open_side(ss.front, symbol, "front") ){
         log_error("BACKING-STORE",
                   "failed to open (front) symbol file", ss.front.path);
         return false;
@@ -315,6 +479,80 @@ BackingStore::_add_store( const string& symbol )
 }
 
 
+bool
+BackingStore::_open_side( SymbolStore::Side& side,
+                          const string& symbol,
+                          const string& name )
+{
+    side.path = _directory_path + symbol + "." + name + ".bars";
+    if( file_exists(side.path) )
+        return true;
+
+    string text_path = _directory_path + symbol + "." + name + ".store";
+    if( file_exists(text_path) ){
+        log_info("BACKING-STORE", "converting old text store", text_path);
+        return convert_text_store(text_path, side.path);
+    }
+
+    std::ofstream f(side.path, FFLAG::out | FFLAG::binary);
+    BarFileHeader h = BarFileHeader::Build();
+    f.write( reinterpret_cast<const char*>(&h), sizeof(h) );
+    return static_cast<bool>(f);
+}
+
+
+bool
+BackingStore::convert_text_store( const string& text_path,
+                                  const string& bars_path )
+{
+    std::ifstream in(text_path);
+    if( !in ){
+        log_error("FILE", "failed to open text store", text_path);
+        return false;
+    }
+
+    std::vector<BarRecord> recs;
+    BarRecord r;
+    while( in >> r.min_since_epoch >> r.open >> r.high >> r.low >> r.close
+              >> r.volume )
+    {
+        recs.push_back(r);
+    }
+    if( in.bad() || !in.eof() ){
+        log_error("FILE", "failed to parse text store", text_path);
+        return false;
+    }
+
+    // write to a temp file first so a failure can't leave a partial .bars
+    string tmp_path = bars_path + ".tmp";
+    {
+        std::ofstream out(tmp_path, FFLAG::out | FFLAG::trunc | FFLAG::binary);
+        BarFileHeader h = BarFileHeader::Build();
+        out.write( reinterpret_cast<const char*>(&h), sizeof(h) );
+        if( !recs.empty() ){
+            out.write( reinterpret_cast<const char*>(recs.data()),
+                       recs.size() * sizeof(BarRecord) );
+        }
+        if( !out ){
+            log_error("FILE", "failed to write converted store", tmp_path);
+            out.close();
+            remove(tmp_path.c_str());
+            return false;
+        }
+    }
+
+    if( rename(tmp_path.c_str(), bars_path.c_str()) ){
+        string err = std::to_string(errno);
+        log_error("FILE", "failed to rename " + tmp_path + ", errno", err);
+        return false;
+    }
+
+    log_info( "BACKING-STORE", "converted " + std::to_string(recs.size())
+              + " records to", bars_path );
+    return true;
+}
+
+
 bool
 BackingStore::_write_index( const string& symbol )
 {
@@ -327,47 +565,66 @@ BackingStore::_write_index( const string& symbol )
 }
 
 
-// {success, lines read, elems pushed}
+// {success, records read, elems pushed}
 std::tuple<bool, long long, long long> 
-BackingStore::_read_store( SymbolStore::Side& side, fileio_func_ty read_func )
+BackingStore::_read_store( SymbolStore::Side& side, read_func_ty read_func )
 {
-    side.file->seekp(0, FFLAG::end);
-    if( side.file->fail() ){
-        log_error("FILE", "seekp to end of file failed", side.path);
+    MappedFile m;
+    if( !m.open(side.path) ){
+        log_error("FILE", "failed to map .bars file", side.path);
         return std::make_tuple(false, -1, -1);
     }
 
-    if( side.file->tellp() == std::fstream::pos_type(0) )
-        return std::make_tuple(true, 0, 0);
-
-    side.file->seekg(0, FFLAG::beg);
-    if( side.file->fail() ){
-        log_error("FILE", "seek to beginning of file failed", side.path);
+    if( m.size() < sizeof(BarFileHeader)
+        || !reinterpret_cast<const BarFileHeader*>(m.data())->is_valid() )
+    {
+        log_error("FILE", "invalid .bars file header", side.path);
         return std::make_tuple(false, -1, -1);
     }
 
-    auto p = read_func( *(side.file) );
-    bool success = false;
+    size_t nbytes = m.size() - sizeof(BarFileHeader);
+    if( nbytes % sizeof(BarRecord) )
+        log_error("FILE", "ignoring partial record at end of", side.path);
 
-    if( side.file->bad() )
-        log_error("FILE", "I/O error reading from .store file", side.path);      
-    else if( !side.file->eof() )
-        log_error("FILE", ".store file didn't reach EOF", side.path);
-    else
-        success = true;
+    const BarRecord *b = reinterpret_cast<const BarRecord*>(
+        m.data() + sizeof(BarFileHeader) );
+    auto p = read_func( b, b + nbytes / sizeof(BarRecord) );
 
-    return std::make_tuple(success, p.first, p.second);
+    return std::make_tuple(true, p.first, p.second);
 }
 
 
-// {success, lines written, elems pulled}
+// {success, records written, elems pulled}
 std::tuple<bool, long long, long long> 
-BackingStore::_write_store( SymbolStore::Side& side, fileio_func_ty write_func )
+BackingStore::_write_store( SymbolStore::Side& side, write_func_ty write_func )
 {
-    auto p = write_func( *(side.file) );
-    if( !(*side.file) ){
+    std::vector<BarRecord> recs;
+    auto p = write_func( recs );
+    if( recs.empty() )
+        return std::make_tuple(true, p.first, p.second);
+
+    long long sz = file_size(side.path);
+    if( sz < static_cast<long long>(sizeof(BarFileHeader)) ){
+        log_error("FILE", "invalid .bars file", side.path);
+        return std::make_tuple(false, 0, 0);
+    }
+
+    // drop a partial record (from a previous failure) so we stay aligned
+    long long end = sz - (sz - sizeof(BarFileHeader)) % sizeof(BarRecord);
+
+    bool success = (end == sz) || truncate_file(side.path, end);
+    if( success ){
+        std::ofstream f(side.path, FFLAG::out | FFLAG::app | FFLAG::binary);
+        f.write( reinterpret_cast<const char*>(recs.data()),
+                 recs.size() * sizeof(BarRecord) );
+        f.close();
+        success = static_cast<bool>(f);
+    }
+
+    if( !success ){
         log_error("FILE", "symbol store write failed", side.path);
-        return std::make_tuple(false, p.first, p.second);
+        truncate_file(side.path, end); // all or nothing
+        return std::make_tuple(false, 0, 0);
     }
 
     log_info("FILE", "symbol store write succeeded", side.path);
@@ -24,11 +24,17 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <iomanip>
 #include <ctime>
 #include <queue>
+#include <deque>
+#include <set>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
 
 #include "common.h"
 #include "tdma_data_store.h"
 #include "backing_store.h"
+#include "contiguous_deque.h"
 
 #include "tdma_api_streaming.h"
 #include "tdma_api_get.h"
@@ -59,8 +65,6 @@ const int NUPDATE_ATTEMPTS = 4;
 const double UPDATE_EXPAND_FACTOR = 2.0;
 const unsigned long long UPDATE_MIN_BARS = 24 * 60; // 1 day
 
-const int NNOINITS_TO_WARN = 10;
-
 const int CREDS_EXP_THRESHOLD_SEC = 2 * 24 * 60 * 60; // 2 days
 
 const std::set<tdma::ChartEquitySubscription::FieldType>
@@ -87,13 +91,14 @@ std::string log_file_path;
 
 std::shared_ptr<BackingStore> backing_store;
 std::shared_ptr<tdma::StreamingSession> session;
-std::shared_ptr<tdma::ChartEquitySubscription> sub_equity_chart;
-std::shared_ptr<tdma::TimesaleEquitySubscription> sub_equity_timesale;
 
 Credentials *credentials; // TODO
 
 volatile bool is_initialized = false;
 
+// end (minute) of the last reconnect gap not yet backfilled (via QueuesGuard)
+unsigned long long reconnect_gap_end_min = 0;
+
 enum class UpdateState : int {
     failed = 0,
     succeeded,
@@ -108,6 +113,7 @@ class DataStoreError
 
 struct SymbolData {
     typedef std::map<std::string, SymbolData> all_ty;
+    typedef ContiguousDeque<OHLCVData> data_ty;
     static all_ty all;
 
 private:
@@ -117,39 +123,45 @@ private:
     };
 
     struct WriteHelper : public IOHelper{
-        std::deque<OHLCVData>::const_iterator b, e;
+        data_ty::const_iterator b, e;
         WriteHelper( SymbolData * sdata )
             : IOHelper(sdata), b(sdata->data->cbegin()), e(sdata->data->cend())
         {}
     };
 
+    static BarRecord
+    to_record( const OHLCVData& d )
+    {
+        return BarRecord{ d.min_since_epoch, d.open, d.high, d.low, d.close,
+                          d.volume };
+    }
+
     struct FrontWriter : public WriteHelper {
         using WriteHelper::WriteHelper;
-        std::pair<long long, long long> operator()(std::fstream& f){
+        std::pair<long long, long long> operator()(std::vector<BarRecord>& r){
             auto start = b + sdata->write_pos_begin; //exclusive
             auto pos = start;
-            long long nlines = 0;
-            while( pos > b && f ){
+            r.reserve( start - b );
+            while( pos > b ){
                 --pos;
                 if( pos->close == 0 ){
                     assert( pos->is_empty_bar() );
                     if( (pos != (start-1)) && (pos != b) )
                         continue; // skip empty bars, not first or last
                 }
-                f << *pos << std::endl;
-                ++nlines;
+                r.push_back( to_record(*pos) );
             }
-            return {nlines, (start - pos)};
+            return {static_cast<long long>(r.size()), (start - pos)};
         }
     };
 
     struct BackWriter : public WriteHelper {
         using WriteHelper::WriteHelper;
-        std::pair<long long, long long> operator()(std::fstream& f){
+        std::pair<long long, long long> operator()(std::vector<BarRecord>& r){
             auto start = b + sdata->write_pos_end; //inclusive
             auto pos = start;
-            long long nlines = 0;
-            while( pos < e && f ){
+            r.reserve( e - start );
+            while( pos < e ){
                 if( pos->close == 0 ){
                     assert( pos->is_empty_bar() );
                     if( (pos != start) && (pos != (e-1)) ){
@@ -157,21 +169,24 @@ private:
                         continue; // skip empty bars, not first or last
                     }
                 }
-                f << *pos << std::endl;
+                r.push_back( to_record(*pos) );
                 ++pos;
-                ++nlines;
             }
-            return {nlines, (pos - start)};
+            return {static_cast<long long>(r.size()), (pos - start)};
         }
     };
 
     struct FrontReader : public IOHelper{
         using IOHelper::IOHelper;
-        std::pair<long long, long long> operator()(std::fstream& f){
-            double open, high, low, close;
-            long long volume, ngaps, dt, dt_last = -1, nlines = 0, nelems = 0;
-            while( f >> dt >> open >> high >> low >> close >> volume )
+        std::pair<long long, long long>
+        operator()(const BarRecord *b, const BarRecord *e){
+            long long ngaps, dt, dt_last = -1, nelems = 0;
+            if( b < e && e[-1].min_since_epoch > b->min_since_epoch ) // gaps too
+                sdata->data->reserve_front(
+                    e[-1].min_since_epoch - b->min_since_epoch + 1 );
+            for( const BarRecord *r = b; r < e; ++r )
             {
+                dt = static_cast<long long>(r->min_since_epoch);
                 if( dt_last > -1 ){
                     ngaps = dt - dt_last;
                     assert( ngaps >= 0 ); // allow duplicates
@@ -181,24 +196,28 @@ private:
                     }
                 }
                 if( dt_last == -1 || dt > dt_last ){ // drop duplicates
-                    sdata->data->emplace_front(dt,open,high,low,close,volume);
+                    sdata->data->emplace_front( dt, r->open, r->high, r->low,
+                                                r->close, r->volume );
                     ++nelems;
                 }
                 dt_last = dt;
-                ++nlines;
             };
-            return {nlines, nelems};
+            return {(e - b), nelems};
         }
     };
 
     // TODO error check for bad dt
     struct BackReader : public IOHelper{
         using IOHelper::IOHelper;
-        std::pair<long long, long long> operator()(std::fstream& f){
-            double open, high, low, close;
-            long long volume, ngaps, dt, dt_last = -1, nlines = 0, nelems = 0;
-            while( f >> dt >> open >> high >> low >> close >> volume )
+        std::pair<long long, long long>
+        operator()(const BarRecord *b, const BarRecord *e){
+            long long ngaps, dt, dt_last = -1, nelems = 0;
+            if( b < e && b->min_since_epoch > e[-1].min_since_epoch ) // gaps too
+                sdata->data->reserve_back(
+                    b->min_since_epoch - e[-1].min_since_epoch + 1 );
+            for( const BarRecord *r = b; r < e; ++r )
             {
+                dt = static_cast<long long>(r->min_since_epoch);
                 if( dt_last > -1 ){
                      ngaps = dt_last - dt;
                      assert( ngaps >= 0 ); // allow duplicates
@@ -208,13 +227,13 @@ private:
                      }
                  }
                 if( dt_last == -1 || dt < dt_last ){ // drop duplicates
-                    sdata->data->emplace_back(dt,open,high,low,close,volume);
+                    sdata->data->emplace_back( dt, r->open, r->high, r->low,
+                                               r->close, r->volume );
                     ++nelems;
                 }
                 dt_last = dt;
-                ++nlines;
             };
-            return {nlines, nelems};
+            return {(e - b), nelems};
         }
     };
 
@@ -234,11 +253,11 @@ private:
 
 public:
     std::string symbol;
-    std::unique_ptr<std::deque<OHLCVData>> data; // restricts copy / assign for us
+    std::unique_ptr<data_ty> data; // restricts copy / assign for us
     unsigned long long min_start;
     unsigned long long min_end;
-    std::deque<OHLCVData>::size_type write_pos_begin; // < here goes to file_back
-    std::deque<OHLCVData>::size_type write_pos_end; // >= here goes to file_front
+    data_ty::size_type write_pos_begin; // < here goes to file_back
+    data_ty::size_type write_pos_end; // >= here goes to file_front
     bool allow_reload;
 
     SymbolData() = delete;
@@ -300,7 +319,7 @@ public:
 
         write_pos_begin = write_pos_end = 0;
         min_start = min_end = 0;
-        data.reset( new std::deque<OHLCVData>  );
+        data.reset( new data_ty );
 
         unsigned long long nfront, nback;
         bool success;
@@ -322,7 +341,7 @@ public:
             min_start = data->back().min_since_epoch;
             min_end = data->front().min_since_epoch;          
             if( (data->size() - 1) != (min_end - min_start) )
-                throw DataStoreError("size of deque doesn't match time range");
+                throw DataStoreError("size of data doesn't match time range");
         }
         return true;
     }
@@ -377,14 +396,14 @@ public:
             - static_cast<long long>(min_start);
     }
 
-    typename std::deque<OHLCVData>::iterator
+    data_ty::iterator
     find_safe( unsigned long long min_since_epoch ) const
     {
         // binary search O(log) - safer, but slower
         return find_desc(*data, OHLCVData(min_since_epoch), OHLCVData::IsOlder);
     }
 
-    typename std::deque<OHLCVData>::iterator
+    data_ty::iterator
     find_fast( unsigned long long min_since_epoch ) const
     {
         // index/lookup search O(C) - faster
@@ -397,6 +416,17 @@ public:
 
         return data->begin() + front;
     }
+
+    /*
+     * Update() only grows the front but that can still move everything;
+     * re-derive a range (from before the Update) relative to the back
+     */
+    std::pair<data_ty::const_iterator, data_ty::const_iterator>
+    rebase( data_ty::size_type from_back, data_ty::size_type count ) const
+    {
+        auto e = data->cend() - from_back;
+        return {e - count, e};
+    }
 };
 
 std::map<std::string, SymbolData> SymbolData::all;
@@ -723,6 +753,15 @@ session_callback( int callback_type,
     case StreamingCallbackType::notify:
         log_error("STREAMING", "notify", (data ? string(data) : "" ) );
         return;
+    case StreamingCallbackType::reconnected:
+        log_info("STREAMING", "reconnected", (data ? string(data) : "" ) );
+        if( data ){
+            unsigned long long gap_end = json::parse(string(data))["gap_end"];
+            StreamingData::QueuesGuard lock;
+            reconnect_gap_end_min = std::max( reconnect_gap_end_min,
+                                              gap_end / MSEC_IN_MIN );
+        }
+        return;
     case StreamingCallbackType::data:
         break;
     }
@@ -790,62 +829,67 @@ session_callback( int callback_type,
 }
 
 
-json
-get_historical_range( const std::string& symbol,
-                   unsigned long long start_min,
-                   unsigned long long end_min )
+// decoded straight into columns, no json; null on failure
+typedef std::unique_ptr<tdma::HistoricalCandles> candles_ptr;
+
+
+std::unique_ptr<tdma::HistoricalRangeGetter>
+create_historical_range_getter( const std::string& symbol )
+{
+    return std::unique_ptr<tdma::HistoricalRangeGetter>(
+        new tdma::HistoricalRangeGetter( *credentials, symbol,
+            tdma::FrequencyType::minute, 1, 0, 0, true )
+        );
+}
+
+
+candles_ptr
+fetch_historical_range( tdma::HistoricalRangeGetter& getter,
+                        const std::string& symbol,
+                        unsigned long long start_min,
+                        unsigned long long end_min )
 {
-    static std::unique_ptr<tdma::HistoricalRangeGetter> pgetter;
     std::stringstream ss;
 
     assert( end_min >= start_min );
 
-    json j;
     try{
-        if( !pgetter ){
-            pgetter.reset(
-                new tdma::HistoricalRangeGetter( *credentials, symbol,
-                    tdma::FrequencyType::minute, 1, 0, 0, true )
-            );
-        }
-        pgetter->set_symbol(symbol);
-        pgetter->set_start_msec_since_epoch(start_min * MSEC_IN_MIN);
-        pgetter->set_end_msec_since_epoch((end_min+1) * MSEC_IN_MIN);
+        getter.set_symbol(symbol);
+        getter.set_start_msec_since_epoch(start_min * MSEC_IN_MIN);
+        getter.set_end_msec_since_epoch((end_min+1) * MSEC_IN_MIN);
 
         ss << "HTTP/GET between " << start_min << " and " << end_min;
         log_info("GET-HIST-RANGE", ss.str(), symbol );
 
-        j = pgetter->get();
+        return candles_ptr( new tdma::HistoricalCandles(getter.get_candles()) );
 
     }catch( tdma::APIException& e ){
         log_error("GET-HIST-RANGE", "historical getter failed", e.what());
-        return {};
+        return nullptr;
     }
+}
 
-    auto jcandles_iter = j.find("candles");
-    if( jcandles_iter == j.end() ){
-        log_error("GET-HIST-RANGE", "bad json, no 'candles'", symbol);
-        return {};
-    }
 
-    auto jsymbol_iter = j.find("symbol");
-    if( jsymbol_iter == j.end() ){
-        log_error("GET-HIST-RANGE", "bad json, no 'symbol'", symbol);
-        return {};
-    }
+bool
+check_historical_range( const tdma::HistoricalCandles& candles,
+                        const std::string& symbol,
+                        unsigned long long start_min,
+                        unsigned long long end_min )
+{
+    std::stringstream ss;
 
-    if( symbol != *jsymbol_iter ){
-        log_error("GET-HIST-RANGE", "bad json, wrong symbol", symbol);
-        return {};
+    if( symbol != candles.symbol() ){
+        log_error("GET-HIST-RANGE", "bad response, wrong symbol", symbol);
+        return false;
     }
 
-    size_t n = jcandles_iter->size();
+    size_t n = candles.size();
     if( n == 0 ){
         log_info("GET-HIST-RANGE", "no candles returned", symbol);
-        return {};
+        return false;
     }
 
-    unsigned long long dt = jcandles_iter->at(0)["datetime"];
+    unsigned long long dt = candles.datetime()[0];
     dt /= MSEC_IN_MIN;
     if( dt > start_min ){
         ss.str("");
@@ -853,7 +897,7 @@ get_historical_range( const std::string& symbol,
         log_info("GET-HIST-RANGE", ss.str(), symbol);
     }
 
-    dt = jcandles_iter->at(n-1)["datetime"];
+    dt = candles.datetime()[n-1];
     dt /= MSEC_IN_MIN;
     if( dt < end_min ){
         ss.str("");
@@ -861,7 +905,33 @@ get_historical_range( const std::string& symbol,
         log_info("GET-HIST-RANGE", ss.str(), symbol);
     }
 
-    return *jcandles_iter;
+    return true;
+}
+
+
+candles_ptr
+get_historical_range( const std::string& symbol,
+                   unsigned long long start_min,
+                   unsigned long long end_min )
+{
+    static std::unique_ptr<tdma::HistoricalRangeGetter> pgetter;
+
+    try{
+        if( !pgetter )
+            pgetter = create_historical_range_getter(symbol);
+    }catch( tdma::APIException& e ){
+        log_error("GET-HIST-RANGE", "historical getter failed", e.what());
+        return nullptr;
+    }
+
+    candles_ptr candles = fetch_historical_range(*pgetter, symbol, start_min,
+                                                 end_min);
+    if( candles
+        && !check_historical_range(*candles, symbol, start_min, end_min) )
+    {
+        candles.reset();
+    }
+    return candles;
 }
 
 
@@ -890,40 +960,61 @@ update_with_empty_bars( unsigned long long start_min,
 }
 
 
-bool
-update_front_from_historical( unsigned long long start_min,
-                              unsigned long long end_min,
-                              SymbolData& sdata )
+// every bar in [start_min, end_min], oldest first; missing bars are empty
+std::vector<OHLCVData>
+bars_from_historical( const tdma::HistoricalCandles *candles,
+                      unsigned long long start_min,
+                      unsigned long long end_min )
 {
-    json j = get_historical_range( sdata.symbol, start_min, end_min );
-    if( j.empty() ){
-        update_with_empty_bars<true>(start_min, end_min, sdata);
-        return false;
-    }
+    std::vector<OHLCVData> bars;
+    bars.reserve( end_min - start_min + 1 );
 
-    long long last = start_min-1;
+    unsigned long long next = start_min;
 
     // oldest first
-    for( auto elemj : j ){
-        unsigned long long dt = elemj["datetime"];
+    size_t n = candles ? candles->size() : 0;
+    for( size_t i = 0; i < n; ++i ){
+        unsigned long long dt = candles->datetime()[i];
         dt /= MSEC_IN_MIN;
         if( dt < start_min )
             continue;
         else if( dt > end_min )
             break;
         else{
-            assert( dt - last > 0 );
-            update_with_empty_bars<true>( last + 1, dt - 1, sdata );
-
-            sdata.emplace_front( dt, elemj["open"], elemj["high"], elemj["low"],
-                                 elemj["close"], elemj["volume"] );
-            last = dt;
+            assert( dt >= next );
+            while( next < dt )
+                bars.emplace_back( next++ );
+
+            bars.emplace_back( dt, candles->open()[i], candles->high()[i],
+                               candles->low()[i], candles->close()[i],
+                               candles->volume()[i] );
+            next = dt + 1;
         }
     }
 
     // account for everything up to end (or all if we have no valid)
-    assert( end_min - last >= 0 );
-    update_with_empty_bars<true>( last + 1, end_min, sdata );
+    while( next <= end_min )
+        bars.emplace_back( next++ );
+
+    return bars;
+}
+
+
+bool
+update_front_from_historical( unsigned long long start_min,
+                              unsigned long long end_min,
+                              SymbolData& sdata )
+{
+    candles_ptr candles = get_historical_range( sdata.symbol, start_min,
+                                                end_min );
+    if( !candles ){
+        update_with_empty_bars<true>(start_min, end_min, sdata);
+        return false;
+    }
+
+    sdata.data->reserve_front( end_min - start_min + 1 );
+    for( auto& d : bars_from_historical(candles.get(), start_min, end_min) )
+        sdata.push_front(d);
     return true;
 }
 
@@ -935,37 +1026,270 @@ update_back_from_historical( unsigned long long start_min,
                              unsigned long long end_min,
                              SymbolData& sdata )
 {
-    json j = get_historical_range( sdata.symbol, start_min, end_min );
-    if( j.empty() ){
+    candles_ptr candles = get_historical_range( sdata.symbol, start_min,
+                                                end_min );
+    if( !candles ){
         update_with_empty_bars<false>(start_min, end_min, sdata);
         return false;
     }
 
-    long long last = end_min + 1;
+    auto bars = bars_from_historical(candles.get(), start_min, end_min);
 
     // newest first
-    for( auto iter = j.rbegin() ; iter != j.rend(); ++iter ){
-        auto& elemj = *iter;
-        unsigned long long dt = elemj["datetime"];
-        dt /= MSEC_IN_MIN;
-        if( dt > end_min )
-            continue;
-        else if(dt < start_min )
-            break;
-        else{
-            assert( last - dt > 0 );
-            update_with_empty_bars<false>(dt + 1, last - 1, sdata);
+    sdata.data->reserve_back( bars.size() );
+    for( auto iter = bars.rbegin(); iter != bars.rend(); ++iter )
+        sdata.push_back(*iter);
+    return true;
+}
+
+
+/*
+ * Gaps in the front of a symbol's data (e.g since the last session) are
+ * filled from historical data off of the caller's thread so Update() doesn't
+ * block on HTTP/throttling for every new symbol:
+ *
+ *   fetch thread - issues the (throttled) requests, in order; the
+ *                  response is decoded into candle columns as it's read
+ *   parse thread - checks/converts the previous candles to bars meanwhile
+ *
+ * Update() merges finished ranges (and any streaming data held back while
+ * waiting) into SymbolData; other symbols can be used in the meantime.
+ */
+class BackfillScheduler {
+public:
+    struct Range {
+        std::string symbol;
+        unsigned long long start_min;
+        unsigned long long end_min;
+        unsigned long long generation; // set by schedule()
+    };
+
+    struct Result {
+        Range range;
+        std::vector<OHLCVData> bars; // oldest first, all of 'range'
+        bool success;
+    };
+
+private:
+    std::deque<Range> _requests;
+    std::deque<std::pair<Range, candles_ptr>> _responses;
+    std::vector<Result> _results;
+    // symbol -> generation of its outstanding request; a symbol that was
+    // cancelled (e.g removed) and rescheduled ignores the older result
+    std::map<std::string, unsigned long long> _pending;
+    unsigned long long _generation;
+    std::mutex _mtx;
+    std::condition_variable _request_cond;
+    std::condition_variable _response_cond;
+    std::condition_variable _result_cond;
+    std::thread _fetch_thread;
+    std::thread _parse_thread;
+    bool _stop;
+
+    void
+    _fetch()
+    {
+        std::unique_ptr<tdma::HistoricalRangeGetter> getter;
+        while( true ){
+            Range r;
+            {
+                std::unique_lock<std::mutex> lock(_mtx);
+                _request_cond.wait( lock,
+                    [this]{ return _stop || !_requests.empty(); } );
+                if( _stop )
+                    return;
+                r = std::move(_requests.front());
+                _requests.pop_front();
+            }
+
+            candles_ptr candles;
+            try{
+                if( !getter )
+                    getter = create_historical_range_getter(r.symbol);
+                candles = fetch_historical_range(*getter, r.symbol, r.start_min,
+                                                 r.end_min);
+            }catch( tdma::APIException& e ){
+                log_error("BACKFILL", "historical getter failed", e.what());
+            }
 
-            sdata.emplace_back( dt, elemj["open"], elemj["high"], elemj["low"],
-                                elemj["close"], elemj["volume"] );
-            last = dt;
+            {
+                std::lock_guard<std::mutex> _(_mtx);
+                _responses.emplace_back( std::move(r), std::move(candles) );
+            }
+            _response_cond.notify_one();
         }
     }
 
-    // account for everything up to start (or all if we have no valid)
-    assert( last - start_min >= 0 );
-    update_with_empty_bars<false>( start_min, last - 1, sdata );
-    return true;
+    void
+    _parse()
+    {
+        while( true ){
+            std::pair<Range, candles_ptr> p;
+            {
+                std::unique_lock<std::mutex> lock(_mtx);
+                _response_cond.wait( lock,
+                    [this]{ return _stop || !_responses.empty(); } );
+                if( _stop )
+                    return;
+                p = std::move(_responses.front());
+                _responses.pop_front();
+            }
+
+            Range& r = p.first;
+            bool ok = p.second && check_historical_range( *p.second, r.symbol,
+                                                          r.start_min,
+                                                          r.end_min );
+            Result res{ r, bars_from_historical( (ok ? p.second.get() : nullptr),
+                                                 r.start_min, r.end_min ),
+                        ok };
+            {
+                std::lock_guard<std::mutex> _(_mtx);
+                _results.emplace_back( std::move(res) );
+            }
+            _result_cond.notify_all();
+        }
+    }
+
+public:
+    BackfillScheduler()
+        :
+            _generation(0),
+            _stop(false)
+        {
+            _fetch_thread = std::thread( &BackfillScheduler::_fetch, this );
+            _parse_thread = std::thread( &BackfillScheduler::_parse, this );
+        }
+
+    ~BackfillScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> _(_mtx);
+            _stop = true;
+        }
+        _request_cond.notify_all();
+        _response_cond.notify_all();
+        _result_cond.notify_all();
+        _fetch_thread.join();
+        _parse_thread.join();
+    }
+
+    void
+    schedule( Range r )
+    {
+        {
+            std::lock_guard<std::mutex> _(_mtx);
+            r.generation = ++_generation;
+            _pending[r.symbol] = r.generation;
+            _requests.push_back( std::move(r) );
+        }
+        _request_cond.notify_one();
+    }
+
+    // drop a queued request (or ignore its result when it's done)
+    void
+    cancel( const std::string& symbol )
+    {
+        std::lock_guard<std::mutex> _(_mtx);
+        _pending.erase(symbol);
+        _requests.erase(
+            std::remove_if( _requests.begin(), _requests.end(),
+                            [&](const Range& r){ return r.symbol == symbol; } ),
+            _requests.end() );
+    }
+
+    bool
+    is_pending( const std::string& symbol )
+    {
+        std::lock_guard<std::mutex> _(_mtx);
+        return _pending.count(symbol) > 0;
+    }
+
+    std::set<std::string>
+    pending()
+    {
+        std::lock_guard<std::mutex> _(_mtx);
+        std::set<std::string> tmp;
+        for( auto& p : _pending )
+            tmp.insert( p.first );
+        return tmp;
+    }
+
+    // finished (and not cancelled) ranges; no longer pending after this
+    std::vector<Result>
+    take_results()
+    {
+        std::lock_guard<std::mutex> _(_mtx);
+        std::vector<Result> tmp;
+        for( auto& r : _results ){
+            auto iter = _pending.find(r.range.symbol);
+            if( iter != _pending.end()
+                && iter->second == r.range.generation )
+            {
+                _pending.erase(iter);
+                tmp.emplace_back( std::move(r) );
+            }
+        }
+        _results.clear();
+        return tmp;
+    }
+
+    // false if still pending after 'timeout'
+    bool
+    wait_for_results( std::chrono::milliseconds timeout )
+    {
+        std::unique_lock<std::mutex> lock(_mtx);
+        return _result_cond.wait_for( lock, timeout,
+            [this]{ return _pending.empty() || !_results.empty(); } );
+    }
+};
+
+std::unique_ptr<BackfillScheduler> backfill;
+
+// streaming data held back while waiting for a symbol's backfill
+std::map<std::string, std::queue<StreamingData>> backfill_held;
+
+
+bool
+update_front_from_streaming( SymbolData& sdata,
+                             std::queue<StreamingData>&& qdata );
+
+/* CALLER'S THREAD (from Update) */
+void
+merge_backfills()
+{
+    if( !backfill )
+        return;
+
+    for( auto& res : backfill->take_results() ){
+        const std::string& s = res.range.symbol;
+        std::queue<StreamingData> held;
+        std::swap( held, backfill_held[s] );
+        backfill_held.erase(s);
+
+        auto iter_sd = SymbolData::all.find(s);
+        if( iter_sd == SymbolData::all.cend() ){
+            log_info("BACKFILL", "symbol data no longer available", s);
+            continue;
+        }
+        SymbolData& sdata = iter_sd->second;
+
+        // nothing else touches the front of sdata while it's pending
+        assert( sdata.min_end + 1 == res.range.start_min );
+
+        std::stringstream ss;
+        ss << (res.success ? "merge historical" : "historical failed, empties")
+           << " between " << res.range.start_min << " and "
+           << res.range.end_min;
+        log_info("BACKFILL", ss.str(), s);
+
+        sdata.data->reserve_front( res.bars.size() );
+        for( auto& d : res.bars )
+            sdata.push_front(d);
+
+        StreamingData::SetInitialized(s);
+        if( !update_front_from_streaming(sdata, std::move(held)) )
+            log_error("BACKFILL", "front-from-streaming failed", s);
+    }
 }
 
 
@@ -1134,38 +1458,42 @@ control_session( const std::set<std::string> symbols, bool add_not_remove )
     }
 
     assert(session);
-    std::deque<bool> ret;
     std::string cmd_str;
 
     try{
-        sub_equity_chart.reset(
-            new ChartEquitySubscription(symbols, EQUITY_CHART_SUB_FIELDS)
-        );
-
-        sub_equity_timesale.reset(
-            new TimesaleEquitySubscription(symbols, EQUITY_TIMESALE_SUB_FIELDS)
-        );
+        ChartEquitySubscription chart(symbols, EQUITY_CHART_SUB_FIELDS);
+        TimesaleEquitySubscription timesale(symbols, EQUITY_TIMESALE_SUB_FIELDS);
 
         if( session->is_active() ){
+            /* session only sends the symbols that changed (ADD/UNSUBS) */
             if( add_not_remove ){
-                sub_equity_chart->set_command( tdma::CommandType::ADD );
-                sub_equity_timesale->set_command( tdma::CommandType::ADD );
-                cmd_str = "ADD";
-                ret = session->add_subscriptions(
-                    {*sub_equity_chart, *sub_equity_timesale}
-                );
+                cmd_str = "SUBSCRIBE";
+                session->subscribe(chart);
+                session->subscribe(timesale);
             }else{
-                sub_equity_chart->set_command( tdma::CommandType::UNSUBS );
-                sub_equity_timesale->set_command( tdma::CommandType::UNSUBS );
-                cmd_str = "UNSUBS";
-                ret = session->add_subscriptions(
-                    {*sub_equity_chart, *sub_equity_timesale}
-                );
+                cmd_str = "UNSUBSCRIBE";
+                session->unsubscribe(chart);
+                session->unsubscribe(timesale);
+            }
+            if( !session->flush_subscriptions() ){
+                log_error("SESSION", "'" + cmd_str + "' failed",
+                          "CHART_EQUITY/TIMESALE_EQUITY");
+                return false;
             }
         }else{
             if( add_not_remove ){
                 cmd_str = "SUBS";
-                ret = session->start( {*sub_equity_chart, *sub_equity_timesale});
+                std::deque<bool> ret = session->start( {chart, timesale} );
+                assert( ret.size() == 2 );
+                if( !ret[0] ){
+                    log_error("SESSION", "'" + cmd_str + "' failed",
+                              "CHART_EQUITY");
+                    return false;
+                }else if( !ret[1] ){
+                    log_error("SESSION", "'" + cmd_str + "' failed",
+                              "TIMESALE_EQUITY");
+                    return false;
+                }
             }else{
                 log_info("SESSION", "can't remove from inactive session");
                 return false;
@@ -1176,15 +1504,6 @@ control_session( const std::set<std::string> symbols, bool add_not_remove )
         return false;
     }
 
-    assert( ret.size() == 2 );
-    if( !ret[0] ){
-        log_error("SESSION", "'" + cmd_str + "' failed", "CHART_EQUITY");
-        return false;
-    }else if( !ret[1] ){
-        log_error("SESSION", "'" + cmd_str + "' failed", "TIMESALE_EQUITY");
-        return false;
-    }
-
     log_info("SESSION", "'" + cmd_str + "' succeeded");
     return true;
 }
@@ -1192,7 +1511,7 @@ control_session( const std::set<std::string> symbols, bool add_not_remove )
 
 /*
 std::pair<DataAccessor::const_iterator, DataAccessor::const_iterator>
-range_between(const std::deque<OHLCVData>& sdata, long long start, long long end)
+range_between(const SymbolData::data_ty& sdata, long long start, long long end)
 {
     // all checks done already, but just to be sure...
     assert( start >= 0 );
@@ -1342,6 +1661,12 @@ Start( milliseconds listening_timeout )
     }
     log_info("START", "successfully created streaming session");
 
+    try{
+        session->set_auto_reconnect(true);
+    }catch(tdma::APIException& e){
+        log_error("START", "failed to enable auto-reconnect", e.what());
+    }
+
     std::set<std::string> symbols;
     for( auto& p : SymbolData::all )
         symbols.insert(p.first);
@@ -1387,10 +1712,13 @@ Add( const std::string& symbol )
     SymbolData::all.emplace( s, std::move(sdata) );
 
     if( session ){
-        auto old_symbols = sub_equity_chart->get_symbols();
-        assert( old_symbols == sub_equity_timesale->get_symbols() );
-        old_symbols.insert(s);
-        if( !control_session( old_symbols, true )){
+        /* an inactive session is (re)started w/ everything we have */
+        std::set<std::string> symbols{s};
+        if( !session->is_active() ){
+            for( auto& p : SymbolData::all )
+                symbols.insert(p.first);
+        }
+        if( !control_session( symbols, true )){
             log_error("ADD-STORE", "failed to update session");
             return false;
         }
@@ -1426,6 +1754,9 @@ Remove( const std::string& symbol, bool delete_file )
         StreamingData::QueuesGuard lock;
         StreamingData::RemoveQueue(s); // might not exist yet
     }
+    if( backfill )
+        backfill->cancel(s);
+    backfill_held.erase(s);
 
     bool ret = true;
     // TODO catch exc
@@ -1476,7 +1807,8 @@ Stop()
         log_info("STOP", "successfully stopped streaming session");
     }
 
-    Update();
+    // no new data, but let outstanding history (and held data) get merged
+    WaitForBackfill( milliseconds::max() );
 }
 
 
@@ -1488,6 +1820,9 @@ Finalize()
     if( is_initialized && !store() )
         log_error("FINALIZE", "failed to store (ALL)");
 
+    backfill.reset();
+    backfill_held.clear();
+
     SymbolData::all.clear();
 
     is_initialized = false;
@@ -1543,10 +1878,13 @@ Update()
 
     std::map<std::string, std::queue<StreamingData>> queue_copies;
     std::map<std::string, StreamingData> abar_copies;
+    unsigned long long gap_end_min;
     {
         StreamingData::QueuesGuard lock;
         queue_copies = StreamingData::GetQueueCopiesAndClear();
         abar_copies = StreamingData::GetActiveBarCopies();
+        gap_end_min = reconnect_gap_end_min;
+        reconnect_gap_end_min = 0;
     }
     /*
      * limit what we do under the lock, each 'update' call may
@@ -1561,16 +1899,27 @@ Update()
     auto nnoinit = actives.size()
         - std::count_if( actives.cbegin(), actives.cend(),
                          StreamingData::IsInitialized );
-    if( nnoinit > 0 ){
+    if( nnoinit > 0 )
         log_info("UPDATE", "initializing", std::to_string(nnoinit));
-        if( nnoinit > NNOINITS_TO_WARN ){
-            std::stringstream ss;
-            auto w = nnoinit * tdma::APIGetter::get_wait_msec().count() / 1000;
-            ss << "WARNING: " << nnoinit
-               << " symbols need to be initialized - may block for "
-               << w << "+ seconds";
-            std::cout<< ss.str() << std::endl;
-            log_info("UPDATE", ss.str());
+
+    merge_backfills();
+
+    /* session reconnected: get what we missed on the backfill threads */
+    if( gap_end_min ){
+        for( auto& p : SymbolData::all ){
+            const std::string& s = p.first;
+            SymbolData& sdata = p.second;
+            if( (backfill && backfill->is_pending(s))
+                || !StreamingData::IsInitialized(s)
+                || sdata.min_end == 0
+                || gap_end_min <= sdata.min_end + 1 )
+            {
+                continue;
+            }
+            if( !backfill )
+                backfill.reset( new BackfillScheduler );
+            backfill->schedule( { s, sdata.min_end + 1, gap_end_min - 1 } );
+            log_info("UPDATE", "backfill reconnect gap", s);
         }
     }
 
@@ -1580,6 +1929,7 @@ Update()
             log_info("UPDATE", "symbol data no longer available", s);
             continue;
         }
+        SymbolData& sdata = iter_sd->second;
 
         auto& Q = queue_copies[s]; // def constr if not already there
 
@@ -1598,7 +1948,33 @@ Update()
             }
         }
 
-        if( !update_front_from_streaming(iter_sd->second, std::move(Q)) )
+        // still waiting on history, hold on to it until it's merged
+        if( backfill && backfill->is_pending(s) ){
+            auto& H = backfill_held[s];
+            while( !Q.empty() ){
+                H.push( std::move(Q.front()) );
+                Q.pop();
+            }
+            continue;
+        }
+
+        /*
+         * first streaming bar for a symbol w/ a gap: get the history on
+         * the backfill threads instead of blocking here (see handle_gap)
+         */
+        if( !Q.empty() && !StreamingData::IsInitialized(s)
+            && sdata.min_end > 0
+            && Q.front().data.min_since_epoch > sdata.min_end + 1 )
+        {
+            if( !backfill )
+                backfill.reset( new BackfillScheduler );
+            backfill->schedule( { s, sdata.min_end + 1,
+                                  Q.front().data.min_since_epoch - 1 } );
+            backfill_held[s] = std::move(Q);
+            continue;
+        }
+
+        if( !update_front_from_streaming(sdata, std::move(Q)) )
             log_error("UPDATE", "front-from-streaming failed", s);
         // p.second no longer valid
     }
@@ -1606,6 +1982,35 @@ Update()
 }
 
 
+std::set<std::string>
+GetBackfillingSymbols()
+{
+    INIT_CHECK_AND_RETURN("GET-BACKFILLING", {});
+
+    return backfill ? backfill->pending() : std::set<std::string>();
+}
+
+
+bool
+WaitForBackfill( milliseconds timeout )
+{
+    INIT_CHECK_AND_RETURN("WAIT-BACKFILL", false);
+
+    auto start = steady_clock::now();
+    while( true ){
+        Update();
+        if( !backfill || backfill->pending().empty() )
+            return true;
+        auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start);
+        if( elapsed >= timeout )
+            return false;
+        // (in pieces so 'timeout' can be milliseconds::max())
+        backfill->wait_for_results( std::min(timeout - elapsed,
+                                             milliseconds(1000)) );
+    }
+}
+
+
 /* *** DATA ACCESSOR *** */
 
 DataAccessor::DataAccessor( const std::string& symbol )
@@ -1844,6 +2249,14 @@ DataAccessor::between() const
 }
 
 
+OHLCVSpan
+DataAccessor::span() const
+{
+    INIT_CHECK_AND_THROW("SPAN");
+    return ToSpan( _all() );
+}
+
+
 minutes
 DataAccessor::_start_minute() const
 {
@@ -1954,9 +2367,10 @@ DataAccessor::_between(minutes start_min_since_epoch,
             || ((long long)((tmp.second - 1)->min_since_epoch)
                     == (static_cast<long long>(D.min_start) + back)) );
 
+    auto count = tmp.second - tmp.first;
     Update();
 
-    return tmp;
+    return D.rebase(back, count);
 }
 
 
@@ -2015,8 +2429,9 @@ DataAccessor::_between(unsigned int start_indx, unsigned int end_indx) const
         log_info("BETWEEN-INDX", ss.str(), _symbol);
     }
 
+    auto count = tmp.second - tmp.first;
     Update();
-    return tmp;
+    return D.rebase(back, count);
 }
 
 
@@ -2040,9 +2455,9 @@ std::pair<DataAccessor::const_iterator, // newest
 DataAccessor::_all() const
 {
     auto& D = get_symbol_data_or_throw(_symbol);
-    auto p = std::make_pair(D.data->cbegin(), D.data->cend());
+    auto n = D.data->size();
     Update();
-    return p;
+    return D.rebase(0, n);
 }
 
 
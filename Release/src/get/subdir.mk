@@ -7,9 +7,11 @@ CPP_SRCS += \
 ../src/get/account.cpp \
 ../src/get/get.cpp \
 ../src/get/historical.cpp \
+../src/get/historical_candles.cpp \
 ../src/get/instrument_info.cpp \
 ../src/get/market_hours.cpp \
 ../src/get/movers.cpp \
+../src/get/option_chain.cpp \
 ../src/get/options.cpp \
 ../src/get/quotes.cpp 
 
@@ -17,9 +19,11 @@ OBJS += \
 ./src/get/account.o \
 ./src/get/get.o \
 ./src/get/historical.o \
+./src/get/historical_candles.o \
 ./src/get/instrument_info.o \
 ./src/get/market_hours.o \
 ./src/get/movers.o \
+./src/get/option_chain.o \
 ./src/get/options.o \
 ./src/get/quotes.o 
 
@@ -27,9 +31,11 @@ CPP_DEPS += \
 ./src/get/account.d \
 ./src/get/get.d \
 ./src/get/historical.d \
+./src/get/historical_candles.d \
 ./src/get/instrument_info.d \
 ./src/get/market_hours.d \
 ./src/get/movers.d \
+./src/get/option_chain.d \
 ./src/get/options.d \
 ./src/get/quotes.d 
 
@@ -7,7 +7,9 @@ CPP_SRCS += \
 ../src/auth.cpp \
 ../src/common.cpp \
 ../src/curl_connect.cpp \
+../src/curl_multi.cpp \
 ../src/error.cpp \
+../src/frame_capture.cpp \
 ../src/tdma_connect.cpp \
 ../src/util.cpp \
 ../src/websocket_connect.cpp 
@@ -16,7 +18,9 @@ OBJS += \
 ./src/auth.o \
 ./src/common.o \
 ./src/curl_connect.o \
+./src/curl_multi.o \
 ./src/error.o \
+./src/frame_capture.o \
 ./src/tdma_connect.o \
 ./src/util.o \
 ./src/websocket_connect.o 
@@ -25,7 +29,9 @@ CPP_DEPS += \
 ./src/auth.d \
 ./src/common.d \
 ./src/curl_connect.d \
+./src/curl_multi.d \
 ./src/error.d \
+./src/frame_capture.d \
 ./src/tdma_connect.d \
 ./src/util.d \
 ./src/websocket_connect.d 
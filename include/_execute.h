@@ -16,8 +16,13 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 */
 
 #include <string>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <memory>
 
 #include "tdma_api_execute.h"
+#include "curl_connect.h"
 
 namespace tdma {
 
@@ -199,6 +204,130 @@ public:
 };
 
 
+/*
+ * an order serialized once; price, stopPrice and each (top-level) leg
+ * quantity sit in fixed-width slots (padded w/ whitespace) so they can be
+ * overwritten in place w/o rebuilding the json
+ */
+class OrderTemplateImpl {
+    std::string _json;
+    size_t _price_off; // npos if the ticket had no price
+    size_t _stop_price_off;
+    std::vector<size_t> _quantity_offs; // one per leg
+
+    void
+    _write_slot(size_t off, const char* val, size_t n);
+
+public:
+    typedef OrderTemplate ProxyType;
+    static const int TYPE_ID_LOW = 1;
+    static const int TYPE_ID_HIGH = 1;
+
+    static const size_t SLOT_WIDTH = 24;
+
+    explicit OrderTemplateImpl(const OrderTicketImpl& order);
+
+    void
+    set_price(double price);
+
+    void
+    set_stop_price(double stop_price);
+
+    void
+    set_leg_quantity(size_t n, size_t quantity);
+
+    const std::string&
+    body() const
+    { return _json; }
+
+    std::string
+    as_json_string() const
+    { return _json; }
+};
+
+
+/* order ID from the 'Location' header of a successful send */
+std::string
+order_id_from_header(const std::string& header);
+
+
+/*
+ * one keep-alive handle per account for send/cancel/replace; it's connected
+ * (and the token checked) on construction and, if 'keep_warm' is non-zero,
+ * a cheap GET goes out whenever it's been idle that long. The GET uses its
+ * own handle (sharing the connection cache) so it never holds up an order.
+ */
+class ExecutionSessionImpl {
+    std::shared_ptr<Credentials> _credentials; // our own copy
+    std::string _account_id;
+    std::string _account_url;
+    conn::CurlShare _share; // must outlive the handles
+    conn::HTTPConnection _connection; // orders; _mtx
+    conn::HTTPConnection _warm_connection; // ctor, then _warm_thread only
+    mutable std::mutex _mtx; // one order at a time on _connection
+    std::chrono::milliseconds _keep_warm;
+    conn::clock_ty::time_point _last_used;
+    std::condition_variable _warm_cond;
+    bool _closing;
+    std::thread _warm_thread;
+
+    /* returns the response header; call w/ _mtx */
+    std::string
+    _execute( conn::HttpMethod meth,
+              const std::string& url,
+              const std::string& body,
+              long success_code );
+
+    /* call w/o _mtx */
+    void
+    _warm();
+
+    std::string
+    _send(const std::string& body);
+
+    void
+    _warm_loop();
+
+public:
+    typedef ExecutionSession ProxyType;
+    static const int TYPE_ID_LOW = 1;
+    static const int TYPE_ID_HIGH = 1;
+
+    ExecutionSessionImpl( Credentials& creds,
+                          const std::string& account_id,
+                          std::chrono::milliseconds keep_warm );
+
+    ~ExecutionSessionImpl();
+
+    ExecutionSessionImpl( const ExecutionSessionImpl& ) = delete;
+
+    ExecutionSessionImpl&
+    operator=( const ExecutionSessionImpl& ) = delete;
+
+    std::string
+    get_account_id() const
+    { return _account_id; }
+
+    std::chrono::milliseconds
+    get_keep_warm() const;
+
+    void
+    set_keep_warm(std::chrono::milliseconds keep_warm);
+
+    std::string
+    send_order(const OrderTicketImpl& order);
+
+    std::string
+    send_order(const OrderTemplateImpl& order);
+
+    bool
+    cancel_order(const std::string& order_id);
+
+    std::string
+    replace_order(const std::string& order_id, const OrderTicketImpl& order);
+};
+
+
 template<typename T>
 int
 order_obj_is_same( typename T::ProxyType::CType *pl,
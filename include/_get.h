@@ -17,6 +17,10 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 
 #include <string>
 #include <chrono>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <exception>
 
 #include "curl_connect.h"
 #include "tdma_api_get.h"
@@ -42,25 +46,75 @@ const int TYPE_ID_GETTER_ORDERS = 16;
 const int TYPE_ID_GETTER_USER_PRINCIPALS = 17;
 const int TYPE_ID_GETTER_INSTRUMENT_INFO = 18;
 
+/*
+ * Token bucket: up to 'burst' requests can be admitted at once, then one
+ * per 'interval'. Only admission is serialized; once a request has its token
+ * it runs concurrently with everything else. An interval of 0 is unlimited.
+ */
+class TokenBucket{
+    std::chrono::milliseconds _interval;
+    unsigned int _burst;
+    double _tokens; // < 0 when callers are waiting on tokens they reserved
+    conn::clock_ty::time_point _last;
+    mutable std::mutex _mtx;
+
+    void
+    _refill(conn::clock_ty::time_point now);
+
+public:
+    TokenBucket(std::chrono::milliseconds interval, unsigned int burst);
+
+    TokenBucket( const TokenBucket& ) = delete;
+
+    TokenBucket&
+    operator=( const TokenBucket& ) = delete;
+
+    /* reserve the next token; returns how long until it can be used */
+    conn::clock_ty::duration
+    reserve();
+
+    /* give back a reserved token that won't be used */
+    void
+    release();
+
+    /* blocks until admitted (the lock is NOT held while waiting) */
+    void
+    acquire();
+
+    std::chrono::milliseconds
+    wait_remaining();
+
+    void
+    set(std::chrono::milliseconds interval, unsigned int burst);
+
+    std::pair<std::chrono::milliseconds, unsigned int>
+    get() const;
+};
+
+
 class APIGetterImpl{
-    static std::chrono::milliseconds wait_msec; // DEF_WAIT_MSEC
-    static std::chrono::milliseconds last_get_msec; // 0
-    static std::mutex get_mtx;
+    static TokenBucket throttle; // all requests
+    static TokenBucket endpoint_throttles[]; // by EndpointClass
     static int current_connection_group;
 
-    static std::string
+    static conn::ResponseBuffer
     throttled_get(APIGetterImpl& getter);
 
-    static std::chrono::milliseconds
-    throttled_wait_remaining();
+    std::vector<conn::CurlMultiEngine::gate_ty>
+    throttle_gates() const;
 
     api_on_error_cb_ty _on_error_callback;
     std::reference_wrapper<Credentials> _credentials;
     std::unique_ptr<conn::HTTPConnectionInterface> _connection;
     int _connection_group_id;
+    EndpointClass _endpoint_class;
+    /* the same getter in different threads; connections aren't thread-safe */
+    std::unique_ptr<std::mutex> _get_mtx;
 
 protected:
-    APIGetterImpl(Credentials& creds, api_on_error_cb_ty on_error_callback);
+    APIGetterImpl( Credentials& creds,
+                   api_on_error_cb_ty on_error_callback,
+                   EndpointClass endpoint_class );
 
     APIGetterImpl( const APIGetterImpl& ) = delete;
 
@@ -84,6 +138,8 @@ public:
     static const int TYPE_ID_HIGH = TYPE_ID_GETTER_INSTRUMENT_INFO;
 
     static const std::chrono::milliseconds DEF_WAIT_MSEC;
+    static const unsigned int DEF_BURST = 1;
+    static const unsigned int MAX_BURST = 1000;
 
     static std::chrono::milliseconds
     get_wait_msec();
@@ -91,9 +147,27 @@ public:
     static void
     set_wait_msec(std::chrono::milliseconds msec);
 
+    static unsigned int
+    get_burst();
+
+    static void
+    set_burst(unsigned int burst);
+
     static std::chrono::milliseconds
     wait_remaining();
 
+    static std::pair<std::chrono::milliseconds, unsigned int>
+    get_endpoint_throttle(EndpointClass endpoint_class);
+
+    static void
+    set_endpoint_throttle( EndpointClass endpoint_class,
+                           std::chrono::milliseconds msec,
+                           unsigned int burst );
+
+    EndpointClass
+    get_endpoint_class() const
+    { return _endpoint_class; }
+
     static void
     share_connections(bool share)
     { current_connection_group = (share ? 0 : -1); }
@@ -105,6 +179,28 @@ public:
     virtual std::string
     get();
 
+    /* the raw response, w/o copying it into a string */
+    conn::ResponseBuffer
+    get_buffer();
+
+    /*
+     * like get() but returns immediately; 'callback' is called (on the
+     * async I/O thread) w/ the response OR the exception. Goes through the
+     * same throttles as get(). Returns an id that can be passed to
+     * cancel_async.
+     */
+    typedef std::function<void(conn::ResponseBuffer&&, std::exception_ptr)>
+        async_callback_ty;
+
+    unsigned long long
+    get_async(async_callback_ty callback);
+
+    static bool
+    cancel_async(unsigned long long id);
+
+    static size_t
+    pending_async();
+
     void
     close();
 
@@ -118,4 +214,16 @@ public:
     get_timeout() const;
 };
 
+
+/*
+ * decode an option chain response w/ a SAX parser - no json object is
+ * built; returns ONE malloc'd block (see OptionChain_C)
+ */
+OptionChain_C*
+decode_option_chain(const char *first, const char *last);
+
+/* same for a price history response; ONE block (see HistoricalCandles_C) */
+HistoricalCandles_C*
+decode_historical_candles(const char *first, const char *last);
+
 } /* tdma */
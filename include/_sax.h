@@ -0,0 +1,205 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#ifndef SAX_H
+#define SAX_H
+
+#include <vector>
+#include <string>
+
+#include "tdma_common.h"
+
+namespace tdma {
+
+/*
+ * Base for the SAX handlers that decode a response straight into records:
+ * keeps the stack of levels we care about, the depth into containers we
+ * skip and the error; scalars are only passed on at 'value levels'.
+ *
+ * 'Derived' provides (called w/ levels non-empty and nothing skipped
+ * unless noted):
+ *
+ *   static bool _is_value(Level l);       - scalars at 'l' get stored
+ *   template<typename T> void _store(T v);  - bool/number for the target
+ *   void _store_string(const std::string& s);
+ *   void _clear_target();                 - always (even when skipping)
+ *   void _on_key(const std::string& k);
+ *   bool _enter_object(Level parent, Level *child); - false to skip it
+ *   bool _enter_array(Level parent, size_t n, Level *child);
+ *
+ * the root object is always Level() (e.g the first enumerator)
+ */
+template<typename Derived, typename Level>
+class LevelSAX
+        : public nlohmann::json_sax<json> {
+protected:
+    std::vector<Level> _levels;
+    size_t _skip; // depth into containers we don't care about
+    std::string _error;
+
+    LevelSAX()
+        :
+            _levels(),
+            _skip(0),
+            _error()
+        {
+        }
+
+    Derived&
+    _derived()
+    { return *static_cast<Derived*>(this); }
+
+    bool
+    _unexpected(const char *what)
+    {
+        _error = std::string("unexpected ") + what + " at top level";
+        return false;
+    }
+
+    bool
+    _is_value_level() const
+    { return !_skip && !_levels.empty() && Derived::_is_value(_levels.back()); }
+
+    template<typename T>
+    bool
+    _scalar(T v, const char *what)
+    {
+        if( _levels.empty() )
+            return _unexpected(what);
+        if( _is_value_level() )
+            _derived()._store(v);
+        return true;
+    }
+
+public:
+    const std::string&
+    error() const
+    { return _error; }
+
+    bool
+    null()
+    {
+        if( _levels.empty() )
+            return _unexpected("null");
+        _derived()._clear_target();
+        return true;
+    }
+
+    bool
+    boolean(bool val)
+    { return _scalar(val, "boolean"); }
+
+    bool
+    number_integer(number_integer_t val)
+    { return _scalar(val, "number"); }
+
+    bool
+    number_unsigned(number_unsigned_t val)
+    { return _scalar(val, "number"); }
+
+    bool
+    number_float(number_float_t val, const string_t&)
+    { return _scalar(val, "number"); }
+
+    bool
+    string(string_t& val)
+    {
+        if( _levels.empty() )
+            return _unexpected("string");
+        if( _is_value_level() )
+            _derived()._store_string(val);
+        else
+            _derived()._clear_target();
+        return true;
+    }
+
+    bool
+    key(string_t& val)
+    {
+        _derived()._clear_target();
+        if( !_skip )
+            _derived()._on_key(val);
+        return true;
+    }
+
+    bool
+    start_object(std::size_t)
+    {
+        _derived()._clear_target();
+        if( _skip ){
+            ++_skip;
+            return true;
+        }
+
+        Level child;
+        if( _levels.empty() )
+            _levels.push_back( Level() );
+        else if( _derived()._enter_object(_levels.back(), &child) )
+            _levels.push_back(child);
+        else
+            ++_skip;
+        return true;
+    }
+
+    bool
+    end_object()
+    {
+        if( _skip )
+            --_skip;
+        else
+            _levels.pop_back();
+        return true;
+    }
+
+    bool
+    start_array(std::size_t n)
+    {
+        _derived()._clear_target();
+        if( _levels.empty() )
+            return _unexpected("array");
+
+        Level child;
+        if( !_skip && _derived()._enter_array(_levels.back(), n, &child) )
+            _levels.push_back(child);
+        else
+            ++_skip;
+        return true;
+    }
+
+    bool
+    end_array()
+    {
+        if( _skip )
+            --_skip;
+        else
+            _levels.pop_back();
+        return true;
+    }
+
+    bool
+    parse_error( std::size_t,
+                 const std::string&,
+                 const nlohmann::detail::exception& e )
+    {
+        _error = e.what();
+        return false;
+    }
+};
+
+} /* tdma */
+
+#endif /* SAX_H */
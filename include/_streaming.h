@@ -17,7 +17,11 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 
 #include <string>
 #include <map>
+#include <vector>
+#include <set>
+#include <mutex>
 #include <unordered_map>
+#include <cstring>
 
 #include "_tdma_api.h"
 #include "tdma_api_streaming.h"
@@ -135,6 +139,211 @@ StreamingSubscriptionImpl
 C_sub_ptr_to_impl(StreamingSubscription_C *psub);
 
 
+/*
+ * Latest merged fields, per symbol, of the LEVELONE-type services (QUOTE,
+ * OPTION, LEVELONE_FUTURES/FOREX/FUTURES_OPTIONS). Each row is a flat array
+ * indexed by the service's FieldType that deltas are merged into in place.
+ *
+ * Every record merged bumps a book-wide sequence #; rows and cells remember
+ * the sequence # of their last change so callers can ask for what changed
+ * since the last time they looked.
+ */
+class QuoteBook{
+    struct Table{
+        size_t nfields;
+        std::unordered_map<std::string, size_t> rows;
+        std::vector<std::string> keys;
+        std::vector<unsigned long long> row_seq;
+        std::vector<StreamingField_C> cells; // [row * nfields + field]
+        std::vector<unsigned long long> cell_seq;
+        std::vector<std::string> text; // backs 'text' cells
+
+        Table(size_t nfields = 0);
+    };
+
+    mutable std::mutex _mtx;
+    std::unordered_map<int, Table> _tables;
+    unsigned long long _seq;
+
+public:
+    QuoteBook();
+
+    QuoteBook( const QuoteBook& ) = delete;
+
+    QuoteBook&
+    operator=( const QuoteBook& ) = delete;
+
+    static bool
+    is_supported(StreamerServiceType service);
+
+    /* merge decoded 'data' records */
+    void
+    update( StreamerServiceType service,
+            const StreamingRecord_C *records,
+            size_t nrecords );
+
+    void
+    clear();
+
+    unsigned long long
+    sequence() const;
+
+    /*
+     * rows (or just 'symbol', if not null) w/ the cells changed after
+     * 'since_seq' (0 for everything) in ONE malloc'd block the caller frees;
+     * returns nullptr if nothing matched. '*seq' is the current sequence #.
+     */
+    StreamingRecord_C*
+    export_records( StreamerServiceType service,
+                    const char *symbol,
+                    unsigned long long since_seq,
+                    size_t *nrecords,
+                    unsigned long long *seq ) const;
+};
+
+
+
+/* copy 'n' chars of 'src' into a fixed-size field, truncating if need be */
+template<size_t N>
+void
+copy_text(char (&dest)[N], const char *src, size_t n)
+{
+    if( n >= N )
+        n = N - 1;
+    memcpy(dest, src, n);
+    dest[n] = 0;
+}
+
+template<size_t N>
+void
+copy_text(char (&dest)[N], const std::string& src)
+{ copy_text(dest, src.c_str(), src.size()); }
+
+
+/* fill 'event' from an ACCT_ACTIVITY message; 'none' if not an order msg */
+void
+decode_acct_activity( const char *message_type,
+                      const char *message_data,
+                      OrderEvent_C *event );
+
+
+/*
+ * Order state, by order id, built from decoded ACCT_ACTIVITY events. Like the
+ * quote book every change bumps a cache-wide sequence # each order remembers.
+ */
+class OrderCache{
+    mutable std::mutex _mtx;
+    std::unordered_map<std::string, OrderState_C> _orders;
+    unsigned long long _seq;
+
+    OrderState_C&
+    _get_or_insert(const char *order_id);
+
+public:
+    OrderCache();
+
+    OrderCache( const OrderCache& ) = delete;
+
+    OrderCache&
+    operator=( const OrderCache& ) = delete;
+
+    /* apply 'event'; '*state' (if not null) gets the resulting state */
+    void
+    apply(const OrderEvent_C& event, OrderState_C *state);
+
+    bool
+    get(const char *order_id, OrderState_C *state) const;
+
+    void
+    clear();
+
+    unsigned long long
+    sequence() const;
+
+    /* states changed after 'since_seq' in a malloc'd block (or nullptr) */
+    OrderState_C*
+    export_states( unsigned long long since_seq,
+                   size_t *n,
+                   unsigned long long *seq ) const;
+
+    /*
+     * merge an OrdersGetter response (child orders too); orders an event
+     * changed after 'since_seq' are newer than the response and left alone
+     */
+    void
+    seed(const json& orders, unsigned long long since_seq);
+
+    /* orders still open (all, or of 'symbol' if not null) like above */
+    OrderState_C*
+    export_open(const char *symbol, size_t *n) const;
+};
+
+
+
+/*
+ * Keys/fields per service: 'live' is what the server was last sent,
+ * 'wanted' is what the caller asked for. Everything the session sends goes
+ * through observe() so live (and wanted) follow unmanaged requests too;
+ * subscribe()/unsubscribe() only change what's wanted and diff() returns
+ * the fewest requests (SUBS, ADD, UNSUBS, VIEW) that take live to wanted.
+ */
+class SubscriptionManager{
+    struct Service{
+        std::set<std::string> live_keys;
+        std::set<int> live_fields;
+        std::set<std::string> wanted_keys;
+        std::set<int> wanted_fields;
+        bool resync; // live is unknown, re-SUBS what's wanted
+
+        Service();
+    };
+
+    mutable std::mutex _mtx;
+    std::map<std::string, Service> _services;
+
+public:
+    SubscriptionManager();
+
+    SubscriptionManager( const SubscriptionManager& ) = delete;
+
+    SubscriptionManager&
+    operator=( const SubscriptionManager& ) = delete;
+
+    /*
+     * a request about to be sent; if it came from diff() only the live set
+     * changes so subscribe()/unsubscribe() calls made since aren't lost
+     */
+    void
+    observe(const StreamingSubscriptionImpl& sub, bool from_diff = false);
+
+    /* add the keys of 'sub'; its fields replace the service's */
+    void
+    subscribe(const StreamingSubscriptionImpl& sub);
+
+    /* remove the keys of 'sub' */
+    void
+    unsubscribe(const StreamingSubscriptionImpl& sub);
+
+    /* a request for 'service' failed */
+    void
+    invalidate(const std::string& service);
+
+    /* requests to send, in one message, to bring live in line w/ wanted */
+    std::vector<StreamingSubscriptionImpl>
+    diff() const;
+
+    std::set<std::string>
+    get_keys(const std::string& service) const;
+
+    /* new connection: nothing is live, next diff() re-SUBS what's wanted */
+    void
+    reset_live();
+
+    void
+    clear();
+};
+
+
 } /* tdma */
 
 
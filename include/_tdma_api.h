@@ -32,7 +32,8 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 
 namespace tdma{
 
-const std::string URL_BASE = "https://api.tdameritrade.com/v1/";
+const std::string URL_ORIGIN = "https://api.tdameritrade.com";
+const std::string URL_BASE = URL_ORIGIN + "/v1/";
 const std::string URL_MARKETDATA = URL_BASE + "marketdata/";
 const std::string URL_ACCOUNTS = URL_BASE + "accounts/";
 const std::string URL_INSTRUMENTS = URL_BASE + "instruments";
@@ -42,19 +43,57 @@ typedef std::function<void(long, const std::string&)> api_on_error_cb_ty;
 json
 connect_auth( conn::HTTPConnectionInterface& connection, std::string fname);
 
-std::pair<std::string, conn::clock_ty::time_point>
+std::pair<conn::ResponseBuffer, conn::clock_ty::time_point>
 connect_get( conn::HTTPConnectionInterface& connection,
              Credentials& creds,
              api_on_error_cb_ty on_error_cb );
 
+typedef std::function<void(conn::ResponseBuffer&&, std::exception_ptr)>
+    async_get_cb_ty;
+
+/* returns the conn::CurlMultiEngine id */
+unsigned long long
+connect_get_async( conn::HTTPConnectionInterface& connection,
+                   Credentials& creds,
+                   api_on_error_cb_ty on_error_cb,
+                   std::vector<conn::CurlMultiEngine::gate_ty> gates,
+                   async_get_cb_ty callback );
+
 std::pair<std::string, conn::clock_ty::time_point>
 connect_execute( conn::HTTPConnectionInterface& connection,
                    Credentials& creds,
                    long success_code );
 
+typedef std::function<void(std::string&&, conn::clock_ty::time_point,
+                           std::exception_ptr)> async_execute_cb_ty;
+
+/*
+ * 'callback' gets the response header; 'timeout' (msec) is per attempt.
+ * Returns the conn::CurlMultiEngine id
+ */
+unsigned long long
+connect_execute_async( const std::string& url,
+                       conn::HttpMethod meth,
+                       const std::string& body,
+                       Credentials& creds,
+                       long success_code,
+                       long timeout,
+                       async_execute_cb_ty callback );
+
+/* for requests that can outlive the caller's credentials */
+std::shared_ptr<Credentials>
+copy_connect_creds(const Credentials& creds);
+
 json
 get_user_principals_for_streaming(Credentials& creds);
 
+json
+get_orders_for_streaming( Credentials& creds,
+                          const std::string& account_id,
+                          unsigned int nmax_results,
+                          const std::string& from_entered_time,
+                          const std::string& to_entered_time );
+
 void
 data_api_on_error_callback(long code, const std::string& data);
 
@@ -76,6 +115,12 @@ to_new_char_buffers( const std::set<std::string>& strs,
                      size_t *n,
                      bool allow_exceptions );
 
+int
+to_new_char_buffers( const std::vector<std::string>& strs,
+                     char*** bufs,
+                     size_t *n,
+                     bool allow_exceptions );
+
 void
 set_error_state( int code,
                  const std::string&  msg,
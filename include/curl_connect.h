@@ -26,6 +26,12 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <mutex>
 #include <tuple>
 #include <memory>
+#include <functional>
+#include <thread>
+#include <condition_variable>
+#include <unordered_set>
+#include <chrono>
+#include <cstdlib>
 
 #include "curl/curl.h"
 
@@ -38,6 +44,77 @@ typedef std::chrono::steady_clock clock_ty;
 static_assert( static_cast<double>(clock_ty::period::num)
                / clock_ty::period::den <= .001, "invalid tick size of clock" );
 
+/*
+ * Growable, malloc'd, NULL-terminated response body. Pre-sized from
+ * Content-Length when there is one. Only moves; release() hands the memory
+ * to the caller (who calls free) so a body can get from curl to the client
+ * w/o being copied.
+ */
+class ResponseBuffer {
+    char *_buf;
+    size_t _size;
+    size_t _capacity; // NOT including the NULL term
+
+    void
+    _grow(size_t capacity);
+
+public:
+    ResponseBuffer()
+        : _buf(nullptr), _size(0), _capacity(0)
+        {}
+
+    explicit ResponseBuffer(const std::string& s);
+
+    ResponseBuffer( ResponseBuffer&& buffer );
+
+    ResponseBuffer&
+    operator=( ResponseBuffer&& buffer );
+
+    ResponseBuffer( const ResponseBuffer& ) = delete;
+
+    ResponseBuffer&
+    operator=( const ResponseBuffer& ) = delete;
+
+    ~ResponseBuffer()
+    { free(_buf); }
+
+    void
+    reserve(size_t n)
+    { if( n > _capacity ) _grow(n); }
+
+    void
+    append(const char *data, size_t n);
+
+    void
+    clear()
+    { _size = 0; if( _buf ) _buf[0] = 0; }
+
+    const char*
+    data() const
+    { return _buf ? _buf : ""; }
+
+    size_t
+    size() const
+    { return _size; }
+
+    bool
+    empty() const
+    { return _size == 0; }
+
+    size_t
+    capacity() const
+    { return _capacity; }
+
+    std::string
+    str() const
+    { return std::string(data(), _size); }
+
+    /* caller owns the (NULL-terminated) memory; NULL if never allocated */
+    char*
+    release();
+};
+
+
 class CurlConnection {
     friend std::ostream&
     operator<<(std::ostream& out, const CurlConnection& session);       
@@ -81,7 +158,7 @@ public:
     reset_options();
 
     // <status code, body, header(optional), time>
-    std::tuple<long, std::string, std::string, clock_ty::time_point>
+    std::tuple<long, ResponseBuffer, std::string, clock_ty::time_point>
     execute(bool return_header_data);
 
     void
@@ -113,6 +190,13 @@ public:
     void
     set_keepalive(bool on);
 
+    // HTTP/2 for https (1.1 otherwise); false if libcurl wasn't built w/ it
+    bool
+    set_http2(bool on);
+
+    void
+    set_share(CURLSH *share);
+
     void
     set_timeout(long timeout);
 
@@ -170,7 +254,7 @@ public:
 
     virtual bool has_headers() = 0;
 
-    virtual std::tuple<long, std::string, std::string, clock_ty::time_point>
+    virtual std::tuple<long, ResponseBuffer, std::string, clock_ty::time_point>
     execute(bool return_header_data) = 0;
 
     virtual void
@@ -252,7 +336,7 @@ public:
     has_headers()
     { return CurlConnection::has_headers(); }
 
-    std::tuple<long, std::string, std::string, clock_ty::time_point>
+    std::tuple<long, ResponseBuffer, std::string, clock_ty::time_point>
     execute(bool return_header_data)
     { return CurlConnection::execute(return_header_data); }
 
@@ -280,22 +364,95 @@ std::string
 pairs_to_fields_str(const std::vector<std::pair<std::string, std::string>>& fields);
 
 
+/* share connection cache, DNS and TLS sessions between easy handles */
+class CurlShare {
+    CURLSH *_share;
+    std::mutex _mtxs[CURL_LOCK_DATA_LAST];
+
+    static void
+    _lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *ptr);
+
+    static void
+    _unlock(CURL *handle, curl_lock_data data, void *ptr);
+
+public:
+    CurlShare();
+
+    ~CurlShare();
+
+    CurlShare( const CurlShare& ) = delete;
+
+    CurlShare&
+    operator=( const CurlShare& ) = delete;
+
+    CURLSH*
+    get() const
+    { return _share; }
+};
+
+
+/*
+ * Connections w/ the same 'context_id' check handles out of a pool (one per
+ * host) of up to 'pool size' warm HTTPConnections. If they're all in use
+ * execute() waits for one to be returned.
+ */
 class SharedHTTPConnection : public HTTPConnectionInterface {
+public:
+    struct PoolStats{
+        unsigned long long hits; // got an idle handle
+        unsigned long long misses; // had to open a new handle
+        unsigned long long waits; // pool exhausted; had to wait
+        clock_ty::duration wait_time; // total
+        clock_ty::duration max_wait_time;
+        unsigned long long nhandles; // open now (idle + in use)
+    };
+
+    static const size_t DEF_POOL_SIZE = 4;
+    static const size_t MAX_POOL_SIZE = 64;
+
+    static void
+    set_pool_size(size_t n);
+
+    static size_t
+    get_pool_size();
+
+    static PoolStats
+    get_pool_stats();
+
+    static void
+    reset_pool_stats();
+
+private:
+    /* a pooled connection and what was last applied to it */
+    struct Handle{
+        HTTPConnection conn;
+        std::vector<std::pair<std::string,std::string>> headers;
+        long timeout;
+
+        Handle(const std::string& url, HttpMethod meth, CURLSH *share);
+    };
+
+    struct Pool{
+        std::unique_ptr<CurlShare> share; // must outlive handles
+        std::vector<std::unique_ptr<Handle>> idle;
+        size_t nout;
+        std::condition_variable cond;
+
+        Pool() : share( new CurlShare() ), idle(), nout(0), cond() {}
+    };
 
     struct Context{
         size_t nref;
-        std::shared_ptr<HTTPConnection> conn;
-        std::shared_ptr<std::mutex> mtx;
+        std::unordered_map<std::string, std::unique_ptr<Pool>> pools; // by host
 
-        Context(HTTPConnection * pconn)
-            : nref(0), conn(pconn), mtx(new std::mutex())
-            {}
-
-        Context() : Context(nullptr) {}
+        Context() : nref(0), pools() {}
     };
 
+    /* contexts_mtx covers contexts, pools and stats */
     static std::unordered_map<int, Context> contexts;
     static std::mutex contexts_mtx;
+    static size_t pool_size;
+    static PoolStats pool_stats;
 
     static int
     nconnections(int context_id);
@@ -314,8 +471,11 @@ class SharedHTTPConnection : public HTTPConnectionInterface {
     long _timeout;
     int _id;
 
-    Context&
-    _get_context() const;
+    std::unique_ptr<Handle>
+    _checkout(const std::string& host, Pool*& pool);
+
+    void
+    _checkin(Pool *pool, std::unique_ptr<Handle> handle);
 
 public:
     SharedHTTPConnection( const std::string& url,
@@ -384,7 +544,7 @@ public:
     has_headers()
     { return !_headers.empty(); }
 
-    std::tuple<long, std::string, std::string, clock_ty::time_point>
+    std::tuple<long, ResponseBuffer, std::string, clock_ty::time_point>
     execute(bool return_header_data);
 
     void
@@ -404,6 +564,119 @@ public:
 };
 
 
+/* everything CurlMultiEngine needs to run a request w/o a connection object */
+struct HTTPRequest{
+    std::string url;
+    HttpMethod method;
+    std::vector<std::pair<std::string,std::string>> headers;
+    std::string fields;
+    long timeout; // msec, 0 for none
+    bool return_header; // fill HTTPResponse::header
+};
+
+struct HTTPResponse{
+    long code;
+    ResponseBuffer body;
+    clock_ty::time_point tp;
+    CURLcode curl_code; // CURLE_OK unless the transfer itself failed
+    std::string error;
+    std::string header; // if HTTPRequest::return_header
+};
+
+
+/*
+ * Runs HTTPRequests asynchronously on ONE I/O thread using a curl multi
+ * handle (connections are cached/reused across requests).
+ *
+ * Before a request starts each of its 'gates' is called, in order, on the
+ * I/O thread; a gate returns how long the request must wait before the next
+ * gate (or the transfer itself) can go. This lets callers throttle w/o
+ * blocking anything. If the request is canceled before it starts, the
+ * gates it got through are released (if they have a 'release').
+ *
+ * Callbacks run on the I/O thread and should return quickly. Anything still
+ * waiting/in-flight when the engine is destroyed gets CURLE_ABORTED_BY_CALLBACK.
+ */
+class CurlMultiEngine {
+public:
+    typedef unsigned long long id_type;
+    struct gate_ty{
+        std::function<clock_ty::duration()> reserve;
+        std::function<void()> release; // optional
+    };
+    typedef std::function<void(HTTPResponse&&)> callback_ty;
+
+    static CurlMultiEngine&
+    instance();
+
+    ~CurlMultiEngine();
+
+    CurlMultiEngine( const CurlMultiEngine& ) = delete;
+
+    CurlMultiEngine&
+    operator=( const CurlMultiEngine& ) = delete;
+
+    id_type
+    submit( HTTPRequest request,
+            std::vector<gate_ty> gates,
+            callback_ty callback );
+
+    /*
+     * if still waiting/in-flight the callback gets CURLE_ABORTED_BY_CALLBACK
+     * (on the I/O thread) and we return true
+     */
+    bool
+    cancel(id_type id);
+
+    size_t
+    pending() const;
+
+private:
+    class Transfer;
+
+    static const std::chrono::milliseconds MAX_WAIT;
+    static const size_t MAX_FREE_HANDLES = 16;
+
+    CurlMultiEngine();
+
+    CURLM *_multi;
+    std::vector<CURL*> _free_handles;
+
+    mutable std::mutex _mtx;
+    std::condition_variable _cond;
+    std::vector<std::shared_ptr<Transfer>> _incoming; // _mtx
+    std::unordered_set<id_type> _active; // _mtx
+    std::unordered_set<id_type> _canceled; // _mtx
+    id_type _next_id; // _mtx
+    bool _stop; // _mtx
+
+    /* only touched by the I/O thread */
+    std::multimap<clock_ty::time_point, std::shared_ptr<Transfer>> _waiting;
+    std::unordered_map<CURL*, std::shared_ptr<Transfer>> _running;
+
+    std::thread _thread;
+
+    void
+    _run();
+
+    void
+    _admit(clock_ty::time_point now);
+
+    bool
+    _start(std::shared_ptr<Transfer> t);
+
+    void
+    _finish(std::shared_ptr<Transfer> t, HTTPResponse&& r);
+
+    void
+    _cancel(const std::unordered_set<id_type>& ids);
+
+    /* the I/O thread, if it's waiting */
+    void
+    _wakeup();
+};
+
+
 class CurlException
         : public std::exception{
     std::string _what;
@@ -438,6 +711,19 @@ set_certificate_bundle_path( const std::string& path );
 std::string
 get_certificate_bundle_path();
 
+/*
+ * requests for urls that begin w/ 'from' go to 'to' instead
+ * (e.g a local mock server); empty 'from' removes the override
+ */
+void
+set_url_override( const std::string& from, const std::string& to );
+
+std::string
+get_url_override( const std::string& from );
+
+std::string
+apply_url_override( const std::string& url );
+
 } /* conn */
 
 #endif // CONNECT_H
@@ -0,0 +1,168 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <condition_variable>
+
+#include "_common.h"
+#include "websocket_connect.h"
+
+namespace conn{
+
+/*
+ * capture file:
+ *
+ *     "TDMACAP1"
+ *     { u64 nsec since capture start, u32 frame length, frame } ...
+ *
+ * integers are little-endian, nsec is from steady_clock
+ */
+static const char CAPTURE_MAGIC[] = "TDMACAP1";
+static const size_t CAPTURE_MAGIC_SIZE = 8;
+
+
+/* written from the socket thread, started/stopped from any */
+class FrameRecorder{
+    std::mutex _mtx;
+    std::FILE *_file;
+    std::atomic<bool> _active;
+    std::chrono::steady_clock::time_point _start;
+
+public:
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    FrameRecorder();
+
+    FrameRecorder( const FrameRecorder& ) = delete;
+
+    FrameRecorder&
+    operator=( const FrameRecorder& ) = delete;
+
+    ~FrameRecorder();
+
+    /* truncates 'path'; false if it can't be opened */
+    bool
+    start(const std::string& path);
+
+    void
+    stop();
+
+    bool
+    is_active() const
+    { return _active; }
+
+    void
+    write(const char *frame, size_t len);
+};
+
+
+/*
+ * plays a capture through the WebSocketClient interface:
+ *
+ *   'speed' scales the recorded gaps between frames; 1.0 is the original
+ *   speed, 0 is as fast as possible (frames are handed over in batches
+ *   of up to MAX_BATCH)
+ *
+ *   requests passed to send() get a successful response right away;
+ *   responses in the capture (to the original requests) are skipped
+ *
+ *   at the end of the capture the consumer gets the 'empty message'
+ */
+class FrameReplayClient
+        : public WebSocketClientInterface {
+    std::string _path;
+    double _speed;
+    std::FILE *_file;
+    std::atomic<bool> _connected;
+
+    std::mutex _mtx;
+    std::condition_variable _cond;
+    std::deque<std::string> _responses; // to what was sent, ahead of capture
+    bool _stop_flag;
+    bool _eof;
+
+    std::string _next;
+    bool _has_next;
+    unsigned long long _next_nsec;
+    unsigned long long _first_nsec;
+    bool _started;
+    std::chrono::steady_clock::time_point _start;
+
+    /* next non-response frame into _next; false at end of capture */
+    bool
+    _read_next();
+
+    std::chrono::steady_clock::time_point
+    _due(unsigned long long nsec) const;
+
+public:
+    static const size_t MAX_BATCH = 256;
+
+    FrameReplayClient(std::string path, double speed);
+
+    FrameReplayClient( const FrameReplayClient& ) = delete;
+
+    FrameReplayClient&
+    operator=( const FrameReplayClient& ) = delete;
+
+    virtual
+    ~FrameReplayClient();
+
+    static bool
+    is_capture_file(const std::string& path);
+
+    void
+    connect(std::chrono::milliseconds timeout);
+
+    bool
+    is_connected() const
+    { return _connected; }
+
+    void
+    close(bool graceful=true);
+
+    void
+    send(std::string msg);
+
+    void
+    push_empty_message();
+
+    std::string
+    recv_or_wait_for(std::chrono::milliseconds timeout);
+
+    size_t
+    recv_atleast_n_or_wait_for( size_t n,
+                                std::chrono::milliseconds timeout,
+                                std::vector<std::string>& frames );
+
+    void
+    recycle(std::vector<std::string>& frames)
+    { frames.clear(); }
+};
+
+} /* conn */
+
+#endif // FRAME_CAPTURE_H
@@ -0,0 +1,409 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <chrono>
+#include <vector>
+#include <condition_variable>
+
+#include "_common.h"
+
+/*
+ * Bounded, lock-free, single-producer/single-consumer ring.
+ *
+ * ONE thread may push and ONE thread may pop at any given time (ownership of
+ * either side can be handed off if there is a happens-before, e.g a join).
+ *
+ * Elements are moved in and out; push/pop only touch the mutex when the
+ * other side has parked itself after spinning on an empty/full ring.
+ */
+template<typename T>
+class SPSCRing {
+    static const size_t CACHE_LINE = 64;
+    static const unsigned int SPIN_MIN = 16;
+    static const unsigned int SPIN_MAX = 4096;
+
+    const size_t _capacity;
+    const size_t _mask;
+    std::unique_ptr<T[]> _buffer;
+
+    /* consumer */
+    char _pad0[CACHE_LINE];
+    std::atomic<size_t> _head;
+    size_t _tail_cache;
+    unsigned int _pop_spin;
+
+    /* producer */
+    char _pad1[CACHE_LINE];
+    std::atomic<size_t> _tail;
+    size_t _head_cache;
+    unsigned int _push_spin;
+
+    /* parking */
+    char _pad2[CACHE_LINE];
+    std::atomic<unsigned int> _consumer_parked; // # of threads parked
+    std::atomic<unsigned int> _producer_parked;
+    std::atomic<bool> _wake;
+    std::atomic<bool> _closed;
+    std::mutex _park_mtx;
+    std::condition_variable _consumer_cond;
+    std::condition_variable _producer_cond;
+
+    static size_t
+    _round_up_pow2(size_t n)
+    {
+        size_t c = 2;
+        while( c < n )
+            c <<= 1;
+        return c;
+    }
+
+    void
+    _notify(std::atomic<unsigned int>& parked, std::condition_variable& cond)
+    {
+        /* pairs w/ the fence in _wait; either we see 'parked' or they see us */
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if( parked.load(std::memory_order_relaxed) ){
+            std::lock_guard<std::mutex> _(_park_mtx);
+            cond.notify_all();
+        }
+    }
+
+    /*
+     * spin for up to 'spin' iterations, then park until 'ready' or
+     * 'deadline'; 'spin' adapts to how often spinning pays off
+     */
+    template<typename F>
+    bool
+    _wait( F ready,
+           unsigned int& spin,
+           std::atomic<unsigned int>& parked,
+           std::condition_variable& cond,
+           const std::chrono::steady_clock::time_point *deadline )
+    {
+        for( unsigned int i = 0; i < spin; ++i ){
+            if( ready() ){
+                if( spin < SPIN_MAX )
+                    spin <<= 1;
+                return true;
+            }
+            if( i & 0x3f )
+                continue;
+            std::this_thread::yield();
+        }
+        if( spin > SPIN_MIN )
+            spin >>= 1;
+
+        std::unique_lock<std::mutex> lock(_park_mtx);
+        parked.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto pred = [&]{ return ready() || _closed.load(); };
+        bool r = deadline ? cond.wait_until(lock, *deadline, pred)
+                          : (cond.wait(lock, pred), true);
+        parked.fetch_sub(1, std::memory_order_relaxed);
+        return r && ready();
+    }
+
+    bool
+    _readable()
+    {
+        if( _tail_cache != _head.load(std::memory_order_relaxed) )
+            return true;
+        _tail_cache = _tail.load(std::memory_order_acquire);
+        return _tail_cache != _head.load(std::memory_order_relaxed);
+    }
+
+    bool
+    _writable()
+    {
+        size_t t = _tail.load(std::memory_order_relaxed);
+        if( t - _head_cache < _capacity )
+            return true;
+        _head_cache = _head.load(std::memory_order_acquire);
+        return t - _head_cache < _capacity;
+    }
+
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+
+    static const size_t DEF_CAPACITY = 1024;
+
+    explicit SPSCRing(size_t capacity = DEF_CAPACITY)
+        :
+            _capacity( _round_up_pow2(capacity) ),
+            _mask( _capacity - 1 ),
+            _buffer( new T[_capacity] ),
+            _head(0),
+            _tail_cache(0),
+            _pop_spin(SPIN_MIN),
+            _tail(0),
+            _head_cache(0),
+            _push_spin(SPIN_MIN),
+            _consumer_parked(0),
+            _producer_parked(0),
+            _wake(false),
+            _closed(false),
+            _park_mtx(),
+            _consumer_cond(),
+            _producer_cond()
+        {
+        }
+
+    SPSCRing(const SPSCRing&) = delete;
+
+    SPSCRing&
+    operator=(const SPSCRing&) = delete;
+
+    size_type
+    capacity() const
+    { return _capacity; }
+
+    size_type
+    size() const
+    {
+        return _tail.load(std::memory_order_acquire)
+               - _head.load(std::memory_order_acquire);
+    }
+
+    bool
+    empty() const
+    { return size() == 0; }
+
+    bool
+    is_closed() const
+    { return _closed.load(); }
+
+    /*
+     * PRODUCER
+     */
+
+    /* moves from 'value' ONLY if it returns true */
+    bool
+    try_push(T& value)
+    {
+        if( _closed.load(std::memory_order_relaxed) || !_writable() )
+            return false;
+        size_t t = _tail.load(std::memory_order_relaxed);
+        _buffer[t & _mask] = std::move(value);
+        _tail.store(t + 1, std::memory_order_release);
+        _notify(_consumer_parked, _consumer_cond);
+        return true;
+    }
+
+    /* blocks while full; returns false (and drops) if closed */
+    bool
+    push(T value)
+    {
+        while( !try_push(value) ){
+            if( _closed.load() )
+                return false;
+            _wait( [this]{ return _writable(); }, _push_spin,
+                   _producer_parked, _producer_cond, nullptr );
+        }
+        return true;
+    }
+
+    /*
+     * wait (w/o pushing) until there's room, close() or 'deadline'; only
+     * reads the indices, so any number of threads can wait here while
+     * pushes are serialized by a lock of their own
+     */
+    bool
+    wait_writable(const std::chrono::steady_clock::time_point *deadline = nullptr)
+    {
+        unsigned int spin = SPIN_MIN;
+        return _wait( [this]{ return size() < _capacity || _closed.load(); },
+                      spin, _producer_parked, _producer_cond, deadline );
+    }
+
+    /*
+     * CONSUMER
+     */
+
+    /* pointer to the next element or nullptr; valid until the next pop */
+    T*
+    front()
+    { return _readable() ? &_buffer[_head.load(std::memory_order_relaxed) & _mask]
+                         : nullptr; }
+
+    bool
+    try_pop(T& value)
+    {
+        if( !_readable() )
+            return false;
+        size_t h = _head.load(std::memory_order_relaxed);
+        value = std::move(_buffer[h & _mask]);
+        _head.store(h + 1, std::memory_order_release);
+        _notify(_producer_parked, _producer_cond);
+        return true;
+    }
+
+    /* move up to 'max' elements onto the back of 'out'; one release/notify */
+    size_type
+    drain(std::vector<T>& out, size_type max = static_cast<size_type>(-1))
+    {
+        if( !_readable() )
+            return 0;
+        size_t h = _head.load(std::memory_order_relaxed);
+        size_t n = _tail_cache - h;
+        if( n > max )
+            n = max;
+        for( size_t i = 0; i < n; ++i )
+            out.emplace_back( std::move(_buffer[(h + i) & _mask]) );
+        _head.store(h + n, std::memory_order_release);
+        _notify(_producer_parked, _producer_cond);
+        return n;
+    }
+
+    /*
+     * discard up to 'n' of the oldest elements 'pred' is true for, keeping
+     * the rest in order; each is passed to 'on_drop' (to move from) first
+     *
+     * the producer can call this too IF it and the consumer's pops are
+     * serialized by a lock of their own
+     */
+    template<typename P, typename D>
+    size_type
+    drop_front_if(size_type n, P pred, D on_drop)
+    {
+        size_t h = _head.load(std::memory_order_relaxed);
+        _tail_cache = _tail.load(std::memory_order_acquire);
+        size_t avail = _tail_cache - h;
+
+        /* the shortest prefix holding 'n' of them */
+        size_t m = 0, k = 0;
+        for( ; m < avail && k < n; ++m ){
+            if( pred(_buffer[(h + m) & _mask]) )
+                ++k;
+        }
+        if( !k )
+            return 0;
+
+        /* slide the ones we keep to the back of the prefix */
+        size_t dst = h + m;
+        for( size_t i = h + m; i-- > h; ){
+            T& e = _buffer[i & _mask];
+            if( pred(e) )
+                on_drop(e);
+            else if( --dst != i )
+                _buffer[dst & _mask] = std::move(e);
+        }
+
+        _head.store(h + k, std::memory_order_release);
+        _notify(_producer_parked, _producer_cond);
+        return k;
+    }
+
+    /*
+     * wait (w/o popping) until something is queued, wake_consumer(),
+     * close() or 'deadline'; only reads the indices, so another thread can
+     * be popping under a lock the consumer shares (see drop_front_if)
+     */
+    bool
+    wait_readable(const std::chrono::steady_clock::time_point *deadline = nullptr)
+    {
+        return _wait( [this]{ return size() != 0 || _wake.load() || _closed.load(); },
+                      _pop_spin, _consumer_parked, _consumer_cond, deadline );
+    }
+
+    /*
+     * block until something can be popped; false if woken by
+     * wake_consumer() or close() with nothing to pop
+     */
+    bool
+    pop_or_wait(T& value)
+    {
+        while( !try_pop(value) ){
+            if( clear_wake() || _closed.load() )
+                return false;
+            _wait( [this]{ return _readable() || _wake.load(); }, _pop_spin,
+                   _consumer_parked, _consumer_cond, nullptr );
+        }
+        return true;
+    }
+
+    /* as above but also false on timeout */
+    bool
+    pop_or_wait_for(T& value, std::chrono::milliseconds timeout)
+    {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while( !try_pop(value) ){
+            if( clear_wake() || _closed.load()
+                || std::chrono::steady_clock::now() >= deadline )
+            {
+                return false;
+            }
+            _wait( [this]{ return _readable() || _wake.load(); }, _pop_spin,
+                   _consumer_parked, _consumer_cond, &deadline );
+        }
+        return true;
+    }
+
+    /* drain; if nothing is ready wait up to 'timeout' for at least 1 */
+    size_type
+    drain_or_wait_for( std::vector<T>& out,
+                       std::chrono::milliseconds timeout,
+                       size_type max = static_cast<size_type>(-1) )
+    {
+        size_type n = drain(out, max);
+        if( n || max == 0 )
+            return n;
+        out.emplace_back();
+        if( !pop_or_wait_for(out.back(), timeout) ){
+            out.pop_back();
+            return 0;
+        }
+        return 1 + drain(out, max - 1);
+    }
+
+    /*
+     * ANY THREAD
+     */
+
+    /* force a waiting (or the next) consumer wait to return */
+    void
+    wake_consumer()
+    {
+        _wake.store(true);
+        std::lock_guard<std::mutex> _(_park_mtx);
+        _consumer_cond.notify_one();
+    }
+
+    /* consumer: was a wake_consumer() pending ? */
+    bool
+    clear_wake()
+    { return _wake.exchange(false); }
+
+    /* stop accepting elements and release any waits; pops still drain */
+    void
+    close()
+    {
+        _closed.store(true);
+        std::lock_guard<std::mutex> _(_park_mtx);
+        _consumer_cond.notify_all();
+        _producer_cond.notify_all();
+    }
+};
+
+#endif // SPSC_RING_H
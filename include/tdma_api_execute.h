@@ -4338,6 +4338,146 @@ Execute_CancelOrder_ABI( struct Credentials *creds,
                          int *success,
                          int allow_exceptions );
 
+/* replaces 'order_id' w/ 'porder'; returns the ID of the new order */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+Execute_ReplaceOrder_ABI( struct Credentials *creds,
+                          const char* account_id,
+                          const char* order_id,
+                          OrderTicket_C *porder,
+                          char** buf,
+                          size_t *n,
+                          int allow_exceptions );
+
+#define EXECUTE_SEND_ORDERS_TIMEOUT_MSEC 30000
+
+/*
+ * sends 'norders' orders concurrently; 'errors' and 'usec' ('norders' long,
+ * caller allocated) get each order's error code (0 on success) and round
+ * trip; '*order_ids' gets 'norders' IDs ("" on failure), free w/ FreeBuffers.
+ * Orders w/o a response in EXECUTE_SEND_ORDERS_TIMEOUT_MSEC get
+ * TDMA_API_TIMEOUT_ERROR - they may still have been placed.
+ */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+Execute_SendOrders_ABI( struct Credentials *creds,
+                        const char* account_id,
+                        OrderTicket_C *orders,
+                        size_t norders,
+                        char ***order_ids,
+                        int *errors,
+                        unsigned long long *usec,
+                        int allow_exceptions );
+
+/*
+ * OrderTemplate - an OrderTicket serialized once for repeated sends
+ *
+ * price, stop price and the quantity of each leg can be changed in place;
+ * only fields the ticket had when the template was created can be set and
+ * child orders are fixed
+ */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+OrderTemplate_Create_ABI( OrderTicket_C *porder,
+                          OrderTemplate_C *ptemplate,
+                          int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+OrderTemplate_Destroy_ABI( OrderTemplate_C *ptemplate,
+                           int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+OrderTemplate_SetPrice_ABI( OrderTemplate_C *ptemplate,
+                            double price,
+                            int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+OrderTemplate_SetStopPrice_ABI( OrderTemplate_C *ptemplate,
+                                double stop_price,
+                                int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+OrderTemplate_SetLegQuantity_ABI( OrderTemplate_C *ptemplate,
+                                  size_t n,
+                                  size_t quantity,
+                                  int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+OrderTemplate_AsJsonString_ABI( OrderTemplate_C *ptemplate,
+                                char **buf,
+                                size_t *n,
+                                int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+Execute_SendOrderTemplate_ABI( struct Credentials *creds,
+                               const char* account_id,
+                               OrderTemplate_C *ptemplate,
+                               char** buf,
+                               size_t *n,
+                               int allow_exceptions );
+
+/*
+ * ExecutionSession - keeps one connection per account warm for send/cancel
+ *
+ * connects on create; if 'keep_warm' (msec) is non-zero a cheap GET is made
+ * whenever the connection's been idle that long (0 to disable), on its own
+ * handle so it doesn't hold up orders; the session keeps its own copy of
+ * 'pcreds'
+ */
+#define EXECUTION_SESSION_DEF_KEEP_WARM 30000
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+ExecutionSession_Create_ABI( struct Credentials *pcreds,
+                             const char* account_id,
+                             unsigned long keep_warm,
+                             ExecutionSession_C *psession,
+                             int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+ExecutionSession_Destroy_ABI( ExecutionSession_C *psession,
+                              int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+ExecutionSession_GetAccountId_ABI( ExecutionSession_C *psession,
+                                   char **buf,
+                                   size_t *n,
+                                   int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+ExecutionSession_GetKeepWarm_ABI( ExecutionSession_C *psession,
+                                  unsigned long *keep_warm,
+                                  int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+ExecutionSession_SetKeepWarm_ABI( ExecutionSession_C *psession,
+                                  unsigned long keep_warm,
+                                  int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+ExecutionSession_SendOrder_ABI( ExecutionSession_C *psession,
+                                OrderTicket_C *porder,
+                                char **buf,
+                                size_t *n,
+                                int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+ExecutionSession_CancelOrder_ABI( ExecutionSession_C *psession,
+                                  const char* order_id,
+                                  int *success,
+                                  int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+ExecutionSession_ReplaceOrder_ABI( ExecutionSession_C *psession,
+                                   const char* order_id,
+                                   OrderTicket_C *porder,
+                                   char **buf,
+                                   size_t *n,
+                                   int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+ExecutionSession_SendOrderTemplate_ABI( ExecutionSession_C *psession,
+                                        OrderTemplate_C *ptemplate,
+                                        char **buf,
+                                        size_t *n,
+                                        int allow_exceptions );
+
 #ifndef __cplusplus
 
 static inline int
@@ -4356,6 +4496,117 @@ Execute_CancelOrder( struct Credentials *creds,
                      int *success )
 { return Execute_CancelOrder_ABI(creds, account_id, order_id, success, 0); }
 
+static inline int
+Execute_ReplaceOrder( struct Credentials *creds,
+                      const char* account_id,
+                      const char* order_id,
+                      OrderTicket_C *porder,
+                      char** buf,
+                      size_t *n )
+{ return Execute_ReplaceOrder_ABI(creds, account_id, order_id, porder, buf, n, 0); }
+
+static inline int
+Execute_SendOrders( struct Credentials *creds,
+                    const char* account_id,
+                    OrderTicket_C *orders,
+                    size_t norders,
+                    char ***order_ids,
+                    int *errors,
+                    unsigned long long *usec )
+{
+    return Execute_SendOrders_ABI(creds, account_id, orders, norders,
+                                  order_ids, errors, usec, 0);
+}
+
+static inline int
+OrderTemplate_Create( OrderTicket_C *porder, OrderTemplate_C *ptemplate )
+{ return OrderTemplate_Create_ABI(porder, ptemplate, 0); }
+
+static inline int
+OrderTemplate_Destroy( OrderTemplate_C *ptemplate )
+{ return OrderTemplate_Destroy_ABI(ptemplate, 0); }
+
+static inline int
+OrderTemplate_SetPrice( OrderTemplate_C *ptemplate, double price )
+{ return OrderTemplate_SetPrice_ABI(ptemplate, price, 0); }
+
+static inline int
+OrderTemplate_SetStopPrice( OrderTemplate_C *ptemplate, double stop_price )
+{ return OrderTemplate_SetStopPrice_ABI(ptemplate, stop_price, 0); }
+
+static inline int
+OrderTemplate_SetLegQuantity( OrderTemplate_C *ptemplate,
+                              size_t n,
+                              size_t quantity )
+{ return OrderTemplate_SetLegQuantity_ABI(ptemplate, n, quantity, 0); }
+
+static inline int
+OrderTemplate_AsJsonString( OrderTemplate_C *ptemplate, char **buf, size_t *n )
+{ return OrderTemplate_AsJsonString_ABI(ptemplate, buf, n, 0); }
+
+static inline int
+Execute_SendOrderTemplate( struct Credentials *creds,
+                           const char* account_id,
+                           OrderTemplate_C *ptemplate,
+                           char** buf,
+                           size_t *n )
+{ return Execute_SendOrderTemplate_ABI(creds, account_id, ptemplate, buf, n, 0); }
+
+static inline int
+ExecutionSession_Create( struct Credentials *pcreds,
+                         const char* account_id,
+                         unsigned long keep_warm,
+                         ExecutionSession_C *psession )
+{ return ExecutionSession_Create_ABI(pcreds, account_id, keep_warm, psession, 0); }
+
+static inline int
+ExecutionSession_Destroy( ExecutionSession_C *psession )
+{ return ExecutionSession_Destroy_ABI(psession, 0); }
+
+static inline int
+ExecutionSession_GetAccountId( ExecutionSession_C *psession,
+                               char **buf,
+                               size_t *n )
+{ return ExecutionSession_GetAccountId_ABI(psession, buf, n, 0); }
+
+static inline int
+ExecutionSession_GetKeepWarm( ExecutionSession_C *psession,
+                              unsigned long *keep_warm )
+{ return ExecutionSession_GetKeepWarm_ABI(psession, keep_warm, 0); }
+
+static inline int
+ExecutionSession_SetKeepWarm( ExecutionSession_C *psession,
+                              unsigned long keep_warm )
+{ return ExecutionSession_SetKeepWarm_ABI(psession, keep_warm, 0); }
+
+static inline int
+ExecutionSession_SendOrder( ExecutionSession_C *psession,
+                            OrderTicket_C *porder,
+                            char **buf,
+                            size_t *n )
+{ return ExecutionSession_SendOrder_ABI(psession, porder, buf, n, 0); }
+
+static inline int
+ExecutionSession_CancelOrder( ExecutionSession_C *psession,
+                              const char* order_id,
+                              int *success )
+{ return ExecutionSession_CancelOrder_ABI(psession, order_id, success, 0); }
+
+static inline int
+ExecutionSession_ReplaceOrder( ExecutionSession_C *psession,
+                               const char* order_id,
+                               OrderTicket_C *porder,
+                               char **buf,
+                               size_t *n )
+{ return ExecutionSession_ReplaceOrder_ABI(psession, order_id, porder, buf, n, 0); }
+
+static inline int
+ExecutionSession_SendOrderTemplate( ExecutionSession_C *psession,
+                                    OrderTemplate_C *ptemplate,
+                                    char **buf,
+                                    size_t *n )
+{ return ExecutionSession_SendOrderTemplate_ABI(psession, ptemplate, buf, n, 0); }
+
 
 #else
 
@@ -4379,6 +4630,210 @@ Execute_CancelOrder( Credentials& creds,
     return static_cast<bool>(success);
 }
 
+inline std::string
+Execute_ReplaceOrder( Credentials& creds,
+                      const std::string& account_id,
+                      const std::string& order_id,
+                      const OrderTicket& order )
+{
+    return str_from_abi_vargs( Execute_ReplaceOrder_ABI, ALLOW_EXCEPTIONS,
+                               &creds, account_id.c_str(), order_id.c_str(),
+                               order.get_cproxy() );
+}
+
+
+struct ExecuteResult{
+    std::string order_id; // empty on failure
+    int error; // TDMA_API_ error code, 0 on success
+    std::chrono::microseconds elapsed;
+};
+
+inline std::vector<ExecuteResult>
+Execute_SendOrders( Credentials& creds,
+                    const std::string& account_id,
+                    const std::vector<OrderTicket>& orders )
+{
+    size_t n = orders.size();
+    std::vector<OrderTicket_C> corders;
+    corders.reserve(n);
+    for( auto& o : orders )
+        corders.push_back( *o.get_cproxy() );
+
+    char **ids = nullptr;
+    std::vector<int> errors(n);
+    std::vector<unsigned long long> usec(n);
+    call_abi( Execute_SendOrders_ABI, &creds, account_id.c_str(),
+              corders.data(), n, &ids, errors.data(), usec.data() );
+
+    std::vector<ExecuteResult> results;
+    results.reserve(n);
+    for( size_t i = 0; i < n; ++i ){
+        results.push_back( ExecuteResult{ (ids ? ids[i] : ""), errors[i],
+                                          std::chrono::microseconds(usec[i]) } );
+    }
+    if( ids )
+        FreeBuffers_ABI(ids, n, ALLOW_EXCEPTIONS);
+    return results;
+}
+
+
+class OrderTemplate{
+public:
+    typedef OrderTemplate_C CType;
+
+private:
+    std::unique_ptr<CType, CProxyDestroyer<CType>> _obj;
+
+public:
+    explicit OrderTemplate( const OrderTicket& order )
+        :
+            _obj( new CType{0,0},
+                  CProxyDestroyer<CType>(OrderTemplate_Destroy_ABI) )
+        {
+            call_abi( OrderTemplate_Create_ABI, order.get_cproxy(),
+                      _obj.get() );
+        }
+
+    OrderTemplate( OrderTemplate&& ) = default;
+
+    OrderTemplate&
+    operator=( OrderTemplate&& ) = default;
+
+    OrderTemplate( const OrderTemplate& ) = delete;
+
+    OrderTemplate&
+    operator=( const OrderTemplate& ) = delete;
+
+    OrderTemplate&
+    set_price(double price)
+    {
+        call_abi( OrderTemplate_SetPrice_ABI, _obj.get(), price );
+        return *this;
+    }
+
+    OrderTemplate&
+    set_stop_price(double stop_price)
+    {
+        call_abi( OrderTemplate_SetStopPrice_ABI, _obj.get(), stop_price );
+        return *this;
+    }
+
+    OrderTemplate&
+    set_leg_quantity(size_t n, size_t quantity)
+    {
+        call_abi( OrderTemplate_SetLegQuantity_ABI, _obj.get(), n, quantity );
+        return *this;
+    }
+
+    std::string
+    as_json_string() const
+    { return str_from_abi(OrderTemplate_AsJsonString_ABI, _obj.get()); }
+
+    CType*
+    get_cproxy() const
+    { return _obj.get(); }
+};
+
+inline std::string
+Execute_SendOrder( Credentials& creds,
+                   const std::string& account_id,
+                   const OrderTemplate& order )
+{
+    return str_from_abi_vargs( Execute_SendOrderTemplate_ABI, ALLOW_EXCEPTIONS,
+                               &creds, account_id.c_str(),
+                               order.get_cproxy() );
+}
+
+
+class ExecutionSession{
+public:
+    typedef ExecutionSession_C CType;
+
+    static const std::chrono::milliseconds DEF_KEEP_WARM; // 30000
+
+private:
+    std::unique_ptr<CType, CProxyDestroyer<CType>> _obj;
+
+public:
+    ExecutionSession( Credentials& creds,
+                      const std::string& account_id,
+                      std::chrono::milliseconds keep_warm = DEF_KEEP_WARM )
+        :
+            _obj( new CType{0,0},
+                  CProxyDestroyer<CType>(ExecutionSession_Destroy_ABI) )
+        {
+            call_abi( ExecutionSession_Create_ABI, &creds, account_id.c_str(),
+                      static_cast<unsigned long>(keep_warm.count()),
+                      _obj.get() );
+        }
+
+    ExecutionSession( ExecutionSession&& ) = default;
+
+    ExecutionSession&
+    operator=( ExecutionSession&& ) = default;
+
+    ExecutionSession( const ExecutionSession& ) = delete;
+
+    ExecutionSession&
+    operator=( const ExecutionSession& ) = delete;
+
+    std::string
+    get_account_id() const
+    { return str_from_abi(ExecutionSession_GetAccountId_ABI, _obj.get()); }
+
+    std::chrono::milliseconds
+    get_keep_warm() const
+    {
+        unsigned long kw;
+        call_abi( ExecutionSession_GetKeepWarm_ABI, _obj.get(), &kw );
+        return std::chrono::milliseconds(kw);
+    }
+
+    void
+    set_keep_warm(std::chrono::milliseconds keep_warm)
+    {
+        call_abi( ExecutionSession_SetKeepWarm_ABI, _obj.get(),
+                  static_cast<unsigned long>(keep_warm.count()) );
+    }
+
+    std::string
+    send_order(const OrderTicket& order)
+    {
+        return str_from_abi_vargs( ExecutionSession_SendOrder_ABI,
+                                   ALLOW_EXCEPTIONS, _obj.get(),
+                                   order.get_cproxy() );
+    }
+
+    std::string
+    send_order(const OrderTemplate& order)
+    {
+        return str_from_abi_vargs( ExecutionSession_SendOrderTemplate_ABI,
+                                   ALLOW_EXCEPTIONS, _obj.get(),
+                                   order.get_cproxy() );
+    }
+
+    bool
+    cancel_order(const std::string& order_id)
+    {
+        int success;
+        call_abi( ExecutionSession_CancelOrder_ABI, _obj.get(),
+                  order_id.c_str(), &success );
+        return static_cast<bool>(success);
+    }
+
+    std::string
+    replace_order(const std::string& order_id, const OrderTicket& order)
+    {
+        return str_from_abi_vargs( ExecutionSession_ReplaceOrder_ABI,
+                                   ALLOW_EXCEPTIONS, _obj.get(),
+                                   order_id.c_str(), order.get_cproxy() );
+    }
+
+    CType*
+    get_cproxy() const
+    { return _obj.get(); }
+};
+
 } /* tdma */
 
 #endif /* __cplusplus */
@@ -25,9 +25,21 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <set>
 #include <unordered_map>
 #include <iostream>
+#include <future>
+#include <memory>
+#include <algorithm>
 
 #endif /* __cplusplus */
 
+/* groups of getters that can be throttled separately */
+DECL_C_CPP_TDMA_ENUM(EndpointClass, 0, 4,
+    BUILD_C_CPP_TDMA_ENUM_NAME(EndpointClass, quotes), // quotes, option chains
+    BUILD_C_CPP_TDMA_ENUM_NAME(EndpointClass, history), // price history
+    BUILD_C_CPP_TDMA_ENUM_NAME(EndpointClass, account), // accounts, transactions etc.
+    BUILD_C_CPP_TDMA_ENUM_NAME(EndpointClass, orders), // order(s)
+    BUILD_C_CPP_TDMA_ENUM_NAME(EndpointClass, other) // hours, movers, instruments
+);
+
 DECL_C_CPP_TDMA_ENUM(PeriodType, 0, 3,
     BUILD_C_CPP_TDMA_ENUM_NAME(PeriodType, day),
     BUILD_C_CPP_TDMA_ENUM_NAME(PeriodType, month),
@@ -311,6 +323,30 @@ APIGetter_Get_ABI( Getter_C *pgetter,
                    size_t *n,
                    int allow_exceptions );
 
+/*
+ * async get callback - called from the library's I/O thread:
+ *   error_code - 0 on success, otherwise the TDMA_API_ error code
+ *   data       - response (or error msg); ONLY valid during the call
+ *   n          - size of 'data' AND NULL term
+ *   ctx        - whatever was passed to GetAsync
+ */
+typedef void(*get_async_cb_ty)(int, const char*, size_t, void*);
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+APIGetter_GetAsync_ABI( Getter_C *pgetter,
+                        get_async_cb_ty callback,
+                        void *ctx,
+                        unsigned long long *id,
+                        int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+APIGetter_CancelAsync_ABI( unsigned long long id,
+                           int *canceled,
+                           int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+APIGetter_PendingAsync_ABI(size_t *n, int allow_exceptions);
+
 EXTERN_C_SPEC_ DLL_SPEC_ int
 APIGetter_Close_ABI(Getter_C *pgetter, int allow_exceptions);
 
@@ -335,12 +371,53 @@ APIGetter_GetDefWaitMSec_ABI(unsigned long long *msec, int allow_exceptions);
 EXTERN_C_SPEC_ DLL_SPEC_ int
 APIGetter_WaitRemaining_ABI(unsigned long long *msec, int allow_exceptions);
 
+EXTERN_C_SPEC_ DLL_SPEC_ int
+APIGetter_SetBurst_ABI(unsigned int burst, int allow_exceptions);
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+APIGetter_GetBurst_ABI(unsigned int *burst, int allow_exceptions);
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+APIGetter_SetEndpointThrottle_ABI( int endpoint_class,
+                                   unsigned long long msec,
+                                   unsigned int burst,
+                                   int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+APIGetter_GetEndpointThrottle_ABI( int endpoint_class,
+                                   unsigned long long *msec,
+                                   unsigned int *burst,
+                                   int allow_exceptions );
+
 EXTERN_C_SPEC_ DLL_SPEC_ int
 APIGetter_ShareConnections_ABI(int b, int allow_exceptions);
 
 EXTERN_C_SPEC_ DLL_SPEC_ int
 APIGetter_IsSharingConnections_ABI(int *b, int allow_exceptions);
 
+/* shared connections; times in microseconds */
+typedef struct {
+    unsigned long long hits; // got an idle (warm) connection
+    unsigned long long misses; // had to open a new connection
+    unsigned long long waits; // all were in use; had to wait for one
+    unsigned long long wait_usec; // total time waiting
+    unsigned long long max_wait_usec;
+    unsigned long long nhandles; // currently open, idle or in use
+} ConnectionPoolStats;
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+APIGetter_SetConnectionPoolSize_ABI(unsigned int n, int allow_exceptions);
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+APIGetter_GetConnectionPoolSize_ABI(unsigned int *n, int allow_exceptions);
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+APIGetter_GetConnectionPoolStats_ABI( ConnectionPoolStats *stats,
+                                      int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+APIGetter_ResetConnectionPoolStats_ABI(int allow_exceptions);
+
 /* QuoteGetter */
 EXTERN_C_SPEC_ DLL_SPEC_ int
 QuoteGetter_Create_ABI( struct Credentials *pcreds,
@@ -521,6 +598,33 @@ HistoricalGetterBase_SetFrequency_ABI( Getter_C *pgetter,
                                        unsigned int frequency,
                                        int allow_exceptions );
 
+/*
+ * candles decoded into columns (see HistoricalGetterBase_GetCandles_ABI);
+ * the columns and the symbol live in ONE block, free w/
+ * FreeHistoricalCandlesBuffer
+ */
+typedef struct{
+    const char *symbol;
+    int empty;
+    size_t ncandles;
+    const long long *datetime; /* msec since epoch */
+    const double *open;
+    const double *high;
+    const double *low;
+    const double *close;
+    const long long *volume;
+} HistoricalCandles_C;
+
+/* get and decode w/o building a json object */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+HistoricalGetterBase_GetCandles_ABI( Getter_C *pgetter,
+                                     HistoricalCandles_C **pcandles,
+                                     int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+FreeHistoricalCandlesBuffer_ABI( HistoricalCandles_C *candles,
+                                 int allow_exceptions );
+
 /* HistoricalPeriodGetter */
 EXTERN_C_SPEC_ DLL_SPEC_ int
 HistoricalPeriodGetter_Create_ABI(
@@ -608,6 +712,89 @@ HistoricalRangeGetter_SetStartMSecSinceEpoch_ABI(
     int allow_exceptions );
 
 
+/*
+ * option chain decoded straight from the response (see
+ * OptionChainGetter_GetChain_ABI); everything - including the strings
+ * and indices pointed to - lives in ONE block, free w/ FreeOptionChainBuffer
+ */
+typedef struct{
+    const char *symbol;
+    const char *description;
+    const char *exchange_name;
+    const char *expiration_type;
+    int is_put;
+    int in_the_money;
+    int non_standard;
+    int mini;
+    int days_to_expiration;
+    double strike_price;
+    long long expiration_date; /* msec since epoch */
+    long long last_trading_day; /* msec since epoch */
+    double bid;
+    double ask;
+    double last;
+    double mark;
+    long long bid_size;
+    long long ask_size;
+    long long last_size;
+    double high_price;
+    double low_price;
+    double open_price;
+    double close_price;
+    long long total_volume;
+    long long open_interest;
+    long long quote_time; /* msec since epoch */
+    long long trade_time; /* msec since epoch */
+    double net_change;
+    double percent_change;
+    double mark_change;
+    double mark_percent_change;
+    double volatility;
+    double delta;
+    double gamma;
+    double theta;
+    double vega;
+    double rho;
+    double time_value;
+    double theoretical_option_value;
+    double theoretical_volatility;
+    double multiplier;
+    size_t expiration_index; /* into OptionChain_C.expirations */
+    size_t strike_index; /* into OptionChain_C.strikes */
+} OptionContract_C;
+
+typedef struct{
+    const char *date; /* yyyy-MM-dd */
+    int days_to_expiration;
+    const size_t *contracts; /* indices into OptionChain_C.contracts */
+    size_t ncontracts;
+} OptionChainExpiration_C;
+
+typedef struct{
+    double strike_price;
+    const size_t *contracts; /* indices into OptionChain_C.contracts */
+    size_t ncontracts;
+} OptionChainStrike_C;
+
+/*
+ * contracts are ordered by expiration, strike, call/put; expirations and
+ * strikes are ascending
+ */
+typedef struct{
+    const char *symbol;
+    const char *status;
+    int is_delayed;
+    double underlying_price;
+    double interest_rate;
+    double volatility;
+    const OptionContract_C *contracts;
+    size_t ncontracts;
+    const OptionChainExpiration_C *expirations;
+    size_t nexpirations;
+    const OptionChainStrike_C *strikes;
+    size_t nstrikes;
+} OptionChain_C;
+
 /* OptionChainGetter */
 EXTERN_C_SPEC_ DLL_SPEC_ int
 OptionChainGetter_Create_ABI( struct Credentials *pcreds,
@@ -712,6 +899,18 @@ OptionChainGetter_SetOptionType_ABI( OptionChainGetter_C *pgetter,
                                      int option_type,
                                      int allow_exceptions );
 
+/*
+ * get and decode w/o building a json object; free w/ FreeOptionChainBuffer.
+ * Strategy getters (legs, not contracts) return TDMA_API_VALUE_ERROR.
+ */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+OptionChainGetter_GetChain_ABI( OptionChainGetter_C *pgetter,
+                                OptionChain_C **pchain,
+                                int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+FreeOptionChainBuffer_ABI( OptionChain_C *chain, int allow_exceptions );
+
 /* OptionChainStrategyGetter */
 EXTERN_C_SPEC_ DLL_SPEC_ int
 OptionChainStrategyGetter_Create_ABI( struct Credentials *pcreds,
@@ -1202,6 +1401,27 @@ static inline int
 APIGetter_Get(Getter_C *pgetter, char** buf, size_t *n)
 { return APIGetter_Get_ABI(pgetter, buf, n, 0); }
 
+/*
+ * returns immediately; 'callback' is called w/ the result from another thread
+ * (possibly before this returns). The getter can be destroyed/changed once
+ * this returns but the credentials can't.
+ */
+static inline int
+APIGetter_GetAsync( Getter_C *pgetter,
+                    get_async_cb_ty callback,
+                    void *ctx,
+                    unsigned long long *id )
+{ return APIGetter_GetAsync_ABI(pgetter, callback, ctx, id, 0); }
+
+/* 'canceled' is 1 if still pending; callback gets an error instead */
+static inline int
+APIGetter_CancelAsync(unsigned long long id, int *canceled)
+{ return APIGetter_CancelAsync_ABI(id, canceled, 0); }
+
+static inline int
+APIGetter_PendingAsync(size_t *n)
+{ return APIGetter_PendingAsync_ABI(n, 0); }
+
 static inline int
 APIGetter_Close(Getter_C *pgetter)
 { return APIGetter_Close_ABI(pgetter, 0); }
@@ -1234,6 +1454,26 @@ static inline int
 APIGetter_WaitRemaining(unsigned long long *msec)
 { return APIGetter_WaitRemaining_ABI(msec, 0); }
 
+static inline int
+APIGetter_SetBurst(unsigned int burst)
+{ return APIGetter_SetBurst_ABI(burst, 0); }
+
+static inline int
+APIGetter_GetBurst(unsigned int *burst)
+{ return APIGetter_GetBurst_ABI(burst, 0); }
+
+static inline int
+APIGetter_SetEndpointThrottle( EndpointClass endpoint_class,
+                               unsigned long long msec,
+                               unsigned int burst )
+{ return APIGetter_SetEndpointThrottle_ABI((int)endpoint_class, msec, burst, 0); }
+
+static inline int
+APIGetter_GetEndpointThrottle( EndpointClass endpoint_class,
+                               unsigned long long *msec,
+                               unsigned int *burst )
+{ return APIGetter_GetEndpointThrottle_ABI((int)endpoint_class, msec, burst, 0); }
+
 static inline int
 APIGetter_ShareConnections(int share)
 { return APIGetter_ShareConnections_ABI(share, 0); }
@@ -1242,6 +1482,22 @@ static inline int
 APIGetter_IsSharingConnections(int *share)
 { return APIGetter_IsSharingConnections(share, 0); }
 
+static inline int
+APIGetter_SetConnectionPoolSize(unsigned int n)
+{ return APIGetter_SetConnectionPoolSize_ABI(n, 0); }
+
+static inline int
+APIGetter_GetConnectionPoolSize(unsigned int *n)
+{ return APIGetter_GetConnectionPoolSize_ABI(n, 0); }
+
+static inline int
+APIGetter_GetConnectionPoolStats(ConnectionPoolStats *stats)
+{ return APIGetter_GetConnectionPoolStats_ABI(stats, 0); }
+
+static inline int
+APIGetter_ResetConnectionPoolStats()
+{ return APIGetter_ResetConnectionPoolStats_ABI(0); }
+
 /* declare derived versions of Get, Close, IsClosed for each getter*/
 #define DECL_WRAPPED_API_GETTER_BASE_FUNCS(name) \
 static inline int \
@@ -1249,6 +1505,13 @@ name##_Get(name##_C *pgetter, char** buf, size_t *n) \
 { return APIGetter_Get_ABI( (Getter_C*)pgetter, buf, n, 0); } \
 \
 static inline int \
+name##_GetAsync( name##_C *pgetter, \
+                 get_async_cb_ty callback, \
+                 void *ctx, \
+                 unsigned long long *id ) \
+{ return APIGetter_GetAsync_ABI( (Getter_C*)pgetter, callback, ctx, id, 0); } \
+\
+static inline int \
 name##_Close(name##_C *pgetter) \
 { return APIGetter_Close_ABI( (Getter_C*)pgetter, 0); } \
 \
@@ -1526,6 +1789,12 @@ HistoricalPeriodGetter_SetFrequency( HistoricalPeriodGetter_C *pgetter,
                                                 (int)frequency_type,
                                                 frequency, 0); }
 
+static inline int
+HistoricalPeriodGetter_GetCandles( HistoricalPeriodGetter_C *pgetter,
+                                   HistoricalCandles_C **pcandles )
+{ return HistoricalGetterBase_GetCandles_ABI( (Getter_C*)pgetter,
+                                              pcandles, 0); }
+
 static inline int
 HistoricalPeriodGetter_SetMSecSinceEpoch( HistoricalPeriodGetter_C *pgetter,
                                           long long msec_since_epoch )
@@ -1644,6 +1913,16 @@ HistoricalRangeGetter_SetFrequency( HistoricalRangeGetter_C *pgetter,
                                                 (int)frequency_type,
                                                 frequency, 0); }
 
+static inline int
+HistoricalRangeGetter_GetCandles( HistoricalRangeGetter_C *pgetter,
+                                  HistoricalCandles_C **pcandles )
+{ return HistoricalGetterBase_GetCandles_ABI( (Getter_C*)pgetter,
+                                              pcandles, 0); }
+
+static inline int
+FreeHistoricalCandlesBuffer( HistoricalCandles_C *candles )
+{ return FreeHistoricalCandlesBuffer_ABI(candles, 0); }
+
 static inline int
 GetHistoricalRange( struct Credentials *pcreds,
                     const char* symbol,
@@ -1770,7 +2049,16 @@ name##_GetOptionType(name##_C *pgetter, OptionType *option_type) \
 static inline int \
 name##_SetOptionType(name##_C *pgetter, OptionType option_type) \
 { return OptionChainGetter_SetOptionType_ABI( (OptionChainGetter_C*)pgetter, \
-                                               (int)option_type, 0); }
+                                               (int)option_type, 0); } \
+\
+static inline int \
+name##_GetChain(name##_C *pgetter, OptionChain_C **pchain) \
+{ return OptionChainGetter_GetChain_ABI( (OptionChainGetter_C*)pgetter, \
+                                          pchain, 0); }
+
+static inline int
+FreeOptionChainBuffer( OptionChain_C *chain )
+{ return FreeOptionChainBuffer_ABI(chain, 0); }
 
 DECL_WRAPPED_API_GETTER_BASE_FUNCS(OptionChainGetter)
 DECL_WRAPPED_OPTION_GETTER_BASE_FUNCS(OptionChainGetter)
@@ -2509,6 +2797,26 @@ public:
 private:
     std::unique_ptr<CType, CProxyDestroyer<CType>> _cgetter;
 
+    /* GetAsync callback; 'ctx' is the heap-allocated async_callback_type */
+    static void
+    _async_callback(int err, const char *data, size_t n, void *ctx)
+    {
+        std::unique_ptr<std::function<void(json, std::exception_ptr)>> cb(
+            reinterpret_cast<std::function<void(json, std::exception_ptr)>*>(ctx)
+            );
+        json j;
+        std::exception_ptr e;
+        try{
+            if( err )
+                throw_error_code(err, (data ? data : ""), 0, "");
+            if( n > 1 )
+                j = json::parse(data, data + n - 1);
+        }catch(...){
+            e = std::current_exception();
+        }
+        (*cb)( std::move(j), e );
+    }
+
 protected:
     template<typename CTy=CType>
     CTy*
@@ -2587,6 +2895,40 @@ public:
         return std::chrono::milliseconds(w);
     }
 
+    /* # of requests that can start at once before 'wait_msec' applies */
+    static unsigned int
+    get_burst()
+    {
+        unsigned int b;
+        call_abi( APIGetter_GetBurst_ABI, &b );
+        return b;
+    }
+
+    static void
+    set_burst(unsigned int burst)
+    { call_abi( APIGetter_SetBurst_ABI, burst ); }
+
+    /* additional limit for one class of getter; 0 msec for none (default) */
+    static std::pair<std::chrono::milliseconds, unsigned int>
+    get_endpoint_throttle(EndpointClass endpoint_class)
+    {
+        unsigned long long w;
+        unsigned int b;
+        call_abi( APIGetter_GetEndpointThrottle_ABI,
+                  static_cast<int>(endpoint_class), &w, &b );
+        return std::make_pair(std::chrono::milliseconds(w), b);
+    }
+
+    static void
+    set_endpoint_throttle( EndpointClass endpoint_class,
+                           std::chrono::milliseconds msec,
+                           unsigned int burst = 1 )
+    {
+        call_abi( APIGetter_SetEndpointThrottle_ABI,
+                  static_cast<int>(endpoint_class),
+                  static_cast<unsigned long long>(msec.count()), burst );
+    }
+
     static void
     share_connections(bool share)
     {
@@ -2601,16 +2943,93 @@ public:
         return static_cast<bool>(b);
     }
 
+    /* max # of connections per host when sharing (idle ones stay open) */
+    static void
+    set_connection_pool_size(unsigned int n)
+    { call_abi( APIGetter_SetConnectionPoolSize_ABI, n ); }
+
+    static unsigned int
+    get_connection_pool_size()
+    {
+        unsigned int n;
+        call_abi( APIGetter_GetConnectionPoolSize_ABI, &n );
+        return n;
+    }
+
+    static ConnectionPoolStats
+    get_connection_pool_stats()
+    {
+        ConnectionPoolStats s;
+        call_abi( APIGetter_GetConnectionPoolStats_ABI, &s );
+        return s;
+    }
+
+    static void
+    reset_connection_pool_stats()
+    { call_abi( APIGetter_ResetConnectionPoolStats_ABI ); }
+
     json
     get() const
     {
         char *buf;
         size_t n;
         call_abi( APIGetter_Get_ABI, _cgetter.get(), &buf, &n );
-        json j = (n > 1) ? json::parse(std::string(buf)) : json();
-        if(buf)
-            free(buf);
-        return j;
+        /* parse in place; 'buf' is the body curl wrote into */
+        std::unique_ptr<char, void(*)(void*)> _(buf, free);
+        return (n > 1) ? json::parse(buf, buf + n - 1) : json();
+    }
+
+    typedef std::function<void(json, std::exception_ptr)> async_callback_type;
+
+    /*
+     * returns immediately; 'callback' is called from the library's I/O
+     * thread w/ the result OR the exception (json will be null). Goes
+     * through the same throttling as get(). Returns an id for cancel_async.
+     */
+    unsigned long long
+    get_async(async_callback_type callback) const
+    {
+        unsigned long long id;
+        auto *ctx = new async_callback_type( std::move(callback) );
+        try{
+            call_abi( APIGetter_GetAsync_ABI, _cgetter.get(),
+                      &APIGetter::_async_callback, static_cast<void*>(ctx),
+                      &id );
+        }catch(...){
+            delete ctx;
+            throw;
+        }
+        return id;
+    }
+
+    std::future<json>
+    get_async() const
+    {
+        auto p = std::make_shared<std::promise<json>>();
+        get_async( [p](json j, std::exception_ptr e){
+            if( e )
+                p->set_exception(e);
+            else
+                p->set_value( std::move(j) );
+        });
+        return p->get_future();
+    }
+
+    /* true if it hadn't finished (its callback gets an exception) */
+    static bool
+    cancel_async(unsigned long long id)
+    {
+        int b;
+        call_abi( APIGetter_CancelAsync_ABI, id, &b );
+        return static_cast<bool>(b);
+    }
+
+    static size_t
+    pending_async()
+    {
+        size_t n;
+        call_abi( APIGetter_PendingAsync_ABI, &n );
+        return n;
     }
 
     void
@@ -2851,6 +3270,63 @@ public:
 };
 
 
+/* owns the block returned by HistoricalGetterBase::get_candles */
+class HistoricalCandles{
+    std::shared_ptr<HistoricalCandles_C> _candles;
+
+public:
+    explicit HistoricalCandles(HistoricalCandles_C *candles)
+        :
+            _candles( candles,
+                      [](HistoricalCandles_C *c){
+                          FreeHistoricalCandlesBuffer_ABI(c, 0);
+                      } )
+        {
+        }
+
+    const HistoricalCandles_C&
+    raw() const
+    { return *_candles; }
+
+    std::string
+    symbol() const
+    { return _candles->symbol; }
+
+    size_t
+    size() const
+    { return _candles->ncandles; }
+
+    bool
+    empty() const
+    { return _candles->ncandles == 0; }
+
+    /* columns, oldest first; each has size() elements */
+    const long long*
+    datetime() const
+    { return _candles->datetime; }
+
+    const double*
+    open() const
+    { return _candles->open; }
+
+    const double*
+    high() const
+    { return _candles->high; }
+
+    const double*
+    low() const
+    { return _candles->low; }
+
+    const double*
+    close() const
+    { return _candles->close; }
+
+    const long long*
+    volume() const
+    { return _candles->volume; }
+};
+
+
 class HistoricalGetterBase
         : public APIGetter {
 protected:
@@ -2922,6 +3398,14 @@ public:
                   static_cast<int>(extended_hours) );
     }
 
+    /* typed alternative to get(); no json object is built */
+    HistoricalCandles
+    get_candles() const
+    {
+        HistoricalCandles_C *candles;
+        call_abi( HistoricalGetterBase_GetCandles_ABI, cgetter<>(), &candles );
+        return HistoricalCandles(candles);
+    }
 
 };
 
@@ -3258,6 +3742,101 @@ operator<<(std::ostream& out, const OptionStrategy& strategy)
 }
 
 
+/* owns the block returned by OptionChainGetter::get_chain */
+class OptionChain{
+    std::shared_ptr<OptionChain_C> _chain;
+
+public:
+    explicit OptionChain(OptionChain_C *chain)
+        :
+            _chain( chain,
+                    [](OptionChain_C *c){ FreeOptionChainBuffer_ABI(c, 0); } )
+        {
+        }
+
+    typedef const OptionContract_C* const_iterator;
+
+    const OptionChain_C&
+    raw() const
+    { return *_chain; }
+
+    std::string
+    symbol() const
+    { return _chain->symbol; }
+
+    std::string
+    status() const
+    { return _chain->status; }
+
+    double
+    underlying_price() const
+    { return _chain->underlying_price; }
+
+    size_t
+    size() const
+    { return _chain->ncontracts; }
+
+    bool
+    empty() const
+    { return _chain->ncontracts == 0; }
+
+    const OptionContract_C&
+    operator[](size_t i) const
+    { return _chain->contracts[i]; }
+
+    const_iterator
+    begin() const
+    { return _chain->contracts; }
+
+    const_iterator
+    end() const
+    { return _chain->contracts + _chain->ncontracts; }
+
+    size_t
+    nexpirations() const
+    { return _chain->nexpirations; }
+
+    const OptionChainExpiration_C&
+    expiration(size_t i) const
+    { return _chain->expirations[i]; }
+
+    size_t
+    nstrikes() const
+    { return _chain->nstrikes; }
+
+    const OptionChainStrike_C&
+    strike(size_t i) const
+    { return _chain->strikes[i]; }
+
+    /* nullptr if 'date' (yyyy-MM-dd) isn't in the chain */
+    const OptionChainExpiration_C*
+    find_expiration(const std::string& date) const
+    {
+        const OptionChainExpiration_C *b = _chain->expirations;
+        const OptionChainExpiration_C *e = b + _chain->nexpirations;
+        auto iter = std::lower_bound( b, e, date,
+            [](const OptionChainExpiration_C& exp, const std::string& d){
+                return d.compare(exp.date) > 0;
+            });
+        return (iter != e && date == iter->date) ? iter : nullptr;
+    }
+
+    /* nullptr if 'strike_price' isn't in the chain */
+    const OptionChainStrike_C*
+    find_strike(double strike_price) const
+    {
+        const OptionChainStrike_C *b = _chain->strikes;
+        const OptionChainStrike_C *e = b + _chain->nstrikes;
+        auto iter = std::lower_bound( b, e, strike_price,
+            [](const OptionChainStrike_C& s, double p){
+                return s.strike_price < p;
+            });
+        return (iter != e && iter->strike_price == strike_price) ? iter
+                                                                  : nullptr;
+    }
+};
+
+
 class OptionChainGetter
         : public APIGetter {
 protected:
@@ -3416,6 +3995,18 @@ public:
         call_abi( OptionChainGetter_SetOptionType_ABI, cgetter<CType>(),
                   static_cast<int>(option_type) );
     }
+
+    /*
+     * typed alternative to get(); no json object is built. Throws
+     * ValueException for OptionChainStrategyGetter (legs, not contracts)
+     */
+    OptionChain
+    get_chain() const
+    {
+        OptionChain_C *chain;
+        call_abi( OptionChainGetter_GetChain_ABI, cgetter<CType>(), &chain );
+        return OptionChain(chain);
+    }
 };
 
 
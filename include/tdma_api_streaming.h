@@ -28,6 +28,9 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <thread>
 #include <string>
 #include <deque>
+#include <vector>
+#include <future>
+#include <atomic>
 
 //#include "websocket_connect.h"
 //#include "threadsafe_hashmap.h"
@@ -401,16 +404,51 @@ DECL_C_CPP_TDMA_ENUM(TimesaleSubscriptionField, 0, 5,
     BUILD_C_CPP_TDMA_ENUM_NAME(TimesaleSubscriptionField, last_sequence)
     );
 
-DECL_C_CPP_TDMA_ENUM(StreamingCallbackType, 0, 6,
+DECL_C_CPP_TDMA_ENUM(StreamingCallbackType, 0, 7,
     BUILD_C_CPP_TDMA_ENUM_NAME(StreamingCallbackType, listening_start),
     BUILD_C_CPP_TDMA_ENUM_NAME(StreamingCallbackType, listening_stop),
     BUILD_C_CPP_TDMA_ENUM_NAME(StreamingCallbackType, data),
     BUILD_C_CPP_TDMA_ENUM_NAME(StreamingCallbackType, request_response),
     BUILD_C_CPP_TDMA_ENUM_NAME(StreamingCallbackType, notify),
     BUILD_C_CPP_TDMA_ENUM_NAME(StreamingCallbackType, timeout),
-    BUILD_C_CPP_TDMA_ENUM_NAME(StreamingCallbackType, error)
+    BUILD_C_CPP_TDMA_ENUM_NAME(StreamingCallbackType, error),
+    BUILD_C_CPP_TDMA_ENUM_NAME(StreamingCallbackType, reconnected)
     );
 
+DECL_C_CPP_TDMA_ENUM(StreamingOverflowPolicy, 0, 2,
+    BUILD_C_CPP_TDMA_ENUM_NAME(StreamingOverflowPolicy, block),
+    BUILD_C_CPP_TDMA_ENUM_NAME(StreamingOverflowPolicy, drop_oldest),
+    BUILD_C_CPP_TDMA_ENUM_NAME(StreamingOverflowPolicy, conflate)
+    );
+
+DECL_C_CPP_TDMA_ENUM(StreamingFieldValueType, 0, 4,
+    BUILD_C_CPP_TDMA_ENUM_NAME(StreamingFieldValueType, none),
+    BUILD_C_CPP_TDMA_ENUM_NAME(StreamingFieldValueType, integer),
+    BUILD_C_CPP_TDMA_ENUM_NAME(StreamingFieldValueType, real),
+    BUILD_C_CPP_TDMA_ENUM_NAME(StreamingFieldValueType, boolean),
+    BUILD_C_CPP_TDMA_ENUM_NAME(StreamingFieldValueType, text)
+    );
+
+/* ACCT_ACTIVITY message types (field 2) */
+#define BUILD_ENUM_NAME(n) \
+    BUILD_C_CPP_TDMA_ENUM_NAME(OrderEventType, n)
+DECL_C_CPP_TDMA_ENUM(OrderEventType, 0, 12,
+    BUILD_ENUM_NAME(none), /* SUBSCRIBED, ERROR, not an order message */
+    BUILD_ENUM_NAME(entry), /* OrderEntryRequest */
+    BUILD_ENUM_NAME(activation), /* OrderActivation */
+    BUILD_ENUM_NAME(partial_fill), /* OrderPartialFill */
+    BUILD_ENUM_NAME(fill), /* OrderFill */
+    BUILD_ENUM_NAME(cancel_request), /* OrderCancelRequest */
+    BUILD_ENUM_NAME(canceled), /* UROUT */
+    BUILD_ENUM_NAME(replace_request), /* OrderCancelReplaceRequest */
+    BUILD_ENUM_NAME(rejection), /* OrderRejection */
+    BUILD_ENUM_NAME(too_late_to_cancel), /* TooLateToCancel */
+    BUILD_ENUM_NAME(broken_trade), /* BrokenTrade */
+    BUILD_ENUM_NAME(manual_execution), /* ManualExecution */
+    BUILD_ENUM_NAME(other) /* an order message we don't know */
+    );
+#undef BUILD_ENUM_NAME
+
 
 
 static const int SUBSCRIPTION_MAX_FIELDS = 100;
@@ -2032,10 +2070,195 @@ public:
 #define STREAMING_DEF_LISTENING_TIMEOUT 30000
 #define STREAMING_DEF_SUBSCRIBE_TIMEOUT 1500
 #define STREAMING_MAX_SUBSCRIPTIONS 50
+#define STREAMING_MAX_DISPATCH_THREADS 64
+#define STREAMING_MIN_HIGH_WATER_MARK 16
+#define STREAMING_MAX_HIGH_WATER_MARK 1048576
+#define STREAMING_DEF_HIGH_WATER_MARK 8192
+#define STREAMING_DEF_SUBSCRIPTION_WINDOW 50
+#define STREAMING_MAX_SUBSCRIPTION_WINDOW 10000
+#define STREAMING_RECONNECT_MIN_BACKOFF 500
+#define STREAMING_RECONNECT_MAX_BACKOFF 30000
+#define STREAMING_RECONNECT_MAX_ATTEMPTS 10
+#define STREAMING_NO_RESPONSE_CODE -1
+#define STREAMING_REPLAY_UNPACED 0.0
 
 
 typedef void(*streaming_cb_ty)(int, int, unsigned long long, const char*);
 
+/*
+ * pre-parsed 'data' records passed to the typed callback; pointers are
+ * only valid until the callback returns
+ */
+typedef struct{
+    int field; /* numeric field id, i.e the service's FieldType value */
+    int value_type; /* StreamingFieldValueType */
+    long long ival; /* integer, boolean */
+    double dval; /* real, integer */
+    const char *sval; /* text */
+} StreamingField_C;
+
+/*
+ * per-service views of a record (StreamingRecord_C::typed), members in
+ * FieldType order; fields not sent are 0/NULL. Bit N of 'fields_set' is set
+ * if field N was sent - QUOTE records are deltas. 'symbol' is filled from the
+ * record's key.
+ */
+typedef struct{
+    unsigned long long fields_set;
+    const char *symbol;
+    double bid_price;
+    double ask_price;
+    double last_price;
+    long long bid_size;
+    long long ask_size;
+    const char *ask_id;
+    const char *bid_id;
+    long long total_volume;
+    long long last_size;
+    long long trade_time;
+    long long quote_time;
+    double high_price;
+    double low_price;
+    const char *bid_tick;
+    double close_price;
+    const char *exchange_id;
+    int marginable;
+    int shortable;
+    double island_bid;
+    double island_ask;
+    long long island_volume;
+    long long quote_day;
+    long long trade_day;
+    double volatility;
+    const char *description;
+    const char *last_id;
+    long long digits;
+    double open_price;
+    double net_change;
+    double high_52_week;
+    double low_52_week;
+    double pe_ratio;
+    double dividend_amount;
+    double dividend_yield;
+    long long island_bid_size;
+    long long island_ask_size;
+    double nav;
+    double fund_price;
+    const char *exchange_name;
+    const char *dividend_date;
+    int regular_market_quote;
+    int regular_market_trade;
+    double regular_market_last_price;
+    long long regular_market_last_size;
+    long long regular_market_trade_time;
+    long long regular_market_trade_day;
+    double regular_market_net_change;
+    const char *security_status;
+    double mark;
+    long long quote_time_as_long;
+    long long trade_time_as_long;
+    long long regular_market_trade_time_as_long;
+} StreamingQuote_C;
+
+/* TIMESALE_EQUITY, TIMESALE_FUTURES, TIMESALE_OPTIONS */
+typedef struct{
+    unsigned long long fields_set;
+    const char *symbol;
+    long long trade_time;
+    double last_price;
+    long long last_size;
+    long long last_sequence;
+} StreamingTimesale_C;
+
+typedef struct{
+    unsigned long long fields_set;
+    const char *symbol;
+    double open_price;
+    double high_price;
+    double low_price;
+    double close_price;
+    long long volume;
+    long long sequence;
+    long long chart_time;
+    long long chart_day;
+} StreamingChartEquity_C;
+
+/* CHART_FUTURES, CHART_OPTIONS */
+typedef struct{
+    unsigned long long fields_set;
+    const char *symbol;
+    long long chart_time;
+    double open_price;
+    double high_price;
+    double low_price;
+    double close_price;
+    long long volume;
+} StreamingChart_C;
+
+typedef struct{
+    const char *key; /* symbol/key or NULL */
+    long long seq; /* sequence number or -1 */
+    const StreamingField_C *fields;
+    size_t nfields;
+    /*
+     * StreamingQuote_C, StreamingTimesale_C, StreamingChartEquity_C or
+     * StreamingChart_C, by service; NULL for other services
+     */
+    const void *typed;
+} StreamingRecord_C;
+
+/* inbound queue counters, cumulative over the life of the session */
+typedef struct{
+    unsigned long long max_depth; /* most frames queued at once */
+    unsigned long long blocked; /* 'block': times the socket had to wait */
+    unsigned long long dropped; /* 'drop_oldest': frames discarded */
+    unsigned long long conflated; /* 'conflate': QUOTE records merged away */
+} StreamingOverflowStats_C;
+
+/* (StreamerServiceType, timestamp, records, nrecords) */
+typedef void(*streaming_typed_cb_ty)( int, unsigned long long,
+                                      const StreamingRecord_C*, size_t );
+
+#define ORDER_EVENT_ID_SIZE 32
+#define ORDER_EVENT_SYMBOL_SIZE 64
+
+#define ORDER_CACHE_SYNC_DEF_RESYNC_MSEC 60000
+#define ORDER_CACHE_SYNC_DEF_LOOKBACK_DAYS 7
+#define ORDER_CACHE_SYNC_MAX_LOOKBACK_DAYS 60
+#define ORDER_CACHE_SYNC_MAX_RESULTS 1000
+
+/* one decoded ACCT_ACTIVITY message; strings are truncated to fit */
+typedef struct{
+    int type; /* OrderEventType */
+    char account_id[ORDER_EVENT_ID_SIZE];
+    char order_id[ORDER_EVENT_ID_SIZE];
+    char original_order_id[ORDER_EVENT_ID_SIZE]; /* replace requests */
+    char symbol[ORDER_EVENT_SYMBOL_SIZE];
+    char timestamp[ORDER_EVENT_ID_SIZE]; /* ActivityTimestamp, as sent */
+    double quantity; /* fills: executed, cancels: canceled, else ordered */
+    double price; /* fills: execution price, else limit price (0 if none) */
+    double leaves_quantity; /* fills: left after this one, else -1 */
+    double order_quantity; /* OriginalQuantity */
+} OrderEvent_C;
+
+/* what the order cache knows about one order */
+typedef struct{
+    char order_id[ORDER_EVENT_ID_SIZE];
+    char symbol[ORDER_EVENT_SYMBOL_SIZE];
+    int status; /* OrderStatusType (tdma_api_get.h) */
+    int last_event; /* OrderEventType */
+    double quantity; /* ordered */
+    double filled_quantity;
+    double remaining_quantity;
+    double average_fill_price;
+    double last_fill_price;
+    double price; /* limit, 0 if none */
+    unsigned long long seq; /* cache sequence # of the last change */
+} OrderState_C;
+
+/* (event, state after the event or NULL if the cache is off) */
+typedef void(*order_event_cb_ty)( const OrderEvent_C*, const OrderState_C* );
+
 EXTERN_C_SPEC_ DLL_SPEC_ int
 StreamingSession_Create_ABI( struct Credentials *pcreds,
                              streaming_cb_ty callback,
@@ -2066,6 +2289,28 @@ StreamingSession_AddSubscriptions_ABI( StreamingSession_C *psession,
                                        int *results_buffer,
                                        int allow_exceptions );
 
+/*
+ * async request callback - called from the listener thread:
+ *   index - position of the subscription in the 'subs' passed
+ *   code  - server response code (0 is success) or
+ *           STREAMING_NO_RESPONSE_CODE if the session stopped/reconnected
+ *           before a response came back
+ *   msg   - response message; ONLY valid during the call
+ *   ctx   - whatever was passed to the *Async call
+ *
+ * called once for each request; never called if the *Async call fails
+ */
+typedef void(*streaming_request_cb_ty)(size_t, int, const char*, void*);
+
+/* all 'subs' are sent in one message; doesn't wait for responses */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_AddSubscriptionsAsync_ABI( StreamingSession_C *psession,
+                                            StreamingSubscription_C **subs,
+                                            size_t nsubs,
+                                            streaming_request_cb_ty callback,
+                                            void *ctx,
+                                            int allow_exceptions );
+
 EXTERN_C_SPEC_ DLL_SPEC_ int
 StreamingSession_Stop_ABI( StreamingSession_C *psession,
                            int allow_exceptions );
@@ -2081,11 +2326,240 @@ StreamingSession_SetQOS_ABI( StreamingSession_C *psession,
                              int *result,
                              int allow_exceptions );
 
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_SetQOSAsync_ABI( StreamingSession_C *psession,
+                                  int qos,
+                                  streaming_request_cb_ty callback,
+                                  void *ctx,
+                                  int allow_exceptions );
+
 EXTERN_C_SPEC_ DLL_SPEC_ int
 StreamingSession_GetQOS_ABI( StreamingSession_C *psession,
                              int *qos,
                              int allow_exceptions );
 
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_SetTypedCallback_ABI( StreamingSession_C *psession,
+                                       streaming_typed_cb_ty callback,
+                                       int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_SetOverflowPolicy_ABI( StreamingSession_C *psession,
+                                        size_t high_water_mark,
+                                        int policy,
+                                        int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_GetOverflowPolicy_ABI( StreamingSession_C *psession,
+                                        size_t *high_water_mark,
+                                        int *policy,
+                                        int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_GetOverflowStats_ABI( StreamingSession_C *psession,
+                                       StreamingOverflowStats_C *stats,
+                                       int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_SetQuoteBookEnabled_ABI( StreamingSession_C *psession,
+                                          int enabled,
+                                          int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_IsQuoteBookEnabled_ABI( StreamingSession_C *psession,
+                                         int *enabled,
+                                         int allow_exceptions );
+
+/* 'records' is ONE block, free w/ FreeStreamingRecordsBuffer_ABI */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_GetQuoteBook_ABI( StreamingSession_C *psession,
+                                   int service,
+                                   const char *symbol,
+                                   unsigned long long since_seq,
+                                   StreamingRecord_C **records,
+                                   size_t *nrecords,
+                                   unsigned long long *seq,
+                                   int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+FreeStreamingRecordsBuffer_ABI( StreamingRecord_C *records,
+                                int allow_exceptions );
+
+/*
+ * decode one ACCT_ACTIVITY record: 'message_type' is field 2 and
+ * 'message_data' the XML in field 3; event->type is 'none' if it isn't an
+ * order message
+ */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+DecodeAcctActivity_ABI( const char *message_type,
+                        const char *message_data,
+                        OrderEvent_C *event,
+                        int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_SetOrderCacheEnabled_ABI( StreamingSession_C *psession,
+                                           int enabled,
+                                           int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_IsOrderCacheEnabled_ABI( StreamingSession_C *psession,
+                                          int *enabled,
+                                          int allow_exceptions );
+
+/* called on the listener thread for each decoded ACCT_ACTIVITY message */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_SetOrderEventCallback_ABI( StreamingSession_C *psession,
+                                            order_event_cb_ty callback,
+                                            int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_GetOrderState_ABI( StreamingSession_C *psession,
+                                    const char *order_id,
+                                    OrderState_C *state,
+                                    int *found,
+                                    int allow_exceptions );
+
+/* orders changed after 'since_seq' (0 for all), free w/ FreeOrderStatesBuffer */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_GetOrderStates_ABI( StreamingSession_C *psession,
+                                     unsigned long long since_seq,
+                                     OrderState_C **states,
+                                     size_t *n,
+                                     unsigned long long *seq,
+                                     int allow_exceptions );
+
+/*
+ * seed the order cache (enabling it) w/ ONE OrdersGetter call for orders
+ * entered in the last 'lookback_days' of 'account_id' (NULL/empty for the
+ * session's) then resync every 'resync_msec' (0 for never) in the
+ * background; the sync keeps its own copy of 'pcreds'
+ */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_StartOrderCacheSync_ABI( StreamingSession_C *psession,
+                                          struct Credentials *pcreds,
+                                          const char *account_id,
+                                          unsigned long resync_msec,
+                                          unsigned int lookback_days,
+                                          int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_StopOrderCacheSync_ABI( StreamingSession_C *psession,
+                                         int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_IsOrderCacheSyncing_ABI( StreamingSession_C *psession,
+                                          int *syncing,
+                                          int allow_exceptions );
+
+/* orders still open (all, or of 'symbol' if not NULL) */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_GetOpenOrders_ABI( StreamingSession_C *psession,
+                                    const char *symbol,
+                                    OrderState_C **states,
+                                    size_t *n,
+                                    int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+FreeOrderStatesBuffer_ABI( OrderState_C *states, int allow_exceptions );
+
+/*
+ * sessions created after this connect to 'url' (e.g "ws://127.0.0.1:8080/ws")
+ * instead of the one from UserPrincipals; empty string to remove
+ */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+SetStreamerURLOverride_ABI( const char *url, int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_SetDispatchThreads_ABI( StreamingSession_C *psession,
+                                         unsigned int nthreads,
+                                         int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_GetDispatchThreads_ABI( StreamingSession_C *psession,
+                                         unsigned int *nthreads,
+                                         int allow_exceptions );
+
+/*
+ * Managed subscriptions: the session tracks the symbols/fields it has sent
+ * per service; Subscribe/Unsubscribe change what's wanted and, after the
+ * subscription window, the session sends only the difference (ADD, UNSUBS,
+ * VIEW or SUBS) for everything that changed in the window in ONE message.
+ */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_Subscribe_ABI( StreamingSession_C *psession,
+                                StreamingSubscription_C *sub,
+                                int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_Unsubscribe_ABI( StreamingSession_C *psession,
+                                  StreamingSubscription_C *sub,
+                                  int allow_exceptions );
+
+/* send pending changes now and wait for the responses */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_FlushSubscriptions_ABI( StreamingSession_C *psession,
+                                         int *result,
+                                         int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_GetSubscribedSymbols_ABI( StreamingSession_C *psession,
+                                           int service,
+                                           char ***buffers,
+                                           size_t *n,
+                                           int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_SetSubscriptionWindow_ABI( StreamingSession_C *psession,
+                                            unsigned long msec,
+                                            int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_GetSubscriptionWindow_ABI( StreamingSession_C *psession,
+                                            unsigned long *msec,
+                                            int allow_exceptions );
+
+/*
+ * reconnect (w/ backoff), login and replay subscriptions/QOS instead of
+ * stopping on a timeout or error; 'reconnected' callback w/ the gap
+ */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_SetAutoReconnect_ABI( StreamingSession_C *psession,
+                                       int enabled,
+                                       int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_IsAutoReconnect_ABI( StreamingSession_C *psession,
+                                      int *enabled,
+                                      int allow_exceptions );
+
+/*
+ * session that plays a capture file instead of connecting; 'speed' scales
+ * the recorded gaps between frames (1.0 is real-time), or
+ * STREAMING_REPLAY_UNPACED to go as fast as possible
+ */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_CreateReplay_ABI( const char *path,
+                                   double speed,
+                                   streaming_cb_ty callback,
+                                   unsigned long listening_timeout,
+                                   StreamingSession_C *psession,
+                                   int allow_exceptions );
+
+/* write every raw inbound frame (w/ a monotonic timestamp) to 'path' */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_StartCapture_ABI( StreamingSession_C *psession,
+                                   const char *path,
+                                   int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_StopCapture_ABI( StreamingSession_C *psession,
+                                  int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+StreamingSession_IsCapturing_ABI( StreamingSession_C *psession,
+                                  int *capturing,
+                                  int allow_exceptions );
+
 #ifndef __cplusplus
 
 /* C Interface */
@@ -2116,6 +2590,17 @@ StreamingSession_CreateEx( struct Credentials *pcreds,
                                        subscribe_timeout, psession, 0);
 }
 
+static inline int
+StreamingSession_CreateReplay( const char *path,
+                               double speed,
+                               streaming_cb_ty callback,
+                               StreamingSession_C *psession )
+{
+    return StreamingSession_CreateReplay_ABI(path, speed, callback,
+                                             STREAMING_DEF_LISTENING_TIMEOUT,
+                                             psession, 0);
+}
+
 static inline int
 StreamingSession_Destroy( StreamingSession_C *psession )
 { return StreamingSession_Destroy_ABI(psession, 0); }
@@ -2137,6 +2622,15 @@ StreamingSession_AddSubscriptions( StreamingSession_C *psession,
 { return StreamingSession_AddSubscriptions_ABI(psession, subs, nsubs,
                                                results_buffer, 0); }
 
+static inline int
+StreamingSession_AddSubscriptionsAsync( StreamingSession_C *psession,
+                                        StreamingSubscription_C **subs,
+                                        size_t nsubs,
+                                        streaming_request_cb_ty callback,
+                                        void *ctx )
+{ return StreamingSession_AddSubscriptionsAsync_ABI(psession, subs, nsubs,
+                                                    callback, ctx, 0); }
+
 static inline int
 StreamingSession_Stop( StreamingSession_C *psession )
 { return StreamingSession_Stop_ABI(psession, 0); }
@@ -2149,16 +2643,273 @@ static inline int
 StreamingSession_SetQOS(StreamingSession_C *psession, QOSType qos, int *result)
 { return StreamingSession_SetQOS_ABI(psession, (int)qos, result, 0); }
 
+static inline int
+StreamingSession_SetQOSAsync( StreamingSession_C *psession,
+                              QOSType qos,
+                              streaming_request_cb_ty callback,
+                              void *ctx )
+{ return StreamingSession_SetQOSAsync_ABI(psession, (int)qos, callback, ctx, 0); }
+
 static inline int
 StreamingSession_GetQOS( StreamingSession_C *psession, QOSType *qos)
 { return StreamingSession_GetQOS_ABI(psession, (int*)qos, 0); }
 
+static inline int
+StreamingSession_SetTypedCallback( StreamingSession_C *psession,
+                                   streaming_typed_cb_ty callback )
+{ return StreamingSession_SetTypedCallback_ABI(psession, callback, 0); }
+
+static inline int
+StreamingSession_SetOverflowPolicy( StreamingSession_C *psession,
+                                    size_t high_water_mark,
+                                    StreamingOverflowPolicy policy )
+{ return StreamingSession_SetOverflowPolicy_ABI(psession, high_water_mark,
+                                                (int)policy, 0); }
+
+static inline int
+StreamingSession_GetOverflowPolicy( StreamingSession_C *psession,
+                                    size_t *high_water_mark,
+                                    StreamingOverflowPolicy *policy )
+{ return StreamingSession_GetOverflowPolicy_ABI(psession, high_water_mark,
+                                                (int*)policy, 0); }
+
+static inline int
+StreamingSession_GetOverflowStats( StreamingSession_C *psession,
+                                   StreamingOverflowStats_C *stats )
+{ return StreamingSession_GetOverflowStats_ABI(psession, stats, 0); }
+
+static inline int
+StreamingSession_SetQuoteBookEnabled( StreamingSession_C *psession,
+                                      int enabled )
+{ return StreamingSession_SetQuoteBookEnabled_ABI(psession, enabled, 0); }
+
+static inline int
+StreamingSession_IsQuoteBookEnabled( StreamingSession_C *psession,
+                                     int *enabled )
+{ return StreamingSession_IsQuoteBookEnabled_ABI(psession, enabled, 0); }
+
+static inline int
+StreamingSession_GetQuoteBook( StreamingSession_C *psession,
+                               StreamerServiceType service,
+                               const char *symbol,
+                               unsigned long long since_seq,
+                               StreamingRecord_C **records,
+                               size_t *nrecords,
+                               unsigned long long *seq )
+{ return StreamingSession_GetQuoteBook_ABI(psession, (int)service, symbol,
+                                           since_seq, records, nrecords,
+                                           seq, 0); }
+
+static inline int
+FreeStreamingRecordsBuffer( StreamingRecord_C *records )
+{ return FreeStreamingRecordsBuffer_ABI(records, 0); }
+
+static inline int
+DecodeAcctActivity( const char *message_type,
+                    const char *message_data,
+                    OrderEvent_C *event )
+{ return DecodeAcctActivity_ABI(message_type, message_data, event, 0); }
+
+static inline int
+StreamingSession_SetOrderCacheEnabled( StreamingSession_C *psession,
+                                       int enabled )
+{ return StreamingSession_SetOrderCacheEnabled_ABI(psession, enabled, 0); }
+
+static inline int
+StreamingSession_IsOrderCacheEnabled( StreamingSession_C *psession,
+                                      int *enabled )
+{ return StreamingSession_IsOrderCacheEnabled_ABI(psession, enabled, 0); }
+
+static inline int
+StreamingSession_SetOrderEventCallback( StreamingSession_C *psession,
+                                        order_event_cb_ty callback )
+{ return StreamingSession_SetOrderEventCallback_ABI(psession, callback, 0); }
+
+static inline int
+StreamingSession_GetOrderState( StreamingSession_C *psession,
+                                const char *order_id,
+                                OrderState_C *state,
+                                int *found )
+{ return StreamingSession_GetOrderState_ABI(psession, order_id, state,
+                                            found, 0); }
+
+static inline int
+StreamingSession_GetOrderStates( StreamingSession_C *psession,
+                                 unsigned long long since_seq,
+                                 OrderState_C **states,
+                                 size_t *n,
+                                 unsigned long long *seq )
+{ return StreamingSession_GetOrderStates_ABI(psession, since_seq, states, n,
+                                             seq, 0); }
+
+static inline int
+StreamingSession_StartOrderCacheSync( StreamingSession_C *psession,
+                                      struct Credentials *pcreds,
+                                      const char *account_id,
+                                      unsigned long resync_msec,
+                                      unsigned int lookback_days )
+{ return StreamingSession_StartOrderCacheSync_ABI(psession, pcreds,
+                                                  account_id, resync_msec,
+                                                  lookback_days, 0); }
+
+static inline int
+StreamingSession_StopOrderCacheSync( StreamingSession_C *psession )
+{ return StreamingSession_StopOrderCacheSync_ABI(psession, 0); }
+
+static inline int
+StreamingSession_IsOrderCacheSyncing( StreamingSession_C *psession,
+                                      int *syncing )
+{ return StreamingSession_IsOrderCacheSyncing_ABI(psession, syncing, 0); }
+
+static inline int
+StreamingSession_GetOpenOrders( StreamingSession_C *psession,
+                                const char *symbol,
+                                OrderState_C **states,
+                                size_t *n )
+{ return StreamingSession_GetOpenOrders_ABI(psession, symbol, states, n, 0); }
+
+static inline int
+FreeOrderStatesBuffer( OrderState_C *states )
+{ return FreeOrderStatesBuffer_ABI(states, 0); }
+
+static inline int
+SetStreamerURLOverride( const char *url )
+{ return SetStreamerURLOverride_ABI(url, 0); }
+
+static inline int
+StreamingSession_SetDispatchThreads( StreamingSession_C *psession,
+                                     unsigned int nthreads )
+{ return StreamingSession_SetDispatchThreads_ABI(psession, nthreads, 0); }
+
+static inline int
+StreamingSession_GetDispatchThreads( StreamingSession_C *psession,
+                                     unsigned int *nthreads )
+{ return StreamingSession_GetDispatchThreads_ABI(psession, nthreads, 0); }
+
+static inline int
+StreamingSession_Subscribe( StreamingSession_C *psession,
+                            StreamingSubscription_C *sub )
+{ return StreamingSession_Subscribe_ABI(psession, sub, 0); }
+
+static inline int
+StreamingSession_Unsubscribe( StreamingSession_C *psession,
+                              StreamingSubscription_C *sub )
+{ return StreamingSession_Unsubscribe_ABI(psession, sub, 0); }
+
+static inline int
+StreamingSession_FlushSubscriptions( StreamingSession_C *psession,
+                                     int *result )
+{ return StreamingSession_FlushSubscriptions_ABI(psession, result, 0); }
+
+static inline int
+StreamingSession_GetSubscribedSymbols( StreamingSession_C *psession,
+                                       StreamerServiceType service,
+                                       char ***buffers,
+                                       size_t *n )
+{ return StreamingSession_GetSubscribedSymbols_ABI(psession, (int)service,
+                                                   buffers, n, 0); }
+
+static inline int
+StreamingSession_SetSubscriptionWindow( StreamingSession_C *psession,
+                                        unsigned long msec )
+{ return StreamingSession_SetSubscriptionWindow_ABI(psession, msec, 0); }
+
+static inline int
+StreamingSession_GetSubscriptionWindow( StreamingSession_C *psession,
+                                        unsigned long *msec )
+{ return StreamingSession_GetSubscriptionWindow_ABI(psession, msec, 0); }
+
+static inline int
+StreamingSession_SetAutoReconnect( StreamingSession_C *psession,
+                                   int enabled )
+{ return StreamingSession_SetAutoReconnect_ABI(psession, enabled, 0); }
+
+static inline int
+StreamingSession_IsAutoReconnect( StreamingSession_C *psession,
+                                  int *enabled )
+{ return StreamingSession_IsAutoReconnect_ABI(psession, enabled, 0); }
+
+static inline int
+StreamingSession_StartCapture( StreamingSession_C *psession, const char *path )
+{ return StreamingSession_StartCapture_ABI(psession, path, 0); }
+
+static inline int
+StreamingSession_StopCapture( StreamingSession_C *psession )
+{ return StreamingSession_StopCapture_ABI(psession, 0); }
+
+static inline int
+StreamingSession_IsCapturing( StreamingSession_C *psession, int *capturing )
+{ return StreamingSession_IsCapturing_ABI(psession, capturing, 0); }
+
 #else
 
 /* C++ Interface */
 
 namespace tdma{
 
+inline void
+SetStreamerURLOverride(const std::string& url)
+{ call_abi( SetStreamerURLOverride_ABI, url.c_str() ); }
+
+inline OrderEvent_C
+DecodeAcctActivity( const std::string& message_type,
+                    const std::string& message_data )
+{
+    OrderEvent_C event;
+    call_abi( DecodeAcctActivity_ABI, message_type.c_str(),
+              message_data.c_str(), &event );
+    return event;
+}
+
+/* owns the block returned by StreamingSession::get_quote_book */
+class QuoteBookSnapshot{
+    std::shared_ptr<StreamingRecord_C> _records;
+    size_t _n;
+    unsigned long long _seq;
+
+public:
+    QuoteBookSnapshot( StreamingRecord_C *records,
+                       size_t n,
+                       unsigned long long seq )
+        :
+            _records( records,
+                      [](StreamingRecord_C *r){
+                          FreeStreamingRecordsBuffer_ABI(r, 0);
+                      } ),
+            _n(n),
+            _seq(seq)
+        {
+        }
+
+    typedef const StreamingRecord_C* const_iterator;
+
+    /* pass to get_quote_book as 'since_seq' to get only what's changed */
+    unsigned long long
+    seq() const
+    { return _seq; }
+
+    size_t
+    size() const
+    { return _n; }
+
+    bool
+    empty() const
+    { return _n == 0; }
+
+    const StreamingRecord_C&
+    operator[](size_t i) const
+    { return _records.get()[i]; }
+
+    const_iterator
+    begin() const
+    { return _records.get(); }
+
+    const_iterator
+    end() const
+    { return _records.get() + _n; }
+};
+
+
 class DLL_SPEC_ StreamingSession{
 public:
     static const std::string VERSION; // = "1.0"
@@ -2168,7 +2919,22 @@ public:
     static const std::chrono::milliseconds DEF_CONNECT_TIMEOUT; // 3000
     static const std::chrono::milliseconds DEF_LISTENING_TIMEOUT; // 30000
     static const std::chrono::milliseconds DEF_SUBSCRIBE_TIMEOUT; // 1500
+    static const std::chrono::milliseconds DEF_SUBSCRIPTION_WINDOW; // 50
+    static const std::chrono::milliseconds MAX_SUBSCRIPTION_WINDOW; // 10000
+    static const std::chrono::milliseconds RECONNECT_MIN_BACKOFF; // 500
+    static const std::chrono::milliseconds RECONNECT_MAX_BACKOFF; // 30000
+    static const unsigned int RECONNECT_MAX_ATTEMPTS =
+        STREAMING_RECONNECT_MAX_ATTEMPTS; // 10
     static const int MAX_SUBSCRIPTIONS = STREAMING_MAX_SUBSCRIPTIONS; // 50
+    static const unsigned int MAX_DISPATCH_THREADS =
+        STREAMING_MAX_DISPATCH_THREADS; // 64
+    static const size_t MIN_HIGH_WATER_MARK =
+        STREAMING_MIN_HIGH_WATER_MARK; // 16
+    static const size_t MAX_HIGH_WATER_MARK =
+        STREAMING_MAX_HIGH_WATER_MARK; // 1048576
+    static const size_t DEF_HIGH_WATER_MARK =
+        STREAMING_DEF_HIGH_WATER_MARK; // 8192
+    static constexpr double REPLAY_UNPACED = STREAMING_REPLAY_UNPACED;
 
     typedef StreamingSession_C CType;
 
@@ -2213,6 +2979,22 @@ private:
         return cpp_results;
     }
 
+    struct _AsyncRequests{
+        std::vector<std::promise<bool>> promises;
+        std::atomic<size_t> remaining;
+
+        _AsyncRequests(size_t n) : promises(n), remaining(n) {}
+    };
+
+    static void
+    _async_request_callback(size_t i, int code, const char*, void *ctx)
+    {
+        _AsyncRequests *reqs = reinterpret_cast<_AsyncRequests*>(ctx);
+        reqs->promises[i].set_value(code == 0);
+        if( --(reqs->remaining) == 0 )
+            delete reqs;
+    }
+
 public:
     static std::shared_ptr<StreamingSession>
     Create( Credentials& creds,
@@ -2220,7 +3002,9 @@ public:
              std::string account_id = "",
              std::chrono::milliseconds connect_timeout=DEF_CONNECT_TIMEOUT,
              std::chrono::milliseconds listening_timeout=DEF_LISTENING_TIMEOUT,
-             std::chrono::milliseconds subscribe_timeout=DEF_SUBSCRIBE_TIMEOUT
+             std::chrono::milliseconds subscribe_timeout=DEF_SUBSCRIBE_TIMEOUT,
+             size_t high_water_mark=DEF_HIGH_WATER_MARK,
+             StreamingOverflowPolicy overflow_policy=StreamingOverflowPolicy::block
              )
     {
         StreamingSession *ss = nullptr;
@@ -2230,6 +3014,30 @@ public:
                       account_id.c_str(), connect_timeout.count(),
                       listening_timeout.count(), subscribe_timeout.count(),
                       ss->_obj.get() );
+            if( high_water_mark != DEF_HIGH_WATER_MARK
+                || overflow_policy != StreamingOverflowPolicy::block )
+            {
+                ss->set_overflow_policy(high_water_mark, overflow_policy);
+            }
+        }catch(...){
+            if( ss ) delete ss;
+            throw;
+        }
+        return std::shared_ptr<StreamingSession>(ss);
+    }
+
+    /* plays a capture (see start_capture) through the same callbacks */
+    static std::shared_ptr<StreamingSession>
+    CreateReplay( const std::string& path,
+                  streaming_cb_ty callback,
+                  double speed = 1.0,
+                  std::chrono::milliseconds listening_timeout=DEF_LISTENING_TIMEOUT )
+    {
+        StreamingSession *ss = nullptr;
+        try{
+            ss = new StreamingSession;
+            call_abi( StreamingSession_CreateReplay_ABI, path.c_str(), speed,
+                      callback, listening_timeout.count(), ss->_obj.get() );
         }catch(...){
             if( ss ) delete ss;
             throw;
@@ -2274,6 +3082,42 @@ public:
             std::vector<StreamingSubscription>{subscription})[0];
     }
 
+    /* sent in one message; futures are ready as each response comes back */
+    std::vector<std::future<bool>>
+    add_subscriptions_async(
+        const std::vector<StreamingSubscription>& subscriptions
+        )
+    {
+        std::vector<std::future<bool>> futs;
+        size_t sz = subscriptions.size();
+        if( !sz )
+            return futs;
+
+        std::vector<StreamingSubscription_C*> buffer;
+        for( auto& s : subscriptions )
+            buffer.push_back( s.csub() );
+
+        _AsyncRequests *reqs = new _AsyncRequests(sz);
+        for( auto& p : reqs->promises )
+            futs.push_back( p.get_future() );
+        try{
+            call_abi( StreamingSession_AddSubscriptionsAsync_ABI, _obj.get(),
+                      buffer.data(), sz, &StreamingSession::_async_request_callback,
+                      static_cast<void*>(reqs) );
+        }catch(...){
+            delete reqs;
+            throw;
+        }
+        return futs;
+    }
+
+    std::future<bool>
+    add_subscription_async(const StreamingSubscription& subscription)
+    {
+        return std::move( add_subscriptions_async(
+            std::vector<StreamingSubscription>{subscription})[0] );
+    }
+
 
     QOSType
     get_qos() const
@@ -2291,6 +3135,302 @@ public:
                   static_cast<int>(qos), &result );
         return static_cast<bool>(result);
     }
+
+    std::future<bool>
+    set_qos_async(const QOSType& qos)
+    {
+        _AsyncRequests *reqs = new _AsyncRequests(1);
+        std::future<bool> fut = reqs->promises[0].get_future();
+        try{
+            call_abi( StreamingSession_SetQOSAsync_ABI, _obj.get(),
+                      static_cast<int>(qos),
+                      &StreamingSession::_async_request_callback,
+                      static_cast<void*>(reqs) );
+        }catch(...){
+            delete reqs;
+            throw;
+        }
+        return fut;
+    }
+
+    /* 'data' goes to 'callback' (pre-parsed) instead of the json callback */
+    void
+    set_typed_callback(streaming_typed_cb_ty callback)
+    { call_abi( StreamingSession_SetTypedCallback_ABI, _obj.get(), callback ); }
+
+    /* can only be changed while the session is stopped */
+    void
+    set_overflow_policy( size_t high_water_mark,
+                         StreamingOverflowPolicy policy )
+    {
+        call_abi( StreamingSession_SetOverflowPolicy_ABI, _obj.get(),
+                  high_water_mark, static_cast<int>(policy) );
+    }
+
+    std::pair<size_t, StreamingOverflowPolicy>
+    get_overflow_policy() const
+    {
+        size_t hwm;
+        int p;
+        call_abi( StreamingSession_GetOverflowPolicy_ABI, _obj.get(), &hwm, &p );
+        return std::make_pair(hwm, static_cast<StreamingOverflowPolicy>(p));
+    }
+
+    StreamingOverflowStats_C
+    get_overflow_stats() const
+    {
+        StreamingOverflowStats_C stats;
+        call_abi( StreamingSession_GetOverflowStats_ABI, _obj.get(), &stats );
+        return stats;
+    }
+
+    /* merged LEVELONE state per symbol; see get_quote_book */
+    void
+    set_quote_book_enabled(bool enabled)
+    {
+        call_abi( StreamingSession_SetQuoteBookEnabled_ABI, _obj.get(),
+                  static_cast<int>(enabled) );
+    }
+
+    bool
+    is_quote_book_enabled() const
+    {
+        int e;
+        call_abi( StreamingSession_IsQuoteBookEnabled_ABI, _obj.get(), &e );
+        return static_cast<bool>(e);
+    }
+
+    /*
+     * symbols (or just 'symbol') of 'service' w/ the fields that changed
+     * after 'since_seq' (0 for a full snapshot)
+     */
+    QuoteBookSnapshot
+    get_quote_book( StreamerServiceType service,
+                    unsigned long long since_seq = 0,
+                    const std::string& symbol = "" ) const
+    {
+        StreamingRecord_C *records;
+        size_t n;
+        unsigned long long seq;
+        call_abi( StreamingSession_GetQuoteBook_ABI, _obj.get(),
+                  static_cast<int>(service),
+                  (symbol.empty() ? nullptr : symbol.c_str()), since_seq,
+                  &records, &n, &seq );
+        return QuoteBookSnapshot(records, n, seq);
+    }
+
+    /* order state from ACCT_ACTIVITY messages; see get_order_state(s) */
+    void
+    set_order_cache_enabled(bool enabled)
+    {
+        call_abi( StreamingSession_SetOrderCacheEnabled_ABI, _obj.get(),
+                  static_cast<int>(enabled) );
+    }
+
+    bool
+    is_order_cache_enabled() const
+    {
+        int e;
+        call_abi( StreamingSession_IsOrderCacheEnabled_ABI, _obj.get(), &e );
+        return static_cast<bool>(e);
+    }
+
+    /* decoded ACCT_ACTIVITY messages, on the listener thread */
+    void
+    set_order_event_callback(order_event_cb_ty callback)
+    {
+        call_abi( StreamingSession_SetOrderEventCallback_ABI, _obj.get(),
+                  callback );
+    }
+
+    bool
+    get_order_state(const std::string& order_id, OrderState_C& state) const
+    {
+        int found;
+        call_abi( StreamingSession_GetOrderState_ABI, _obj.get(),
+                  order_id.c_str(), &state, &found );
+        return static_cast<bool>(found);
+    }
+
+    /* orders changed after 'since_seq' (0 for all); '*seq' for next time */
+    std::vector<OrderState_C>
+    get_order_states( unsigned long long since_seq = 0,
+                      unsigned long long *seq = nullptr ) const
+    {
+        OrderState_C *states;
+        size_t n;
+        unsigned long long s;
+        call_abi( StreamingSession_GetOrderStates_ABI, _obj.get(), since_seq,
+                  &states, &n, &s );
+        std::vector<OrderState_C> v(states, states + n);
+        FreeOrderStatesBuffer_ABI(states, 0);
+        if( seq )
+            *seq = s;
+        return v;
+    }
+
+    /*
+     * seed the order cache w/ one OrdersGetter call and resync it in the
+     * background; the sync keeps its own copy of 'creds'
+     */
+    void
+    start_order_cache_sync( Credentials& creds,
+                            const std::string& account_id = "",
+                            std::chrono::milliseconds resync_interval =
+                                std::chrono::milliseconds(
+                                    ORDER_CACHE_SYNC_DEF_RESYNC_MSEC),
+                            unsigned int lookback_days =
+                                ORDER_CACHE_SYNC_DEF_LOOKBACK_DAYS )
+    {
+        call_abi( StreamingSession_StartOrderCacheSync_ABI, _obj.get(),
+                  &creds, account_id.c_str(),
+                  static_cast<unsigned long>(resync_interval.count()),
+                  lookback_days );
+    }
+
+    void
+    stop_order_cache_sync()
+    { call_abi( StreamingSession_StopOrderCacheSync_ABI, _obj.get() ); }
+
+    bool
+    is_order_cache_syncing() const
+    {
+        int s;
+        call_abi( StreamingSession_IsOrderCacheSyncing_ABI, _obj.get(), &s );
+        return static_cast<bool>(s);
+    }
+
+    /* open orders (all, or of 'symbol') */
+    std::vector<OrderState_C>
+    get_open_orders(const std::string& symbol = "") const
+    {
+        OrderState_C *states;
+        size_t n;
+        call_abi( StreamingSession_GetOpenOrders_ABI, _obj.get(),
+                  symbol.empty() ? nullptr : symbol.c_str(), &states, &n );
+        std::vector<OrderState_C> v(states, states + n);
+        FreeOrderStatesBuffer_ABI(states, 0);
+        return v;
+    }
+
+    unsigned int
+    get_dispatch_threads() const
+    {
+        unsigned int n;
+        call_abi( StreamingSession_GetDispatchThreads_ABI, _obj.get(), &n );
+        return n;
+    }
+
+    /*
+     * > 0 runs 'data' callbacks on 'nthreads' workers (routed by symbol)
+     * instead of the listening thread; callbacks MUST be thread-safe.
+     * Can only be changed while the session is stopped.
+     */
+    void
+    set_dispatch_threads(unsigned int nthreads)
+    { call_abi( StreamingSession_SetDispatchThreads_ABI, _obj.get(), nthreads ); }
+
+    /*
+     * add the symbols of 'subscription' (its fields replace the service's);
+     * the change is sent, as a diff, when the subscription window closes.
+     * The command of 'subscription' is ignored.
+     */
+    void
+    subscribe(const StreamingSubscription& subscription)
+    {
+        call_abi( StreamingSession_Subscribe_ABI, _obj.get(),
+                  subscription.csub() );
+    }
+
+    /* remove the symbols of 'subscription' */
+    void
+    unsubscribe(const StreamingSubscription& subscription)
+    {
+        call_abi( StreamingSession_Unsubscribe_ABI, _obj.get(),
+                  subscription.csub() );
+    }
+
+    /* send pending changes now; false if any request failed/timed out */
+    bool
+    flush_subscriptions()
+    {
+        int result;
+        call_abi( StreamingSession_FlushSubscriptions_ABI, _obj.get(),
+                  &result );
+        return static_cast<bool>(result);
+    }
+
+    /* symbols (keys) last sent for 'service' */
+    std::set<std::string>
+    get_subscribed_symbols(StreamerServiceType service) const
+    {
+        char **buf;
+        size_t n;
+        std::set<std::string> strs;
+        call_abi( StreamingSession_GetSubscribedSymbols_ABI, _obj.get(),
+                  static_cast<int>(service), &buf, &n );
+        if( buf ){
+            while(n--){
+                strs.insert(buf[n]);
+                free(buf[n]);
+            }
+            free(buf);
+        }
+        return strs;
+    }
+
+    void
+    set_subscription_window(std::chrono::milliseconds window)
+    {
+        call_abi( StreamingSession_SetSubscriptionWindow_ABI, _obj.get(),
+                  static_cast<unsigned long>(window.count()) );
+    }
+
+    std::chrono::milliseconds
+    get_subscription_window() const
+    {
+        unsigned long ms;
+        call_abi( StreamingSession_GetSubscriptionWindow_ABI, _obj.get(), &ms );
+        return std::chrono::milliseconds(ms);
+    }
+
+    /*
+     * on a timeout/error reconnect (up to RECONNECT_MAX_ATTEMPTS, backing
+     * off from RECONNECT_MIN_BACKOFF to RECONNECT_MAX_BACKOFF), login and
+     * replay subscriptions and QOS; the callback gets 'reconnected' w/ the
+     * gap in the data instead of 'timeout'/'error' (unless we give up)
+     */
+    void
+    set_auto_reconnect(bool enabled)
+    {
+        call_abi( StreamingSession_SetAutoReconnect_ABI, _obj.get(),
+                  static_cast<int>(enabled) );
+    }
+
+    bool
+    is_auto_reconnect() const
+    {
+        int e;
+        call_abi( StreamingSession_IsAutoReconnect_ABI, _obj.get(), &e );
+        return static_cast<bool>(e);
+    }
+
+    /* raw inbound frames to 'path', across stop/start, until stopped */
+    void
+    start_capture(const std::string& path)
+    { call_abi( StreamingSession_StartCapture_ABI, _obj.get(), path.c_str() ); }
+
+    void
+    stop_capture()
+    { call_abi( StreamingSession_StopCapture_ABI, _obj.get() ); }
+
+    bool
+    is_capturing() const
+    {
+        int c;
+        call_abi( StreamingSession_IsCapturing_ABI, _obj.get(), &c );
+        return static_cast<bool>(c);
+    }
 };
 
 } /* tdma */
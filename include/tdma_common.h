@@ -110,6 +110,8 @@ DECL_CPROXY_BASE_STRUCT(Getter_C);
 DECL_CPROXY_BASE_STRUCT(StreamingSubscription_C);
 DECL_CPROXY_BASE_STRUCT(OrderLeg_C);
 DECL_CPROXY_BASE_STRUCT(OrderTicket_C);
+DECL_CPROXY_BASE_STRUCT(ExecutionSession_C);
+DECL_CPROXY_BASE_STRUCT(OrderTemplate_C);
 
 #undef DECL_CPROXY_BASE_STRUCT
 
@@ -135,6 +137,7 @@ typedef struct{
 #define TDMA_API_AUTH_ERROR 102
 #define TDMA_API_REQUEST_ERROR 103
 #define TDMA_API_SERVER_ERROR 104
+#define TDMA_API_TIMEOUT_ERROR 105
 
 #define TDMA_API_STREAM_ERROR 201
 
@@ -195,6 +198,17 @@ GetDefaultCertificateBundlePath_ABI( char **path,
                                      size_t *n,
                                      int allow_exceptions );
 
+/*
+ * send HTTP requests to 'base' (e.g "http://127.0.0.1:8080") instead of
+ * https://api.tdameritrade.com - for testing against a mock server;
+ * empty string to remove
+ */
+EXTERN_C_SPEC_ DLL_SPEC_ int
+SetBaseURLOverride_ABI(const char* base, int allow_exceptions );
+
+EXTERN_C_SPEC_ DLL_SPEC_ int
+GetBaseURLOverride_ABI(char **base, size_t *n, int allow_exceptions );
+
 EXTERN_C_SPEC_ DLL_SPEC_ int
 CreateCredentials_ABI( const char* access_token,
                        const char* refresh_token,
@@ -314,6 +328,14 @@ GetCertificateBundlePath(char **path, size_t *n)
 GetDefaultCertificateBundlePath(char **path, size_t *n )
 { return GetDefaultCertificateBundlePath_ABI(path, n, 0); }
 
+static inline int
+SetBaseURLOverride(const char* base)
+{ return SetBaseURLOverride_ABI(base, 0); }
+
+static inline int
+GetBaseURLOverride(char **base, size_t *n)
+{ return GetBaseURLOverride_ABI(base, n, 0); }
+
 static inline int
 CreateCredentials( const char* access_token
                    const char* refresh_token,
@@ -514,7 +536,9 @@ struct IsValidCProxy<ProxyTy, void>{
         || IsValidCProxy<ProxyTy, StreamingSubscription_C>::value
         || IsValidCProxy<ProxyTy, StreamingSession_C>::value
         || IsValidCProxy<ProxyTy, OrderLeg_C>::value
-        || IsValidCProxy<ProxyTy, OrderTicket_C>::value;
+        || IsValidCProxy<ProxyTy, OrderTicket_C>::value
+        || IsValidCProxy<ProxyTy, ExecutionSession_C>::value
+        || IsValidCProxy<ProxyTy, OrderTemplate_C>::value;
 };
 
 template<typename ProxyTy>
@@ -524,7 +548,9 @@ struct IsCProxyBase{
         || std::is_same<ProxyTy, StreamingSubscription_C>::value
         || std::is_same<ProxyTy, StreamingSession_C>::value
         || std::is_same<ProxyTy, OrderLeg_C>::value
-        || std::is_same<ProxyTy, OrderTicket_C>::value;
+        || std::is_same<ProxyTy, OrderTicket_C>::value
+        || std::is_same<ProxyTy, ExecutionSession_C>::value
+        || std::is_same<ProxyTy, OrderTemplate_C>::value;
 };
 
 template<typename F, typename... Args>
@@ -632,6 +658,14 @@ GetCertificateBundlePath()
 GetDefaultCertificateBundlePath()
 { return str_from_abi_vargs(GetDefaultCertificateBundlePath_ABI, ALLOW_EXCEPTIONS); }
 
+inline void
+SetBaseURLOverride(const std::string& base)
+{ call_abi( SetBaseURLOverride_ABI, base.c_str() ); }
+
+inline std::string
+GetBaseURLOverride()
+{ return str_from_abi_vargs(GetBaseURLOverride_ABI, ALLOW_EXCEPTIONS); }
+
 inline int
 LastErrorCode()
 {
@@ -872,6 +906,23 @@ public:
 };
 
 
+class TimeoutError
+        : public ConnectException{
+public:
+    static const int ERROR_CODE = TDMA_API_TIMEOUT_ERROR;
+
+    using ConnectException::ConnectException;
+
+    virtual const char*
+    name() const noexcept
+    { return "TimeoutError"; }
+
+    virtual int
+    error_code() const noexcept
+    { return ERROR_CODE; }
+};
+
+
 class StreamingException
         : public APIException {
 public:
@@ -942,6 +993,35 @@ public:
 };
 
 
+static void
+throw_error_code( int code,
+                  const std::string& msg,
+                  int lineno,
+                  const std::string& fname )
+{
+    switch(code){
+    case TDMA_API_ERROR: throw APIException(msg, lineno, fname);
+    case TDMA_API_CRED_ERROR: throw LocalCredentialException(msg, lineno, fname);
+    case TDMA_API_VALUE_ERROR: throw ValueException(msg, lineno, fname);
+    case TDMA_API_TYPE_ERROR: throw TypeException(msg, lineno, fname);
+    case TDMA_API_MEMORY_ERROR: throw MemoryError(msg, lineno, fname);
+    case TDMA_API_CONNECT_ERROR: throw ConnectException(msg, lineno, fname);
+    case TDMA_API_AUTH_ERROR: throw AuthenticationException(msg, lineno, fname);
+    case TDMA_API_REQUEST_ERROR: throw InvalidRequest(msg, lineno, fname);
+    case TDMA_API_SERVER_ERROR: throw ServerError(msg, lineno, fname);
+    case TDMA_API_TIMEOUT_ERROR: throw TimeoutError(msg, lineno, fname);
+    case TDMA_API_STREAM_ERROR: throw StreamingException(msg, lineno, fname);
+    case TDMA_API_EXECUTE_ERROR: throw ExecuteException(msg, lineno, fname);
+    case TDMA_API_STD_EXCEPTION: throw StdException(msg);
+    case TDMA_API_UNKNOWN_EXCEPTION: throw UnknownException("unknown exception");
+    default:
+        throw UnknownException(
+            "unknown error code(" + std::to_string(code) + ')'
+            );
+    };
+}
+
+
 static void
 error_to_exc(int code)
 {
@@ -971,25 +1051,7 @@ error_to_exc(int code)
        << ", line: " << lineno << ']';
     msg = ss.str();
 
-    switch(code){
-    case TDMA_API_ERROR: throw APIException(msg, lineno, fname);
-    case TDMA_API_CRED_ERROR: throw LocalCredentialException(msg, lineno, fname);
-    case TDMA_API_VALUE_ERROR: throw ValueException(msg, lineno, fname);
-    case TDMA_API_TYPE_ERROR: throw TypeException(msg, lineno, fname);
-    case TDMA_API_MEMORY_ERROR: throw MemoryError(msg, lineno, fname);
-    case TDMA_API_CONNECT_ERROR: throw ConnectException(msg, lineno, fname);
-    case TDMA_API_AUTH_ERROR: throw AuthenticationException(msg, lineno, fname);
-    case TDMA_API_REQUEST_ERROR: throw InvalidRequest(msg, lineno, fname);
-    case TDMA_API_SERVER_ERROR: throw ServerError(msg, lineno, fname);
-    case TDMA_API_STREAM_ERROR: throw StreamingException(msg, lineno, fname);
-    case TDMA_API_EXECUTE_ERROR: throw ExecuteException(msg, lineno, fname);
-    case TDMA_API_STD_EXCEPTION: throw StdException(msg);
-    case TDMA_API_UNKNOWN_EXCEPTION: throw UnknownException("unknown exception");
-    default:
-        throw UnknownException(
-            "unknown error code(" + std::to_string(code) + ')'
-            );
-    };
+    throw_error_code(code, msg, lineno, fname);
 }
 
 
@@ -105,6 +105,16 @@ public:
         _map.clear();
     }
 
+    /* remove and return everything in one lock */
+    std::unordered_map<K, V>
+    take_all()
+    {
+        std::unordered_map<K, V> m;
+        std::lock_guard<std::mutex> _(_mtx);
+        m.swap(_map);
+        return m;
+    }
+
     void
     access(access_cb_ty access_cb)
     {
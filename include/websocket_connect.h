@@ -22,22 +22,84 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <functional>
 #include <mutex>
 #include <thread>
+#include <atomic>
 #include <condition_variable>
 #include <signal.h>
 
 #include "_common.h"
 #include "../include/util.h"
-#include "threadsafe_queue.h"
+#include "spsc_ring.h"
 
 #include "../uWebSockets/uWS.h"
 
 namespace conn{
 
-class WebSocketClient{
+/* what the socket thread does when the inbound queue is at its limit */
+enum class OverflowPolicy {
+    block, // wait for the consumer (stalls the uWS loop)
+    drop_oldest // discard the oldest queued data frame to make room
+};
+
+/* written by WebSocketClient, readable from any thread */
+struct InQueueStats{
+    std::atomic<unsigned long long> max_depth;
+    std::atomic<unsigned long long> blocked; // times the socket thread waited
+    std::atomic<unsigned long long> dropped; // frames discarded
+
+    InQueueStats()
+        : max_depth(0), blocked(0), dropped(0)
+    {}
+};
+
+class FrameRecorder;
+
+/* what StreamingSession needs from a connection */
+class WebSocketClientInterface{
+public:
+    virtual
+    ~WebSocketClientInterface(){}
+
+    virtual void
+    connect(std::chrono::milliseconds timeout) = 0;
+
+    virtual bool
+    is_connected() const = 0;
+
+    virtual void
+    close(bool graceful=true) = 0;
+
+    virtual void
+    send(std::string msg) = 0;
+
+    virtual void
+    push_empty_message() = 0;
+
+    virtual std::string
+    recv_or_wait_for(std::chrono::milliseconds timeout) = 0;
+
+    virtual size_t
+    recv_atleast_n_or_wait_for( size_t n,
+                                std::chrono::milliseconds timeout,
+                                std::vector<std::string>& frames ) = 0;
+
+    virtual void
+    recycle(std::vector<std::string>& frames) = 0;
+};
+
+
+class WebSocketClient
+        : public WebSocketClientInterface {
     typedef uWS::WebSocket<uWS::CLIENT> uws_client_ty;
 
+    /*
+     * each client has its own hub; the client is the user data of its socket
+     * (and the async) so a late callback from an old connection can only
+     * touch the client that owns it
+     */
     struct Callbacks{
-        static WebSocketClient *wsc;
+        static WebSocketClient*
+        from(uws_client_ty *ws)
+        { return reinterpret_cast<WebSocketClient*>(ws->getUserData()); }
 
         static void
         on_connect(uws_client_ty *ws, uWS::HttpRequest r);
@@ -59,8 +121,20 @@ class WebSocketClient{
     std::string _url;
     uS::Async *_signal;
     std::thread _thread;
-    ThreadSafeQueue<std::string> _in_queue; // in from server
-    ThreadSafeQueue<std::string> _out_queue; // out to server
+    SPSCRing<std::string> _in_queue; // in from server (uWS -> listener)
+    SPSCRing<std::string> _out_queue; // out to server (send -> uWS)
+    SPSCRing<std::string> _pool; // recycled frame buffers (listener -> uWS)
+    std::mutex _send_mtx; // _out_queue has one producer
+    /*
+     * drop_oldest: the socket thread evicts from the front of _in_queue and
+     * pushes to _pool, so the consumer's pops and recycles take this too
+     */
+    std::mutex _evict_mtx;
+    std::atomic<bool> _stop_flag; // push_empty_message
+    size_t _high_water_mark;
+    OverflowPolicy _overflow_policy;
+    InQueueStats *_stats;
+    FrameRecorder *_recorder;
     std::condition_variable _init_cond;
     bool _init_flag;
     std::mutex _init_mtx;
@@ -82,7 +156,7 @@ class WebSocketClient{
         operator()(){
             util::debug_out("WebSocket", "SocketThreadTarget IN", _wsc,
                             std::cout);
-            _wsc->_hub.connect(_wsc->_url, nullptr, {}, _timeout.count());
+            _wsc->_hub.connect(_wsc->_url, _wsc, {}, _timeout.count());
             _wsc->_hub.run();
             util::debug_out("WebSocket", "SocketThreadTarget OUT", _wsc,
                             std::cout);
@@ -94,8 +168,70 @@ class WebSocketClient{
         {}
     };
 
+    std::unique_lock<std::mutex>
+    _evict_lock()
+    {
+        return _overflow_policy == OverflowPolicy::drop_oldest
+            ? std::unique_lock<std::mutex>(_evict_mtx)
+            : std::unique_lock<std::mutex>();
+    }
+
+    /* (socket thread) drop_oldest: discard the oldest queued data frame */
+    void
+    _evict_oldest();
+
+    /* back to the pool, if it isn't too big (or the pool full) */
+    void
+    _recycle(std::string& frame)
+    {
+        if( frame.capacity() <= POOL_MAX_BUFFER_SIZE )
+            _pool.try_push(frame);
+    }
+
+    /*
+     * (consumer) _in_queue ops; waits don't hold _evict_mtx, a null
+     * 'deadline' waits indefinitely
+     */
+    size_t
+    _drain( std::vector<std::string>& out,
+            size_t max = static_cast<size_t>(-1) );
+
+    bool
+    _pop_or_wait( std::string& s,
+                  const std::chrono::steady_clock::time_point *deadline );
+
+    size_t
+    _drain_or_wait( std::vector<std::string>& out,
+                    const std::chrono::steady_clock::time_point *deadline,
+                    size_t max = static_cast<size_t>(-1) );
+
+    /* append the 'empty message' if push_empty_message was called */
+    template<typename C>
+    void
+    _append_stop_message(C& c)
+    {
+        if( _stop_flag.exchange(false) ){
+            _in_queue.clear_wake();
+            c.emplace_back();
+        }
+    }
+
 public:
-    WebSocketClient(std::string url);
+    static const size_t IN_QUEUE_CAPACITY = 8192;
+    static const size_t OUT_QUEUE_CAPACITY = 256;
+    static const size_t POOL_CAPACITY = 1024;
+    static const size_t POOL_MAX_BUFFER_SIZE = 1 << 16; // don't hoard big ones
+
+    /*
+     * 'high_water_mark' is the max # of frames we queue for the consumer
+     * (rounded up to a power of 2 for 'block'); 'stats' and 'recorder'
+     * are optional and must outlive the client
+     */
+    WebSocketClient( std::string url,
+                     size_t high_water_mark = IN_QUEUE_CAPACITY,
+                     OverflowPolicy overflow_policy = OverflowPolicy::block,
+                     InQueueStats *stats = nullptr,
+                     FrameRecorder *recorder = nullptr );
 
     WebSocketClient( const WebSocketClient& ) = delete;
 
@@ -117,9 +253,13 @@ public:
     void
     send(std::string msg);
 
+    /* signal the consumer to stop, AFTER it drains what's in the queue */
     void
     push_empty_message()
-    { _in_queue.push(""); }
+    {
+        _stop_flag = true;
+        _in_queue.wake_consumer();
+    }
 
     size_t
     nready()
@@ -143,6 +283,19 @@ public:
     std::vector<std::string>
     recv_atleast_n_or_wait_for(size_t n, std::chrono::milliseconds timeout);
 
+    /*
+     * appends to 'frames' (which should be re-used) w/ buffers from the pool;
+     * pass them back to recycle() when done; returns # of frames appended
+     */
+    size_t
+    recv_atleast_n_or_wait_for( size_t n,
+                                std::chrono::milliseconds timeout,
+                                std::vector<std::string>& frames );
+
+    /* return frame buffers to the pool and clear 'frames' */
+    void
+    recycle(std::vector<std::string>& frames);
+
     std::vector<std::string>
     recv_atmost_n(size_t n);
 
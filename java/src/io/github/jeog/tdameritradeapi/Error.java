@@ -39,6 +39,7 @@ public class Error {
         NAMES.put(102, "TDMA_API_AUTH_ERROR");
         NAMES.put(103, "TDMA_API_REQUEST_ERROR");
         NAMES.put(104, "TDMA_API_SERVER_ERROR");
+        NAMES.put(105, "TDMA_API_TIMEOUT_ERROR");
         NAMES.put(201, "TDMA_API_STREAM_ERROR");
         NAMES.put(301, "TDMA_API_EXECUTE_ERROR");
         NAMES.put(501, "TDMA_API_STD_EXCEPTION");
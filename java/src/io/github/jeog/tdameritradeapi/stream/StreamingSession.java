@@ -147,7 +147,8 @@ public class StreamingSession implements AutoCloseable {
         REQUEST_RESPONSE(3),
         NOTIFY(4),
         TIMEOUT(5),
-        ERROR(6);        
+        ERROR(6),
+        RECONNECTED(7);
                 
         private int value;
         
@@ -108,6 +108,7 @@ ERRORS = {
     102 : 'TDMA_API_AUTH_ERROR',
     103 : 'TDMA_API_REQUEST_ERROR',
     104 : 'TDMA_API_SERVER_ERROR',
+    105 : 'TDMA_API_TIMEOUT_ERROR',
     201 : 'TDMA_API_STREAM_ERROR',
     301 : 'TDMA_API_EXECUTE_ERROR',
     501 : 'TDMA_API_STD_EXCEPTION',
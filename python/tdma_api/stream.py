@@ -106,6 +106,7 @@ CALLBACK_TYPE_REQUEST_RESPONSE = 3
 CALLBACK_TYPE_NOTIFY = 4
 CALLBACK_TYPE_TIMEOUT = 5
 CALLBACK_TYPE_ERROR = 6
+CALLBACK_TYPE_RECONNECTED = 7
 
 
 def service_type_to_str(service):
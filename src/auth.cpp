@@ -771,6 +771,27 @@ string
 GetDefaultCertificateBundlePathImpl()
 { return DEF_CERTIFICATE_BUNDLE_PATH; }
 
+void
+SetBaseURLOverrideImpl(const string& base)
+{
+    if( base.empty() ){
+        conn::set_url_override("", "");
+        return;
+    }
+
+    if( base.rfind("http://", 0) != 0 && base.rfind("https://", 0) != 0 )
+        TDMA_API_THROW(ValueException, "base url must be http(s)://");
+
+    string b(base);
+    while( !b.empty() && b.back() == '/' )
+        b.pop_back();
+    conn::set_url_override(URL_ORIGIN, b);
+}
+
+string
+GetBaseURLOverrideImpl()
+{ return conn::get_url_override(URL_ORIGIN); }
+
 
 void
 CloseCredentialsImpl(Credentials* pcreds)
@@ -905,6 +926,29 @@ GetCertificateBundlePath_ABI(char **path, size_t *n, int allow_exceptions)
 }
 
 
+int
+SetBaseURLOverride_ABI(const char *base, int allow_exceptions)
+{
+    CHECK_PTR(base, "base", allow_exceptions);
+    return CallImplFromABI(allow_exceptions, SetBaseURLOverrideImpl, base);
+}
+
+
+int
+GetBaseURLOverride_ABI(char **base, size_t *n, int allow_exceptions)
+{
+    CHECK_PTR(base, "base", allow_exceptions);
+
+    string r;
+    int err;
+    tie(r,err) = CallImplFromABI(allow_exceptions, GetBaseURLOverrideImpl);
+    if( err )
+        return err;
+
+    return to_new_char_buffer(r, base, n, allow_exceptions);
+}
+
+
 int
 GetDefaultCertificateBundlePath_ABI( char **path,
                                      size_t *n,
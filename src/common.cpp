@@ -146,11 +146,12 @@ to_new_char_buffer( const string& s,
     return 0;
 }
 
+template<typename T>
 int
-to_new_char_buffers( const std::set<string>& strs,
-                     char*** bufs,
-                     size_t *n,
-                     bool allow_exceptions )
+to_new_char_buffers_( const T& strs,
+                      char*** bufs,
+                      size_t *n,
+                      bool allow_exceptions )
 {
     assert(bufs);
     assert(n);
@@ -187,6 +188,20 @@ to_new_char_buffers( const std::set<string>& strs,
     return 0;
 }
 
+int
+to_new_char_buffers( const std::set<string>& strs,
+                     char*** bufs,
+                     size_t *n,
+                     bool allow_exceptions )
+{ return to_new_char_buffers_(strs, bufs, n, allow_exceptions); }
+
+int
+to_new_char_buffers( const std::vector<string>& strs,
+                     char*** bufs,
+                     size_t *n,
+                     bool allow_exceptions )
+{ return to_new_char_buffers_(strs, bufs, n, allow_exceptions); }
+
 } /* tdma */
 
 
@@ -21,8 +21,11 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <iomanip>
 #include <iostream>
 #include <regex>
+#include <new>
+#include <atomic>
 
 #include <assert.h>
+#include <string.h>
 
 #include "../include/curl_connect.h"
 //#include "../include/util.h"
@@ -81,6 +84,32 @@ class CurlConnection::CurlConnectionImpl_ {
         { _buf.str(""); }
     };
 
+    struct BodyCallback {
+        CURL *_handle;
+        ResponseBuffer _buf;
+
+        static size_t
+        write( char* input, size_t sz, size_t n, void* output )
+        {
+            BodyCallback *cb = reinterpret_cast<BodyCallback*>(output);
+            try{
+                if( cb->_buf.capacity() == 0 ){
+                    /* size it all at once if we can (-1 if unknown) */
+                    curl_off_t len = -1;
+                    curl_easy_getinfo( cb->_handle,
+                                       CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,
+                                       &len );
+                    if( len > 0 )
+                        cb->_buf.reserve( static_cast<size_t>(len) );
+                }
+                cb->_buf.append(input, sz * n);
+            }catch(...){
+                return 0; // CURLE_WRITE_ERROR
+            }
+            return sz * n;
+        }
+    };
+
 public:
     CurlConnectionImpl_(string url)
         :
@@ -191,14 +220,15 @@ public:
     }
     
     // <status code, data, header, time>
-    tuple<long, string, string, clock_ty::time_point>
+    tuple<long, ResponseBuffer, string, clock_ty::time_point>
     execute( bool return_header_data )
     {
         if (!_handle)
             throw CurlException("connection/handle has been closed");
 
-        WriteCallback cb_data, cb_header;
-        set_option(CURLOPT_WRITEFUNCTION, &WriteCallback::write);
+        BodyCallback cb_data{_handle, ResponseBuffer()};
+        WriteCallback cb_header;
+        set_option(CURLOPT_WRITEFUNCTION, &BodyCallback::write);
         set_option(CURLOPT_WRITEDATA, &cb_data);
 
         if( return_header_data ){
@@ -211,18 +241,14 @@ public:
         if (ccode != CURLE_OK)
             throw CurlConnectionError(ccode, _error_buffer);
 
-        string res = cb_data.str();
-        cb_data.clear();
         long c;
         curl_easy_getinfo(_handle, CURLINFO_RESPONSE_CODE, &c);
 
         string head;
-        if( return_header_data ){
+        if( return_header_data )
             head = cb_header.str();
-            cb_data.clear();
-        }
 
-        return make_tuple(c, res, head, tp);
+        return make_tuple(c, std::move(cb_data._buf), std::move(head), tp);
     }
 
     void
@@ -286,6 +312,23 @@ public:
     SET_keepalive(bool on)
     { set_option(CURLOPT_TCP_KEEPALIVE, on ? 1L : 0L); }
 
+    bool
+    SET_http2(bool on)
+    {
+        static const bool HAS_HTTP2 =
+            (curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP2);
+        if( !HAS_HTTP2 )
+            return false;
+        set_option( CURLOPT_HTTP_VERSION,
+                    static_cast<long>(on ? CURL_HTTP_VERSION_2TLS
+                                         : CURL_HTTP_VERSION_1_1) );
+        return true;
+    }
+
+    void
+    SET_share(CURLSH *share)
+    { set_option(CURLOPT_SHARE, share); }
+
     void
     SET_timeout(long timeout)
     { set_option(CURLOPT_TIMEOUT_MS, (timeout > 0 ? timeout : 0)); }
@@ -458,7 +501,7 @@ CurlConnection::reset_options()
 { _pimpl->RESET_options(); }
 
 // <status code, data, time>
-tuple<long, string, string, clock_ty::time_point>
+tuple<long, ResponseBuffer, string, clock_ty::time_point>
 CurlConnection::execute( bool return_header_data )
 { return _pimpl->execute(return_header_data); }
 
@@ -502,6 +545,14 @@ void
 CurlConnection::set_keepalive(bool on)
 { _pimpl->SET_keepalive(on); }
 
+bool
+CurlConnection::set_http2(bool on)
+{ return _pimpl->SET_http2(on); }
+
+void
+CurlConnection::set_share(CURLSH *share)
+{ _pimpl->SET_share(share); }
+
 void
 CurlConnection::set_timeout(long timeout)
 { _pimpl->SET_timeout(timeout); }
@@ -546,17 +597,21 @@ const string HTTPConnection::DEFAULT_ENCODING("gzip");
 HttpMethod
 HTTPConnection::_set_method(HttpMethod meth)
 {
+    /* clear what the last method left behind so a handle can switch */
     switch( meth ){
     case HttpMethod::http_get:
+        set_option(CURLOPT_CUSTOMREQUEST, static_cast<char*>(nullptr));
         set_option(CURLOPT_HTTPGET, 1L);
         break;
     case HttpMethod::http_post:
+        set_option(CURLOPT_CUSTOMREQUEST, static_cast<char*>(nullptr));
         set_option(CURLOPT_POST, 1L);
         break;
     case HttpMethod::http_delete:
+        set_option(CURLOPT_HTTPGET, 1L); // drop any POST body
         set_option(CURLOPT_CUSTOMREQUEST, "DELETE");
         break;
-    case HttpMethod::http_put:
+    case HttpMethod::http_put: // set_fields() turns the body back on
         set_option(CURLOPT_CUSTOMREQUEST, "PUT");
         break;
     default:
@@ -590,8 +645,9 @@ HTTPConnection::HTTPConnection( HttpMethod meth )
 
 
 void
-HTTPConnection::set_url(const std::string& url)
+HTTPConnection::set_url(const std::string& url_in)
 {
+    string url = apply_url_override(url_in);
     if( url.rfind("https://",0) == 0 ){
         if(_proto != Protocol::https ){
             if( certificate_bundle_path.empty() )
@@ -609,8 +665,53 @@ HTTPConnection::set_url(const std::string& url)
 }
 
 
+CurlShare::CurlShare()
+    : _share( curl_share_init() )
+    {
+        if( !_share )
+            throw CurlException("curl_share_init failed");
+        curl_share_setopt(_share, CURLSHOPT_LOCKFUNC, &CurlShare::_lock);
+        curl_share_setopt(_share, CURLSHOPT_UNLOCKFUNC, &CurlShare::_unlock);
+        curl_share_setopt(_share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+
+CurlShare::~CurlShare()
+{ curl_share_cleanup(_share); }
+
+void
+CurlShare::_lock( CURL *handle,
+                  curl_lock_data data,
+                  curl_lock_access access,
+                  void *ptr )
+{ reinterpret_cast<CurlShare*>(ptr)->_mtxs[data].lock(); }
+
+void
+CurlShare::_unlock(CURL *handle, curl_lock_data data, void *ptr)
+{ reinterpret_cast<CurlShare*>(ptr)->_mtxs[data].unlock(); }
+
+
 std::unordered_map<int, SharedHTTPConnection::Context> SharedHTTPConnection::contexts;
 std::mutex SharedHTTPConnection::contexts_mtx;
+size_t SharedHTTPConnection::pool_size(SharedHTTPConnection::DEF_POOL_SIZE);
+SharedHTTPConnection::PoolStats SharedHTTPConnection::pool_stats{
+    0, 0, 0, clock_ty::duration(0), clock_ty::duration(0), 0
+};
+
+
+SharedHTTPConnection::Handle::Handle( const std::string& url,
+                                      HttpMethod meth,
+                                      CURLSH *share )
+    :
+        conn(url, meth),
+        headers(),
+        timeout(0)
+    {
+        conn.set_share(share);
+        conn.set_http2(true);
+    }
 
 SharedHTTPConnection::SharedHTTPConnection( const std::string& url,
                                             HttpMethod meth,
@@ -624,27 +725,12 @@ SharedHTTPConnection::SharedHTTPConnection( const std::string& url,
         _timeout(0),
         _id(context_id)
     {
+        if( !url.empty() )
+            set_url(url);
+
         { // all 'opening' context ops should hold static mutex
             std::lock_guard<std::mutex> lock(contexts_mtx);
-
-            auto citer = contexts.find(context_id);
-            if( citer == contexts.cend() ){
-                // if new id add a context with new connection
-                contexts[context_id] = Context(
-                        url.empty() ? new HTTPConnection(meth)
-                                    : new HTTPConnection(url,meth)
-                );
-            }else{
-                assert( citer->second.nref > 0 );
-                {
-                    // if old but not all have been closed
-                    std::lock_guard<std::mutex> lock( *(citer->second.mtx) );
-                    citer->second.conn->set_method(meth);
-                    // set url (redundant) to force ssl verify check
-                    if( !url.empty() )
-                        citer->second.conn->set_url(url);
-                }
-            }
+            contexts[context_id]; // handles are opened lazily by execute
             incr_ref(context_id);
         }
         _is_open = true;
@@ -708,46 +794,163 @@ SharedHTTPConnection::operator==( const SharedHTTPConnection& connection )
 
 }
 
-std::tuple<long, std::string, std::string, clock_ty::time_point>
+std::tuple<long, ResponseBuffer, std::string, clock_ty::time_point>
 SharedHTTPConnection::execute(bool return_header_data)
 {
     if( is_closed() )
         throw CurlException("connection has been closed");
 
-    Context& ctx = _get_context();
-    assert( ctx.conn );
-    assert( ctx.mtx );
+    /* pool by scheme/host AND method so we never have to change methods */
+    size_t host_beg = _url.find("://");
+    host_beg = (host_beg == string::npos) ? 0 : host_beg + 3;
+    string key = std::to_string(static_cast<int>(_meth)) + ' '
+               + _url.substr(0, _url.find('/', host_beg));
+
+    Pool *pool = nullptr;
+    std::unique_ptr<Handle> h = _checkout(key, pool);
+    assert( pool );
+
+    try{
+        HTTPConnection& c = h->conn;
+        c.set_url(_url);
+
+        /* only touch what's changed since the handle was last used */
+        if( h->headers != _headers ){
+            c.reset_headers();
+            if( !_headers.empty() )
+                c.add_headers(_headers);
+            h->headers = _headers;
+        }
+
+        if( _meth != HttpMethod::http_get && !_fields.empty() )
+            c.set_fields(_fields);
+        _fields.clear();
+
+        if( h->timeout != _timeout ){
+            c.set_timeout(_timeout);
+            h->timeout = _timeout;
+        }
+
+        auto r = c.execute(return_header_data);
+        _checkin( pool, std::move(h) );
+        return r;
+    }catch(...){
+        _checkin( pool, std::move(h) );
+        throw;
+    }
+}
+
+
+std::unique_ptr<SharedHTTPConnection::Handle>
+SharedHTTPConnection::_checkout(const std::string& key, Pool*& pool)
+{
+    std::unique_lock<std::mutex> lock(contexts_mtx);
+
+    auto citer = contexts.find(_id);
+    assert( citer != contexts.cend() );
+    std::unique_ptr<Pool>& p = citer->second.pools[key];
+    if( !p )
+        p.reset( new Pool() );
+    pool = p.get();
+
+    if( pool->idle.empty() && pool->nout >= pool_size ){
+        ++pool_stats.waits;
+        auto start = clock_ty::now();
+        pool->cond.wait( lock, [&]{
+            return !pool->idle.empty() || pool->nout < pool_size;
+        });
+        auto waited = clock_ty::now() - start;
+        pool_stats.wait_time += waited;
+        if( waited > pool_stats.max_wait_time )
+            pool_stats.max_wait_time = waited;
+    }
+
+    ++(pool->nout);
+    if( !pool->idle.empty() ){
+        ++pool_stats.hits;
+        std::unique_ptr<Handle> h = std::move(pool->idle.back());
+        pool->idle.pop_back();
+        return h;
+    }
+
+    ++pool_stats.misses;
+    ++pool_stats.nhandles;
+    CURLSH *share = pool->share->get();
+    lock.unlock();
+
+    try{
+        return std::unique_ptr<Handle>( new Handle(_url, _meth, share) );
+    }catch(...){
+        lock.lock();
+        --(pool->nout);
+        --pool_stats.nhandles;
+        pool->cond.notify_one();
+        throw;
+    }
+}
+
+
+void
+SharedHTTPConnection::_checkin(Pool *pool, std::unique_ptr<Handle> handle)
+{
+    {
+        std::lock_guard<std::mutex> lock(contexts_mtx);
+        --(pool->nout);
+        if( pool->idle.size() + pool->nout < pool_size ){
+            pool->idle.push_back( std::move(handle) );
+        }else{
+            --pool_stats.nhandles; // pool was shrunk
+            handle.reset();
+        }
+    }
+    pool->cond.notify_one();
+}
+
 
-    // protect from concurrent access by other shared connections
-    std::lock_guard<std::mutex> lock( *ctx.mtx );
+void
+SharedHTTPConnection::set_pool_size(size_t n)
+{
+    if( n < 1 || n > MAX_POOL_SIZE )
+        throw CurlException("invalid pool size");
 
-    ctx.conn->set_url(_url);
+    std::lock_guard<std::mutex> lock(contexts_mtx);
+    pool_size = n;
+    for( auto& c : contexts ){
+        for( auto& p : c.second.pools ){
+            Pool& pool = *p.second;
+            while( !pool.idle.empty() && pool.idle.size() + pool.nout > n ){
+                pool.idle.pop_back();
+                --pool_stats.nhandles;
+            }
+            pool.cond.notify_all();
+        }
+    }
+}
 
-    ctx.conn->reset_headers();
-    if( !_headers.empty() )
-        ctx.conn->add_headers(_headers);
 
-    ctx.conn->set_method(_meth);
-    if( _meth != HttpMethod::http_get && !_fields.empty() )
-        ctx.conn->set_fields(_fields);
-    _fields.clear();
+size_t
+SharedHTTPConnection::get_pool_size()
+{
+    std::lock_guard<std::mutex> lock(contexts_mtx);
+    return pool_size;
+}
 
-    ctx.conn->set_timeout(_timeout);
 
-    return ctx.conn->execute(return_header_data);
+SharedHTTPConnection::PoolStats
+SharedHTTPConnection::get_pool_stats()
+{
+    std::lock_guard<std::mutex> lock(contexts_mtx);
+    return pool_stats;
 }
 
-SharedHTTPConnection::Context&
-SharedHTTPConnection::_get_context() const
+
+void
+SharedHTTPConnection::reset_pool_stats()
 {
     std::lock_guard<std::mutex> lock(contexts_mtx);
-    /*
-     * only hold the static mutex for the find - if open the only
-     *   shared-state at risk of data race is nref which we don't need
-     */
-    auto citer = contexts.find(_id);
-    assert( citer != contexts.cend() );
-    return citer->second;
+    unsigned long long n = pool_stats.nhandles;
+    pool_stats = PoolStats{0, 0, 0, clock_ty::duration(0),
+                           clock_ty::duration(0), n};
 }
 
 void
@@ -782,11 +985,15 @@ SharedHTTPConnection::decr_ref(int id)
 {
     auto citer = contexts.find(id);
     assert( citer != contexts.cend() );
-    assert( citer->second.conn );
+    assert( citer->second.nref > 0 );
     --(citer->second.nref);
-    assert(citer->second.nref >= 0);
-    if( citer->second.nref == 0 )
+    if( citer->second.nref == 0 ){
+        for( auto& p : citer->second.pools ){
+            assert( p.second->nout == 0 );
+            pool_stats.nhandles -= p.second->idle.size();
+        }
         contexts.erase(citer);
+    }
 }
 
 // caller needs to hold static mutex
@@ -795,7 +1002,6 @@ SharedHTTPConnection::incr_ref(int id)
 {
     auto citer = contexts.find(id);
     assert( citer != contexts.cend() );
-    assert( citer->second.conn );
     ++(citer->second.nref);
 }
 
@@ -807,6 +1013,66 @@ SharedHTTPConnection::nconnections(int context_id)
     return (citer == contexts.end()) ? 0 : citer->second.nref;
 }
 
+ResponseBuffer::ResponseBuffer(const std::string& s)
+    : ResponseBuffer()
+    { append(s.data(), s.size()); }
+
+ResponseBuffer::ResponseBuffer( ResponseBuffer&& buffer )
+    :
+        _buf(buffer._buf),
+        _size(buffer._size),
+        _capacity(buffer._capacity)
+    {
+        buffer._buf = nullptr;
+        buffer._size = buffer._capacity = 0;
+    }
+
+ResponseBuffer&
+ResponseBuffer::operator=( ResponseBuffer&& buffer )
+{
+    if( this != &buffer ){
+        free(_buf);
+        _buf = buffer._buf;
+        _size = buffer._size;
+        _capacity = buffer._capacity;
+        buffer._buf = nullptr;
+        buffer._size = buffer._capacity = 0;
+    }
+    return *this;
+}
+
+void
+ResponseBuffer::_grow(size_t capacity)
+{
+    char *buf = reinterpret_cast<char*>( realloc(_buf, capacity + 1) );
+    if( !buf )
+        throw std::bad_alloc();
+    if( !_buf )
+        buf[0] = 0;
+    _buf = buf;
+    _capacity = capacity;
+}
+
+void
+ResponseBuffer::append(const char *data, size_t n)
+{
+    if( _size + n > _capacity )
+        _grow( std::max(_capacity * 2, _size + n) );
+    memcpy(_buf + _size, data, n);
+    _size += n;
+    _buf[_size] = 0;
+}
+
+char*
+ResponseBuffer::release()
+{
+    char *buf = _buf;
+    _buf = nullptr;
+    _size = _capacity = 0;
+    return buf;
+}
+
+
 CurlException::CurlException(string what)
     :
         _what(what)
@@ -961,7 +1227,9 @@ const map<CURLoption, string> CurlConnection::option_strings = {
     { CURLOPT_HTTPHEADER, "CURLOPT_HTTPHEADER"},
     { CURLOPT_NOSIGNAL, "CURLOPT_NOSIGNAL"},
     { CURLOPT_CUSTOMREQUEST, "CURLOPT_CUSTOMREQUEST" },
-    { CURLOPT_TIMEOUT_MS, "CURLOPT_TIMEOUT_MS" }
+    { CURLOPT_TIMEOUT_MS, "CURLOPT_TIMEOUT_MS" },
+    { CURLOPT_HTTP_VERSION, "CURLOPT_HTTP_VERSION" },
+    { CURLOPT_SHARE, "CURLOPT_SHARE" }
 };
 
 
@@ -973,4 +1241,44 @@ std::string
 get_certificate_bundle_path()
 { return certificate_bundle_path; }
 
+
+namespace {
+
+std::mutex url_override_mtx;
+std::atomic<bool> url_override_set(false);
+std::pair<std::string, std::string> url_override;
+
+} /* namespace */
+
+void
+set_url_override( const std::string& from, const std::string& to )
+{
+    std::lock_guard<std::mutex> _(url_override_mtx);
+    url_override = from.empty() ? std::make_pair(string(), string())
+                                : std::make_pair(from, to);
+    url_override_set = !from.empty();
+}
+
+std::string
+get_url_override( const std::string& from )
+{
+    std::lock_guard<std::mutex> _(url_override_mtx);
+    return (url_override_set && url_override.first == from)
+        ? url_override.second
+        : "";
+}
+
+std::string
+apply_url_override( const std::string& url )
+{
+    if( !url_override_set )
+        return url;
+
+    std::lock_guard<std::mutex> _(url_override_mtx);
+    const string& from = url_override.first;
+    if( from.empty() || url.compare(0, from.size(), from) != 0 )
+        return url;
+    return url_override.second + url.substr(from.size());
+}
+
 } /* conn */
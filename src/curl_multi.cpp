@@ -0,0 +1,532 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#include <iostream>
+#include <algorithm>
+
+#include <assert.h>
+
+#include "../include/curl_connect.h"
+
+using std::string;
+using std::vector;
+using std::shared_ptr;
+using std::unordered_set;
+using std::chrono::milliseconds;
+
+namespace {
+
+/* stop setting options after the first failure */
+template<typename T>
+void
+set_option(CURL *handle, CURLcode& ccode, CURLoption option, T param)
+{
+    if( ccode == CURLE_OK )
+        ccode = curl_easy_setopt(handle, option, param);
+}
+
+const bool HAS_HTTP2 =
+    (curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP2);
+
+/* 7.66 added curl_multi_poll, which curl_multi_wakeup can interrupt */
+#if LIBCURL_VERSION_NUM >= 0x074200
+#define CURL_MULTI_HAS_WAKEUP
+#endif
+
+} /* namespace */
+
+
+namespace conn{
+
+class CurlMultiEngine::Transfer{
+public:
+    const id_type id;
+    const HTTPRequest request;
+    const vector<gate_ty> gates;
+    size_t next_gate;
+    callback_ty callback;
+    CURL *handle;
+    struct curl_slist *header_list;
+    ResponseBuffer body;
+    string header;
+    char error_buffer[CURL_ERROR_SIZE + 1];
+
+    Transfer( id_type id,
+              HTTPRequest&& request,
+              vector<gate_ty>&& gates,
+              callback_ty&& callback )
+        :
+            id(id),
+            request( std::move(request) ),
+            gates( std::move(gates) ),
+            next_gate(0),
+            callback( std::move(callback) ),
+            handle(nullptr),
+            header_list(nullptr),
+            body(),
+            header()
+        {
+            error_buffer[0] = error_buffer[CURL_ERROR_SIZE] = 0;
+        }
+
+    static size_t
+    write( char* input, size_t sz, size_t n, void* output )
+    {
+        Transfer *t = reinterpret_cast<Transfer*>(output);
+        try{
+            if( t->body.capacity() == 0 ){
+                curl_off_t len = -1;
+                curl_easy_getinfo( t->handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,
+                                   &len );
+                if( len > 0 )
+                    t->body.reserve( static_cast<size_t>(len) );
+            }
+            t->body.append(input, sz * n);
+        }catch(...){
+            return 0; // CURLE_WRITE_ERROR
+        }
+        return sz * n;
+    }
+
+    static size_t
+    write_header( char* input, size_t sz, size_t n, void* output )
+    {
+        try{
+            reinterpret_cast<Transfer*>(output)->header.append(input, sz * n);
+        }catch(...){
+            return 0;
+        }
+        return sz * n;
+    }
+};
+
+
+/*
+ * longest we'll sit in curl_multi_wait/poll before checking for new
+ * submissions/cancels; w/o curl_multi_wakeup (< 7.66) that's the latency
+ */
+#ifdef CURL_MULTI_HAS_WAKEUP
+const milliseconds CurlMultiEngine::MAX_WAIT(1000);
+#else
+const milliseconds CurlMultiEngine::MAX_WAIT(10);
+#endif
+
+
+CurlMultiEngine&
+CurlMultiEngine::instance()
+{
+    static CurlMultiEngine engine;
+    return engine;
+}
+
+
+CurlMultiEngine::CurlMultiEngine()
+    :
+        _multi( curl_multi_init() ),
+        _free_handles(),
+        _mtx(),
+        _cond(),
+        _incoming(),
+        _active(),
+        _canceled(),
+        _next_id(0),
+        _stop(false),
+        _waiting(),
+        _running(),
+        _thread()
+    {
+        if( !_multi )
+            throw CurlException("curl_multi_init failed");
+        /* requests to the same host share one HTTP/2 connection if possible */
+        curl_multi_setopt(_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        _thread = std::thread( &CurlMultiEngine::_run, this );
+    }
+
+
+CurlMultiEngine::~CurlMultiEngine()
+{
+    {
+        std::lock_guard<std::mutex> _(_mtx);
+        _stop = true;
+    }
+    _wakeup();
+    if( _thread.joinable() )
+        _thread.join();
+
+    /* fail anything that didn't finish so no caller is left waiting */
+    vector<shared_ptr<Transfer>> dead;
+    {
+        std::lock_guard<std::mutex> _(_mtx);
+        dead.swap(_incoming);
+    }
+    for( auto& w : _waiting )
+        dead.push_back(w.second);
+    _waiting.clear();
+    for( auto& r : _running ){
+        curl_multi_remove_handle(_multi, r.first);
+        dead.push_back(r.second);
+    }
+    _running.clear();
+
+    for( auto& t : dead ){
+        HTTPResponse r{0, ResponseBuffer(), clock_ty::now(),
+                       CURLE_ABORTED_BY_CALLBACK, "async engine has been stopped"};
+        _finish(t, std::move(r));
+    }
+
+    for( CURL *h : _free_handles )
+        curl_easy_cleanup(h);
+    curl_multi_cleanup(_multi);
+}
+
+
+CurlMultiEngine::id_type
+CurlMultiEngine::submit( HTTPRequest request,
+                         vector<gate_ty> gates,
+                         callback_ty callback )
+{
+    id_type id;
+    {
+        std::lock_guard<std::mutex> _(_mtx);
+        if( _stop )
+            throw CurlException("async engine has been stopped");
+
+        id = ++_next_id;
+        _incoming.emplace_back(
+            new Transfer( id, std::move(request), std::move(gates),
+                          std::move(callback) )
+            );
+        _active.insert(id);
+    }
+    _wakeup();
+    return id;
+}
+
+
+bool
+CurlMultiEngine::cancel(id_type id)
+{
+    {
+        std::lock_guard<std::mutex> _(_mtx);
+        if( !_active.count(id) )
+            return false;
+        _canceled.insert(id);
+    }
+    _wakeup();
+    return true;
+}
+
+
+void
+CurlMultiEngine::_wakeup()
+{
+    _cond.notify_one();
+#ifdef CURL_MULTI_HAS_WAKEUP
+    curl_multi_wakeup(_multi);
+#endif
+}
+
+
+size_t
+CurlMultiEngine::pending() const
+{
+    std::lock_guard<std::mutex> _(_mtx);
+    return _active.size();
+}
+
+
+void
+CurlMultiEngine::_run()
+{
+    vector<shared_ptr<Transfer>> incoming;
+    unordered_set<id_type> canceled;
+
+    while( true ){
+        {
+            std::unique_lock<std::mutex> lock(_mtx);
+            auto wake = [this]{
+                return !_incoming.empty() || !_canceled.empty() || _stop;
+            };
+            /* nothing in flight; sleep until something arrives or is due */
+            if( _running.empty() && !wake() ){
+                if( _waiting.empty() )
+                    _cond.wait(lock, wake);
+                else
+                    _cond.wait_until(lock, _waiting.begin()->first, wake);
+            }
+            if( _stop )
+                break;
+            incoming.swap(_incoming);
+            canceled.swap(_canceled);
+        }
+
+        auto now = clock_ty::now();
+        for( auto& t : incoming )
+            _waiting.emplace(now, std::move(t));
+        incoming.clear();
+
+        if( !canceled.empty() ){
+            _cancel(canceled);
+            canceled.clear();
+        }
+
+        _admit(now);
+        if( _running.empty() )
+            continue;
+
+        int nrunning = 0;
+        curl_multi_perform(_multi, &nrunning);
+
+        CURLMsg *msg;
+        int nmsgs;
+        while( (msg = curl_multi_info_read(_multi, &nmsgs)) ){
+            if( msg->msg != CURLMSG_DONE )
+                continue;
+
+            CURL *h = msg->easy_handle;
+            CURLcode ccode = msg->data.result;
+            auto r_iter = _running.find(h);
+            assert( r_iter != _running.end() );
+            shared_ptr<Transfer> t = r_iter->second;
+            _running.erase(r_iter);
+            curl_multi_remove_handle(_multi, h);
+
+            HTTPResponse r{0, std::move(t->body), clock_ty::now(), ccode, "",
+                           std::move(t->header)};
+            if( ccode == CURLE_OK )
+                curl_easy_getinfo(h, CURLINFO_RESPONSE_CODE, &r.code);
+            else
+                r.error = t->error_buffer[0] ? t->error_buffer
+                                             : curl_easy_strerror(ccode);
+            _finish(t, std::move(r));
+        }
+
+        if( _running.empty() )
+            continue;
+
+        milliseconds wait(MAX_WAIT);
+        long curl_wait = -1;
+        curl_multi_timeout(_multi, &curl_wait);
+        if( curl_wait >= 0 )
+            wait = std::min(wait, milliseconds(curl_wait));
+        if( !_waiting.empty() ){
+            wait = std::min( wait, std::chrono::duration_cast<milliseconds>(
+                                       _waiting.begin()->first - clock_ty::now()) );
+        }
+        if( wait.count() <= 0 )
+            continue;
+
+#ifdef CURL_MULTI_HAS_WAKEUP
+        /* waits out 'wait' even w/ no fds; submit/cancel wake it early */
+        curl_multi_poll(_multi, nullptr, 0, static_cast<int>(wait.count()), nullptr);
+#else
+        /*
+         * w/ nothing to wait on yet (e.g resolving) curl_multi_wait returns
+         * at once; sleep what's left so we don't spin (nfds is also 0 after
+         * an ordinary timeout, so check the time)
+         */
+        auto t_beg = clock_ty::now();
+        int nfds = 0;
+        curl_multi_wait(_multi, nullptr, 0, static_cast<int>(wait.count()), &nfds);
+        if( nfds == 0 ){
+            auto left = wait - std::chrono::duration_cast<milliseconds>(
+                                   clock_ty::now() - t_beg );
+            if( left > wait / 2 )
+                std::this_thread::sleep_for(left);
+        }
+#endif
+    }
+}
+
+
+void
+CurlMultiEngine::_admit(clock_ty::time_point now)
+{
+    while( !_waiting.empty() && _waiting.begin()->first <= now ){
+        shared_ptr<Transfer> t = _waiting.begin()->second;
+        _waiting.erase( _waiting.begin() );
+
+        bool ready = true;
+        while( t->next_gate < t->gates.size() ){
+            clock_ty::duration d = t->gates[t->next_gate++].reserve();
+            if( d.count() > 0 ){
+                _waiting.emplace(now + d, t);
+                ready = false;
+                break;
+            }
+        }
+        if( ready )
+            _start(t);
+    }
+}
+
+
+bool
+CurlMultiEngine::_start(shared_ptr<Transfer> t)
+{
+    CURL *h;
+    if( _free_handles.empty() ){
+        h = curl_easy_init();
+    }else{
+        h = _free_handles.back();
+        _free_handles.pop_back();
+    }
+    t->handle = h;
+
+    const HTTPRequest& req = t->request;
+    CURLcode ccode = h ? CURLE_OK : CURLE_FAILED_INIT;
+
+    for( auto& hdr : req.headers ){
+        string s = hdr.first + ": " + hdr.second;
+        struct curl_slist *l = curl_slist_append(t->header_list, s.c_str());
+        if( !l ){
+            ccode = CURLE_OUT_OF_MEMORY;
+            break;
+        }
+        t->header_list = l;
+    }
+
+    set_option(h, ccode, CURLOPT_NOSIGNAL, 1L);
+    set_option(h, ccode, CURLOPT_ERRORBUFFER, t->error_buffer);
+    string url = apply_url_override(req.url);
+    set_option(h, ccode, CURLOPT_URL, url.c_str());
+    switch( req.method ){
+    case HttpMethod::http_get:
+        set_option(h, ccode, CURLOPT_HTTPGET, 1L);
+        break;
+    case HttpMethod::http_post:
+        set_option(h, ccode, CURLOPT_POST, 1L);
+        break;
+    case HttpMethod::http_delete:
+        set_option(h, ccode, CURLOPT_CUSTOMREQUEST, "DELETE");
+        break;
+    case HttpMethod::http_put:
+        set_option(h, ccode, CURLOPT_CUSTOMREQUEST, "PUT");
+        break;
+    }
+    if( req.method != HttpMethod::http_get ){
+        set_option(h, ccode, CURLOPT_POSTFIELDSIZE, static_cast<long>(req.fields.size()));
+        set_option(h, ccode, CURLOPT_COPYPOSTFIELDS, req.fields.c_str());
+    }
+    set_option(h, ccode, CURLOPT_ACCEPT_ENCODING, HTTPConnection::DEFAULT_ENCODING.c_str());
+    set_option(h, ccode, CURLOPT_TCP_KEEPALIVE, 1L);
+    if( url.rfind("https://", 0) == 0 ){
+        if( HAS_HTTP2 ){
+            set_option(h, ccode, CURLOPT_HTTP_VERSION,
+                       static_cast<long>(CURL_HTTP_VERSION_2TLS));
+            /* wait for a connection that can multiplex vs. opening another */
+            set_option(h, ccode, CURLOPT_PIPEWAIT, 1L);
+        }
+        set_option(h, ccode, CURLOPT_SSL_VERIFYPEER, 1L);
+        set_option(h, ccode, CURLOPT_SSL_VERIFYHOST, 2L);
+        string ca = get_certificate_bundle_path();
+        if( !ca.empty() )
+            set_option(h, ccode, CURLOPT_CAINFO, ca.c_str());
+    }
+    if( t->header_list )
+        set_option(h, ccode, CURLOPT_HTTPHEADER, t->header_list);
+    set_option(h, ccode, CURLOPT_TIMEOUT_MS, (req.timeout > 0 ? req.timeout : 0L));
+    set_option(h, ccode, CURLOPT_WRITEFUNCTION, &Transfer::write);
+    set_option(h, ccode, CURLOPT_WRITEDATA, t.get());
+    if( req.return_header ){
+        set_option(h, ccode, CURLOPT_HEADERFUNCTION, &Transfer::write_header);
+        set_option(h, ccode, CURLOPT_HEADERDATA, t.get());
+    }
+
+    if( ccode == CURLE_OK
+        && curl_multi_add_handle(_multi, h) == CURLM_OK )
+    {
+        _running.emplace(h, t);
+        return true;
+    }
+
+    HTTPResponse r{0, ResponseBuffer(), clock_ty::now(),
+                   (ccode == CURLE_OK ? CURLE_FAILED_INIT : ccode),
+                   "failed to start transfer"};
+    _finish(t, std::move(r));
+    return false;
+}
+
+
+void
+CurlMultiEngine::_finish(shared_ptr<Transfer> t, HTTPResponse&& r)
+{
+    if( t->handle ){
+        if( _free_handles.size() < MAX_FREE_HANDLES ){
+            curl_easy_reset(t->handle);
+            _free_handles.push_back(t->handle);
+        }else{
+            curl_easy_cleanup(t->handle);
+        }
+        t->handle = nullptr;
+    }
+    if( t->header_list ){
+        curl_slist_free_all(t->header_list);
+        t->header_list = nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> _(_mtx);
+        _active.erase(t->id);
+    }
+
+    try{
+        t->callback( std::move(r) );
+    }catch(std::exception& e){
+        std::cerr<< "exception in async callback: " << e.what() << std::endl;
+    }catch(...){
+        std::cerr<< "exception in async callback" << std::endl;
+    }
+}
+
+
+void
+CurlMultiEngine::_cancel(const unordered_set<id_type>& ids)
+{
+    vector<shared_ptr<Transfer>> dead;
+
+    for( auto w_iter = _waiting.begin(); w_iter != _waiting.end(); ){
+        if( ids.count(w_iter->second->id) ){
+            /* never started; give back what it reserved */
+            Transfer& t = *(w_iter->second);
+            for( size_t i = 0; i < t.next_gate; ++i ){
+                if( t.gates[i].release )
+                    t.gates[i].release();
+            }
+            dead.push_back(w_iter->second);
+            w_iter = _waiting.erase(w_iter);
+        }else
+            ++w_iter;
+    }
+
+    for( auto r_iter = _running.begin(); r_iter != _running.end(); ){
+        if( ids.count(r_iter->second->id) ){
+            curl_multi_remove_handle(_multi, r_iter->first);
+            dead.push_back(r_iter->second);
+            r_iter = _running.erase(r_iter);
+        }else
+            ++r_iter;
+    }
+
+    for( auto& t : dead ){
+        HTTPResponse r{0, ResponseBuffer(), clock_ty::now(),
+                       CURLE_ABORTED_BY_CALLBACK, "canceled"};
+        _finish(t, std::move(r));
+    }
+}
+
+} /* conn */
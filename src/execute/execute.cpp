@@ -15,14 +15,43 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see http://www.gnu.org/licenses.
 */
 #include <iostream>
+#include <condition_variable>
+#include <memory>
+#include <chrono>
 
 #include "../../include/_tdma_api.h"
 #include "../../include/_execute.h"
 
 using std::string;
+using std::vector;
 
 namespace {
 
+/*
+ * what CallImplFromABI would have returned for 'e'; the error response was
+ * already reported when it came back so the caller just gets the code
+ */
+int
+error_code_from_exception(std::exception_ptr eptr)
+{
+    try{
+        std::rethrow_exception(eptr);
+    }catch(tdma::APIException& e){
+        return e.error_code();
+    }catch(conn::CurlException& e){
+        return TDMA_API_ERROR;
+    }catch(std::exception& e){
+        return TDMA_API_STD_EXCEPTION;
+    }catch(...){
+        return TDMA_API_UNKNOWN_EXCEPTION;
+    }
+}
+
+} /* namespace */
+
+
+namespace tdma{
+
 string
 order_id_from_header(const string& header)
 {
@@ -40,18 +69,13 @@ order_id_from_header(const string& header)
     return "";
 }
 
-} /* namespace */
-
-
-namespace tdma{
 
 string
 Execute_SendOrderImpl( Credentials& creds,
                        const string& account_id,
-                       const OrderTicketImpl& order )
+                       const string& body )
 {
     string url = URL_ACCOUNTS + util::url_encode(account_id) + "/orders";
-    string body = order.as_json_string();
 
     if( body.empty() )
         TDMA_API_THROW(ValueException, "order json is empty");
@@ -67,6 +91,13 @@ Execute_SendOrderImpl( Credentials& creds,
 }
 
 
+string
+Execute_SendOrderImpl( Credentials& creds,
+                       const string& account_id,
+                       const OrderTicketImpl& order )
+{ return Execute_SendOrderImpl(creds, account_id, order.as_json_string()); }
+
+
 bool
 Execute_CancelOrderImpl( Credentials& creds,
                          const string& account_id,
@@ -82,6 +113,139 @@ Execute_CancelOrderImpl( Credentials& creds,
     return true;
 }
 
+
+string
+Execute_ReplaceOrderImpl( Credentials& creds,
+                          const string& account_id,
+                          const string& order_id,
+                          const OrderTicketImpl& order )
+{
+    string url = URL_ACCOUNTS + util::url_encode(account_id)
+               + "/orders/" + util::url_encode(order_id);
+    string body = order.as_json_string();
+
+    if( body.empty() )
+        TDMA_API_THROW(ValueException, "order json is empty");
+
+    conn::HTTPConnection connection( url, conn::HttpMethod::http_put );
+    connection.set_fields(body);
+
+    string r_head;
+    conn::clock_ty::time_point r_tp;
+    tie(r_head, r_tp) =
+        connect_execute(connection, creds, conn::HTTP_RESPONSE_CREATED);
+    return order_id_from_header(r_head);
+}
+
+
+/*
+ * all the orders go out at once on the async engine (one I/O thread, shared
+ * connections); blocks until every one has a response or the timeout. A bad
+ * order (empty json) throws before anything is sent, failures after that are
+ * per-order. Each attempt gets EXECUTE_SEND_ORDERS_TIMEOUT_MSEC; a token
+ * refresh means a second one so that's how long we wait, twice over, before
+ * canceling what's left and reporting it as TDMA_API_TIMEOUT_ERROR. The
+ * callbacks share 'state' so one that comes in after we return is harmless.
+ */
+vector<ExecuteResult>
+Execute_SendOrdersImpl( Credentials& creds,
+                        const string& account_id,
+                        const vector<const OrderTicketImpl*>& orders )
+{
+    static const std::chrono::milliseconds WAIT_TIMEOUT(
+        2 * EXECUTE_SEND_ORDERS_TIMEOUT_MSEC );
+
+    string url = URL_ACCOUNTS + util::url_encode(account_id) + "/orders";
+
+    vector<string> bodies;
+    bodies.reserve( orders.size() );
+    for( const OrderTicketImpl *o : orders ){
+        bodies.push_back( o->as_json_string() );
+        if( bodies.back().empty() )
+            TDMA_API_THROW(ValueException, "order json is empty");
+    }
+
+    struct State{
+        std::mutex mtx;
+        std::condition_variable cond;
+        vector<ExecuteResult> results;
+        vector<bool> done;
+        size_t ndone;
+        bool abandoned;
+    };
+
+    auto state = std::make_shared<State>();
+    state->results.resize( orders.size() );
+    state->done.resize( orders.size(), false );
+    state->ndone = 0;
+    state->abandoned = false;
+
+    auto done = [state](size_t i, string id, int err,
+                        conn::clock_ty::time_point tp,
+                        conn::clock_ty::time_point tbeg){
+        std::lock_guard<std::mutex> _(state->mtx);
+        if( state->abandoned || state->done[i] )
+            return;
+        state->results[i].order_id = std::move(id);
+        state->results[i].error = err;
+        state->results[i].elapsed =
+            std::chrono::duration_cast<std::chrono::microseconds>(tp - tbeg);
+        state->done[i] = true;
+        if( ++state->ndone == state->results.size() )
+            state->cond.notify_one();
+    };
+
+    vector<unsigned long long> ids( bodies.size(), 0 );
+    vector<conn::clock_ty::time_point> tbegs( bodies.size() );
+    for( size_t i = 0; i < bodies.size(); ++i ){
+        auto tbeg = tbegs[i] = conn::clock_ty::now();
+        try{
+            ids[i] = connect_execute_async(
+                url, conn::HttpMethod::http_post, bodies[i], creds,
+                conn::HTTP_RESPONSE_CREATED, EXECUTE_SEND_ORDERS_TIMEOUT_MSEC,
+                [done, i, tbeg]( string&& r_head, conn::clock_ty::time_point tp,
+                                 std::exception_ptr e ){
+                    if( e )
+                        done(i, "", error_code_from_exception(e), tp, tbeg);
+                    else
+                        done(i, order_id_from_header(r_head), 0, tp, tbeg);
+                }
+            );
+        }catch(...){
+            done( i, "", error_code_from_exception(std::current_exception()),
+                  conn::clock_ty::now(), tbeg );
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(state->mtx);
+    if( !state->cond.wait_for( lock, WAIT_TIMEOUT,
+            [&]{ return state->ndone == state->results.size(); } ) )
+    {
+        state->abandoned = true;
+        auto now = conn::clock_ty::now();
+        for( size_t i = 0; i < state->results.size(); ++i ){
+            if( state->done[i] )
+                continue;
+            state->results[i].error = TDMA_API_TIMEOUT_ERROR;
+            state->results[i].elapsed =
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    now - tbegs[i] );
+            std::cerr<< "order " << i << " timed out, it may still have "
+                     << "been placed" << std::endl;
+        }
+        lock.unlock();
+        /*
+         * 'done' won't touch 'state' again; ids of re-submits (after a
+         * refresh) aren't known so this is best effort
+         */
+        for( size_t i = 0; i < ids.size(); ++i ){
+            if( ids[i] && !state->done[i] )
+                conn::CurlMultiEngine::instance().cancel(ids[i]);
+        }
+    }
+    return state->results;
+}
+
 } /* tdma */
 
 
@@ -119,6 +283,39 @@ Execute_SendOrder_ABI( Credentials *creds,
     return to_new_char_buffer(r, buf, n, allow_exceptions);
 }
 
+int
+Execute_SendOrderTemplate_ABI( Credentials *creds,
+                               const char* account_id,
+                               OrderTemplate_C *ptemplate,
+                               char** buf,
+                               size_t *n,
+                               int allow_exceptions )
+{
+    int err = proxy_is_callable<OrderTemplateImpl>(ptemplate, allow_exceptions);
+    if( err )
+         return err;
+
+    CHECK_PTR(account_id, "account id", allow_exceptions);
+    CHECK_PTR(buf, "buf", allow_exceptions);
+    CHECK_PTR(n, "n", allow_exceptions);
+
+    static auto meth =
+        +[]( Credentials *c, const char* id, OrderTemplate_C* ptemplate ){
+            return Execute_SendOrderImpl(
+                *c, id,
+                reinterpret_cast<OrderTemplateImpl*>(ptemplate->obj)->body()
+                );
+        };
+
+    string r;
+    std::tie(r,err) = CallImplFromABI( allow_exceptions, meth, creds,
+                                       account_id, ptemplate );
+    if( err )
+        return err;
+
+    return to_new_char_buffer(r, buf, n, allow_exceptions);
+}
+
 int
 Execute_CancelOrder_ABI( Credentials *creds,
                          const char* account_id,
@@ -140,6 +337,94 @@ Execute_CancelOrder_ABI( Credentials *creds,
     return err;
 }
 
+int
+Execute_ReplaceOrder_ABI( Credentials *creds,
+                          const char* account_id,
+                          const char* order_id,
+                          OrderTicket_C *porder,
+                          char** buf,
+                          size_t *n,
+                          int allow_exceptions )
+{
+    int err = proxy_is_callable<OrderTicketImpl>(porder, allow_exceptions);
+    if( err )
+         return err;
+
+    CHECK_PTR(account_id, "account id", allow_exceptions);
+    CHECK_PTR(order_id, "order id", allow_exceptions);
+    CHECK_PTR(buf, "buf", allow_exceptions);
+    CHECK_PTR(n, "n", allow_exceptions);
+
+    static auto meth =
+        +[]( Credentials *c, const char* aid, const char* oid,
+             OrderTicket_C* porder ){
+            return Execute_ReplaceOrderImpl(
+                *c, aid, oid, *reinterpret_cast<OrderTicketImpl*>(porder->obj)
+                );
+        };
+
+    string r;
+    std::tie(r,err) = CallImplFromABI( allow_exceptions, meth, creds,
+                                       account_id, order_id, porder );
+    if( err )
+        return err;
+
+    return to_new_char_buffer(r, buf, n, allow_exceptions);
+}
+
+int
+Execute_SendOrders_ABI( Credentials *creds,
+                        const char* account_id,
+                        OrderTicket_C *orders,
+                        size_t norders,
+                        char ***order_ids,
+                        int *errors,
+                        unsigned long long *usec,
+                        int allow_exceptions )
+{
+    CHECK_PTR(account_id, "account id", allow_exceptions);
+    CHECK_PTR(order_ids, "order ids", allow_exceptions);
+    if( norders ){
+        CHECK_PTR(orders, "orders", allow_exceptions);
+        CHECK_PTR(errors, "errors", allow_exceptions);
+        CHECK_PTR(usec, "usec", allow_exceptions);
+    }
+
+    vector<const OrderTicketImpl*> impls;
+    impls.reserve(norders);
+    for( size_t i = 0; i < norders; ++i ){
+        int err = proxy_is_callable<OrderTicketImpl>(orders + i,
+                                                     allow_exceptions);
+        if( err )
+            return err;
+        impls.push_back( reinterpret_cast<OrderTicketImpl*>(orders[i].obj) );
+    }
+
+    static auto meth =
+        +[]( Credentials *c, const char* id,
+             const vector<const OrderTicketImpl*>* impls ){
+            return Execute_SendOrdersImpl(*c, id, *impls);
+        };
+
+    int err;
+    vector<ExecuteResult> r;
+    std::tie(r,err) = CallImplFromABI( allow_exceptions, meth, creds,
+                                       account_id, &impls );
+    if( err )
+        return err;
+
+    vector<string> ids;
+    ids.reserve(norders);
+    for( size_t i = 0; i < norders; ++i ){
+        ids.push_back( std::move(r[i].order_id) );
+        errors[i] = r[i].error;
+        usec[i] = static_cast<unsigned long long>( r[i].elapsed.count() );
+    }
+
+    size_t n;
+    return to_new_char_buffers(ids, order_ids, &n, allow_exceptions);
+}
+
 
 int
 OrderSession_to_string_ABI( TDMA_API_TO_STRING_ABI_ARGS )
@@ -0,0 +1,456 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#include <iostream>
+
+#include "../../include/_tdma_api.h"
+#include "../../include/_execute.h"
+
+using std::string;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::chrono::milliseconds;
+
+namespace {
+
+void
+D(string msg, tdma::ExecutionSessionImpl *obj)
+{ util::debug_out("ExecutionSessionImpl", msg, obj, std::cout); }
+
+} /* namespace */
+
+
+namespace tdma{
+
+const milliseconds ExecutionSession::DEF_KEEP_WARM(
+    EXECUTION_SESSION_DEF_KEEP_WARM
+    );
+
+
+ExecutionSessionImpl::ExecutionSessionImpl( Credentials& creds,
+                                            const string& account_id,
+                                            milliseconds keep_warm )
+    :
+        /* the keep-warm thread can outlive the caller's credentials */
+        _credentials( copy_connect_creds(creds) ),
+        _account_id(account_id),
+        _account_url(URL_ACCOUNTS + util::url_encode(account_id)),
+        _share(),
+        _connection(conn::HttpMethod::http_get),
+        _warm_connection(_account_url, conn::HttpMethod::http_get),
+        _mtx(),
+        _keep_warm(keep_warm),
+        _last_used(),
+        _warm_cond(),
+        _closing(false),
+        _warm_thread()
+    {
+        if( account_id.empty() )
+            TDMA_API_THROW(ValueException, "empty account_id");
+
+        if( keep_warm.count() < 0 )
+            TDMA_API_THROW(ValueException, "keep_warm < 0");
+
+        _connection.set_share( _share.get() );
+        _warm_connection.set_share( _share.get() );
+
+        /* connect (and check the token) before the first order needs to */
+        _last_used = conn::clock_ty::now();
+        _warm();
+
+        _warm_thread = std::thread( &ExecutionSessionImpl::_warm_loop, this );
+        D("construct", this);
+    }
+
+
+ExecutionSessionImpl::~ExecutionSessionImpl()
+{
+    D("destruct", this);
+    {
+        lock_guard<mutex> _(_mtx);
+        _closing = true;
+    }
+    _warm_cond.notify_all();
+    if( _warm_thread.joinable() )
+        _warm_thread.join();
+}
+
+
+milliseconds
+ExecutionSessionImpl::get_keep_warm() const
+{
+    lock_guard<mutex> _(_mtx);
+    return _keep_warm;
+}
+
+
+void
+ExecutionSessionImpl::set_keep_warm(milliseconds keep_warm)
+{
+    if( keep_warm.count() < 0 )
+        TDMA_API_THROW(ValueException, "keep_warm < 0");
+    {
+        lock_guard<mutex> _(_mtx);
+        _keep_warm = keep_warm;
+    }
+    _warm_cond.notify_all();
+}
+
+
+string
+ExecutionSessionImpl::_execute( conn::HttpMethod meth,
+                                const string& url,
+                                const string& body,
+                                long success_code )
+{
+    _connection.set_method(meth);
+    _connection.set_url(url);
+    if( !body.empty() )
+        _connection.set_fields(body);
+
+    string r_head;
+    conn::clock_ty::time_point r_tp;
+    std::tie(r_head, r_tp) = connect_execute(_connection, *_credentials,
+                                             success_code);
+    _last_used = conn::clock_ty::now();
+    return r_head;
+}
+
+
+void
+ExecutionSessionImpl::_warm()
+{
+    /* the connection goes back to the shared cache for _connection */
+    connect_get(_warm_connection, *_credentials,
+                account_api_on_error_callback);
+}
+
+
+void
+ExecutionSessionImpl::_warm_loop()
+{
+    unique_lock<mutex> lock(_mtx);
+    while( !_closing ){
+        if( _keep_warm.count() == 0 ){
+            _warm_cond.wait(lock);
+            continue;
+        }
+
+        auto due = _last_used + _keep_warm;
+        if( conn::clock_ty::now() < due ){
+            _warm_cond.wait_until(lock, due);
+            continue;
+        }
+
+        /* orders can go out on _connection while we're in the GET */
+        _last_used = conn::clock_ty::now();
+        lock.unlock();
+        D("keep warm", this);
+        try{
+            _warm();
+        }catch( std::exception& e ){
+            /* the next order will reconnect (or throw) on its own */
+            std::cerr<< "ExecutionSession keep-warm failed: " << e.what()
+                     << std::endl;
+        }
+        lock.lock();
+    }
+}
+
+
+string
+ExecutionSessionImpl::_send(const string& body)
+{
+    if( body.empty() )
+        TDMA_API_THROW(ValueException, "order json is empty");
+
+    lock_guard<mutex> _(_mtx);
+    string r_head = _execute( conn::HttpMethod::http_post,
+                              _account_url + "/orders", body,
+                              conn::HTTP_RESPONSE_CREATED );
+    return order_id_from_header(r_head);
+}
+
+
+string
+ExecutionSessionImpl::send_order(const OrderTicketImpl& order)
+{ return _send( order.as_json_string() ); }
+
+
+string
+ExecutionSessionImpl::send_order(const OrderTemplateImpl& order)
+{ return _send( order.body() ); }
+
+
+bool
+ExecutionSessionImpl::cancel_order(const string& order_id)
+{
+    string url = _account_url + "/orders/" + util::url_encode(order_id);
+
+    lock_guard<mutex> _(_mtx);
+    _execute( conn::HttpMethod::http_delete, url, "",
+              conn::HTTP_RESPONSE_OK );
+    return true;
+}
+
+
+string
+ExecutionSessionImpl::replace_order( const string& order_id,
+                                     const OrderTicketImpl& order )
+{
+    string url = _account_url + "/orders/" + util::url_encode(order_id);
+    string body = order.as_json_string();
+    if( body.empty() )
+        TDMA_API_THROW(ValueException, "order json is empty");
+
+    lock_guard<mutex> _(_mtx);
+    string r_head = _execute( conn::HttpMethod::http_put, url, body,
+                              conn::HTTP_RESPONSE_CREATED );
+    return order_id_from_header(r_head);
+}
+
+} /* tdma */
+
+
+using namespace tdma;
+
+int
+ExecutionSession_Create_ABI( Credentials *pcreds,
+                             const char* account_id,
+                             unsigned long keep_warm,
+                             ExecutionSession_C *psession,
+                             int allow_exceptions )
+{
+    CHECK_PTR(psession, "session", allow_exceptions);
+    CHECK_PTR_KILL_PROXY(pcreds, "credentials", allow_exceptions, psession);
+    CHECK_PTR_KILL_PROXY(account_id, "account id", allow_exceptions, psession);
+
+    if( !pcreds->access_token | !pcreds->refresh_token | !pcreds->client_id ){
+        return HANDLE_ERROR_EX( LocalCredentialException,
+                                "invalid credentials struct",
+                                allow_exceptions, psession );
+    }
+
+    static auto meth = +[]( Credentials *c, const char* id,
+                            unsigned long kw ){
+        return new ExecutionSessionImpl(*c, id, milliseconds(kw));
+    };
+
+    int err;
+    ExecutionSessionImpl *obj;
+    std::tie(obj, err) = CallImplFromABI( allow_exceptions, meth, pcreds,
+                                          account_id, keep_warm );
+    if( err ){
+        kill_proxy(psession);
+        return err;
+    }
+
+    psession->obj = reinterpret_cast<void*>(obj);
+    psession->type_id = ExecutionSessionImpl::TYPE_ID_LOW;
+    return 0;
+}
+
+
+int
+ExecutionSession_Destroy_ABI( ExecutionSession_C *psession,
+                              int allow_exceptions )
+{ return destroy_proxy<ExecutionSessionImpl>(psession, allow_exceptions); }
+
+
+int
+ExecutionSession_GetAccountId_ABI( ExecutionSession_C *psession,
+                                   char **buf,
+                                   size_t *n,
+                                   int allow_exceptions )
+{
+    return ImplAccessor<char**>::template
+        get<ExecutionSessionImpl>(
+            psession, &ExecutionSessionImpl::get_account_id, buf, n,
+            allow_exceptions
+        );
+}
+
+
+int
+ExecutionSession_GetKeepWarm_ABI( ExecutionSession_C *psession,
+                                  unsigned long *keep_warm,
+                                  int allow_exceptions )
+{
+    int err = proxy_is_callable<ExecutionSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(keep_warm, "keep_warm", allow_exceptions);
+
+    static auto meth = +[](void *obj){
+        return reinterpret_cast<ExecutionSessionImpl*>(obj)->get_keep_warm();
+    };
+
+    milliseconds kw;
+    std::tie(kw, err) = CallImplFromABI(allow_exceptions, meth, psession->obj);
+    if( err )
+        return err;
+
+    *keep_warm = static_cast<unsigned long>( kw.count() );
+    return 0;
+}
+
+
+int
+ExecutionSession_SetKeepWarm_ABI( ExecutionSession_C *psession,
+                                  unsigned long keep_warm,
+                                  int allow_exceptions )
+{
+    int err = proxy_is_callable<ExecutionSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    static auto meth = +[](void *obj, unsigned long kw){
+        reinterpret_cast<ExecutionSessionImpl*>(obj)
+            ->set_keep_warm( milliseconds(kw) );
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj, keep_warm);
+}
+
+
+int
+ExecutionSession_SendOrder_ABI( ExecutionSession_C *psession,
+                                OrderTicket_C *porder,
+                                char **buf,
+                                size_t *n,
+                                int allow_exceptions )
+{
+    int err = proxy_is_callable<ExecutionSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    err = proxy_is_callable<OrderTicketImpl>(porder, allow_exceptions);
+    if( err )
+         return err;
+
+    CHECK_PTR(buf, "buf", allow_exceptions);
+    CHECK_PTR(n, "n", allow_exceptions);
+
+    static auto meth = +[]( void *obj, OrderTicket_C* porder ){
+        return reinterpret_cast<ExecutionSessionImpl*>(obj)->send_order(
+            *reinterpret_cast<OrderTicketImpl*>(porder->obj)
+            );
+    };
+
+    string r;
+    std::tie(r, err) = CallImplFromABI( allow_exceptions, meth,
+                                        psession->obj, porder );
+    if( err )
+        return err;
+
+    return to_new_char_buffer(r, buf, n, allow_exceptions);
+}
+
+
+int
+ExecutionSession_CancelOrder_ABI( ExecutionSession_C *psession,
+                                  const char* order_id,
+                                  int *success,
+                                  int allow_exceptions )
+{
+    int err = proxy_is_callable<ExecutionSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(order_id, "order id", allow_exceptions);
+    CHECK_PTR(success, "success", allow_exceptions);
+
+    static auto meth = +[]( void *obj, const char* oid ){
+        return reinterpret_cast<ExecutionSessionImpl*>(obj)->cancel_order(oid);
+    };
+
+    std::tie(*success, err) = CallImplFromABI( allow_exceptions, meth,
+                                               psession->obj, order_id );
+    return err;
+}
+
+
+int
+ExecutionSession_ReplaceOrder_ABI( ExecutionSession_C *psession,
+                                   const char* order_id,
+                                   OrderTicket_C *porder,
+                                   char **buf,
+                                   size_t *n,
+                                   int allow_exceptions )
+{
+    int err = proxy_is_callable<ExecutionSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    err = proxy_is_callable<OrderTicketImpl>(porder, allow_exceptions);
+    if( err )
+         return err;
+
+    CHECK_PTR(order_id, "order id", allow_exceptions);
+    CHECK_PTR(buf, "buf", allow_exceptions);
+    CHECK_PTR(n, "n", allow_exceptions);
+
+    static auto meth = +[]( void *obj, const char* oid, OrderTicket_C* porder ){
+        return reinterpret_cast<ExecutionSessionImpl*>(obj)->replace_order(
+            oid, *reinterpret_cast<OrderTicketImpl*>(porder->obj)
+            );
+    };
+
+    string r;
+    std::tie(r, err) = CallImplFromABI( allow_exceptions, meth,
+                                        psession->obj, order_id, porder );
+    if( err )
+        return err;
+
+    return to_new_char_buffer(r, buf, n, allow_exceptions);
+}
+
+
+int
+ExecutionSession_SendOrderTemplate_ABI( ExecutionSession_C *psession,
+                                        OrderTemplate_C *ptemplate,
+                                        char **buf,
+                                        size_t *n,
+                                        int allow_exceptions )
+{
+    int err = proxy_is_callable<ExecutionSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    err = proxy_is_callable<OrderTemplateImpl>(ptemplate, allow_exceptions);
+    if( err )
+         return err;
+
+    CHECK_PTR(buf, "buf", allow_exceptions);
+    CHECK_PTR(n, "n", allow_exceptions);
+
+    static auto meth = +[]( void *obj, OrderTemplate_C* ptemplate ){
+        return reinterpret_cast<ExecutionSessionImpl*>(obj)->send_order(
+            *reinterpret_cast<OrderTemplateImpl*>(ptemplate->obj)
+            );
+    };
+
+    string r;
+    std::tie(r, err) = CallImplFromABI( allow_exceptions, meth,
+                                        psession->obj, ptemplate );
+    if( err )
+        return err;
+
+    return to_new_char_buffer(r, buf, n, allow_exceptions);
+}
@@ -0,0 +1,252 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "../../include/_tdma_api.h"
+#include "../../include/_execute.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+
+/* stand-ins we can find in the dump and swap for slots */
+const string PRICE_TAG("@@price@@");
+const string STOP_PRICE_TAG("@@stopPrice@@");
+const string QUANTITY_TAG("@@quantity@@"); // + leg index
+
+struct Slot{
+    string tag; // quoted, as it appears in the dump
+    string value; // what goes in the slot initially
+    size_t *off;
+    size_t pos; // of 'tag' in the dump
+};
+
+string
+quoted(const string& s)
+{ return '"' + s + '"'; }
+
+} /* namespace */
+
+
+namespace tdma{
+
+OrderTemplateImpl::OrderTemplateImpl(const OrderTicketImpl& order)
+    :
+        _json(),
+        _price_off(string::npos),
+        _stop_price_off(string::npos),
+        _quantity_offs()
+    {
+        json j = order.as_json();
+        vector<Slot> slots;
+
+        auto add_slot = [&](json& field, const string& tag, string value,
+                            size_t *off){
+            field = tag;
+            slots.push_back( Slot{quoted(tag), std::move(value), off, 0} );
+        };
+
+        if( j.count("price") ){
+            string v = quoted( j["price"].get<string>() );
+            add_slot( j["price"], PRICE_TAG, v, &_price_off );
+        }
+
+        if( j.count("stopPrice") ){
+            string v = quoted( j["stopPrice"].get<string>() );
+            add_slot( j["stopPrice"], STOP_PRICE_TAG, v, &_stop_price_off );
+        }
+
+        if( j.count("orderLegCollection") ){
+            json& legs = j["orderLegCollection"];
+            _quantity_offs.resize( legs.size(), string::npos );
+            for( size_t i = 0; i < legs.size(); ++i ){
+                add_slot( legs[i]["quantity"],
+                          QUANTITY_TAG + std::to_string(i),
+                          legs[i]["quantity"].dump(), &_quantity_offs[i] );
+            }
+        }
+
+        string dumped = j.dump();
+
+        for( Slot& s : slots ){
+            s.pos = dumped.find(s.tag);
+            if( s.pos == string::npos
+                || dumped.find(s.tag, s.pos + 1) != string::npos )
+            {
+                TDMA_API_THROW(ValueException,
+                               "failed to locate template field " + s.tag);
+            }
+        }
+        std::sort( slots.begin(), slots.end(),
+                   [](const Slot& l, const Slot& r){ return l.pos < r.pos; } );
+
+        _json.reserve( dumped.size() + slots.size() * SLOT_WIDTH );
+        size_t prev = 0;
+        for( Slot& s : slots ){
+            _json.append(dumped, prev, s.pos - prev);
+            *s.off = _json.size();
+            _json.append(SLOT_WIDTH, ' ');
+            _write_slot(*s.off, s.value.c_str(), s.value.size());
+            prev = s.pos + s.tag.size();
+        }
+        _json.append(dumped, prev, string::npos);
+    }
+
+
+void
+OrderTemplateImpl::_write_slot(size_t off, const char* val, size_t n)
+{
+    if( n > SLOT_WIDTH )
+        TDMA_API_THROW(ValueException, "value too wide for template slot");
+
+    /* json doesn't care about the whitespace after the value */
+    char *p = &_json[off];
+    memcpy(p, val, n);
+    memset(p + n, ' ', SLOT_WIDTH - n);
+}
+
+
+void
+OrderTemplateImpl::set_price(double price)
+{
+    if( _price_off == string::npos )
+        TDMA_API_THROW(ValueException, "template has no price field");
+    if( price <= 0.0 )
+        TDMA_API_THROW(ValueException, "price <= 0");
+
+    string s = quoted( util::to_fixedpoint_string(price) );
+    _write_slot(_price_off, s.c_str(), s.size());
+}
+
+
+void
+OrderTemplateImpl::set_stop_price(double stop_price)
+{
+    if( _stop_price_off == string::npos )
+        TDMA_API_THROW(ValueException, "template has no stopPrice field");
+    if( stop_price <= 0.0 )
+        TDMA_API_THROW(ValueException, "stop_price <= 0");
+
+    string s = quoted( util::to_fixedpoint_string(stop_price) );
+    _write_slot(_stop_price_off, s.c_str(), s.size());
+}
+
+
+void
+OrderTemplateImpl::set_leg_quantity(size_t n, size_t quantity)
+{
+    if( n >= _quantity_offs.size() )
+        TDMA_API_THROW(ValueException, "invalid leg index");
+    if( quantity == 0 )
+        TDMA_API_THROW(ValueException, "quantity == 0");
+
+    char buf[32];
+    int len = snprintf( buf, sizeof(buf), "%llu",
+                        static_cast<unsigned long long>(quantity) );
+    _write_slot(_quantity_offs[n], buf, static_cast<size_t>(len));
+}
+
+} /* tdma */
+
+
+using namespace tdma;
+
+int
+OrderTemplate_Create_ABI( OrderTicket_C *porder,
+                          OrderTemplate_C *ptemplate,
+                          int allow_exceptions )
+{
+    CHECK_PTR(ptemplate, "template", allow_exceptions);
+
+    int err = proxy_is_callable<OrderTicketImpl>(porder, allow_exceptions);
+    if( err ){
+        kill_proxy(ptemplate);
+        return err;
+    }
+
+    static auto meth = +[]( OrderTicket_C *porder ){
+        return new OrderTemplateImpl(
+            *reinterpret_cast<OrderTicketImpl*>(porder->obj)
+            );
+    };
+
+    OrderTemplateImpl *obj;
+    std::tie(obj, err) = CallImplFromABI( allow_exceptions, meth, porder );
+    if( err ){
+        kill_proxy(ptemplate);
+        return err;
+    }
+
+    ptemplate->obj = reinterpret_cast<void*>(obj);
+    ptemplate->type_id = OrderTemplateImpl::TYPE_ID_LOW;
+    return 0;
+}
+
+int
+OrderTemplate_Destroy_ABI( OrderTemplate_C *ptemplate, int allow_exceptions )
+{ return destroy_proxy<OrderTemplateImpl>(ptemplate, allow_exceptions); }
+
+int
+OrderTemplate_SetPrice_ABI( OrderTemplate_C *ptemplate,
+                            double price,
+                            int allow_exceptions )
+{
+    return ImplAccessor<double>::template
+        set<OrderTemplateImpl>(ptemplate, &OrderTemplateImpl::set_price,
+            price, allow_exceptions
+            );
+}
+
+int
+OrderTemplate_SetStopPrice_ABI( OrderTemplate_C *ptemplate,
+                                double stop_price,
+                                int allow_exceptions )
+{
+    return ImplAccessor<double>::template
+        set<OrderTemplateImpl>(ptemplate, &OrderTemplateImpl::set_stop_price,
+            stop_price, allow_exceptions
+            );
+}
+
+int
+OrderTemplate_SetLegQuantity_ABI( OrderTemplate_C *ptemplate,
+                                  size_t n,
+                                  size_t quantity,
+                                  int allow_exceptions )
+{
+    return ImplAccessor<size_t>::template
+        set<OrderTemplateImpl>(ptemplate, &OrderTemplateImpl::set_leg_quantity,
+            n, quantity, allow_exceptions
+            );
+}
+
+int
+OrderTemplate_AsJsonString_ABI( OrderTemplate_C *ptemplate,
+                                char **buf,
+                                size_t *n,
+                                int allow_exceptions )
+{
+    return ImplAccessor<char**>::template
+        get<OrderTemplateImpl>(
+            ptemplate, &OrderTemplateImpl::as_json_string, buf, n,
+            allow_exceptions
+        );
+}
@@ -0,0 +1,377 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#include <iostream>
+#include <cstring>
+
+#include "../include/frame_capture.h"
+#include "../include/json.hpp"
+
+using std::string;
+using std::vector;
+using std::lock_guard;
+using std::unique_lock;
+using std::mutex;
+using std::chrono::milliseconds;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+using std::chrono::duration_cast;
+
+namespace {
+
+const size_t RECORD_HEADER_SIZE = 12;
+
+void
+put_le(unsigned char *p, unsigned long long v, size_t n)
+{
+    for( size_t i = 0; i < n; ++i )
+        p[i] = static_cast<unsigned char>( (v >> (8 * i)) & 0xff );
+}
+
+unsigned long long
+get_le(const unsigned char *p, size_t n)
+{
+    unsigned long long v = 0;
+    for( size_t i = 0; i < n; ++i )
+        v |= static_cast<unsigned long long>(p[i]) << (8 * i);
+    return v;
+}
+
+bool
+read_magic(std::FILE *f)
+{
+    char buf[conn::CAPTURE_MAGIC_SIZE];
+    return std::fread(buf, 1, sizeof(buf), f) == sizeof(buf)
+        && std::memcmp(buf, conn::CAPTURE_MAGIC, sizeof(buf)) == 0;
+}
+
+/* the original session's responses; they'd only confuse this one */
+bool
+is_response(const string& frame)
+{
+    static const string RESPONSE("{\"response\"");
+    size_t i = frame.find_first_not_of(" \t\r\n");
+    return i != string::npos && frame.compare(i, RESPONSE.size(), RESPONSE) == 0;
+}
+
+} /* namespace */
+
+
+namespace conn{
+
+void
+D(string msg, FrameReplayClient *obj)
+{ util::debug_out("FrameReplay", msg, obj, std::cout); }
+
+
+FrameRecorder::FrameRecorder()
+    :
+        _mtx(),
+        _file(nullptr),
+        _active(false),
+        _start()
+    {
+    }
+
+
+FrameRecorder::~FrameRecorder()
+{ stop(); }
+
+
+bool
+FrameRecorder::start(const string& path)
+{
+    lock_guard<mutex> _(_mtx);
+    if( _file ){
+        _active = false;
+        std::fclose(_file);
+    }
+
+    _file = std::fopen(path.c_str(), "wb");
+    if( !_file )
+        return false;
+
+    std::setvbuf(_file, nullptr, _IOFBF, BUFFER_SIZE);
+    std::fwrite(CAPTURE_MAGIC, 1, CAPTURE_MAGIC_SIZE, _file);
+    _start = steady_clock::now();
+    _active = true;
+    return true;
+}
+
+
+void
+FrameRecorder::stop()
+{
+    lock_guard<mutex> _(_mtx);
+    _active = false;
+    if( _file ){
+        std::fclose(_file);
+        _file = nullptr;
+    }
+}
+
+
+void
+FrameRecorder::write(const char *frame, size_t len)
+{
+    if( !_active )
+        return;
+
+    unsigned char hdr[RECORD_HEADER_SIZE];
+
+    lock_guard<mutex> _(_mtx);
+    if( !_file )
+        return;
+
+    /* stamp inside the lock so records are in order */
+    auto nsec = duration_cast<nanoseconds>(steady_clock::now() - _start);
+    put_le(hdr, static_cast<unsigned long long>(nsec.count()), 8);
+    put_le(hdr + 8, static_cast<unsigned long long>(len), 4);
+    std::fwrite(hdr, 1, sizeof(hdr), _file);
+    std::fwrite(frame, 1, len, _file);
+}
+
+
+FrameReplayClient::FrameReplayClient(string path, double speed)
+    :
+        _path(path),
+        _speed(speed),
+        _file(nullptr),
+        _connected(false),
+        _mtx(),
+        _cond(),
+        _responses(),
+        _stop_flag(false),
+        _eof(false),
+        _next(),
+        _has_next(false),
+        _next_nsec(0),
+        _first_nsec(0),
+        _started(false),
+        _start()
+    {
+        D("construct", this);
+    }
+
+
+FrameReplayClient::~FrameReplayClient()
+{
+    D("destruct", this);
+    close(false);
+}
+
+
+bool
+FrameReplayClient::is_capture_file(const string& path)
+{
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if( !f )
+        return false;
+    bool b = read_magic(f);
+    std::fclose(f);
+    return b;
+}
+
+
+void
+FrameReplayClient::connect(milliseconds timeout)
+{
+    D("connect", this);
+    lock_guard<mutex> _(_mtx);
+    if( _file )
+        return;
+
+    _file = std::fopen(_path.c_str(), "rb");
+    if( !_file )
+        return;
+
+    if( !read_magic(_file) ){
+        std::fclose(_file);
+        _file = nullptr;
+        return;
+    }
+
+    _connected = true;
+}
+
+
+void
+FrameReplayClient::close(bool graceful)
+{
+    {
+        lock_guard<mutex> _(_mtx);
+        _connected = false;
+        if( _file ){
+            D("close", this);
+            std::fclose(_file);
+            _file = nullptr;
+        }
+    }
+    _cond.notify_all();
+}
+
+
+void
+FrameReplayClient::send(string msg)
+{
+    using nlohmann::json;
+
+    json resp = json::array();
+    try{
+        json j = json::parse(msg);
+        unsigned long long ts =
+            util::get_msec_since_epoch<std::chrono::system_clock>().count();
+        for( auto& r : j.at("requests") ){
+            resp.push_back( {
+                {"service", r.at("service")},
+                {"requestid", r.at("requestid")},
+                {"command", r.at("command")},
+                {"timestamp", ts},
+                {"content", {{"code", 0}, {"msg", "replay"}}}
+            } );
+        }
+    }catch( json::exception& e ){
+        D(string("ignoring invalid request: ") + e.what(), this);
+        return;
+    }
+
+    {
+        lock_guard<mutex> _(_mtx);
+        _responses.push_back( json{{"response", resp}}.dump() );
+    }
+    _cond.notify_all();
+}
+
+
+void
+FrameReplayClient::push_empty_message()
+{
+    {
+        lock_guard<mutex> _(_mtx);
+        _stop_flag = true;
+    }
+    _cond.notify_all();
+}
+
+
+bool
+FrameReplayClient::_read_next()
+{
+    unsigned char hdr[RECORD_HEADER_SIZE];
+    while( _file ){
+        if( std::fread(hdr, 1, sizeof(hdr), _file) != sizeof(hdr) )
+            return false;
+
+        size_t len = static_cast<size_t>( get_le(hdr + 8, 4) );
+        _next.resize(len);
+        if( len && std::fread(&_next[0], 1, len, _file) != len )
+            return false;
+
+        if( is_response(_next) )
+            continue;
+
+        _next_nsec = get_le(hdr, 8);
+        return true;
+    }
+    return false;
+}
+
+
+steady_clock::time_point
+FrameReplayClient::_due(unsigned long long nsec) const
+{
+    double offset = static_cast<double>(nsec - _first_nsec) / _speed;
+    return _start + nanoseconds( static_cast<long long>(offset) );
+}
+
+
+string
+FrameReplayClient::recv_or_wait_for(milliseconds timeout)
+{
+    unique_lock<mutex> lock(_mtx);
+    _cond.wait_for( lock, timeout,
+                    [this]{ return !_responses.empty() || _stop_flag; } );
+
+    if( _responses.empty() ){
+        _stop_flag = false;
+        return "";
+    }
+
+    string s = std::move( _responses.front() );
+    _responses.pop_front();
+    return s;
+}
+
+
+size_t
+FrameReplayClient::recv_atleast_n_or_wait_for( size_t n,
+                                                milliseconds timeout,
+                                                vector<string>& frames )
+{
+    size_t n0 = frames.size();
+    auto deadline = steady_clock::now() + timeout;
+
+    unique_lock<mutex> lock(_mtx);
+    for( ;; ){
+        while( !_responses.empty() ){
+            frames.push_back( std::move(_responses.front()) );
+            _responses.pop_front();
+        }
+
+        if( _stop_flag ){
+            _stop_flag = false;
+            frames.emplace_back();
+            break;
+        }
+
+        auto now = steady_clock::now();
+        while( frames.size() - n0 < MAX_BATCH ){
+            if( !_has_next ){
+                if( _eof )
+                    break;
+                if( !_read_next() ){
+                    D("end of capture", this);
+                    _eof = true;
+                    frames.emplace_back();
+                    break;
+                }
+                _has_next = true;
+                if( !_started ){
+                    _first_nsec = _next_nsec;
+                    _start = now;
+                    _started = true;
+                }
+            }
+            if( _speed > 0 && _due(_next_nsec) > now )
+                break;
+            frames.push_back( std::move(_next) );
+            _has_next = false;
+        }
+
+        if( frames.size() - n0 >= n || now >= deadline )
+            break;
+
+        auto wake = deadline;
+        if( _has_next && _speed > 0 )
+            wake = std::min( wake, _due(_next_nsec) );
+        _cond.wait_until(lock, wake);
+    }
+
+    return frames.size() - n0;
+}
+
+} /* conn */
@@ -36,9 +36,11 @@ class AccountGetterBaseImpl
     build() = 0;
 
 protected:
-    AccountGetterBaseImpl( Credentials& creds, const string& account_id )
+    AccountGetterBaseImpl( Credentials& creds,
+                           const string& account_id,
+                           EndpointClass endpoint_class = EndpointClass::account )
         :
-           APIGetterImpl(creds, account_api_on_error_callback),
+           APIGetterImpl(creds, account_api_on_error_callback, endpoint_class),
            _account_id(account_id)
         {
            if( account_id.empty() )
@@ -401,7 +403,8 @@ public:
                               bool preferences,
                               bool surrogate_ids )
         :
-            APIGetterImpl(creds, account_api_on_error_callback),
+            APIGetterImpl(creds, account_api_on_error_callback,
+                          EndpointClass::account),
             _streamer_subscription_keys(streamer_subscription_keys),
             _streamer_connection_info(streamer_connection_info),
             _preferences(preferences),
@@ -488,7 +491,7 @@ public:
                      const string& account_id,
                      const string& order_id )
         :
-            AccountGetterBaseImpl(creds, account_id),
+            AccountGetterBaseImpl(creds, account_id, EndpointClass::orders),
             _order_id(order_id)
         {
             if( order_id.empty() )
@@ -555,7 +558,7 @@ public:
                       const string& to_entered_time,
                       OrderStatusType order_status_type )
         :
-            AccountGetterBaseImpl(creds, account_id),
+            AccountGetterBaseImpl(creds, account_id, EndpointClass::orders),
             _nmax_results(nmax_results),
             _from_entered_time(from_entered_time),
             _to_entered_time(to_entered_time),
@@ -633,6 +636,19 @@ public:
     }
 };
 
+json
+get_orders_for_streaming( Credentials& creds,
+                          const string& account_id,
+                          unsigned int nmax_results,
+                          const string& from_entered_time,
+                          const string& to_entered_time )
+{
+    string s = OrdersGetterImpl( creds, account_id, nmax_results,
+                                 from_entered_time, to_entered_time,
+                                 OrderStatusType::ALL ).get();
+    return s.empty() ? json::array() : json::parse(s);
+}
+
 } /* tdma */
 
 using namespace tdma;
@@ -20,6 +20,7 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <regex>
 #include <cctype>
 #include <mutex>
+#include <thread>
 #include <string.h>
 
 #include "../../include/_tdma_api.h"
@@ -34,31 +35,131 @@ namespace tdma{
 
 const milliseconds APIGetterImpl::DEF_WAIT_MSEC(500);
 
-milliseconds APIGetterImpl::wait_msec(APIGetterImpl::DEF_WAIT_MSEC);
-milliseconds APIGetterImpl::last_get_msec(
-    util::get_msec_since_epoch<conn::clock_ty>()
-    );
+TokenBucket APIGetterImpl::throttle(APIGetterImpl::DEF_WAIT_MSEC,
+                                    APIGetterImpl::DEF_BURST);
 
-std::mutex APIGetterImpl::get_mtx;
+/* no per-endpoint limits by default, just the overall 'throttle' */
+TokenBucket APIGetterImpl::endpoint_throttles[] = {
+    {milliseconds(0), 1}, // quotes
+    {milliseconds(0), 1}, // history
+    {milliseconds(0), 1}, // account
+    {milliseconds(0), 1}, // orders
+    {milliseconds(0), 1}  // other
+};
 
 int APIGetterImpl::current_connection_group = 0;
 
+
+TokenBucket::TokenBucket(milliseconds interval, unsigned int burst)
+    :
+        _interval(interval),
+        _burst(burst),
+        _tokens(burst),
+        _last( conn::clock_ty::now() ),
+        _mtx()
+    {
+    }
+
+void
+TokenBucket::_refill(conn::clock_ty::time_point now)
+{
+    if( _interval.count() > 0 ){
+        std::chrono::duration<double, std::milli> elapsed = now - _last;
+        _tokens = std::min<double>( _burst,
+                                    _tokens + elapsed.count() / _interval.count() );
+    }else{
+        _tokens = _burst;
+    }
+    _last = now;
+}
+
+conn::clock_ty::duration
+TokenBucket::reserve()
+{
+    std::lock_guard<std::mutex> _(_mtx);
+    if( _interval.count() == 0 )
+        return conn::clock_ty::duration(0);
+
+    _refill( conn::clock_ty::now() );
+    _tokens -= 1.0; // reserve ours, even if we have to wait for it
+    if( _tokens >= 0.0 )
+        return conn::clock_ty::duration(0);
+
+    std::chrono::duration<double, std::milli> wait(
+        -_tokens * _interval.count()
+        );
+    return std::chrono::duration_cast<conn::clock_ty::duration>(wait);
+}
+
+void
+TokenBucket::release()
+{
+    std::lock_guard<std::mutex> _(_mtx);
+    if( _interval.count() == 0 )
+        return;
+
+    _refill( conn::clock_ty::now() );
+    _tokens = std::min<double>( _burst, _tokens + 1.0 );
+}
+
+void
+TokenBucket::acquire()
+{
+    auto wait = reserve();
+    if( wait.count() > 0 )
+        std::this_thread::sleep_for(wait);
+}
+
+milliseconds
+TokenBucket::wait_remaining()
+{
+    std::lock_guard<std::mutex> _(_mtx);
+    _refill( conn::clock_ty::now() );
+    if( _tokens >= 1.0 )
+        return milliseconds(0);
+    return milliseconds(
+        static_cast<long long>( (1.0 - _tokens) * _interval.count() + 0.5 )
+        );
+}
+
+void
+TokenBucket::set(milliseconds interval, unsigned int burst)
+{
+    std::lock_guard<std::mutex> _(_mtx);
+    _refill( conn::clock_ty::now() );
+    _interval = interval;
+    _burst = burst;
+    if( _tokens > _burst )
+        _tokens = _burst;
+}
+
+std::pair<milliseconds, unsigned int>
+TokenBucket::get() const
+{
+    std::lock_guard<std::mutex> _(_mtx);
+    return std::make_pair(_interval, _burst);
+}
+
+
 APIGetterImpl::APIGetterImpl( Credentials& creds,
-                              api_on_error_cb_ty on_error_callback )
+                              api_on_error_cb_ty on_error_callback,
+                              EndpointClass endpoint_class )
     :
         _on_error_callback(on_error_callback),
         _credentials(creds),
         _connection(
             (current_connection_group < 0)
-                ? reinterpret_cast<conn::HTTPConnectionInterface*>(
+                ? static_cast<conn::HTTPConnectionInterface*>(
                         new conn::HTTPConnection(conn::HttpMethod::http_get)
                         )
-                : reinterpret_cast<conn::HTTPConnectionInterface*>(
+                : static_cast<conn::HTTPConnectionInterface*>(
                         new conn::SharedHTTPConnection(
                                 conn::HttpMethod::http_get,
                                 current_connection_group)
                         )
-                )
+                ),
+        _endpoint_class(endpoint_class),
+        _get_mtx( new std::mutex() )
     {
     }
 
@@ -70,6 +171,12 @@ APIGetterImpl::set_url(const string& url)
 
 string
 APIGetterImpl::get()
+{
+    return APIGetterImpl::throttled_get(*this).str();
+}
+
+conn::ResponseBuffer
+APIGetterImpl::get_buffer()
 {
     return APIGetterImpl::throttled_get(*this);
 }
@@ -98,63 +205,91 @@ APIGetterImpl::get_timeout() const
     return milliseconds( _connection->get_timeout() );
 }
 
-string
+conn::ResponseBuffer
 APIGetterImpl::throttled_get(APIGetterImpl& getter)
 {
     /*
-     * get_mtx allows threaded api execution from different getters in
-     * different threads AND the same getter in different threads.
+     * _get_mtx allows the same getter in different threads. Different
+     * getters run concurrently once admitted by the endpoint throttle
+     * AND the global throttle (to avoid excessive calls to TDMA servers).
      *
      * IT DOESN'T HANDLE OTHER OTHER SYNC ISSUES INSIDE THE CurlConnection
-     * CLASSES.
+     * CLASSES. (Token refreshes of shared credentials are serialized in
+     * connect().)
      */
-    std::lock_guard<std::mutex> _(get_mtx);
-
-    auto remaining = throttled_wait_remaining();
-    if( remaining.count() > 0 ){
-        /*
-         * wait_msec and last_get_msec provide a global throttling mechanism
-         * for ALL get requests to avoid excessive calls to TDMA servers
-         */
-        assert( remaining <= wait_msec );
-        std::this_thread::sleep_for( remaining );
-    }
+    std::lock_guard<std::mutex> _(*getter._get_mtx);
 
-    string s;
-    conn::clock_ty::time_point tp;
-    tie(s, tp) = connect_get( *(getter._connection), getter._credentials,
-                              getter._on_error_callback );
+    endpoint_throttles[ static_cast<int>(getter._endpoint_class) ].acquire();
+    throttle.acquire();
 
-    last_get_msec =
-        std::chrono::duration_cast<milliseconds>(tp.time_since_epoch());
-    return s;
+    return connect_get( *(getter._connection), getter._credentials,
+                        getter._on_error_callback ).first;
 }
 
-milliseconds
-APIGetterImpl::throttled_wait_remaining()
+std::vector<conn::CurlMultiEngine::gate_ty>
+APIGetterImpl::throttle_gates() const
+{
+    /* same order as throttled_get; each reservation is made when it's reached */
+    TokenBucket *endpoint = &endpoint_throttles[ static_cast<int>(_endpoint_class) ];
+    return { { [endpoint](){ return endpoint->reserve(); },
+               [endpoint](){ endpoint->release(); } },
+             { [](){ return throttle.reserve(); },
+               [](){ throttle.release(); } } };
+}
+
+unsigned long long
+APIGetterImpl::get_async(async_callback_ty callback)
 {
-    auto elapsed = util::get_msec_since_epoch<conn::clock_ty>() - last_get_msec;
-    assert( elapsed.count() >= 0 );
-    return wait_msec - elapsed;
+    std::lock_guard<std::mutex> _(*_get_mtx);
+    return connect_get_async( *_connection, _credentials, _on_error_callback,
+                              throttle_gates(), callback );
 }
 
+bool
+APIGetterImpl::cancel_async(unsigned long long id)
+{ return conn::CurlMultiEngine::instance().cancel(id); }
+
+size_t
+APIGetterImpl::pending_async()
+{ return conn::CurlMultiEngine::instance().pending(); }
+
 milliseconds
 APIGetterImpl::wait_remaining()
+{ return throttle.wait_remaining(); }
+
+void
+APIGetterImpl::set_wait_msec(milliseconds msec)
+{ throttle.set(msec, throttle.get().second); }
+
+milliseconds
+APIGetterImpl::get_wait_msec()
+{ return throttle.get().first; }
+
+void
+APIGetterImpl::set_burst(unsigned int burst)
 {
-    static const milliseconds ms0(0);
-    return max(throttled_wait_remaining(), ms0);
+    if( burst < 1 || burst > MAX_BURST )
+        TDMA_API_THROW(ValueException, "invalid burst");
+    throttle.set(throttle.get().first, burst);
 }
 
+unsigned int
+APIGetterImpl::get_burst()
+{ return throttle.get().second; }
+
 void
-APIGetterImpl::set_wait_msec(milliseconds msec)
+APIGetterImpl::set_endpoint_throttle( EndpointClass endpoint_class,
+                                      milliseconds msec,
+                                      unsigned int burst )
 {
-    std::lock_guard<std::mutex> _(get_mtx);
-    wait_msec = msec;
+    if( burst < 1 || burst > MAX_BURST )
+        TDMA_API_THROW(ValueException, "invalid burst");
+    endpoint_throttles[ static_cast<int>(endpoint_class) ].set(msec, burst);
 }
 
-milliseconds
-APIGetterImpl::get_wait_msec()
-{ return wait_msec; }
+std::pair<milliseconds, unsigned int>
+APIGetterImpl::get_endpoint_throttle(EndpointClass endpoint_class)
+{ return endpoint_throttles[ static_cast<int>(endpoint_class) ].get(); }
 
 } /* tdma */
 
@@ -167,10 +302,102 @@ APIGetter_Get_ABI( Getter_C *pgetter,
                    size_t *n,
                    int allow_exceptions )
 {
-    return ImplAccessor<char**>::template
-        get<APIGetterImpl>(
-            pgetter, &APIGetterImpl::get, buf, n, allow_exceptions
-        );
+    int err = proxy_is_callable<APIGetterImpl>(pgetter, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(buf, "buf", allow_exceptions);
+    CHECK_PTR(n, "n", allow_exceptions);
+
+    /* hand over the buffer curl wrote into rather than copying it */
+    static auto meth = +[](void* obj, char **buf, size_t *n){
+        conn::ResponseBuffer r = reinterpret_cast<APIGetterImpl*>(obj)->get_buffer();
+        *n = r.size() + 1;
+        *buf = r.release();
+        if( !*buf ){
+            *buf = reinterpret_cast<char*>( calloc(1,1) );
+            if( !*buf )
+                TDMA_API_THROW(MemoryError, "failed to allocate buffer memory");
+        }
+    };
+
+    return CallImplFromABI( allow_exceptions, meth, pgetter->obj, buf, n );
+}
+
+namespace {
+
+/* like CallImplFromABI's handlers but w/o touching the (global) error state */
+std::pair<int, string>
+error_from_exception(std::exception_ptr e)
+{
+    try{
+        std::rethrow_exception(e);
+    }catch(APIException& e){
+        return {e.error_code(), e.what()};
+    }catch(conn::CurlException& e){
+        return {TDMA_API_ERROR, e.what()};
+    }catch(std::exception& e){
+        return {TDMA_API_STD_EXCEPTION, e.what()};
+    }catch(...){
+        return {TDMA_API_UNKNOWN_EXCEPTION, "unknown exception"};
+    }
+}
+
+} /* namespace */
+
+int
+APIGetter_GetAsync_ABI( Getter_C *pgetter,
+                        get_async_cb_ty callback,
+                        void *ctx,
+                        unsigned long long *id,
+                        int allow_exceptions )
+{
+    int err = proxy_is_callable<APIGetterImpl>(pgetter, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(callback, "callback", allow_exceptions);
+    CHECK_PTR(id, "id", allow_exceptions);
+
+    static auto meth = +[](void* obj, get_async_cb_ty cb, void *ctx){
+        return reinterpret_cast<APIGetterImpl*>(obj)->get_async(
+            [cb, ctx](conn::ResponseBuffer&& r, std::exception_ptr e){
+                if( !e ){
+                    cb(0, r.data(), r.size() + 1, ctx);
+                    return;
+                }
+                std::pair<int, string> err = error_from_exception(e);
+                cb(err.first, err.second.c_str(), err.second.size() + 1, ctx);
+            });
+    };
+
+    tie(*id, err) = CallImplFromABI( allow_exceptions, meth, pgetter->obj,
+                                     callback, ctx );
+    return err;
+}
+
+int
+APIGetter_CancelAsync_ABI( unsigned long long id,
+                           int *canceled,
+                           int allow_exceptions )
+{
+    CHECK_PTR(canceled, "canceled", allow_exceptions);
+
+    int err;
+    tie(*canceled, err) = CallImplFromABI( allow_exceptions,
+                                           APIGetterImpl::cancel_async, id );
+    return err;
+}
+
+int
+APIGetter_PendingAsync_ABI(size_t *n, int allow_exceptions)
+{
+    CHECK_PTR(n, "n", allow_exceptions);
+
+    int err;
+    tie(*n, err) = CallImplFromABI( allow_exceptions,
+                                    APIGetterImpl::pending_async );
+    return err;
 }
 
 int
@@ -287,6 +514,60 @@ APIGetter_WaitRemaining_ABI(unsigned long long *msec, int allow_exceptions)
     return 0;
 }
 
+int
+APIGetter_SetBurst_ABI(unsigned int burst, int allow_exceptions)
+{
+    return CallImplFromABI( allow_exceptions, APIGetterImpl::set_burst, burst );
+}
+
+int
+APIGetter_GetBurst_ABI(unsigned int *burst, int allow_exceptions)
+{
+    CHECK_PTR(burst, "burst", allow_exceptions);
+
+    int err;
+    tie(*burst, err) = CallImplFromABI( allow_exceptions,
+                                        APIGetterImpl::get_burst );
+    return err;
+}
+
+int
+APIGetter_SetEndpointThrottle_ABI( int endpoint_class,
+                                   unsigned long long msec,
+                                   unsigned int burst,
+                                   int allow_exceptions )
+{
+    CHECK_ENUM(EndpointClass, endpoint_class, allow_exceptions);
+
+    return CallImplFromABI( allow_exceptions,
+                            APIGetterImpl::set_endpoint_throttle,
+                            static_cast<EndpointClass>(endpoint_class),
+                            milliseconds(msec), burst );
+}
+
+int
+APIGetter_GetEndpointThrottle_ABI( int endpoint_class,
+                                   unsigned long long *msec,
+                                   unsigned int *burst,
+                                   int allow_exceptions )
+{
+    CHECK_ENUM(EndpointClass, endpoint_class, allow_exceptions);
+    CHECK_PTR(msec, "msec", allow_exceptions);
+    CHECK_PTR(burst, "burst", allow_exceptions);
+
+    std::pair<milliseconds, unsigned int> p;
+    int err;
+    tie(p, err) = CallImplFromABI( allow_exceptions,
+                                   APIGetterImpl::get_endpoint_throttle,
+                                   static_cast<EndpointClass>(endpoint_class) );
+    if( err )
+        return err;
+
+    *msec = static_cast<unsigned long long>(p.first.count());
+    *burst = p.second;
+    return 0;
+}
+
 int
 APIGetter_ShareConnections_ABI(int b, int allow_exceptions)
 {
@@ -303,6 +584,79 @@ APIGetter_IsSharingConnections_ABI(int *b, int allow_exceptions)
     return 0;
 }
 
+int
+APIGetter_SetConnectionPoolSize_ABI(unsigned int n, int allow_exceptions)
+{
+    if( n < 1 || n > conn::SharedHTTPConnection::MAX_POOL_SIZE ){
+        return HANDLE_ERROR( tdma::ValueException, "invalid pool size",
+                             allow_exceptions );
+    }
+
+    static auto meth = +[](unsigned int n){
+        conn::SharedHTTPConnection::set_pool_size(n);
+    };
+
+    return CallImplFromABI( allow_exceptions, meth, n );
+}
+
+int
+APIGetter_GetConnectionPoolSize_ABI(unsigned int *n, int allow_exceptions)
+{
+    CHECK_PTR(n, "n", allow_exceptions);
+
+    *n = static_cast<unsigned int>(
+        conn::SharedHTTPConnection::get_pool_size() );
+    return 0;
+}
+
+int
+APIGetter_GetConnectionPoolStats_ABI( ConnectionPoolStats *stats,
+                                      int allow_exceptions )
+{
+    CHECK_PTR(stats, "stats", allow_exceptions);
+
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    conn::SharedHTTPConnection::PoolStats s =
+        conn::SharedHTTPConnection::get_pool_stats();
+    stats->hits = s.hits;
+    stats->misses = s.misses;
+    stats->waits = s.waits;
+    stats->wait_usec = duration_cast<microseconds>(s.wait_time).count();
+    stats->max_wait_usec = duration_cast<microseconds>(s.max_wait_time).count();
+    stats->nhandles = s.nhandles;
+    return 0;
+}
+
+int
+APIGetter_ResetConnectionPoolStats_ABI(int allow_exceptions)
+{
+    conn::SharedHTTPConnection::reset_pool_stats();
+    return 0;
+}
+
+int
+EndpointClass_to_string_ABI( TDMA_API_TO_STRING_ABI_ARGS )
+{
+    CHECK_ENUM(EndpointClass, v, allow_exceptions);
+
+    switch(static_cast<EndpointClass>(v)){
+    case EndpointClass::quotes:
+        return to_new_char_buffer("quotes", buf, n, allow_exceptions);
+    case EndpointClass::history:
+        return to_new_char_buffer("history", buf, n, allow_exceptions);
+    case EndpointClass::account:
+        return to_new_char_buffer("account", buf, n, allow_exceptions);
+    case EndpointClass::orders:
+        return to_new_char_buffer("orders", buf, n, allow_exceptions);
+    case EndpointClass::other:
+        return to_new_char_buffer("other", buf, n, allow_exceptions);
+    default:
+        throw std::runtime_error("invalid EndpointClass");
+    }
+}
+
 int
 PeriodType_to_string_ABI( TDMA_API_TO_STRING_ABI_ARGS )
 {
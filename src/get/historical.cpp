@@ -64,7 +64,8 @@ protected:
                               unsigned int frequency,
                               bool extended_hours )
         :
-            APIGetterImpl(creds, data_api_on_error_callback),
+            APIGetterImpl(creds, data_api_on_error_callback,
+                          EndpointClass::history),
             _symbol( util::toupper(symbol) ),
             _frequency_type(frequency_type),
             _frequency(frequency),
@@ -425,6 +426,38 @@ HistoricalGetterBase_SetFrequency_ABI( Getter_C *pgetter,
             );
 }
 
+int
+HistoricalGetterBase_GetCandles_ABI( Getter_C *pgetter,
+                                     HistoricalCandles_C **pcandles,
+                                     int allow_exceptions )
+{
+    int err = proxy_is_callable<HistoricalGetterBaseImpl>(
+        pgetter, allow_exceptions
+        );
+    if( err )
+        return err;
+
+    CHECK_PTR(pcandles, "pcandles", allow_exceptions);
+
+    static auto meth = +[](void* obj){
+        conn::ResponseBuffer r =
+            reinterpret_cast<HistoricalGetterBaseImpl*>(obj)->get_buffer();
+        return decode_historical_candles(r.data(), r.data() + r.size());
+    };
+
+    tie(*pcandles, err) = CallImplFromABI(allow_exceptions, meth, pgetter->obj);
+    return err;
+}
+
+int
+FreeHistoricalCandlesBuffer_ABI( HistoricalCandles_C *candles,
+                                 int allow_exceptions )
+{
+    if( candles )
+        free( (void*)candles );
+    return 0;
+}
+
 /* HistoricalPeriodGetter */
 int
 HistoricalPeriodGetter_Create_ABI( struct Credentials *pcreds,
@@ -0,0 +1,238 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+#include "../../include/_tdma_api.h"
+#include "../../include/_get.h"
+#include "../../include/_sax.h"
+
+using std::vector;
+
+namespace {
+
+using namespace tdma;
+
+enum class CandlesLevel{
+    root,
+    candles,
+    candle
+};
+
+/*
+ * SAX handler for the 'pricehistory' response:
+ *
+ *   { "candles" : [ {"open":, "high":, "low":, "close":, "volume":,
+ *                    "datetime":}, ... ],
+ *     "symbol" : "", "empty" : false }
+ *
+ * each candle field is appended to its own column as it's read
+ */
+class HistoricalCandlesSAX
+        : public LevelSAX<HistoricalCandlesSAX, CandlesLevel> {
+    friend class LevelSAX<HistoricalCandlesSAX, CandlesLevel>;
+    typedef CandlesLevel Level;
+
+    enum class Target{
+        none,
+        symbol,
+        empty,
+        datetime,
+        open,
+        high,
+        low,
+        close,
+        volume
+    };
+
+    Target _target; // of the next scalar
+    bool _next_is_candles;
+
+    std::string _symbol;
+    bool _empty;
+    vector<long long> _datetime;
+    vector<double> _open;
+    vector<double> _high;
+    vector<double> _low;
+    vector<double> _close;
+    vector<long long> _volume;
+
+    static bool
+    _is_value(Level l)
+    { return l == Level::root || l == Level::candle; }
+
+    template<typename T>
+    void
+    _store(T v)
+    {
+        switch( _target ){
+        case Target::empty: _empty = static_cast<bool>(v); break;
+        case Target::datetime: _datetime.back() = static_cast<long long>(v); break;
+        case Target::open: _open.back() = static_cast<double>(v); break;
+        case Target::high: _high.back() = static_cast<double>(v); break;
+        case Target::low: _low.back() = static_cast<double>(v); break;
+        case Target::close: _close.back() = static_cast<double>(v); break;
+        case Target::volume: _volume.back() = static_cast<long long>(v); break;
+        default: break;
+        }
+        _target = Target::none;
+    }
+
+    void
+    _store_string(const std::string& s)
+    {
+        if( _target == Target::symbol )
+            _symbol = s;
+        _target = Target::none;
+    }
+
+    void
+    _clear_target()
+    { _target = Target::none; }
+
+    void
+    _on_key(const std::string& val)
+    {
+        _next_is_candles = false;
+        if( _levels.back() == Level::root ){
+            if( val == "candles" )
+                _next_is_candles = true;
+            else if( val == "symbol" )
+                _target = Target::symbol;
+            else if( val == "empty" )
+                _target = Target::empty;
+        }else if( _levels.back() == Level::candle ){
+            switch( val.empty() ? '\0' : val[0] ){
+            case 'd': if( val == "datetime" ) _target = Target::datetime; break;
+            case 'o': if( val == "open" ) _target = Target::open; break;
+            case 'h': if( val == "high" ) _target = Target::high; break;
+            case 'l': if( val == "low" ) _target = Target::low; break;
+            case 'c': if( val == "close" ) _target = Target::close; break;
+            case 'v': if( val == "volume" ) _target = Target::volume; break;
+            default: break;
+            }
+        }
+    }
+
+    bool
+    _enter_object(Level parent, Level *child)
+    {
+        if( parent != Level::candles )
+            return false;
+        _datetime.push_back(0);
+        _open.push_back(0.0);
+        _high.push_back(0.0);
+        _low.push_back(0.0);
+        _close.push_back(0.0);
+        _volume.push_back(0);
+        *child = Level::candle;
+        return true;
+    }
+
+    bool
+    _enter_array(Level parent, std::size_t n, Level *child)
+    {
+        bool is_candles = (parent == Level::root && _next_is_candles);
+        _next_is_candles = false;
+        if( !is_candles )
+            return false;
+        if( n != static_cast<std::size_t>(-1) ){
+            _datetime.reserve(n);
+            _open.reserve(n);
+            _high.reserve(n);
+            _low.reserve(n);
+            _close.reserve(n);
+            _volume.reserve(n);
+        }
+        *child = Level::candles;
+        return true;
+    }
+
+public:
+    HistoricalCandlesSAX()
+        :
+            _target(Target::none),
+            _next_is_candles(false),
+            _symbol(),
+            _empty(false)
+        {
+        }
+
+    /* copy the columns into one block */
+    HistoricalCandles_C*
+    finish() const
+    {
+        size_t n = _datetime.size();
+        size_t col_bytes = n * 8; // long long and double
+
+        static_assert( sizeof(long long) == 8 && sizeof(double) == 8,
+                       "8 byte columns expected" );
+
+        size_t off_cols = (sizeof(HistoricalCandles_C) + 7) & ~static_cast<size_t>(7);
+        size_t off_chars = off_cols + 6 * col_bytes;
+
+        char *block = reinterpret_cast<char*>(
+            malloc(off_chars + _symbol.size() + 1) );
+        if( !block )
+            TDMA_API_THROW(MemoryError, "failed to allocate candles buffer");
+
+        HistoricalCandles_C *candles =
+            reinterpret_cast<HistoricalCandles_C*>(block);
+        char *cols = block + off_cols;
+        char *chars = block + off_chars;
+
+        auto copy_col = [&](const void *src) -> char* {
+            char *p = cols;
+            if( col_bytes )
+                memcpy(cols, src, col_bytes);
+            cols += col_bytes;
+            return p;
+        };
+
+        candles->datetime = reinterpret_cast<long long*>( copy_col(_datetime.data()) );
+        candles->open = reinterpret_cast<double*>( copy_col(_open.data()) );
+        candles->high = reinterpret_cast<double*>( copy_col(_high.data()) );
+        candles->low = reinterpret_cast<double*>( copy_col(_low.data()) );
+        candles->close = reinterpret_cast<double*>( copy_col(_close.data()) );
+        candles->volume = reinterpret_cast<long long*>( copy_col(_volume.data()) );
+        candles->ncandles = n;
+        candles->empty = static_cast<int>(_empty);
+        memcpy(chars, _symbol.c_str(), _symbol.size() + 1);
+        candles->symbol = chars;
+        return candles;
+    }
+};
+
+} /* namespace */
+
+
+namespace tdma {
+
+HistoricalCandles_C*
+decode_historical_candles(const char *first, const char *last)
+{
+    HistoricalCandlesSAX sax;
+    if( !json::sax_parse(first, last, &sax) )
+        TDMA_API_THROW(ValueException,
+                       "failed to decode candles: " + sax.error());
+    return sax.finish();
+}
+
+} /* tdma */
@@ -63,7 +63,8 @@ public:
                               InstrumentSearchType search_type,
                               const string& query_string )
         :
-            APIGetterImpl(creds, query_api_on_error_callback),
+            APIGetterImpl(creds, query_api_on_error_callback,
+                          EndpointClass::other),
             _query_string(query_string),
             _search_type(search_type)
         {
@@ -57,7 +57,8 @@ public:
                            MarketType market_type,
                            const string& date )
         :
-            APIGetterImpl(creds, data_api_on_error_callback),
+            APIGetterImpl(creds, data_api_on_error_callback,
+                          EndpointClass::other),
             _market_type(market_type),
             _date(date)
         {
@@ -69,7 +69,8 @@ public:
                       MoversDirectionType direction_type,
                       MoversChangeType change_type )
         :
-            APIGetterImpl(creds, data_api_on_error_callback),
+            APIGetterImpl(creds, data_api_on_error_callback,
+                          EndpointClass::other),
             _index(index),
             _direction_type(direction_type),
             _change_type(change_type)
@@ -0,0 +1,527 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstddef>
+
+#include "../../include/_tdma_api.h"
+#include "../../include/_get.h"
+#include "../../include/_sax.h"
+
+using std::string;
+using std::vector;
+using std::unordered_map;
+
+namespace {
+
+using namespace tdma;
+
+/* where a scalar goes, relative to the record being filled */
+struct Field{
+    enum Type{
+        none,
+        real,    // double
+        int64,   // long long
+        int32,   // int
+        boolean, // int
+        text,    // size_t offset into the char buffer
+        put_call // int
+    } type;
+    size_t offset;
+};
+
+struct ContractRec{
+    OptionContract_C c;
+    size_t symbol;
+    size_t description;
+    size_t exchange_name;
+    size_t expiration_type;
+};
+
+struct ChainRec{
+    OptionChain_C c;
+    size_t symbol;
+    size_t status;
+    size_t strategy;
+};
+
+#define CONTRACT_FIELD(name, type, member) \
+    {name, {Field::type, offsetof(ContractRec, c) \
+                         + offsetof(OptionContract_C, member)}}
+
+#define CONTRACT_TEXT_FIELD(name, member) \
+    {name, {Field::text, offsetof(ContractRec, member)}}
+
+const unordered_map<string, Field> CONTRACT_FIELDS = {
+    CONTRACT_TEXT_FIELD("symbol", symbol),
+    CONTRACT_TEXT_FIELD("description", description),
+    CONTRACT_TEXT_FIELD("exchangeName", exchange_name),
+    CONTRACT_TEXT_FIELD("expirationType", expiration_type),
+    CONTRACT_FIELD("putCall", put_call, is_put),
+    CONTRACT_FIELD("inTheMoney", boolean, in_the_money),
+    CONTRACT_FIELD("nonStandard", boolean, non_standard),
+    CONTRACT_FIELD("mini", boolean, mini),
+    CONTRACT_FIELD("daysToExpiration", int32, days_to_expiration),
+    CONTRACT_FIELD("strikePrice", real, strike_price),
+    CONTRACT_FIELD("expirationDate", int64, expiration_date),
+    CONTRACT_FIELD("lastTradingDay", int64, last_trading_day),
+    CONTRACT_FIELD("bid", real, bid),
+    CONTRACT_FIELD("ask", real, ask),
+    CONTRACT_FIELD("last", real, last),
+    CONTRACT_FIELD("mark", real, mark),
+    CONTRACT_FIELD("bidSize", int64, bid_size),
+    CONTRACT_FIELD("askSize", int64, ask_size),
+    CONTRACT_FIELD("lastSize", int64, last_size),
+    CONTRACT_FIELD("highPrice", real, high_price),
+    CONTRACT_FIELD("lowPrice", real, low_price),
+    CONTRACT_FIELD("openPrice", real, open_price),
+    CONTRACT_FIELD("closePrice", real, close_price),
+    CONTRACT_FIELD("totalVolume", int64, total_volume),
+    CONTRACT_FIELD("openInterest", int64, open_interest),
+    CONTRACT_FIELD("quoteTimeInLong", int64, quote_time),
+    CONTRACT_FIELD("tradeTimeInLong", int64, trade_time),
+    CONTRACT_FIELD("netChange", real, net_change),
+    CONTRACT_FIELD("percentChange", real, percent_change),
+    CONTRACT_FIELD("markChange", real, mark_change),
+    CONTRACT_FIELD("markPercentChange", real, mark_percent_change),
+    CONTRACT_FIELD("volatility", real, volatility),
+    CONTRACT_FIELD("delta", real, delta),
+    CONTRACT_FIELD("gamma", real, gamma),
+    CONTRACT_FIELD("theta", real, theta),
+    CONTRACT_FIELD("vega", real, vega),
+    CONTRACT_FIELD("rho", real, rho),
+    CONTRACT_FIELD("timeValue", real, time_value),
+    CONTRACT_FIELD("theoreticalOptionValue", real, theoretical_option_value),
+    CONTRACT_FIELD("theoreticalVolatility", real, theoretical_volatility),
+    CONTRACT_FIELD("multiplier", real, multiplier)
+};
+
+#undef CONTRACT_FIELD
+#undef CONTRACT_TEXT_FIELD
+
+#define CHAIN_FIELD(name, type, member) \
+    {name, {Field::type, offsetof(ChainRec, c) + offsetof(OptionChain_C, member)}}
+
+const unordered_map<string, Field> CHAIN_FIELDS = {
+    {"symbol", {Field::text, offsetof(ChainRec, symbol)}},
+    {"status", {Field::text, offsetof(ChainRec, status)}},
+    {"strategy", {Field::text, offsetof(ChainRec, strategy)}},
+    CHAIN_FIELD("isDelayed", boolean, is_delayed),
+    CHAIN_FIELD("underlyingPrice", real, underlying_price),
+    CHAIN_FIELD("interestRate", real, interest_rate),
+    CHAIN_FIELD("volatility", real, volatility)
+};
+
+#undef CHAIN_FIELD
+
+const Field NO_FIELD = {Field::none, 0};
+
+size_t
+align_up(size_t n)
+{ return (n + 7) & ~static_cast<size_t>(7); }
+
+
+enum class ChainLevel{
+    root,
+    exp_map,
+    strike_map,
+    contracts,
+    contract
+};
+
+/*
+ * SAX handler for the 'chains' response:
+ *
+ *   { ..., "callExpDateMap" : { "yyyy-MM-dd:days" : { "strike" : [ {contract} ] } },
+ *          "putExpDateMap" : { ... } }
+ *
+ * contracts go straight into a flat vector; anything else that's nested
+ * ('underlying' etc.) is skipped. SINGLE and ANALYTICAL chains use these
+ * maps; the other strategies only fill 'monthlyStrategyList' (legs, not
+ * contracts) so they're rejected rather than decoded as an empty chain.
+ */
+class OptionChainSAX
+        : public LevelSAX<OptionChainSAX, ChainLevel> {
+    friend class LevelSAX<OptionChainSAX, ChainLevel>;
+    typedef ChainLevel Level;
+
+    struct Expiration{
+        std::string date;
+        size_t text; // offset of 'date' in the char buffer
+        int days;
+    };
+
+    const Field *_field; // target of the next scalar
+    bool _in_put_map;
+    bool _next_is_map;
+    bool _next_is_put_map;
+    size_t _cur_exp;
+    double _cur_strike;
+
+    ChainRec _chain;
+    vector<ContractRec> _contracts;
+    vector<Expiration> _expirations;
+    unordered_map<std::string, size_t> _exp_lookup;
+    std::string _chars;
+
+    char*
+    _target()
+    {
+        return ( _levels.back() == Level::contract )
+            ? reinterpret_cast<char*>(&_contracts.back())
+            : reinterpret_cast<char*>(&_chain);
+    }
+
+    static bool
+    _is_value(Level l)
+    { return l == Level::root || l == Level::contract; }
+
+    void
+    _clear_target()
+    { _field = &NO_FIELD; }
+
+    size_t
+    _store_text(const std::string& s)
+    {
+        size_t off = _chars.size();
+        _chars.append(s.c_str(), s.size() + 1);
+        return off;
+    }
+
+    template<typename T>
+    void
+    _store(T v)
+    {
+        char *p = _target() + _field->offset;
+        switch( _field->type ){
+        case Field::real:
+            *reinterpret_cast<double*>(p) = static_cast<double>(v);
+            break;
+        case Field::int64:
+            *reinterpret_cast<long long*>(p) = static_cast<long long>(v);
+            break;
+        case Field::int32:
+        case Field::boolean:
+            *reinterpret_cast<int*>(p) = static_cast<int>(v);
+            break;
+        default:
+            break;
+        }
+        _field = &NO_FIELD;
+    }
+
+    void
+    _store_string(const std::string& s)
+    {
+        char *p = _target() + _field->offset;
+        switch( _field->type ){
+        case Field::text:
+            *reinterpret_cast<size_t*>(p) = _store_text(s);
+            break;
+        case Field::put_call:
+            *reinterpret_cast<int*>(p) = (s == "PUT");
+            break;
+        case Field::real: // e.g "NaN"
+            *reinterpret_cast<double*>(p) = strtod(s.c_str(), nullptr);
+            break;
+        case Field::int64:
+            *reinterpret_cast<long long*>(p) = strtoll(s.c_str(), nullptr, 10);
+            break;
+        default:
+            break;
+        }
+        _field = &NO_FIELD;
+    }
+
+    void
+    _add_expiration(const std::string& key)
+    {
+        auto iter = _exp_lookup.find(key);
+        if( iter != _exp_lookup.end() ){
+            _cur_exp = iter->second;
+            return;
+        }
+        size_t pos = key.find(':');
+        std::string date = key.substr(0, pos);
+        Expiration exp{ date, _store_text(date),
+                        (pos == std::string::npos)
+                            ? 0 : atoi(key.c_str() + pos + 1) };
+        _cur_exp = _expirations.size();
+        _expirations.emplace_back(exp);
+        _exp_lookup.emplace(key, _cur_exp);
+    }
+
+    void
+    _add_contract()
+    {
+        ContractRec rec;
+        memset(&rec, 0, sizeof(rec)); // text offsets of 0 -> ""
+        rec.c.is_put = static_cast<int>(_in_put_map);
+        rec.c.strike_price = _cur_strike;
+        rec.c.days_to_expiration = _expirations[_cur_exp].days;
+        rec.c.expiration_index = _cur_exp;
+        _contracts.emplace_back(rec);
+    }
+
+    void
+    _on_key(const std::string& val)
+    {
+        switch( _levels.back() ){
+        case Level::root:
+        {
+            _next_is_map = (val == "callExpDateMap" || val == "putExpDateMap");
+            _next_is_put_map = (val == "putExpDateMap");
+            auto iter = CHAIN_FIELDS.find(val);
+            if( iter != CHAIN_FIELDS.end() )
+                _field = &iter->second;
+            break;
+        }
+        case Level::exp_map:
+            _add_expiration(val);
+            break;
+        case Level::strike_map:
+            _cur_strike = strtod(val.c_str(), nullptr);
+            break;
+        case Level::contract:
+        {
+            auto iter = CONTRACT_FIELDS.find(val);
+            if( iter != CONTRACT_FIELDS.end() )
+                _field = &iter->second;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    bool
+    _enter_object(Level parent, Level *child)
+    {
+        switch( parent ){
+        case Level::root:
+        {
+            bool is_map = _next_is_map;
+            _next_is_map = false;
+            if( !is_map )
+                return false;
+            _in_put_map = _next_is_put_map;
+            *child = Level::exp_map;
+            return true;
+        }
+        case Level::exp_map:
+            *child = Level::strike_map;
+            return true;
+        case Level::contracts:
+            _add_contract();
+            *child = Level::contract;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool
+    _enter_array(Level parent, std::size_t, Level *child)
+    {
+        if( parent != Level::strike_map )
+            return false;
+        *child = Level::contracts;
+        return true;
+    }
+
+public:
+    OptionChainSAX()
+        :
+            _field(&NO_FIELD),
+            _in_put_map(false),
+            _next_is_map(false),
+            _next_is_put_map(false),
+            _cur_exp(0),
+            _cur_strike(0.0),
+            _chain(),
+            _contracts(),
+            _expirations(),
+            _exp_lookup(),
+            _chars(1, '\0')
+        {
+            memset(&_chain, 0, sizeof(_chain));
+            _contracts.reserve(256);
+        }
+
+    /* from the response, "" if it didn't say */
+    const char*
+    strategy() const
+    { return _chars.c_str() + _chain.strategy; }
+
+    /* sort, index and copy everything into one block */
+    OptionChain_C*
+    finish() const;
+};
+
+
+OptionChain_C*
+OptionChainSAX::finish() const
+{
+    size_t ncon = _contracts.size();
+    size_t nexp = _expirations.size();
+
+    /* expirations ascending (yyyy-MM-dd sorts lexicographically) */
+    vector<size_t> exp_order(nexp);
+    for( size_t i = 0; i < nexp; ++i )
+        exp_order[i] = i;
+    std::sort( exp_order.begin(), exp_order.end(),
+               [this](size_t l, size_t r){
+                   return _expirations[l].date < _expirations[r].date;
+               } );
+    vector<size_t> exp_rank(nexp);
+    for( size_t i = 0; i < nexp; ++i )
+        exp_rank[ exp_order[i] ] = i;
+
+    /* strikes ascending, unique */
+    vector<double> strikes;
+    strikes.reserve(ncon);
+    for( const ContractRec& rec : _contracts )
+        strikes.push_back(rec.c.strike_price);
+    std::sort(strikes.begin(), strikes.end());
+    strikes.erase( std::unique(strikes.begin(), strikes.end()), strikes.end() );
+    size_t nstr = strikes.size();
+
+    /* contracts by expiration, strike, call/put (sort indices, not records) */
+    vector<size_t> con_order(ncon);
+    for( size_t i = 0; i < ncon; ++i )
+        con_order[i] = i;
+    std::stable_sort( con_order.begin(), con_order.end(),
+        [&](size_t l, size_t r){
+            const OptionContract_C& lc = _contracts[l].c;
+            const OptionContract_C& rc = _contracts[r].c;
+            size_t le = exp_rank[lc.expiration_index];
+            size_t re = exp_rank[rc.expiration_index];
+            if( le != re )
+                return le < re;
+            if( lc.strike_price != rc.strike_price )
+                return lc.strike_price < rc.strike_price;
+            return lc.is_put < rc.is_put;
+        } );
+
+    size_t off_contracts = align_up( sizeof(OptionChain_C) );
+    size_t off_exps = align_up( off_contracts + ncon * sizeof(OptionContract_C) );
+    size_t off_strikes = align_up( off_exps + nexp * sizeof(OptionChainExpiration_C) );
+    size_t off_index = align_up( off_strikes + nstr * sizeof(OptionChainStrike_C) );
+    size_t off_chars = off_index + 2 * ncon * sizeof(size_t);
+
+    char *block = reinterpret_cast<char*>( malloc(off_chars + _chars.size()) );
+    if( !block )
+        TDMA_API_THROW(MemoryError, "failed to allocate option chain buffer");
+
+    OptionChain_C *chain = reinterpret_cast<OptionChain_C*>(block);
+    OptionContract_C *cons = reinterpret_cast<OptionContract_C*>(
+        block + off_contracts );
+    OptionChainExpiration_C *exps = reinterpret_cast<OptionChainExpiration_C*>(
+        block + off_exps );
+    OptionChainStrike_C *strs = reinterpret_cast<OptionChainStrike_C*>(
+        block + off_strikes );
+    size_t *exp_index = reinterpret_cast<size_t*>(block + off_index);
+    size_t *str_index = exp_index + ncon;
+    char *chars = block + off_chars;
+    memcpy(chars, _chars.data(), _chars.size());
+
+    *chain = _chain.c;
+    chain->symbol = chars + _chain.symbol;
+    chain->status = chars + _chain.status;
+    chain->contracts = cons;
+    chain->ncontracts = ncon;
+    chain->expirations = exps;
+    chain->nexpirations = nexp;
+    chain->strikes = strs;
+    chain->nstrikes = nstr;
+
+    for( size_t i = 0; i < nexp; ++i ){
+        exps[i].date = chars + _expirations[ exp_order[i] ].text;
+        exps[i].days_to_expiration = _expirations[ exp_order[i] ].days;
+        exps[i].contracts = exp_index;
+        exps[i].ncontracts = 0;
+    }
+    for( size_t i = 0; i < nstr; ++i ){
+        strs[i].strike_price = strikes[i];
+        strs[i].contracts = nullptr;
+        strs[i].ncontracts = 0;
+    }
+
+    for( size_t i = 0; i < ncon; ++i ){
+        const ContractRec& rec = _contracts[ con_order[i] ];
+        OptionContract_C& c = cons[i];
+        c = rec.c;
+        c.symbol = chars + rec.symbol;
+        c.description = chars + rec.description;
+        c.exchange_name = chars + rec.exchange_name;
+        c.expiration_type = chars + rec.expiration_type;
+        c.expiration_index = exp_rank[rec.c.expiration_index];
+        c.strike_index = std::lower_bound( strikes.begin(), strikes.end(),
+                                           rec.c.strike_price )
+                         - strikes.begin();
+        ++exps[c.expiration_index].ncontracts;
+        ++strs[c.strike_index].ncontracts;
+    }
+
+    /* contracts are grouped by expiration already, strikes need a pass */
+    size_t pos = 0;
+    for( size_t i = 0; i < nexp; ++i ){
+        exps[i].contracts = exp_index + pos;
+        pos += exps[i].ncontracts;
+    }
+    pos = 0;
+    for( size_t i = 0; i < nstr; ++i ){
+        strs[i].contracts = str_index + pos;
+        pos += strs[i].ncontracts;
+        strs[i].ncontracts = 0;
+    }
+    for( size_t i = 0; i < ncon; ++i ){
+        exp_index[i] = i;
+        OptionChainStrike_C& s = strs[ cons[i].strike_index ];
+        const_cast<size_t*>(s.contracts)[s.ncontracts++] = i;
+    }
+
+    return chain;
+}
+
+} /* namespace */
+
+
+namespace tdma {
+
+OptionChain_C*
+decode_option_chain(const char *first, const char *last)
+{
+    OptionChainSAX sax;
+    if( !json::sax_parse(first, last, &sax) )
+        TDMA_API_THROW(ValueException,
+                       "failed to decode option chain: " + sax.error());
+
+    string strategy = sax.strategy();
+    if( !strategy.empty() && strategy != "SINGLE" && strategy != "ANALYTICAL" ){
+        TDMA_API_THROW(ValueException,
+                       "can't decode '" + strategy + "' strategy chain");
+    }
+    return sax.finish();
+}
+
+} /* tdma */
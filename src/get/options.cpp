@@ -119,7 +119,8 @@ public:
                            OptionExpMonth exp_month,
                            OptionType option_type )
         :
-            APIGetterImpl(creds, data_api_on_error_callback),
+            APIGetterImpl(creds, data_api_on_error_callback,
+                          EndpointClass::quotes),
             _symbol( util::toupper(symbol) ),
             _strikes(strikes),
             _contract_type(contract_type),
@@ -726,6 +727,43 @@ OptionChainGetter_SetOptionType_ABI( OptionChainGetter_C *pgetter,
         );
 }
 
+int
+OptionChainGetter_GetChain_ABI( OptionChainGetter_C *pgetter,
+                                OptionChain_C **pchain,
+                                int allow_exceptions )
+{
+    int err = proxy_is_callable<OptionChainGetterImpl>(
+        pgetter, allow_exceptions
+        );
+    if( err )
+        return err;
+
+    CHECK_PTR(pchain, "pchain", allow_exceptions);
+
+    /* strategy chains are lists of legs, not contracts; don't send for them */
+    static auto meth = +[](void* obj, int type_id){
+        if( type_id == TYPE_ID_GETTER_OPTION_CHAIN_STRATEGY ){
+            TDMA_API_THROW( ValueException,
+                "GetChain can't decode strategy chains, use Get" );
+        }
+        conn::ResponseBuffer r =
+            reinterpret_cast<OptionChainGetterImpl*>(obj)->get_buffer();
+        return decode_option_chain(r.data(), r.data() + r.size());
+    };
+
+    tie(*pchain, err) = CallImplFromABI( allow_exceptions, meth, pgetter->obj,
+                                         pgetter->type_id );
+    return err;
+}
+
+int
+FreeOptionChainBuffer_ABI( OptionChain_C *chain, int allow_exceptions )
+{
+    if( chain )
+        free( (void*)chain );
+    return 0;
+}
+
 
 int
 OptionChainStrategyGetter_Create_ABI( struct Credentials *pcreds,
@@ -48,7 +48,8 @@ public:
 
     QuoteGetterImpl( Credentials& creds, const string& symbol )
         :
-            APIGetterImpl(creds, data_api_on_error_callback),
+            APIGetterImpl(creds, data_api_on_error_callback,
+                          EndpointClass::quotes),
             _symbol( util::toupper(symbol) )
         {
             if( symbol.empty() )
@@ -114,7 +115,8 @@ public:
 
     QuotesGetterImpl( Credentials& creds, const set<string>& symbols)
         :
-            APIGetterImpl(creds, data_api_on_error_callback),
+            APIGetterImpl(creds, data_api_on_error_callback,
+                          EndpointClass::quotes),
             _symbols( util::toupper(symbols) )
         {
             _throw_if_bad_input(symbols);
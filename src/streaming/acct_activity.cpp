@@ -0,0 +1,343 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#include <cstring>
+#include <cstdlib>
+
+#include "../../include/_streaming.h"
+
+namespace {
+
+using namespace tdma;
+
+/*
+ * The XML in field 3 is flat enough that we don't need a real parser: walk
+ * the tags keeping a stack of (local) element names and pick the text of
+ * the handful of elements we care about by their path below the root.
+ */
+
+const size_t MAX_DEPTH = 8;
+const size_t MAX_NAME = 32;
+
+enum class Elem{
+    none,
+    account_id,
+    timestamp,
+    order_id,
+    symbol,
+    order_quantity,
+    limit_price,
+    exec_quantity,
+    exec_price,
+    leaves_quantity,
+    cancelled_quantity,
+    pending_cancel_quantity,
+    original_order_id
+};
+
+struct Path{
+    Elem elem;
+    const char* names[3];
+};
+
+const Path PATHS[] = {
+    {Elem::account_id, {"OrderGroupID", "AccountKey", nullptr}},
+    {Elem::timestamp, {"ActivityTimestamp", nullptr, nullptr}},
+    {Elem::order_id, {"Order", "OrderKey", nullptr}},
+    {Elem::symbol, {"Order", "Security", "Symbol"}},
+    {Elem::order_quantity, {"Order", "OriginalQuantity", nullptr}},
+    {Elem::limit_price, {"Order", "OrderPricing", "Limit"}},
+    {Elem::exec_quantity, {"ExecutionInformation", "Quantity", nullptr}},
+    {Elem::exec_price, {"ExecutionInformation", "ExecutionPrice", nullptr}},
+    {Elem::leaves_quantity, {"ExecutionInformation", "LeavesQuantity", nullptr}},
+    {Elem::cancelled_quantity, {"CancelledQuantity", nullptr, nullptr}},
+    {Elem::pending_cancel_quantity, {"PendingCancelQuantity", nullptr, nullptr}},
+    {Elem::original_order_id, {"OriginalOrderId", nullptr, nullptr}}
+};
+
+struct TypeName{
+    const char *name;
+    OrderEventType type;
+};
+
+const TypeName TYPE_NAMES[] = {
+    {"OrderEntryRequest", OrderEventType::entry},
+    {"OrderActivation", OrderEventType::activation},
+    {"OrderPartialFill", OrderEventType::partial_fill},
+    {"OrderFill", OrderEventType::fill},
+    {"OrderCancelRequest", OrderEventType::cancel_request},
+    {"UROUT", OrderEventType::canceled},
+    {"OrderCancelReplaceRequest", OrderEventType::replace_request},
+    {"OrderRejection", OrderEventType::rejection},
+    {"TooLateToCancel", OrderEventType::too_late_to_cancel},
+    {"BrokenTrade", OrderEventType::broken_trade},
+    {"ManualExecution", OrderEventType::manual_execution},
+    {"SUBSCRIBED", OrderEventType::none},
+    {"ERROR", OrderEventType::none}
+};
+
+OrderEventType
+type_from_name(const char *name, size_t n)
+{
+    for( const TypeName& tn : TYPE_NAMES ){
+        if( strlen(tn.name) == n && strncmp(tn.name, name, n) == 0 )
+            return tn.type;
+    }
+    return OrderEventType::other;
+}
+
+double
+to_double(const char *src, size_t n)
+{
+    char buf[64];
+    copy_text(buf, src, n);
+    return strtod(buf, nullptr);
+}
+
+class Scanner{
+    char _stack[MAX_DEPTH][MAX_NAME];
+    size_t _depth;
+    const char *_root;
+    size_t _root_len;
+
+    Elem
+    _match() const
+    {
+        /* _stack[0] is the root (e.g OrderFillMessage) */
+        for( const Path& p : PATHS ){
+            size_t d = 1;
+            for( ; d < 4 && p.names[d-1]; ++d ){
+                if( d >= _depth || strcmp(p.names[d-1], _stack[d]) )
+                    break;
+            }
+            if( d == _depth && (d == 4 || !p.names[d-1]) )
+                return p.elem;
+        }
+        return Elem::none;
+    }
+
+public:
+    Scanner()
+        : _depth(0), _root(nullptr), _root_len(0)
+    {}
+
+    const char*
+    root(size_t *n) const
+    {
+        *n = _root_len;
+        return _root;
+    }
+
+    /* calls on_text(Elem, const char*, size_t) for each element we want */
+    template<typename F>
+    void
+    scan(const char *p, F on_text)
+    {
+        while( *p ){
+            if( *p != '<' ){
+                const char *beg = p;
+                while( *p && *p != '<' )
+                    ++p;
+                if( _depth > 1 && _depth <= MAX_DEPTH ){
+                    Elem e = _match();
+                    if( e != Elem::none )
+                        on_text(e, beg, static_cast<size_t>(p - beg));
+                }
+                continue;
+            }
+
+            ++p;
+            if( *p == '?' || *p == '!' ){ // prolog, comment
+                while( *p && *p != '>' )
+                    ++p;
+                if( *p )
+                    ++p;
+                continue;
+            }
+
+            bool closing = (*p == '/');
+            if( closing )
+                ++p;
+
+            const char *name = p;
+            while( *p && *p != '>' && *p != '/' && *p != ' '
+                   && *p != '\t' && *p != '\r' && *p != '\n' )
+            {
+                if( *p++ == ':' ) // drop namespace prefix
+                    name = p;
+            }
+            size_t len = static_cast<size_t>(p - name);
+
+            bool empty = false;
+            while( *p && *p != '>' ){
+                if( *p == '/' )
+                    empty = true;
+                else if( *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' )
+                    empty = false; // '/' inside an attribute value
+                ++p;
+            }
+            if( *p )
+                ++p;
+
+            if( closing ){
+                if( _depth )
+                    --_depth;
+                continue;
+            }
+
+            if( !_depth ){
+                _root = name;
+                _root_len = len;
+            }
+            if( empty )
+                continue;
+            if( _depth < MAX_DEPTH )
+                copy_text(_stack[_depth], name, len);
+            ++_depth;
+        }
+    }
+};
+
+} /* namespace */
+
+
+namespace tdma{
+
+void
+decode_acct_activity( const char *message_type,
+                      const char *message_data,
+                      OrderEvent_C *event )
+{
+    memset(event, 0, sizeof(*event));
+    event->leaves_quantity = -1;
+
+    double exec_qty = 0, exec_notional = 0;
+    double cancelled_qty = -1, pending_cancel_qty = -1;
+    double limit = 0, last_exec_qty = 0;
+    bool have_exec = false;
+
+    Scanner scanner;
+    if( message_data ){
+        scanner.scan( message_data,
+            [&](Elem e, const char *s, size_t n){
+                switch( e ){
+                case Elem::account_id:
+                    copy_text(event->account_id, s, n);
+                    break;
+                case Elem::timestamp:
+                    copy_text(event->timestamp, s, n);
+                    break;
+                case Elem::order_id:
+                    copy_text(event->order_id, s, n);
+                    break;
+                case Elem::symbol:
+                    copy_text(event->symbol, s, n);
+                    break;
+                case Elem::order_quantity:
+                    event->order_quantity = to_double(s, n);
+                    break;
+                case Elem::limit_price:
+                    limit = to_double(s, n);
+                    break;
+                case Elem::exec_quantity:
+                    last_exec_qty = to_double(s, n);
+                    exec_qty += last_exec_qty;
+                    have_exec = true;
+                    break;
+                case Elem::exec_price: // follows Quantity
+                    exec_notional += last_exec_qty * to_double(s, n);
+                    break;
+                case Elem::leaves_quantity:
+                    event->leaves_quantity = to_double(s, n);
+                    break;
+                case Elem::cancelled_quantity:
+                    cancelled_qty = to_double(s, n);
+                    break;
+                case Elem::pending_cancel_quantity:
+                    pending_cancel_qty = to_double(s, n);
+                    break;
+                case Elem::original_order_id:
+                    copy_text(event->original_order_id, s, n);
+                    break;
+                default:
+                    break;
+                }
+            } );
+    }
+
+    OrderEventType type;
+    if( message_type && *message_type ){
+        type = type_from_name(message_type, strlen(message_type));
+    }else{
+        size_t n;
+        const char *root = scanner.root(&n);
+        if( !root )
+            return;
+        if( n > 7 && strncmp(root + n - 7, "Message", 7) == 0 )
+            n -= 7;
+        type = type_from_name(root, n);
+    }
+    event->type = static_cast<int>(type);
+
+    switch( type ){
+    case OrderEventType::partial_fill:
+    case OrderEventType::fill:
+    case OrderEventType::manual_execution:
+        if( have_exec ){
+            event->quantity = exec_qty;
+            event->price = exec_qty > 0 ? exec_notional / exec_qty : 0;
+            break;
+        }
+        event->quantity = event->order_quantity;
+        event->price = limit;
+        break;
+    case OrderEventType::canceled:
+        event->quantity = cancelled_qty >= 0 ? cancelled_qty
+                                             : event->order_quantity;
+        event->price = limit;
+        break;
+    case OrderEventType::cancel_request:
+        event->quantity = pending_cancel_qty >= 0 ? pending_cancel_qty
+                                                  : event->order_quantity;
+        event->price = limit;
+        break;
+    default:
+        event->quantity = event->order_quantity;
+        event->price = limit;
+    }
+}
+
+} /* tdma */
+
+
+using namespace tdma;
+
+int
+DecodeAcctActivity_ABI( const char *message_type,
+                        const char *message_data,
+                        OrderEvent_C *event,
+                        int allow_exceptions )
+{
+    CHECK_PTR(event, "event", allow_exceptions);
+
+    static auto meth = +[]( const char *t, const char *d, OrderEvent_C *e ){
+        decode_acct_activity(t, d, e);
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, message_type, message_data,
+                           event);
+}
@@ -0,0 +1,443 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#include "../../include/_streaming.h"
+#include "../../include/tdma_api_get.h"
+
+using std::string;
+using std::vector;
+using std::mutex;
+using std::lock_guard;
+
+namespace {
+
+using namespace tdma;
+
+const int WORKING = static_cast<int>(OrderStatusType::WORKING);
+const int FILLED = static_cast<int>(OrderStatusType::FILLED);
+const int CANCELED = static_cast<int>(OrderStatusType::CANCELED);
+const int REPLACED = static_cast<int>(OrderStatusType::REPLACED);
+const int REJECTED = static_cast<int>(OrderStatusType::REJECTED);
+const int EXPIRED = static_cast<int>(OrderStatusType::EXPIRED);
+const int PENDING_CANCEL = static_cast<int>(OrderStatusType::PENDING_CANCEL);
+const int PENDING_REPLACE = static_cast<int>(OrderStatusType::PENDING_REPLACE);
+
+bool
+is_done(int status)
+{
+    return status == FILLED || status == CANCELED || status == REPLACED
+           || status == REJECTED || status == EXPIRED;
+}
+
+void
+add_fill(OrderState_C& o, double quantity, double price)
+{
+    if( quantity <= 0 )
+        return;
+    double filled = o.filled_quantity + quantity;
+    o.average_fill_price =
+        (o.average_fill_price * o.filled_quantity + price * quantity) / filled;
+    o.filled_quantity = filled;
+    o.last_fill_price = price;
+}
+
+/*
+ * the part of a fill event we haven't counted: the cumulative fill implied
+ * by its leaves quantity less what we have, so a fill the REST snapshot
+ * already included isn't added again when its event shows up
+ */
+double
+new_fill_quantity(const OrderState_C& o, const OrderEvent_C& event)
+{
+    double quantity = event.quantity;
+    if( o.quantity > 0 ){
+        double filled = (event.leaves_quantity >= 0)
+                      ? o.quantity - event.leaves_quantity
+                      : o.quantity;
+        quantity = std::min(quantity, filled - o.filled_quantity);
+    }
+    return quantity;
+}
+
+int
+status_from_str(const string& status)
+{
+    static const std::unordered_map<string, int> statuses = []{
+        std::unordered_map<string, int> m;
+        for( int i = 0; i < static_cast<int>(OrderStatusType::ALL); ++i )
+            m.emplace( to_string(static_cast<OrderStatusType>(i)), i );
+        return m;
+    }();
+
+    auto iter = statuses.find(status);
+    return iter == statuses.end() ? -1 : iter->second;
+}
+
+double
+num_field(const json& j, const char *name)
+{
+    auto iter = j.find(name);
+    return (iter != j.end() && iter->is_number()) ? iter->get<double>() : 0.0;
+}
+
+/* state of one order from its OrdersGetter json; false if it's not usable */
+bool
+state_from_json(const json& order, OrderState_C& o)
+{
+    auto id_iter = order.find("orderId");
+    auto st_iter = order.find("status");
+    if( id_iter == order.end() || st_iter == order.end()
+        || !st_iter->is_string() )
+    {
+        return false;
+    }
+
+    string id = id_iter->is_string() ? id_iter->get<string>()
+                                     : id_iter->dump();
+    copy_text(o.order_id, id);
+
+    int status = status_from_str( st_iter->get<string>() );
+    if( status < 0 )
+        return false;
+    o.status = status;
+
+    o.quantity = num_field(order, "quantity");
+    o.filled_quantity = num_field(order, "filledQuantity");
+    o.remaining_quantity = num_field(order, "remainingQuantity");
+    o.price = num_field(order, "price");
+
+    auto legs = order.find("orderLegCollection");
+    if( legs != order.end() && legs->is_array() && !legs->empty() ){
+        auto inst = legs->front().find("instrument");
+        if( inst != legs->front().end() ){
+            auto sym = inst->find("symbol");
+            if( sym != inst->end() && sym->is_string() )
+                copy_text(o.symbol, sym->get_ref<const string&>());
+        }
+    }
+
+    double qty = 0, notional = 0, last = o.last_fill_price;
+    auto acts = order.find("orderActivityCollection");
+    if( acts != order.end() && acts->is_array() ){
+        for( const json& a : *acts ){
+            auto exec = a.find("executionLegs");
+            if( exec == a.end() || !exec->is_array() )
+                continue;
+            for( const json& l : *exec ){
+                double q = num_field(l, "quantity");
+                last = num_field(l, "price");
+                qty += q;
+                notional += q * last;
+            }
+        }
+    }
+    if( qty > 0 ){
+        o.average_fill_price = notional / qty;
+        o.last_fill_price = last;
+    }
+    return true;
+}
+
+bool
+same_state(const OrderState_C& l, const OrderState_C& r)
+{
+    return strcmp(l.symbol, r.symbol) == 0
+           && l.status == r.status
+           && l.quantity == r.quantity
+           && l.filled_quantity == r.filled_quantity
+           && l.remaining_quantity == r.remaining_quantity
+           && l.average_fill_price == r.average_fill_price
+           && l.last_fill_price == r.last_fill_price
+           && l.price == r.price;
+}
+
+} /* namespace */
+
+
+namespace tdma {
+
+OrderCache::OrderCache()
+    :
+        _mtx(),
+        _orders(),
+        _seq(0)
+    {
+    }
+
+
+OrderState_C&
+OrderCache::_get_or_insert(const char *order_id)
+{
+    auto iter = _orders.find(order_id);
+    if( iter == _orders.end() ){
+        OrderState_C o;
+        memset(&o, 0, sizeof(o));
+        copy_text(o.order_id, order_id, strlen(order_id));
+        o.status = static_cast<int>(OrderStatusType::ACCEPTED);
+        o.last_event = static_cast<int>(OrderEventType::none);
+        iter = _orders.emplace(order_id, o).first;
+    }
+    return iter->second;
+}
+
+
+void
+OrderCache::apply(const OrderEvent_C& event, OrderState_C *state)
+{
+    OrderEventType type = static_cast<OrderEventType>(event.type);
+    if( type == OrderEventType::none || !event.order_id[0] ){
+        if( state )
+            memset(state, 0, sizeof(*state));
+        return;
+    }
+
+    lock_guard<mutex> _(_mtx);
+
+    unsigned long long seq = ++_seq;
+    OrderState_C& o = _get_or_insert(event.order_id);
+
+    if( event.symbol[0] )
+        copy_text(o.symbol, event.symbol, strlen(event.symbol));
+    if( event.order_quantity > 0 )
+        o.quantity = event.order_quantity;
+
+    bool is_fill = (type == OrderEventType::partial_fill
+                    || type == OrderEventType::fill
+                    || type == OrderEventType::manual_execution);
+    if( !is_fill && event.price > 0 )
+        o.price = event.price;
+
+    switch( type ){
+    case OrderEventType::entry:
+    case OrderEventType::activation:
+        if( !is_done(o.status) )
+            o.status = WORKING;
+        break;
+    case OrderEventType::partial_fill:
+    case OrderEventType::fill:
+    case OrderEventType::manual_execution:
+        add_fill(o, new_fill_quantity(o, event), event.price);
+        if( type == OrderEventType::fill || event.leaves_quantity == 0 )
+            o.status = FILLED;
+        else if( !is_done(o.status) )
+            o.status = WORKING;
+        break;
+    case OrderEventType::cancel_request:
+        if( !is_done(o.status) )
+            o.status = PENDING_CANCEL;
+        break;
+    case OrderEventType::canceled:
+        o.status = (o.status == PENDING_REPLACE) ? REPLACED : CANCELED;
+        break;
+    case OrderEventType::replace_request:
+        /* 'event' is the new order; the old one waits for its UROUT */
+        if( !is_done(o.status) )
+            o.status = WORKING;
+        if( event.original_order_id[0] ){
+            OrderState_C& old = _get_or_insert(event.original_order_id);
+            if( !is_done(old.status) )
+                old.status = PENDING_REPLACE;
+            old.last_event = event.type;
+            old.seq = seq;
+        }
+        break;
+    case OrderEventType::rejection:
+        o.status = REJECTED;
+        break;
+    case OrderEventType::too_late_to_cancel:
+        if( o.status == PENDING_CANCEL || o.status == PENDING_REPLACE )
+            o.status = WORKING;
+        break;
+    default:
+        break;
+    }
+
+    if( is_fill && event.leaves_quantity >= 0 )
+        o.remaining_quantity = event.leaves_quantity;
+    else if( is_done(o.status) && o.status != FILLED )
+        o.remaining_quantity = 0;
+    else
+        o.remaining_quantity = std::max(o.quantity - o.filled_quantity, 0.0);
+
+    o.last_event = event.type;
+    o.seq = seq;
+
+    if( state )
+        *state = o;
+}
+
+
+bool
+OrderCache::get(const char *order_id, OrderState_C *state) const
+{
+    lock_guard<mutex> _(_mtx);
+
+    auto iter = _orders.find(order_id);
+    if( iter == _orders.end() )
+        return false;
+    *state = iter->second;
+    return true;
+}
+
+
+void
+OrderCache::clear()
+{
+    lock_guard<mutex> _(_mtx);
+    _orders.clear();
+}
+
+
+unsigned long long
+OrderCache::sequence() const
+{
+    lock_guard<mutex> _(_mtx);
+    return _seq;
+}
+
+
+OrderState_C*
+OrderCache::export_states( unsigned long long since_seq,
+                           size_t *n,
+                           unsigned long long *seq ) const
+{
+    lock_guard<mutex> _(_mtx);
+
+    *n = 0;
+    *seq = _seq;
+
+    size_t count = 0;
+    for( auto& p : _orders ){
+        if( p.second.seq > since_seq )
+            ++count;
+    }
+    if( !count )
+        return nullptr;
+
+    OrderState_C *states =
+        reinterpret_cast<OrderState_C*>( malloc(count * sizeof(OrderState_C)) );
+    if( !states )
+        throw std::bad_alloc();
+
+    for( auto& p : _orders ){
+        if( p.second.seq > since_seq )
+            states[(*n)++] = p.second;
+    }
+    return states;
+}
+
+
+void
+OrderCache::seed(const json& orders, unsigned long long since_seq)
+{
+    if( !orders.is_array() )
+        return;
+
+    lock_guard<mutex> _(_mtx);
+
+    vector<const json*> todo;
+    for( const json& o : orders )
+        todo.push_back(&o);
+
+    while( !todo.empty() ){
+        const json& order = *todo.back();
+        todo.pop_back();
+        if( !order.is_object() )
+            continue;
+
+        auto children = order.find("childOrderStrategies");
+        if( children != order.end() && children->is_array() ){
+            for( const json& c : *children )
+                todo.push_back(&c);
+        }
+
+        OrderState_C o;
+        memset(&o, 0, sizeof(o));
+        o.last_event = static_cast<int>(OrderEventType::none);
+        if( !state_from_json(order, o) )
+            continue;
+
+        auto iter = _orders.find(o.order_id);
+        if( iter == _orders.end() ){
+            o.seq = ++_seq;
+            _orders.emplace(o.order_id, o);
+            continue;
+        }
+
+        OrderState_C& cur = iter->second;
+        if( cur.seq > since_seq || same_state(cur, o) )
+            continue;
+
+        o.last_event = cur.last_event;
+        if( !o.last_fill_price ){
+            o.last_fill_price = cur.last_fill_price;
+            o.average_fill_price = cur.average_fill_price;
+        }
+        o.seq = ++_seq;
+        cur = o;
+    }
+}
+
+
+OrderState_C*
+OrderCache::export_open(const char *symbol, size_t *n) const
+{
+    lock_guard<mutex> _(_mtx);
+
+    *n = 0;
+
+    auto matches = [&](const OrderState_C& o){
+        return !is_done(o.status) && (!symbol || strcmp(symbol, o.symbol) == 0);
+    };
+
+    size_t count = 0;
+    for( auto& p : _orders ){
+        if( matches(p.second) )
+            ++count;
+    }
+    if( !count )
+        return nullptr;
+
+    OrderState_C *states =
+        reinterpret_cast<OrderState_C*>( malloc(count * sizeof(OrderState_C)) );
+    if( !states )
+        throw std::bad_alloc();
+
+    for( auto& p : _orders ){
+        if( matches(p.second) )
+            states[(*n)++] = p.second;
+    }
+    return states;
+}
+
+} /* tdma */
+
+
+using namespace tdma;
+
+int
+FreeOrderStatesBuffer_ABI( OrderState_C *states, int allow_exceptions )
+{
+    if( states )
+        free( (void*)states );
+    return 0;
+}
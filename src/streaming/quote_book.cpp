@@ -0,0 +1,262 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+#include "../../include/_streaming.h"
+
+using std::string;
+using std::vector;
+using std::mutex;
+using std::lock_guard;
+
+namespace {
+
+using namespace tdma;
+
+/* # of FieldType values of each service, 0 if not supported */
+size_t
+nfields_of(StreamerServiceType service)
+{
+    switch( service ){
+    case StreamerServiceType::QUOTE:
+        return static_cast<size_t>(
+            QuotesSubscriptionField::regular_market_trade_time_as_long) + 1;
+    case StreamerServiceType::OPTION:
+        return static_cast<size_t>(OptionsSubscriptionField::mark) + 1;
+    case StreamerServiceType::LEVELONE_FUTURES:
+        return static_cast<size_t>(
+            LevelOneFuturesSubscriptionField::future_expiration_date) + 1;
+    case StreamerServiceType::LEVELONE_FOREX:
+        return static_cast<size_t>(
+            LevelOneForexSubscriptionField::mark) + 1;
+    case StreamerServiceType::LEVELONE_FUTURES_OPTIONS:
+        return static_cast<size_t>(
+            LevelOneFuturesOptionsSubscriptionField::future_expiration_date) + 1;
+    default:
+        return 0;
+    }
+}
+
+} /* namespace */
+
+
+namespace tdma {
+
+QuoteBook::Table::Table(size_t nfields)
+    :
+        nfields(nfields),
+        rows(),
+        keys(),
+        row_seq(),
+        cells(),
+        cell_seq(),
+        text()
+    {
+    }
+
+
+QuoteBook::QuoteBook()
+    :
+        _mtx(),
+        _tables(),
+        _seq(0)
+    {
+    }
+
+
+bool
+QuoteBook::is_supported(StreamerServiceType service)
+{ return nfields_of(service) > 0; }
+
+
+void
+QuoteBook::update( StreamerServiceType service,
+                   const StreamingRecord_C *records,
+                   size_t nrecords )
+{
+    size_t nfields = nfields_of(service);
+    if( !nfields )
+        return;
+
+    lock_guard<mutex> _(_mtx);
+
+    auto t_iter = _tables.find( static_cast<int>(service) );
+    if( t_iter == _tables.end() ){
+        t_iter = _tables.emplace( static_cast<int>(service), Table(nfields) )
+                        .first;
+    }
+    Table& t = t_iter->second;
+
+    for( size_t i = 0; i < nrecords; ++i ){
+        const StreamingRecord_C& rec = records[i];
+        if( !rec.key )
+            continue;
+
+        size_t row;
+        auto r_iter = t.rows.find(rec.key);
+        if( r_iter == t.rows.end() ){
+            row = t.keys.size();
+            t.rows.emplace(rec.key, row);
+            t.keys.emplace_back(rec.key);
+            t.row_seq.push_back(0);
+            t.cells.resize( t.cells.size() + nfields,
+                StreamingField_C{0, static_cast<int>(StreamingFieldValueType::none),
+                                 0, 0.0, nullptr} );
+            t.cell_seq.resize( t.cell_seq.size() + nfields, 0 );
+            t.text.resize( t.text.size() + nfields );
+        }else{
+            row = r_iter->second;
+        }
+
+        unsigned long long seq = ++_seq;
+        t.row_seq[row] = seq;
+
+        size_t base = row * nfields;
+        for( size_t j = 0; j < rec.nfields; ++j ){
+            const StreamingField_C& f = rec.fields[j];
+            if( f.field < 0 || static_cast<size_t>(f.field) >= nfields )
+                continue;
+            size_t c = base + f.field;
+            t.cells[c] = f;
+            t.cells[c].sval = nullptr;
+            if( f.value_type == static_cast<int>(StreamingFieldValueType::text) )
+                t.text[c].assign( f.sval ? f.sval : "" );
+            t.cell_seq[c] = seq;
+        }
+    }
+}
+
+
+void
+QuoteBook::clear()
+{
+    lock_guard<mutex> _(_mtx);
+    _tables.clear();
+}
+
+
+unsigned long long
+QuoteBook::sequence() const
+{
+    lock_guard<mutex> _(_mtx);
+    return _seq;
+}
+
+
+StreamingRecord_C*
+QuoteBook::export_records( StreamerServiceType service,
+                           const char *symbol,
+                           unsigned long long since_seq,
+                           size_t *nrecords,
+                           unsigned long long *seq ) const
+{
+    lock_guard<mutex> _(_mtx);
+
+    *nrecords = 0;
+    *seq = _seq;
+
+    auto t_iter = _tables.find( static_cast<int>(service) );
+    if( t_iter == _tables.end() )
+        return nullptr;
+    const Table& t = t_iter->second;
+
+    vector<size_t> rows;
+    if( symbol ){
+        auto r_iter = t.rows.find(symbol);
+        if( r_iter != t.rows.end() && t.row_seq[r_iter->second] > since_seq )
+            rows.push_back(r_iter->second);
+    }else{
+        for( size_t r = 0; r < t.keys.size(); ++r ){
+            if( t.row_seq[r] > since_seq )
+                rows.push_back(r);
+        }
+    }
+    if( rows.empty() )
+        return nullptr;
+
+    auto changed = [&](size_t c){
+        return t.cells[c].value_type
+                   != static_cast<int>(StreamingFieldValueType::none)
+               && t.cell_seq[c] > since_seq;
+    };
+
+    /* size everything first so it goes in one block: records|fields|strings */
+    size_t nflds = 0;
+    size_t nchars = 0;
+    for( size_t r : rows ){
+        nchars += t.keys[r].size() + 1;
+        for( size_t c = r * t.nfields; c < (r + 1) * t.nfields; ++c ){
+            if( !changed(c) )
+                continue;
+            ++nflds;
+            if( t.cells[c].value_type
+                == static_cast<int>(StreamingFieldValueType::text) )
+            {
+                nchars += t.text[c].size() + 1;
+            }
+        }
+    }
+
+    size_t rec_bytes = rows.size() * sizeof(StreamingRecord_C);
+    size_t fld_bytes = nflds * sizeof(StreamingField_C);
+    char *block = reinterpret_cast<char*>(
+        malloc(rec_bytes + fld_bytes + nchars) );
+    if( !block )
+        TDMA_API_THROW(MemoryError, "failed to allocate quote book buffer");
+
+    StreamingRecord_C *recs = reinterpret_cast<StreamingRecord_C*>(block);
+    StreamingField_C *flds = reinterpret_cast<StreamingField_C*>(
+        block + rec_bytes );
+    char *chars = block + rec_bytes + fld_bytes;
+
+    auto copy_str = [&](const string& s){
+        char *p = chars;
+        memcpy(chars, s.c_str(), s.size() + 1);
+        chars += s.size() + 1;
+        return p;
+    };
+
+    for( size_t i = 0; i < rows.size(); ++i ){
+        size_t r = rows[i];
+        StreamingRecord_C& rec = recs[i];
+        rec.key = copy_str( t.keys[r] );
+        rec.seq = static_cast<long long>( t.row_seq[r] );
+        rec.fields = flds;
+        rec.nfields = 0;
+        rec.typed = nullptr;
+        for( size_t c = r * t.nfields; c < (r + 1) * t.nfields; ++c ){
+            if( !changed(c) )
+                continue;
+            *flds = t.cells[c];
+            if( flds->value_type
+                == static_cast<int>(StreamingFieldValueType::text) )
+            {
+                flds->sval = copy_str( t.text[c] );
+            }
+            ++flds;
+            ++rec.nfields;
+        }
+    }
+
+    *nrecords = rows.size();
+    return recs;
+}
+
+} /* tdma */
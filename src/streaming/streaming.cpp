@@ -18,6 +18,7 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <sstream>
 #include <ctime>
 #include <string>
+#include <mutex>
 
 #include "../../include/_streaming.h"
 
@@ -93,6 +94,9 @@ timestamp_to_ms(string ts)
 
 #undef timegm
 
+std::mutex streamer_url_override_mtx;
+string streamer_url_override;
+
 } /* namespace */
 
 
@@ -147,7 +151,12 @@ get_streamer_info(Credentials& creds, const std::string& desired_acct)
         si.credentials.app_id = i_sinfo->at("appId");
         si.credentials.acl = i_sinfo->at("acl");
         string addr = i_sinfo->at("streamerSocketUrl");
-        si.url = "wss://" + addr + "/ws";
+        {
+            std::lock_guard<std::mutex> _(streamer_url_override_mtx);
+            si.url = streamer_url_override.empty()
+                   ? "wss://" + addr + "/ws"
+                   : streamer_url_override;
+        }
         si.encode_credentials();
     }catch(json::exception& e){
         TDMA_API_THROW(APIException,"failed to convert UserPrincipals JSON to"
@@ -321,11 +330,88 @@ StreamingCallbackType_to_string_ABI( TDMA_API_TO_STRING_ABI_ARGS )
         return to_new_char_buffer("timeout", buf, n, allow_exceptions);
     case StreamingCallbackType::error:
         return to_new_char_buffer("error", buf, n, allow_exceptions);
+    case StreamingCallbackType::reconnected:
+        return to_new_char_buffer("reconnected", buf, n, allow_exceptions);
     default:
         throw std::runtime_error("Invalid StreamingCallbackType");
     }
 }
 
+int
+StreamingOverflowPolicy_to_string_ABI( TDMA_API_TO_STRING_ABI_ARGS )
+{
+    CHECK_ENUM(StreamingOverflowPolicy, v, allow_exceptions);
+
+    switch(static_cast<StreamingOverflowPolicy>(v)){
+    case StreamingOverflowPolicy::block:
+        return to_new_char_buffer("block", buf, n, allow_exceptions);
+    case StreamingOverflowPolicy::drop_oldest:
+        return to_new_char_buffer("drop_oldest", buf, n, allow_exceptions);
+    case StreamingOverflowPolicy::conflate:
+        return to_new_char_buffer("conflate", buf, n, allow_exceptions);
+    default:
+        throw std::runtime_error("Invalid StreamingOverflowPolicy");
+    }
+}
+
+int
+StreamingFieldValueType_to_string_ABI( TDMA_API_TO_STRING_ABI_ARGS )
+{
+    CHECK_ENUM(StreamingFieldValueType, v, allow_exceptions);
+
+    switch(static_cast<StreamingFieldValueType>(v)){
+    case StreamingFieldValueType::none:
+        return to_new_char_buffer("none", buf, n, allow_exceptions);
+    case StreamingFieldValueType::integer:
+        return to_new_char_buffer("integer", buf, n, allow_exceptions);
+    case StreamingFieldValueType::real:
+        return to_new_char_buffer("real", buf, n, allow_exceptions);
+    case StreamingFieldValueType::boolean:
+        return to_new_char_buffer("boolean", buf, n, allow_exceptions);
+    case StreamingFieldValueType::text:
+        return to_new_char_buffer("text", buf, n, allow_exceptions);
+    default:
+        throw std::runtime_error("Invalid StreamingFieldValueType");
+    }
+}
+
+int
+OrderEventType_to_string_ABI( TDMA_API_TO_STRING_ABI_ARGS )
+{
+    CHECK_ENUM(OrderEventType, v, allow_exceptions);
+
+    switch(static_cast<OrderEventType>(v)){
+    case OrderEventType::none:
+        return to_new_char_buffer("none", buf, n, allow_exceptions);
+    case OrderEventType::entry:
+        return to_new_char_buffer("entry", buf, n, allow_exceptions);
+    case OrderEventType::activation:
+        return to_new_char_buffer("activation", buf, n, allow_exceptions);
+    case OrderEventType::partial_fill:
+        return to_new_char_buffer("partial_fill", buf, n, allow_exceptions);
+    case OrderEventType::fill:
+        return to_new_char_buffer("fill", buf, n, allow_exceptions);
+    case OrderEventType::cancel_request:
+        return to_new_char_buffer("cancel_request", buf, n, allow_exceptions);
+    case OrderEventType::canceled:
+        return to_new_char_buffer("canceled", buf, n, allow_exceptions);
+    case OrderEventType::replace_request:
+        return to_new_char_buffer("replace_request", buf, n, allow_exceptions);
+    case OrderEventType::rejection:
+        return to_new_char_buffer("rejection", buf, n, allow_exceptions);
+    case OrderEventType::too_late_to_cancel:
+        return to_new_char_buffer("too_late_to_cancel", buf, n, allow_exceptions);
+    case OrderEventType::broken_trade:
+        return to_new_char_buffer("broken_trade", buf, n, allow_exceptions);
+    case OrderEventType::manual_execution:
+        return to_new_char_buffer("manual_execution", buf, n, allow_exceptions);
+    case OrderEventType::other:
+        return to_new_char_buffer("other", buf, n, allow_exceptions);
+    default:
+        throw std::runtime_error("Invalid OrderEventType");
+    }
+}
+
 int
 StreamerServiceType_to_string_ABI( TDMA_API_TO_STRING_ABI_ARGS )
 {
@@ -400,6 +486,33 @@ StreamerServiceType_to_string_ABI( TDMA_API_TO_STRING_ABI_ARGS )
 }
 
 
+int
+FreeStreamingRecordsBuffer_ABI( StreamingRecord_C *records,
+                                int allow_exceptions )
+{
+    if( records )
+        free( (void*)records );
+    return 0;
+}
+
+
+int
+SetStreamerURLOverride_ABI( const char *url, int allow_exceptions )
+{
+    CHECK_PTR(url, "url", allow_exceptions);
+
+    string u(url);
+    if( !u.empty() && u.rfind("ws://", 0) != 0 && u.rfind("wss://", 0) != 0 ){
+        return HANDLE_ERROR( ValueException, "streamer url must be ws(s)://",
+                             allow_exceptions );
+    }
+
+    std::lock_guard<std::mutex> _(streamer_url_override_mtx);
+    streamer_url_override = u;
+    return 0;
+}
+
+
 /* TODO return actual strings for fields */
 #define DEF_TEMP_FIELD_TO_STRING(name) \
 int \
@@ -18,16 +18,24 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <iostream>
 #include <map>
 #include <ctime>
+#include <cstring>
+#include <cctype>
+#include <cstddef>
 #include <functional>
 #include <queue>
 #include <mutex>
 #include <memory>
+#include <atomic>
+#include <unordered_map>
 #include <condition_variable>
+#include <algorithm>
 
 #include "../../include/_streaming.h"
 #include "../../include/util.h"
 #include "../../include/websocket_connect.h"
+#include "../../include/frame_capture.h"
 #include "../../include/threadsafe_hashmap.h"
+#include "../../include/spsc_ring.h"
 
 using std::string;
 using std::vector;
@@ -70,6 +78,22 @@ D(string msg, StreamingSessionImpl *obj)
 
 set<string> active_accounts;
 
+/* yyyy-MM-dd (UTC) 'days' from today */
+string
+iso8601_date(int days)
+{
+    std::time_t t = std::time(nullptr) + days * 86400LL;
+    std::tm tm;
+#ifdef _WIN32
+    gmtime_s(&tm, &t);
+#else
+    gmtime_r(&t, &tm);
+#endif
+    char buf[16];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+    return buf;
+}
+
 class AdminSubscriptionImpl
         : public StreamingSubscriptionImpl {
 public:
@@ -148,6 +172,398 @@ struct PendingResponseBundle{
 };
 
 
+/*
+ * where each field of a per-service struct lives: 'type' picks the member
+ * type (integer -> long long, real -> double, boolean -> int,
+ * text -> const char*)
+ */
+struct TypedField{
+    size_t offset;
+    StreamingFieldValueType type;
+};
+
+#define TYPED_FIELD(s, m, t) {offsetof(s, m), StreamingFieldValueType::t}
+
+#define QUOTE_FIELD(m, t) TYPED_FIELD(StreamingQuote_C, m, t)
+const TypedField QUOTE_FIELDS[] = {
+    QUOTE_FIELD(symbol, text),
+    QUOTE_FIELD(bid_price, real),
+    QUOTE_FIELD(ask_price, real),
+    QUOTE_FIELD(last_price, real),
+    QUOTE_FIELD(bid_size, integer),
+    QUOTE_FIELD(ask_size, integer),
+    QUOTE_FIELD(ask_id, text),
+    QUOTE_FIELD(bid_id, text),
+    QUOTE_FIELD(total_volume, integer),
+    QUOTE_FIELD(last_size, integer),
+    QUOTE_FIELD(trade_time, integer),
+    QUOTE_FIELD(quote_time, integer),
+    QUOTE_FIELD(high_price, real),
+    QUOTE_FIELD(low_price, real),
+    QUOTE_FIELD(bid_tick, text),
+    QUOTE_FIELD(close_price, real),
+    QUOTE_FIELD(exchange_id, text),
+    QUOTE_FIELD(marginable, boolean),
+    QUOTE_FIELD(shortable, boolean),
+    QUOTE_FIELD(island_bid, real),
+    QUOTE_FIELD(island_ask, real),
+    QUOTE_FIELD(island_volume, integer),
+    QUOTE_FIELD(quote_day, integer),
+    QUOTE_FIELD(trade_day, integer),
+    QUOTE_FIELD(volatility, real),
+    QUOTE_FIELD(description, text),
+    QUOTE_FIELD(last_id, text),
+    QUOTE_FIELD(digits, integer),
+    QUOTE_FIELD(open_price, real),
+    QUOTE_FIELD(net_change, real),
+    QUOTE_FIELD(high_52_week, real),
+    QUOTE_FIELD(low_52_week, real),
+    QUOTE_FIELD(pe_ratio, real),
+    QUOTE_FIELD(dividend_amount, real),
+    QUOTE_FIELD(dividend_yield, real),
+    QUOTE_FIELD(island_bid_size, integer),
+    QUOTE_FIELD(island_ask_size, integer),
+    QUOTE_FIELD(nav, real),
+    QUOTE_FIELD(fund_price, real),
+    QUOTE_FIELD(exchange_name, text),
+    QUOTE_FIELD(dividend_date, text),
+    QUOTE_FIELD(regular_market_quote, boolean),
+    QUOTE_FIELD(regular_market_trade, boolean),
+    QUOTE_FIELD(regular_market_last_price, real),
+    QUOTE_FIELD(regular_market_last_size, integer),
+    QUOTE_FIELD(regular_market_trade_time, integer),
+    QUOTE_FIELD(regular_market_trade_day, integer),
+    QUOTE_FIELD(regular_market_net_change, real),
+    QUOTE_FIELD(security_status, text),
+    QUOTE_FIELD(mark, real),
+    QUOTE_FIELD(quote_time_as_long, integer),
+    QUOTE_FIELD(trade_time_as_long, integer),
+    QUOTE_FIELD(regular_market_trade_time_as_long, integer)
+};
+#undef QUOTE_FIELD
+
+const TypedField TIMESALE_FIELDS[] = {
+    TYPED_FIELD(StreamingTimesale_C, symbol, text),
+    TYPED_FIELD(StreamingTimesale_C, trade_time, integer),
+    TYPED_FIELD(StreamingTimesale_C, last_price, real),
+    TYPED_FIELD(StreamingTimesale_C, last_size, integer),
+    TYPED_FIELD(StreamingTimesale_C, last_sequence, integer)
+};
+
+const TypedField CHART_EQUITY_FIELDS[] = {
+    TYPED_FIELD(StreamingChartEquity_C, symbol, text),
+    TYPED_FIELD(StreamingChartEquity_C, open_price, real),
+    TYPED_FIELD(StreamingChartEquity_C, high_price, real),
+    TYPED_FIELD(StreamingChartEquity_C, low_price, real),
+    TYPED_FIELD(StreamingChartEquity_C, close_price, real),
+    TYPED_FIELD(StreamingChartEquity_C, volume, integer),
+    TYPED_FIELD(StreamingChartEquity_C, sequence, integer),
+    TYPED_FIELD(StreamingChartEquity_C, chart_time, integer),
+    TYPED_FIELD(StreamingChartEquity_C, chart_day, integer)
+};
+
+const TypedField CHART_FIELDS[] = {
+    TYPED_FIELD(StreamingChart_C, symbol, text),
+    TYPED_FIELD(StreamingChart_C, chart_time, integer),
+    TYPED_FIELD(StreamingChart_C, open_price, real),
+    TYPED_FIELD(StreamingChart_C, high_price, real),
+    TYPED_FIELD(StreamingChart_C, low_price, real),
+    TYPED_FIELD(StreamingChart_C, close_price, real),
+    TYPED_FIELD(StreamingChart_C, volume, integer)
+};
+
+#undef TYPED_FIELD
+
+static_assert( sizeof(QUOTE_FIELDS) / sizeof(TypedField)
+                   == static_cast<size_t>( QuotesSubscriptionField
+                                           ::regular_market_trade_time_as_long ) + 1,
+               "QUOTE_FIELDS doesn't match QuotesSubscriptionField" );
+
+
+/*
+ * decodes 'data' content into StreamingRecord_C/StreamingField_C (and the
+ * per-service struct, if any) for the typed callback; buffers are re-used
+ * so steady-state decoding doesn't allocate. Records point into 'content'
+ * and the decoder's buffers.
+ */
+class RecordDecoder{
+    vector<StreamingRecord_C> _records;
+    vector<StreamingField_C> _fields;
+    vector<size_t> _field_offsets;
+
+    /* one per record for the services that have a struct */
+    vector<StreamingQuote_C> _quotes;
+    vector<StreamingTimesale_C> _timesales;
+    vector<StreamingChartEquity_C> _chart_equities;
+    vector<StreamingChart_C> _charts;
+
+    const TypedField *_layout;
+    size_t _nlayout;
+    StreamerServiceType _ss_type;
+
+    void
+    _decode_one(const json& r);
+
+    char*
+    _new_typed();
+
+    const void*
+    _typed_at(size_t i) const;
+
+    static void
+    _set_typed(char *base, const TypedField& tf, const StreamingField_C& fld);
+
+public:
+    RecordDecoder()
+        :
+            _records(),
+            _fields(),
+            _field_offsets(),
+            _quotes(),
+            _timesales(),
+            _chart_equities(),
+            _charts(),
+            _layout(nullptr),
+            _nlayout(0),
+            _ss_type(StreamerServiceType::NONE)
+        {
+        }
+
+    /* decode all of 'content' or only the records at 'indices' */
+    void
+    decode( StreamerServiceType ss_type,
+            const json& content,
+            const vector<size_t> *indices = nullptr );
+
+    const StreamingRecord_C*
+    data() const
+    { return _records.data(); }
+
+    size_t
+    size() const
+    { return _records.size(); }
+};
+
+
+void
+RecordDecoder::decode( StreamerServiceType ss_type,
+                       const json& content,
+                       const vector<size_t> *indices )
+{
+    if( !content.is_array() )
+        TDMA_API_THROW(StreamingException, "'content' is not an array");
+
+    _records.clear();
+    _fields.clear();
+    _field_offsets.clear();
+    _quotes.clear();
+    _timesales.clear();
+    _chart_equities.clear();
+    _charts.clear();
+
+    _ss_type = ss_type;
+    switch( ss_type ){
+    case StreamerServiceType::QUOTE:
+        _layout = QUOTE_FIELDS;
+        _nlayout = sizeof(QUOTE_FIELDS) / sizeof(TypedField);
+        break;
+    case StreamerServiceType::TIMESALE_EQUITY:
+    case StreamerServiceType::TIMESALE_FUTURES:
+    case StreamerServiceType::TIMESALE_OPTIONS:
+        _layout = TIMESALE_FIELDS;
+        _nlayout = sizeof(TIMESALE_FIELDS) / sizeof(TypedField);
+        break;
+    case StreamerServiceType::CHART_EQUITY:
+        _layout = CHART_EQUITY_FIELDS;
+        _nlayout = sizeof(CHART_EQUITY_FIELDS) / sizeof(TypedField);
+        break;
+    case StreamerServiceType::CHART_FUTURES:
+    case StreamerServiceType::CHART_OPTIONS:
+        _layout = CHART_FIELDS;
+        _nlayout = sizeof(CHART_FIELDS) / sizeof(TypedField);
+        break;
+    default:
+        _layout = nullptr;
+        _nlayout = 0;
+    }
+
+    if( indices ){
+        for( size_t i : *indices )
+            _decode_one( content.at(i) );
+    }else{
+        for( auto& r : content )
+            _decode_one(r);
+    }
+
+    /* buffers may have re-allocated so assign pointers last */
+    for( size_t i = 0; i < _records.size(); ++i ){
+        if( _records[i].nfields )
+            _records[i].fields = _fields.data() + _field_offsets[i];
+        _records[i].typed = _typed_at(i);
+    }
+}
+
+
+char*
+RecordDecoder::_new_typed()
+{
+    switch( _ss_type ){
+    case StreamerServiceType::QUOTE:
+        _quotes.push_back( StreamingQuote_C() );
+        return reinterpret_cast<char*>( &_quotes.back() );
+    case StreamerServiceType::TIMESALE_EQUITY:
+    case StreamerServiceType::TIMESALE_FUTURES:
+    case StreamerServiceType::TIMESALE_OPTIONS:
+        _timesales.push_back( StreamingTimesale_C() );
+        return reinterpret_cast<char*>( &_timesales.back() );
+    case StreamerServiceType::CHART_EQUITY:
+        _chart_equities.push_back( StreamingChartEquity_C() );
+        return reinterpret_cast<char*>( &_chart_equities.back() );
+    case StreamerServiceType::CHART_FUTURES:
+    case StreamerServiceType::CHART_OPTIONS:
+        _charts.push_back( StreamingChart_C() );
+        return reinterpret_cast<char*>( &_charts.back() );
+    default:
+        return nullptr;
+    }
+}
+
+
+const void*
+RecordDecoder::_typed_at(size_t i) const
+{
+    switch( _ss_type ){
+    case StreamerServiceType::QUOTE:
+        return &_quotes[i];
+    case StreamerServiceType::TIMESALE_EQUITY:
+    case StreamerServiceType::TIMESALE_FUTURES:
+    case StreamerServiceType::TIMESALE_OPTIONS:
+        return &_timesales[i];
+    case StreamerServiceType::CHART_EQUITY:
+        return &_chart_equities[i];
+    case StreamerServiceType::CHART_FUTURES:
+    case StreamerServiceType::CHART_OPTIONS:
+        return &_charts[i];
+    default:
+        return nullptr;
+    }
+}
+
+
+/* numbers convert between integer/real; anything else has to match */
+void
+RecordDecoder::_set_typed( char *base,
+                           const TypedField& tf,
+                           const StreamingField_C& fld )
+{
+    auto vt = static_cast<StreamingFieldValueType>(fld.value_type);
+    bool is_num = vt == StreamingFieldValueType::integer
+                  || vt == StreamingFieldValueType::real;
+    char *m = base + tf.offset;
+
+    switch( tf.type ){
+    case StreamingFieldValueType::integer:
+        if( is_num ){
+            *reinterpret_cast<long long*>(m) =
+                vt == StreamingFieldValueType::integer
+                    ? fld.ival
+                    : static_cast<long long>(fld.dval);
+        }
+        break;
+    case StreamingFieldValueType::real:
+        if( is_num )
+            *reinterpret_cast<double*>(m) = fld.dval;
+        break;
+    case StreamingFieldValueType::boolean:
+        if( vt == StreamingFieldValueType::boolean || is_num )
+            *reinterpret_cast<int*>(m) = (fld.ival || fld.dval) ? 1 : 0;
+        break;
+    case StreamingFieldValueType::text:
+        if( vt == StreamingFieldValueType::text )
+            *reinterpret_cast<const char**>(m) = fld.sval;
+        break;
+    default:
+        break;
+    }
+}
+
+
+void
+RecordDecoder::_decode_one(const json& r)
+{
+    StreamingRecord_C rec{nullptr, -1, nullptr, 0, nullptr};
+    _field_offsets.push_back( _fields.size() );
+
+    char *typed = _new_typed();
+    /* every struct starts w/ 'fields_set' */
+    unsigned long long fields_set = 0;
+
+    for( auto f = r.cbegin(); f != r.cend(); ++f ){
+        const string& k = f.key();
+        const json& v = f.value();
+        if( k == "key" ){
+            if( v.is_string() )
+                rec.key = v.get_ref<const string&>().c_str();
+            continue;
+        }
+        if( k == "seq" ){
+            if( v.is_number() )
+                rec.seq = v.get<long long>();
+            continue;
+        }
+        /* only numeric ids map to FieldType */
+        if( k.empty() || !std::isdigit(static_cast<unsigned char>(k[0])) )
+            continue;
+
+        StreamingField_C fld{ stoi(k),
+            static_cast<int>(StreamingFieldValueType::none), 0, 0.0,
+            nullptr };
+
+        switch( v.type() ){
+        case json::value_t::number_integer:
+        case json::value_t::number_unsigned:
+            fld.value_type = static_cast<int>(StreamingFieldValueType::integer);
+            fld.ival = v.get<long long>();
+            fld.dval = static_cast<double>(fld.ival);
+            break;
+        case json::value_t::number_float:
+            fld.value_type = static_cast<int>(StreamingFieldValueType::real);
+            fld.dval = v.get<double>();
+            break;
+        case json::value_t::boolean:
+            fld.value_type = static_cast<int>(StreamingFieldValueType::boolean);
+            fld.ival = v.get<bool>() ? 1 : 0;
+            break;
+        case json::value_t::string:
+            fld.value_type = static_cast<int>(StreamingFieldValueType::text);
+            fld.sval = v.get_ref<const string&>().c_str();
+            break;
+        default:
+            break;
+        }
+        _fields.push_back(fld);
+
+        if( typed && fld.field >= 0 && static_cast<size_t>(fld.field) < _nlayout ){
+            _set_typed(typed, _layout[fld.field], fld);
+            fields_set |= 1ULL << fld.field;
+        }
+    }
+
+    if( typed ){
+        /* the symbol is sent as 'key' */
+        const TypedField& sym = _layout[0];
+        if( rec.key && !*reinterpret_cast<const char**>(typed + sym.offset) ){
+            *reinterpret_cast<const char**>(typed + sym.offset) = rec.key;
+            fields_set |= 1ULL;
+        }
+        *reinterpret_cast<unsigned long long*>(typed) = fields_set;
+    }
+
+    rec.nfields = _fields.size() - _field_offsets.back();
+    _records.push_back(rec);
+}
+
+
 class StreamingRequest{
     string _service;
     string _command;
@@ -245,24 +661,133 @@ const milliseconds StreamingSession::DEF_LISTENING_TIMEOUT(
     STREAMING_DEF_LISTENING_TIMEOUT);
 const milliseconds StreamingSession::DEF_SUBSCRIBE_TIMEOUT(
     STREAMING_DEF_SUBSCRIBE_TIMEOUT);
+const milliseconds StreamingSession::DEF_SUBSCRIPTION_WINDOW(
+    STREAMING_DEF_SUBSCRIPTION_WINDOW);
+const milliseconds StreamingSession::MAX_SUBSCRIPTION_WINDOW(
+    STREAMING_MAX_SUBSCRIPTION_WINDOW);
+const milliseconds StreamingSession::RECONNECT_MIN_BACKOFF(
+    STREAMING_RECONNECT_MIN_BACKOFF);
+const milliseconds StreamingSession::RECONNECT_MAX_BACKOFF(
+    STREAMING_RECONNECT_MAX_BACKOFF);
 
 
 class StreamingSessionImpl{
     StreamerInfo _streamer_info;
     string _account_id;
-    std::unique_ptr<conn::WebSocketClient> _client;
+    std::unique_ptr<conn::WebSocketClientInterface> _client;
     streaming_cb_ty _callback;
+    std::atomic<streaming_typed_cb_ty> _typed_callback;
     milliseconds _connect_timeout;
     milliseconds _listening_timeout;
     milliseconds _subscribe_timeout;
     std::thread _listener_thread;
     string _server_id;
-    int _next_request_id;
+    std::atomic<int> _next_request_id;
     bool _logged_in;
     bool _listening;
-    QOSType _qos;
+    std::atomic<QOSType> _qos;
     unsigned long long _last_heartbeat;
     ThreadSafeHashMap<int, PendingResponse> _responses_pending;
+    unsigned int _dispatch_threads;
+    size_t _high_water_mark;
+    StreamingOverflowPolicy _overflow_policy;
+    conn::InQueueStats _in_stats;
+    std::atomic<unsigned long long> _conflated;
+    std::atomic<bool> _quote_book_enabled;
+    QuoteBook _quote_book;
+    std::atomic<bool> _order_cache_enabled;
+    OrderCache _order_cache;
+    std::atomic<order_event_cb_ty> _order_event_callback;
+    std::thread _sync_thread;
+    mutex _sync_mtx;
+    std::condition_variable _sync_cond;
+    bool _sync_stop;
+    bool _sync_now; // resync w/o waiting for the interval
+    mutable mutex _sync_ctl_mtx; // serializes start/stop of the sync
+    mutable mutex _send_mtx; // serializes _send_requests callers, guards _client
+    SubscriptionManager _sub_manager;
+    std::thread _flush_thread;
+    mutable mutex _flush_mtx;
+    std::condition_variable _flush_cond;
+    bool _flush_stop;
+    bool _flush_scheduled;
+    std::chrono::steady_clock::time_point _flush_at;
+    milliseconds _subscription_window;
+    std::atomic<bool> _auto_reconnect;
+    std::atomic<bool> _stopping;
+    mutex _reconnect_mtx;
+    std::condition_variable _reconnect_cond;
+    std::atomic<unsigned long long> _last_recv_ms; // for the reconnect gap
+    conn::FrameRecorder _recorder; // outlives the clients it's passed to
+    string _replay_path; // play this capture instead of connecting
+    double _replay_speed;
+
+    /* 'conflate' lets the socket queue this many marks before blocking */
+    static const size_t CONFLATE_HEADROOM = 4;
+
+    /*
+     * opt-in (_dispatch_threads > 0) workers that run the 'data' callbacks
+     * so the listener only parses and routes; records are routed by a hash
+     * of 'key' so per-symbol ordering is preserved
+     */
+    class DispatchPool{
+        static const size_t QUEUE_CAPACITY = 4096;
+
+        struct Task{
+            std::shared_ptr<const json> frame; // keeps 'content' alive
+            const json *content;
+            vector<size_t> indices; // records in 'content' for this worker
+            StreamerServiceType ss_type;
+            unsigned long long ts;
+
+            Task()
+                :
+                    frame(),
+                    content(nullptr),
+                    indices(),
+                    ss_type( StreamerServiceType::NONE ),
+                    ts(0)
+                {
+                }
+        };
+
+        struct Worker{
+            SPSCRing<Task> tasks; // listener is the only producer
+            RecordDecoder decoder;
+            std::thread thread;
+
+            Worker()
+                : tasks(QUEUE_CAPACITY), decoder(), thread()
+            {}
+        };
+
+        StreamingSessionImpl *_ss;
+        vector<std::unique_ptr<Worker>> _workers;
+        vector<vector<size_t>> _buckets;
+
+        void
+        _run(Worker *w);
+
+        void
+        _report_error(const Task& t, const string& what);
+
+    public:
+        DispatchPool(StreamingSessionImpl *ss, unsigned int nthreads);
+
+        /* drains outstanding tasks and joins the workers */
+        ~DispatchPool();
+
+        DispatchPool( const DispatchPool& ) = delete;
+
+        DispatchPool&
+        operator=( const DispatchPool& ) = delete;
+
+        void
+        dispatch( const std::shared_ptr<const json>& frame,
+                  const json& content,
+                  StreamerServiceType ss_type,
+                  unsigned long long ts );
+    };
 
     class ListenerThreadTarget{
         static const string RESPONSE_TO_REQUEST;
@@ -271,6 +796,26 @@ class StreamingSessionImpl{
         static const string RESPONSE_DATA;
 
         StreamingSessionImpl *_ss;
+        RecordDecoder _decoder;
+
+        /* pooled frames from _client, recycled after each parse */
+        vector<string> _frames;
+
+        /*
+         * the frame being parsed; moved into '_frame' only when it has to be
+         * shared w/ _dispatcher tasks (moving keeps refs into it valid)
+         */
+        json _root;
+        std::shared_ptr<const json> _frame;
+        std::unique_ptr<DispatchPool> _dispatcher;
+
+        /*
+         * 'conflate' policy: from a batch at/over the high water mark until
+         * we catch up, the batch is parsed up front (into _batch) and each
+         * symbol's QUOTE records merged into its last one
+         */
+        bool _conflating;
+        vector<json> _batch;
 
         class Timeout
             : public StreamingException {
@@ -284,6 +829,12 @@ class StreamingSessionImpl{
         void
         parse(const string& responses);
 
+        void
+        parse_frame(json&& frame);
+
+        const std::shared_ptr<const json>&
+        shared_frame();
+
         void
         parse_response_to_request(const json& response);
 
@@ -296,16 +847,49 @@ class StreamingSessionImpl{
         void
         parse_response_data(const json& response);
 
+        void
+        handle_acct_activity(const json& content);
+
+        void
+        conflate_frames();
+
     public:
         ListenerThreadTarget( StreamingSessionImpl *ss )
-            : _ss(ss) {}
+            :
+                _ss(ss),
+                _decoder(),
+                _frames(),
+                _root(),
+                _frame(),
+                _dispatcher(),
+                _conflating(false),
+                _batch()
+            {}
 
         void
         operator()();
     };
 
     bool
-    _login();
+    _login(conn::WebSocketClientInterface& client);
+
+    conn::WebSocketClientInterface*
+    _new_client();
+
+    /* a reconnect swaps _client under _send_mtx */
+    bool
+    _has_client() const
+    {
+        std::lock_guard<mutex> _(_send_mtx);
+        return static_cast<bool>(_client);
+    }
+
+    /*
+     * LISTENER THREAD: swap in a new, logged-in, connection (w/ backoff)
+     * and replay subscriptions and QOS; false if disabled/stopped/gave up
+     */
+    bool
+    _reconnect();
 
     bool
     _logout();
@@ -319,9 +903,56 @@ class StreamingSessionImpl{
     void
     _reset();
 
+    /* caller holds _send_mtx */
+    void
+    _send_requests( const vector<StreamingSubscriptionImpl>& subscriptions,
+                    PendingResponse::response_cb_ty callback = nullptr )
+    {
+        _send_requests( subscriptions,
+            vector<PendingResponse::response_cb_ty>(subscriptions.size(),
+                                                    callback) );
+    }
+
+    /* one callback per subscription, all sent in one message */
     void
     _send_requests( const vector<StreamingSubscriptionImpl>& subscriptions,
-                    PendingResponse::response_cb_ty callback = nullptr );
+                    const vector<PendingResponse::response_cb_ty>& callbacks,
+                    bool from_diff = false );
+
+    /* callbacks of requests that won't get a response are failed */
+    void
+    _fail_responses( std::unordered_map<int, PendingResponse>&& responses );
+
+    PendingResponse::response_cb_ty
+    _async_response_cb( std::function<void(int, const string&)> done );
+
+    /*
+     * managed subscription changes are coalesced: the first change opens
+     * a window (_subscription_window) and the flush thread sends the diff
+     * of everything changed in it as ONE message when it closes
+     */
+    void
+    _start_flush_thread();
+
+    void
+    _stop_flush_thread();
+
+    void
+    _flush_thread_target();
+
+    void
+    _stop_sync_thread();
+
+    /* wake the sync thread, if running, to resync now */
+    void
+    _request_order_cache_sync();
+
+    void
+    _schedule_flush();
+
+    /* bundle to wait on, or nullptr if nothing was sent */
+    std::shared_ptr<PendingResponseBundle>
+    _send_subscription_diff();
 
     void
     _exec_callback( StreamingCallbackType cb_type,
@@ -335,6 +966,18 @@ class StreamingSessionImpl{
         }
     }
 
+    /*
+     * 'data' goes to the typed callback, if set, decoded from the original
+     * parse (avoiding the dump/re-parse of the json callback)
+     */
+    void
+    _exec_data_callback( StreamerServiceType ss_type,
+                         unsigned long long ts,
+                         const json& content,
+                         const vector<size_t> *indices,
+                         RecordDecoder& decoder,
+                         bool decoded = false );
+
 public:
     static const int TYPE_ID_LOW = TYPE_ID_STREAMING_SESSION;
     static const int TYPE_ID_HIGH = TYPE_ID_STREAMING_SESSION;
@@ -350,6 +993,7 @@ public:
             _account_id( streamer_info.desired_acct_id ),
             _client(nullptr),
             _callback( callback ),
+            _typed_callback( nullptr ),
             _connect_timeout( max(connect_timeout,
                                   StreamingSession::MIN_TIMEOUT) ),
             _listening_timeout( max(listening_timeout,
@@ -363,7 +1007,40 @@ public:
             _listening(false),
             _qos( QOSType::fast ),
             _last_heartbeat(0),
-            _responses_pending()
+            _responses_pending(),
+            _dispatch_threads(0),
+            _high_water_mark( StreamingSession::DEF_HIGH_WATER_MARK ),
+            _overflow_policy( StreamingOverflowPolicy::block ),
+            _in_stats(),
+            _conflated(0),
+            _quote_book_enabled(false),
+            _quote_book(),
+            _order_cache_enabled(false),
+            _order_cache(),
+            _order_event_callback( nullptr ),
+            _sync_thread(),
+            _sync_mtx(),
+            _sync_cond(),
+            _sync_stop(false),
+            _sync_now(false),
+            _sync_ctl_mtx(),
+            _send_mtx(),
+            _sub_manager(),
+            _flush_thread(),
+            _flush_mtx(),
+            _flush_cond(),
+            _flush_stop(false),
+            _flush_scheduled(false),
+            _flush_at(),
+            _subscription_window( StreamingSession::DEF_SUBSCRIPTION_WINDOW ),
+            _auto_reconnect(false),
+            _stopping(false),
+            _reconnect_mtx(),
+            _reconnect_cond(),
+            _last_recv_ms(0),
+            _recorder(),
+            _replay_path(),
+            _replay_speed(1.0)
         {
             D("construct", this);
             D("primary account: " + streamer_info.primary_acct_id, this);
@@ -372,10 +1049,27 @@ public:
             D("subscribe_timeout: " + to_string(subscribe_timeout.count()), this);
         }
 
+    /* plays the capture at 'replay_path' instead of connecting */
+    StreamingSessionImpl( const string& replay_path,
+                          double replay_speed,
+                          streaming_cb_ty callback,
+                          milliseconds listening_timeout )
+        :
+            StreamingSessionImpl( StreamerInfo(), callback,
+                                  StreamingSession::MIN_TIMEOUT,
+                                  listening_timeout,
+                                  StreamingSession::MIN_TIMEOUT )
+        {
+            _replay_path = replay_path;
+            _replay_speed = replay_speed;
+            D("replay: " + replay_path, this);
+        }
+
     virtual
     ~StreamingSessionImpl()
     {
         D("destruct", this);
+        stop_order_cache_sync();
         stop();
     }
 
@@ -392,7 +1086,7 @@ public:
 
     bool
     is_active() const
-    { return static_cast<bool>(_client); }
+    { return _has_client(); }
 
     deque<bool> // success/fails in the order passed
     add_subscriptions(const vector<StreamingSubscriptionImpl>& subscriptions);
@@ -404,6 +1098,124 @@ public:
     bool
     set_qos(const QOSType& qos);
 
+    /* raw inbound frames to 'path' (see frame_capture.h) until stopped */
+    void
+    start_capture(const string& path)
+    {
+        if( !_recorder.start(path) )
+            TDMA_API_THROW(StreamingException, "failed to open capture file: "
+                           + path);
+    }
+
+    void
+    stop_capture()
+    { _recorder.stop(); }
+
+    bool
+    is_capturing() const
+    { return _recorder.is_active(); }
+
+    bool
+    is_replay() const
+    { return !_replay_path.empty(); }
+
+    /*
+     * non-blocking versions: everything is sent in one message and
+     * 'done' is called from the listener thread with (index, code, msg)
+     * as each response comes back
+     */
+    typedef std::function<void(size_t, int, const string&)> async_done_ty;
+
+    void
+    add_subscriptions_async( const vector<StreamingSubscriptionImpl>& subscriptions,
+                             async_done_ty done );
+
+    void
+    set_qos_async(const QOSType& qos, async_done_ty done);
+
+    void
+    set_typed_callback(streaming_typed_cb_ty callback)
+    { _typed_callback = callback; }
+
+    unsigned int
+    get_dispatch_threads() const
+    { return _dispatch_threads; }
+
+    void
+    set_overflow_policy(size_t high_water_mark, StreamingOverflowPolicy policy);
+
+    std::pair<size_t, StreamingOverflowPolicy>
+    get_overflow_policy() const
+    { return std::make_pair(_high_water_mark, _overflow_policy); }
+
+    bool
+    is_quote_book_enabled() const
+    { return _quote_book_enabled; }
+
+    void
+    set_quote_book_enabled(bool enabled)
+    {
+        _quote_book_enabled = enabled;
+        if( !enabled )
+            _quote_book.clear();
+    }
+
+    const QuoteBook&
+    get_quote_book() const
+    { return _quote_book; }
+
+    bool
+    is_order_cache_enabled() const
+    { return _order_cache_enabled; }
+
+    void
+    set_order_cache_enabled(bool enabled)
+    {
+        if( !enabled )
+            stop_order_cache_sync();
+        _order_cache_enabled = enabled;
+        if( !enabled )
+            _order_cache.clear();
+    }
+
+    const OrderCache&
+    get_order_cache() const
+    { return _order_cache; }
+
+    void
+    set_order_event_callback(order_event_cb_ty callback)
+    { _order_event_callback = callback; }
+
+    /*
+     * seed the order cache w/ ONE OrdersGetter call (enabling it) then, if
+     * 'resync_interval' isn't 0, repeat that in the background
+     */
+    void
+    start_order_cache_sync( Credentials& creds,
+                            const string& account_id,
+                            milliseconds resync_interval,
+                            unsigned int lookback_days );
+
+    void
+    stop_order_cache_sync();
+
+    bool
+    is_order_cache_syncing() const
+    {
+        std::lock_guard<mutex> _(_sync_ctl_mtx);
+        return _sync_thread.joinable();
+    }
+
+    StreamingOverflowStats_C
+    get_overflow_stats() const
+    {
+        return { _in_stats.max_depth.load(), _in_stats.blocked.load(),
+                 _in_stats.dropped.load(), _conflated.load() };
+    }
+
+    void
+    set_dispatch_threads(unsigned int nthreads);
+
     string
     get_primary_account_id() const
     { return _streamer_info.primary_acct_id; }
@@ -411,6 +1223,37 @@ public:
     string
     get_streamer_subscription_key() const
     { return _streamer_info.streamer_subscription_key; }
+
+    void
+    subscribe(const StreamingSubscriptionImpl& subscription);
+
+    void
+    unsubscribe(const StreamingSubscriptionImpl& subscription);
+
+    bool
+    flush_subscriptions();
+
+    set<string>
+    get_subscribed_symbols(StreamerServiceType service) const
+    { return _sub_manager.get_keys( to_string(service) ); }
+
+    void
+    set_subscription_window(milliseconds window);
+
+    milliseconds
+    get_subscription_window() const
+    {
+        std::lock_guard<mutex> _(_flush_mtx);
+        return _subscription_window;
+    }
+
+    void
+    set_auto_reconnect(bool enabled)
+    { _auto_reconnect = enabled; }
+
+    bool
+    is_auto_reconnect() const
+    { return _auto_reconnect; }
 };
 
 
@@ -424,6 +1267,13 @@ void
 StreamingSessionImpl::ListenerThreadTarget::operator()()
 {
     _ss->_listening = true;
+    _ss->_last_recv_ms =
+        util::get_msec_since_epoch<std::chrono::system_clock>().count();
+
+    if( _ss->_dispatch_threads ){
+        D("start dispatch pool", _ss);
+        _dispatcher.reset( new DispatchPool(_ss, _ss->_dispatch_threads) );
+    }
 
     D("call back (listening_start)", _ss);
     _ss->_exec_callback( StreamingCallbackType::listening_start,
@@ -433,7 +1283,19 @@ StreamingSessionImpl::ListenerThreadTarget::operator()()
     json cb_j;
 
     try{
-        exec();
+        for( ;; ){
+            try{
+                exec();
+                break;
+            }catch( StreamingException& e ){
+                /* Timeout is-a StreamingException */
+                D(string("listening thread interrupted: ") + e.what(), _ss);
+                if( !_ss->_reconnect() )
+                    throw;
+                _frames.clear();
+                _conflating = false;
+            }
+        }
 
     }catch( Timeout& e ){
         /*
@@ -463,6 +1325,12 @@ StreamingSessionImpl::ListenerThreadTarget::operator()()
         throw;
     }
 
+    /* let the workers finish what we've routed before we signal stop */
+    D("stop dispatch pool", _ss);
+    _dispatcher.reset();
+    _frame.reset();
+    _root = json();
+
     _ss->_listening = false;
 
     D("call back (" + to_string(cb_t) + ")", _ss);
@@ -484,15 +1352,33 @@ StreamingSessionImpl::ListenerThreadTarget::exec()
         }
 
         /* BLOCK for _listening_timeout msec until we get at least 1 message */
-        auto results = _ss->_client->recv_atleast_n_or_wait_for( 1,
-                           _ss->_listening_timeout
-                        );
+        _ss->_client->recv_atleast_n_or_wait_for( 1, _ss->_listening_timeout,
+                                                  _frames );
+
+        if( _frames.empty() ){
+            /* the client closes its queue when the socket goes away */
+            if( !_ss->_client->is_connected() ){
+                TDMA_API_THROW( StreamingException,
+                                "client connection ended unexpectedly" );
+            }
+            throw Timeout("exec timeout", __LINE__, __FILE__); /* TIMED OUT */
+        }
 
-        if( results.empty() ) /* TIMED OUT */
-            throw Timeout("exec timeout", __LINE__, __FILE__);
+        _ss->_last_recv_ms =
+            util::get_msec_since_epoch<std::chrono::system_clock>().count();
+
+        if( _ss->_overflow_policy == StreamingOverflowPolicy::conflate ){
+            if( _frames.size() >= _ss->_high_water_mark )
+                _conflating = true;
+            else if( _frames.size() == 1 )
+                _conflating = false; // caught up
+        }
+        if( _conflating )
+            conflate_frames();
 
         /* each message can have mutliple results */
-        for(string& res : results){
+        for( size_t i = 0; i < _frames.size(); ++i ){
+            string& res = _frames[i];
             if( res.empty() ){
                 /* empty message is the signal to stop listening */
                 D("stop-listening message", _ss);
@@ -514,13 +1400,21 @@ StreamingSessionImpl::ListenerThreadTarget::exec()
              *      snapshot: NOT IMPLEMENTED
              */
             try{
-                parse(res);
+                /* (null if it didn't parse; parse again for the error) */
+                if( _conflating && !_batch[i].is_null() )
+                    parse_frame( std::move(_batch[i]) );
+                else
+                    parse(res);
             }catch( json::exception& e ){
                 cerr << "Error Parsing Json: " << endl
                      << '\t' << e.what() << endl
                      << '\t' << res << endl;
             }
         }
+        _batch.clear();
+
+        /* done w/ the frames (and any views into them), back to the pool */
+        _ss->_client->recycle(_frames);
     }
     D("end listening loop", _ss);
 }
@@ -528,14 +1422,20 @@ StreamingSessionImpl::ListenerThreadTarget::exec()
 
 void
 StreamingSessionImpl::ListenerThreadTarget::parse(const string& responses)
+{ parse_frame( json::parse(responses) ); }
+
+
+void
+StreamingSessionImpl::ListenerThreadTarget::parse_frame(json&& frame)
 {
-    auto resp = json::parse(responses);
-    auto r = resp.begin();
-    if( r == resp.end() )
+    _frame.reset();
+    _root = std::move(frame);
+    auto r = _root.cbegin();
+    if( r == _root.cend() )
         TDMA_API_THROW(StreamingException,"invalid response JSON");
 
-    string resp_ty = r.key();
-    auto resp_array = r.value();
+    const string& resp_ty = r.key();
+    const json& resp_array = r.value();
 
     if(resp_ty == RESPONSE_TO_REQUEST){
         for(auto& resp : resp_array)
@@ -554,6 +1454,15 @@ StreamingSessionImpl::ListenerThreadTarget::parse(const string& responses)
     }
 }
 
+
+const std::shared_ptr<const json>&
+StreamingSessionImpl::ListenerThreadTarget::shared_frame()
+{
+    if( !_frame )
+        _frame = std::make_shared<const json>( std::move(_root) );
+    return _frame;
+}
+
 void
 StreamingSessionImpl::ListenerThreadTarget::parse_response_to_request(
     const json& response
@@ -632,18 +1541,313 @@ StreamingSessionImpl::ListenerThreadTarget::parse_response_data(
 {
     try{
         string service = response.at("service");
-        _ss->_exec_callback( StreamingCallbackType::data,
-                             streamer_service_from_str(service),
-                             response.at("timestamp"), response.at("content") );
+        StreamerServiceType ss_type = streamer_service_from_str(service);
+        unsigned long long ts = response.at("timestamp");
+
+        const json& content = response.at("content");
+
+        /* the book sees every delta */
+        bool decoded = false;
+        if( _ss->_quote_book_enabled && QuoteBook::is_supported(ss_type) ){
+            _decoder.decode(ss_type, content);
+            _ss->_quote_book.update(ss_type, _decoder.data(), _decoder.size());
+            decoded = true;
+        }
+
+        if( ss_type == StreamerServiceType::ACCT_ACTIVITY )
+            handle_acct_activity(content);
+
+        if( _dispatcher ){
+            _dispatcher->dispatch(shared_frame(), content, ss_type, ts);
+        }else{
+            _ss->_exec_data_callback( ss_type, ts, content, nullptr, _decoder,
+                                      decoded );
+        }
     }catch(std::exception& e){
         TDMA_API_THROW( StreamingException,
                         "invalid 'data' response: " + string(e.what()) );
     }
 }
 
-bool
-StreamingSessionImpl::_login()
-{
+
+void
+StreamingSessionImpl::ListenerThreadTarget::handle_acct_activity(
+    const json& content
+    )
+{
+    bool use_cache = _ss->_order_cache_enabled;
+    order_event_cb_ty cb = _ss->_order_event_callback;
+    if( !use_cache && !cb )
+        return;
+
+    OrderEvent_C event;
+    OrderState_C state;
+    for( const json& rec : content ){
+        auto t_iter = rec.find("2");
+        auto d_iter = rec.find("3");
+        string type = (t_iter != rec.end() && t_iter->is_string())
+                    ? t_iter->get<string>() : string();
+        string data = (d_iter != rec.end() && d_iter->is_string())
+                    ? d_iter->get<string>() : string();
+
+        decode_acct_activity(type.c_str(), data.c_str(), &event);
+        if( event.type == static_cast<int>(OrderEventType::none) )
+            continue;
+
+        auto a_iter = rec.find("1");
+        if( a_iter != rec.end() && a_iter->is_string() )
+            copy_text(event.account_id, a_iter->get_ref<const string&>());
+
+        if( use_cache )
+            _ss->_order_cache.apply(event, &state);
+        if( cb )
+            cb( &event, use_cache ? &state : nullptr );
+    }
+}
+
+
+void
+StreamingSessionImpl::ListenerThreadTarget::conflate_frames()
+{
+    static const json QUOTE = to_string(StreamerServiceType::QUOTE);
+
+    auto is_quote = [](json& resp, json **content){
+        auto sv = resp.find("service");
+        auto c = resp.find("content");
+        if( sv == resp.end() || *sv != QUOTE || c == resp.end()
+            || !c->is_array() )
+        {
+            return false;
+        }
+        *content = &(*c);
+        return true;
+    };
+
+    /* last record for each symbol so far (element refs survive moves) */
+    std::unordered_map<string, json*> last;
+    json *content;
+
+    _batch.clear();
+    _batch.reserve( _frames.size() );
+    for( const string& res : _frames ){
+        _batch.emplace_back();
+        if( res.empty() )
+            break;
+        try{
+            _batch.back() = json::parse(res);
+        }catch( json::exception& ){
+            continue;
+        }
+        auto d = _batch.back().find(RESPONSE_DATA);
+        if( d == _batch.back().end() || !d->is_array() )
+            continue;
+        for( json& resp : *d ){
+            if( !is_quote(resp, &content) )
+                continue;
+            for( json& rec : *content ){
+                auto k = rec.find("key");
+                if( k == rec.end() || !k->is_string() )
+                    continue;
+                json*& prev = last[ k->get<string>() ];
+                if( prev ){
+                    /* later (changed) fields overwrite earlier ones */
+                    json merged = std::move(*prev);
+                    merged.update(rec);
+                    rec = std::move(merged);
+                    *prev = nullptr;
+                    ++(_ss->_conflated);
+                }
+                prev = &rec;
+            }
+        }
+    }
+
+    /* remove the merged-away records, and responses we left empty */
+    for( json& frame : _batch ){
+        auto d = frame.find(RESPONSE_DATA);
+        if( d == frame.end() || !d->is_array() )
+            continue;
+        json::array_t& resps = d->get_ref<json::array_t&>();
+        for( json& resp : resps ){
+            if( !is_quote(resp, &content) || content->empty() )
+                continue;
+            json::array_t& recs = content->get_ref<json::array_t&>();
+            recs.erase( std::remove_if( recs.begin(), recs.end(),
+                                        [](const json& j){ return j.is_null(); } ),
+                        recs.end() );
+            if( recs.empty() )
+                resp = nullptr;
+        }
+        resps.erase( std::remove_if( resps.begin(), resps.end(),
+                                     [](const json& j){ return j.is_null(); } ),
+                     resps.end() );
+    }
+}
+
+
+void
+StreamingSessionImpl::_exec_data_callback( StreamerServiceType ss_type,
+                                           unsigned long long ts,
+                                           const json& content,
+                                           const vector<size_t> *indices,
+                                           RecordDecoder& decoder,
+                                           bool decoded )
+{
+    streaming_typed_cb_ty typed_cb = _typed_callback;
+    if( typed_cb ){
+        if( !decoded )
+            decoder.decode(ss_type, content, indices);
+        typed_cb( static_cast<int>(ss_type), ts, decoder.data(),
+                  decoder.size() );
+    }else if( indices && indices->size() != content.size() ){
+        json j = json::array();
+        for( size_t i : *indices )
+            j.push_back( content.at(i) );
+        _exec_callback(StreamingCallbackType::data, ss_type, ts, j);
+    }else{
+        _exec_callback(StreamingCallbackType::data, ss_type, ts, content);
+    }
+}
+
+
+StreamingSessionImpl::DispatchPool::DispatchPool( StreamingSessionImpl *ss,
+                                                  unsigned int nthreads )
+    :
+        _ss(ss),
+        _workers(),
+        _buckets(nthreads)
+    {
+        assert(nthreads);
+        for( unsigned int i = 0; i < nthreads; ++i ){
+            _workers.emplace_back( new Worker() );
+            Worker *w = _workers.back().get();
+            w->thread = std::thread( [this, w]{ _run(w); } );
+        }
+    }
+
+
+StreamingSessionImpl::DispatchPool::~DispatchPool()
+{
+    for( auto& w : _workers )
+        w->tasks.close();
+    for( auto& w : _workers ){
+        if( w->thread.joinable() )
+            w->thread.join();
+    }
+}
+
+
+void
+StreamingSessionImpl::DispatchPool::_run(Worker *w)
+{
+    Task t;
+    /* returns false once closed AND drained */
+    while( w->tasks.pop_or_wait(t) ){
+        try{
+            _ss->_exec_data_callback( t.ss_type, t.ts, *t.content,
+                                      &t.indices, w->decoder );
+        }catch( json::exception& e ){
+            cerr<< "Error Dispatching Json: " << e.what() << endl;
+        }catch( std::exception& e ){
+            _report_error(t, e.what());
+        }catch( ... ){
+            _report_error(t, "unknown exception");
+        }
+        t.frame.reset();
+    }
+}
+
+
+/* the worker (and session) keep going; let the client know like exec() does */
+void
+StreamingSessionImpl::DispatchPool::_report_error( const Task& t,
+                                                   const string& what )
+{
+    cerr<< "Error Dispatching: " << what << endl;
+    try{
+        _ss->_exec_callback( StreamingCallbackType::error, t.ss_type, t.ts,
+                             { {"error:", what} } );
+    }catch( ... ){
+    }
+}
+
+
+void
+StreamingSessionImpl::DispatchPool::dispatch(
+    const std::shared_ptr<const json>& frame,
+    const json& content,
+    StreamerServiceType ss_type,
+    unsigned long long ts )
+{
+    if( !content.is_array() )
+        TDMA_API_THROW(StreamingException, "'content' is not an array");
+
+    static const std::hash<string> hasher{};
+    size_t nworkers = _workers.size();
+
+    for( size_t i = 0; i < content.size(); ++i ){
+        const json& rec = content[i];
+        auto k = rec.find("key");
+        size_t h = ( k != rec.end() && k->is_string() )
+                 ? hasher( k->get_ref<const string&>() )
+                 : 0;
+        _buckets[h % nworkers].push_back(i);
+    }
+
+    for( size_t w = 0; w < nworkers; ++w ){
+        if( _buckets[w].empty() )
+            continue;
+        Task t;
+        t.frame = frame;
+        t.content = &content;
+        t.indices.swap( _buckets[w] );
+        t.ss_type = ss_type;
+        t.ts = ts;
+        /* blocks if this worker is QUEUE_CAPACITY tasks behind */
+        _workers[w]->tasks.push( std::move(t) );
+    }
+}
+
+
+void
+StreamingSessionImpl::set_overflow_policy( size_t high_water_mark,
+                                           StreamingOverflowPolicy policy )
+{
+    if( _has_client() ){
+        TDMA_API_THROW( StreamingException,
+                        "can not change overflow policy of an active session" );
+    }
+    if( high_water_mark < StreamingSession::MIN_HIGH_WATER_MARK ){
+        TDMA_API_THROW( ValueException,
+                        "high_water_mark < STREAMING_MIN_HIGH_WATER_MARK" );
+    }
+    if( high_water_mark > StreamingSession::MAX_HIGH_WATER_MARK ){
+        TDMA_API_THROW( ValueException,
+                        "high_water_mark > STREAMING_MAX_HIGH_WATER_MARK" );
+    }
+    _high_water_mark = high_water_mark;
+    _overflow_policy = policy;
+}
+
+
+void
+StreamingSessionImpl::set_dispatch_threads(unsigned int nthreads)
+{
+    if( _has_client() ){
+        TDMA_API_THROW( StreamingException,
+                        "can not change dispatch threads of an active session" );
+    }
+    if( nthreads > STREAMING_MAX_DISPATCH_THREADS ){
+        TDMA_API_THROW( ValueException,
+                        "nthreads > STREAMING_MAX_DISPATCH_THREADS" );
+    }
+    _dispatch_threads = nthreads;
+}
+
+
+bool
+StreamingSessionImpl::_login(conn::WebSocketClientInterface& client)
+{
     D("login", this);
 
     map<string, string> params{
@@ -660,9 +1864,9 @@ StreamingSessionImpl::_login()
         {req_id}
     );
 
-     _client->send( requests.to_json().dump() );
+    client.send( requests.to_json().dump() );
 
-    string rmessage = _client->recv_or_wait_for(_listening_timeout);
+    string rmessage = client.recv_or_wait_for(_listening_timeout);
     if( rmessage.empty() ){
         cerr<< "timed out waiting for login response" << endl;
         return false;
@@ -818,9 +2022,7 @@ StreamingSessionImpl::_logout()
 bool
 StreamingSessionImpl::set_qos(const QOSType& qos)
 {
-    if( _client ){
-        assert( _client->is_connected() );
-    }else{
+    if( !_has_client() ){
         TDMA_API_THROW( StreamingException,
                         "can not set QOS on a stopped session" );
     }
@@ -830,10 +2032,10 @@ StreamingSessionImpl::set_qos(const QOSType& qos)
         [=](int id, string serv, string cmd, unsigned long long ts,
             int code, string msg)
         {
-            bndl->successes[0] = (code == 0);
-            bndl->msg = msg;
             {
                 std::lock_guard<mutex> _(bndl->mtx);
+                bndl->successes[0] = (code == 0);
+                bndl->msg = msg;
                 ++(bndl->n);
             }
             bndl->cond.notify_all();
@@ -852,7 +2054,10 @@ StreamingSessionImpl::set_qos(const QOSType& qos)
         CommandType::QOS,
         {{"qoslevel", to_string(static_cast<int>(qos))}}
     );
-    _send_requests( {sub}, cb );
+    {
+        std::lock_guard<mutex> _(_send_mtx);
+        _send_requests( {sub}, cb );
+    }
 
     std::unique_lock<mutex> l(bndl->mtx);
     if( !bndl->cond.wait_for(l, _subscribe_timeout,
@@ -873,21 +2078,18 @@ StreamingSessionImpl::set_qos(const QOSType& qos)
 void
 StreamingSessionImpl::_send_requests(
     const vector<StreamingSubscriptionImpl>& subscriptions,
-    PendingResponse::response_cb_ty callback
+    const vector<PendingResponse::response_cb_ty>& callbacks,
+    bool from_diff
     )
-{    
-    if( !_responses_pending.empty() ){
-        _responses_pending.access(
-            [](const std::unordered_map<int, PendingResponse>& m){
-                cerr<< "(" << m.size() << ") RESPONSES STILL PENDING" << endl;
-                for( auto& p : m ){
-                    cerr<< "\t request_id: " << p.second.request_id << endl
-                        << "\t service: " << p.second.service << endl
-                        << "\t command: " << p.second.command << endl << endl;
-                }
-            }
-        );
-    }
+{
+    assert( callbacks.size() == subscriptions.size() );
+
+    /* (under _send_mtx) the session may have stopped since the caller checked */
+    if( !_client )
+        TDMA_API_THROW( StreamingException, "session is not active" );
+
+    /* pipelined requests are expected to be outstanding */
+    D("responses pending: " + to_string(_responses_pending.size()), this);
 
     vector<int> req_ids;
     for(auto& s : subscriptions)
@@ -896,18 +2098,127 @@ StreamingSessionImpl::_send_requests(
     StreamingRequests requests( subscriptions, _account_id,
                                 _streamer_info.credentials.app_id, req_ids );
 
-    auto msg = requests.to_json().dump();
-    _client->send( msg );
-
+    /* register before sending so a fast response can't beat us to it */
     for( size_t i = 0; i < subscriptions.size(); ++i ){
         _responses_pending.insert(
             req_ids[i],
             PendingResponse( req_ids[i],
                              subscriptions[i].get_service_str(),
                              subscriptions[i].get_command_str(),
-                             callback )
+                             callbacks[i] )
             );
     }
+
+    try{
+        auto msg = requests.to_json().dump();
+        _client->send( msg );
+    }catch(...){
+        for( int id : req_ids )
+            _responses_pending.get_and_remove_safe(id);
+        throw;
+    }
+
+    for( auto& s : subscriptions )
+        _sub_manager.observe(s, from_diff);
+}
+
+
+void
+StreamingSessionImpl::_fail_responses(
+    std::unordered_map<int, PendingResponse>&& responses
+    )
+{
+    for( auto& p : responses ){
+        if( !p.second.callback )
+            continue;
+        try{
+            p.second.callback( p.first, p.second.service, p.second.command,
+                               0, STREAMING_NO_RESPONSE_CODE, "no response" );
+        }catch( std::exception& e ){
+            cerr<< "exception in response callback: " << e.what() << endl;
+        }
+    }
+}
+
+
+PendingResponse::response_cb_ty
+StreamingSessionImpl::_async_response_cb(
+    std::function<void(int, const string&)> done
+    )
+{
+    return [this, done]( int id, string serv, string cmd,
+                         unsigned long long ts, int code, string msg )
+        {
+            done(code, msg);
+            json j = {
+                {"request_id", id},
+                {"command ", cmd},
+                {"code", code},
+                {"message", msg}
+            };
+            this->_exec_callback( StreamingCallbackType::request_response,
+                                  streamer_service_from_str(serv), ts, j );
+        };
+}
+
+
+void
+StreamingSessionImpl::add_subscriptions_async(
+    const vector<StreamingSubscriptionImpl>& subscriptions,
+    async_done_ty done
+    )
+{
+    if( !_has_client() ){
+        TDMA_API_THROW( StreamingException,
+                        "can not add subscriptions to a stopped session" );
+    }
+
+    if( subscriptions.empty() )
+        return;
+
+    vector<PendingResponse::response_cb_ty> cbs;
+    for( size_t i = 0; i < subscriptions.size(); ++i ){
+        cbs.push_back( _async_response_cb(
+            [i, done](int code, const string& msg){ done(i, code, msg); }
+        ) );
+    }
+
+    std::lock_guard<mutex> _(_send_mtx);
+    if( !_client ){
+        TDMA_API_THROW( StreamingException,
+                        "can not add subscriptions to a stopped session" );
+    }
+    _send_requests(subscriptions, cbs);
+}
+
+
+void
+StreamingSessionImpl::set_qos_async(const QOSType& qos, async_done_ty done)
+{
+    if( !_has_client() ){
+        TDMA_API_THROW( StreamingException,
+                        "can not set QOS on a stopped session" );
+    }
+
+    auto cb = _async_response_cb(
+        [this, qos, done](int code, const string& msg){
+            if( code == 0 )
+                _qos = qos;
+            done(0, code, msg);
+        }
+    );
+
+    AdminSubscriptionImpl sub(
+        CommandType::QOS,
+        {{"qoslevel", to_string(static_cast<int>(qos))}}
+    );
+
+    std::lock_guard<mutex> _(_send_mtx);
+    if( !_client ){
+        TDMA_API_THROW( StreamingException,
+                        "can not set QOS on a stopped session" );
+    }
+    _send_requests( {sub}, cb );
 }
 
 
@@ -916,9 +2227,7 @@ StreamingSessionImpl::add_subscriptions(
     const vector<StreamingSubscriptionImpl>& subscriptions
     )
 {
-    if( _client ){
-        assert( _client->is_connected() );
-    }else{
+    if( !_has_client() ){
         TDMA_API_THROW( StreamingException,
                         "can not add subscriptions to a stopped session" );
     }
@@ -937,7 +2246,6 @@ StreamingSessionImpl::add_subscriptions(
                                               int code,
                                               string msg )
         {
-            bndl->successes[bndl->n] = ( code == 0 );
             json j = {
                   {"request_id", id},
                   {"command ", cmd},
@@ -948,6 +2256,7 @@ StreamingSessionImpl::add_subscriptions(
                                   streamer_service_from_str(serv), ts, j );
             {
                 std::lock_guard<mutex> _(bndl->mtx);
+                bndl->successes[bndl->n] = ( code == 0 );
                 ++(bndl->n);
                 if( !bndl->is_ready() )
                     return;
@@ -956,8 +2265,10 @@ StreamingSessionImpl::add_subscriptions(
         };
 
 
-
-    _send_requests(subscriptions, cb);
+    {
+        std::lock_guard<mutex> _(_send_mtx);
+        _send_requests(subscriptions, cb);
+    }
 
     std::unique_lock<mutex> lock(bndl->mtx);
     if( !bndl->cond.wait_for( lock, _subscribe_timeout,
@@ -974,105 +2285,542 @@ StreamingSessionImpl::add_subscriptions(
 }
 
 
-deque<bool>
-StreamingSessionImpl::start(
-    const vector<StreamingSubscriptionImpl>& subscriptions
-    )
+void
+StreamingSessionImpl::subscribe(const StreamingSubscriptionImpl& subscription)
 {
-    D("start", this);
-
-    if( _client )
-        TDMA_API_THROW(StreamingException,"session has already started");
-
-    if( subscriptions.empty() )
-        TDMA_API_THROW(StreamingException,"subscriptions is empty");
-
-    for( auto& sub : subscriptions ){
-        if( sub.get_command_str() != to_string(CommandType::SUBS) )
-            TDMA_API_THROW(StreamingException, "can only start() session "
-                "using Subscriptions with command 'SUBS'");
-    }
-
-    D("check unique session", this);
-    string acct = get_primary_account_id();
-    if( active_accounts.count(acct) ){
+    if( !_has_client() ){
         TDMA_API_THROW( StreamingException,
-                        "Can not start Session; one is already active "
-                        "for this primary account: " + acct );
+                        "can not subscribe on a stopped session" );
     }
+    _sub_manager.subscribe(subscription);
+    _schedule_flush();
+}
 
-    D("_client->reset", this);
-    _client.reset( new conn::WebSocketClient(_streamer_info.url) );
 
-    D("_client->connect", this);
-    _client->connect( _connect_timeout );
-    if( !_client->is_connected() ){
-        _client.reset();
+void
+StreamingSessionImpl::unsubscribe(const StreamingSubscriptionImpl& subscription)
+{
+    if( !_has_client() ){
         TDMA_API_THROW( StreamingException,
-                        "streaming session failed to connect" );
+                        "can not unsubscribe on a stopped session" );
     }
-
-    _logged_in = _login();
-    if( !_logged_in )
-        TDMA_API_THROW(StreamingException,"login failed");
-
-    /* only after connect AND login do we consider this an active session */
-    active_accounts.insert(acct);
-    _start_listener_thread();
-    return add_subscriptions(subscriptions);
+    _sub_manager.unsubscribe(subscription);
+    _schedule_flush();
 }
 
 
-void
-StreamingSessionImpl::stop()
+bool
+StreamingSessionImpl::flush_subscriptions()
 {
-    D("stop", this);
+    if( !_has_client() ){
+        TDMA_API_THROW( StreamingException,
+                        "can not flush subscriptions of a stopped session" );
+    }
 
-    _stop_listener_thread();
-    try{
-        if( _client && _client->is_connected() ){
-            if( _logged_in )
-                _logged_in = !_logout();
-            _client->close();
-        }
-    }catch(...){
-        _reset();
-        throw;
+    {
+        std::lock_guard<mutex> _(_flush_mtx);
+        _flush_scheduled = false;
     }
 
-    _reset();
-}
+    auto bndl = _send_subscription_diff();
+    if( !bndl )
+        return true;
 
+    std::unique_lock<mutex> lock(bndl->mtx);
+    if( !bndl->cond.wait_for( lock, _subscribe_timeout,
+                              [&](){ return bndl->is_ready(); } ) )
+    {
+        cerr<< "timed out waiting for subscription response" << endl;
+        return false;
+    }
 
-void
-StreamingSessionImpl::_reset()
-{
-    D("_reset", this);
-    _client.reset();
-    _responses_pending.clear();
-    _server_id.clear();
-    try{
-        active_accounts.erase( get_primary_account_id() );
-    }catch(...){}
+    return std::all_of( bndl->successes.cbegin(), bndl->successes.cend(),
+                        [](bool b){ return b; } );
 }
 
 
 void
-StreamingSessionImpl::_start_listener_thread()
+StreamingSessionImpl::set_subscription_window(milliseconds window)
 {
-    D("start listener thread", this);
-    assert( !_listening );
-
-    D("join listener thread", this);
-    if( _listener_thread.joinable() )
-        _listener_thread.join();
+    if( window > StreamingSession::MAX_SUBSCRIPTION_WINDOW ){
+        TDMA_API_THROW( ValueException, "window > MAX_SUBSCRIPTION_WINDOW" );
+    }
+    if( window.count() < 0 )
+        TDMA_API_THROW( ValueException, "window < 0" );
 
-    D("move new listener thread", this);
-    _listener_thread = std::move( std::thread(ListenerThreadTarget(this)) );
+    std::lock_guard<mutex> _(_flush_mtx);
+    _subscription_window = window;
 }
 
 
-void
+std::shared_ptr<PendingResponseBundle>
+StreamingSessionImpl::_send_subscription_diff()
+{
+    std::lock_guard<mutex> _(_send_mtx);
+    if( !_client )
+        return nullptr;
+
+    vector<StreamingSubscriptionImpl> subs = _sub_manager.diff();
+    if( subs.empty() )
+        return nullptr;
+
+    std::shared_ptr<PendingResponseBundle> bndl(
+        new PendingResponseBundle(subs.size())
+    );
+
+    PendingResponse::response_cb_ty cb = [=]( int id,
+                                              string serv,
+                                              string cmd,
+                                              unsigned long long ts,
+                                              int code,
+                                              string msg )
+        {
+            /*
+             * live set is unknown now; re-SUBS the service w/ the next flush
+             * (if the re-SUBS itself failed wait for the next change)
+             */
+            if( code != 0 ){
+                this->_sub_manager.invalidate(serv);
+                if( cmd != to_string(CommandType::SUBS) )
+                    this->_schedule_flush();
+            }
+
+            json j = {
+                  {"request_id", id},
+                  {"command ", cmd},
+                  {"code", code},
+                  {"message", msg}
+              };
+            this->_exec_callback( StreamingCallbackType::request_response,
+                                  streamer_service_from_str(serv), ts, j );
+            {
+                std::lock_guard<mutex> _(bndl->mtx);
+                bndl->successes[bndl->n] = ( code == 0 );
+                ++(bndl->n);
+                if( !bndl->is_ready() )
+                    return;
+            }
+            bndl->cond.notify_all();
+        };
+
+    _send_requests( subs,
+        vector<PendingResponse::response_cb_ty>(subs.size(), cb), true );
+    return bndl;
+}
+
+
+void
+StreamingSessionImpl::_schedule_flush()
+{
+    std::lock_guard<mutex> _(_flush_mtx);
+    /* the window opens w/ the first change, later ones ride along */
+    if( !_flush_scheduled ){
+        _flush_scheduled = true;
+        _flush_at = std::chrono::steady_clock::now() + _subscription_window;
+        _flush_cond.notify_one();
+    }
+}
+
+
+void
+StreamingSessionImpl::_flush_thread_target()
+{
+    std::unique_lock<mutex> lock(_flush_mtx);
+    while( !_flush_stop ){
+        if( !_flush_scheduled ){
+            _flush_cond.wait(lock);
+            continue;
+        }
+        if( _flush_cond.wait_until(lock, _flush_at)
+            != std::cv_status::timeout ){
+            continue;
+        }
+        _flush_scheduled = false;
+
+        lock.unlock();
+        try{
+            _send_subscription_diff();
+        }catch(std::exception& e){
+            cerr<< "failed to flush subscriptions: " << e.what() << endl;
+        }
+        lock.lock();
+    }
+}
+
+
+void
+StreamingSessionImpl::_start_flush_thread()
+{
+    D("start flush thread", this);
+    {
+        std::lock_guard<mutex> _(_flush_mtx);
+        _flush_stop = false;
+        _flush_scheduled = false;
+    }
+    _flush_thread = std::thread( [this]{ _flush_thread_target(); } );
+}
+
+
+void
+StreamingSessionImpl::_stop_flush_thread()
+{
+    D("stop flush thread", this);
+    {
+        std::lock_guard<mutex> _(_flush_mtx);
+        _flush_stop = true;
+    }
+    _flush_cond.notify_all();
+    if( _flush_thread.joinable() )
+        _flush_thread.join();
+}
+
+
+void
+StreamingSessionImpl::start_order_cache_sync( Credentials& creds,
+                                              const string& account_id,
+                                              milliseconds resync_interval,
+                                              unsigned int lookback_days )
+{
+    if( lookback_days < 1 || lookback_days > ORDER_CACHE_SYNC_MAX_LOOKBACK_DAYS )
+        TDMA_API_THROW(ValueException, "invalid lookback_days");
+
+    string acct = account_id.empty() ? _account_id : account_id;
+    if( acct.empty() )
+        TDMA_API_THROW(ValueException, "no account id to sync orders for");
+
+    std::lock_guard<mutex> ctl(_sync_ctl_mtx);
+    _stop_sync_thread();
+
+    /* the thread can outlive the caller's credentials */
+    std::shared_ptr<Credentials> pcreds = copy_connect_creds(creds);
+    auto sync = [this, pcreds, acct, lookback_days](){
+        /* events after this are newer than what the getter returns */
+        unsigned long long seq = _order_cache.sequence();
+        json orders = get_orders_for_streaming(
+            *pcreds, acct, ORDER_CACHE_SYNC_MAX_RESULTS,
+            iso8601_date(-static_cast<int>(lookback_days)), iso8601_date(0)
+            );
+        _order_cache.seed(orders, seq);
+    };
+
+    _order_cache_enabled = true;
+    sync();
+
+    /* even w/o an interval we resync after a reconnect */
+    D("start order cache sync thread", this);
+    {
+        std::lock_guard<mutex> _(_sync_mtx);
+        _sync_stop = false;
+        _sync_now = false;
+    }
+    _sync_thread = std::thread( [this, sync, resync_interval]{
+        std::unique_lock<mutex> lock(_sync_mtx);
+        auto woken = [this]{ return _sync_stop || _sync_now; };
+        while( !_sync_stop ){
+            if( resync_interval.count() > 0 )
+                _sync_cond.wait_for(lock, resync_interval, woken);
+            else
+                _sync_cond.wait(lock, woken);
+            if( _sync_stop )
+                break;
+            _sync_now = false;
+            lock.unlock();
+            try{
+                sync();
+            }catch(std::exception& e){
+                cerr<< "failed to resync order cache: " << e.what() << endl;
+            }
+            lock.lock();
+        }
+    } );
+}
+
+
+void
+StreamingSessionImpl::stop_order_cache_sync()
+{
+    std::lock_guard<mutex> ctl(_sync_ctl_mtx);
+    _stop_sync_thread();
+}
+
+
+void
+StreamingSessionImpl::_stop_sync_thread()
+{
+    if( !_sync_thread.joinable() )
+        return;
+
+    D("stop order cache sync thread", this);
+    {
+        std::lock_guard<mutex> _(_sync_mtx);
+        _sync_stop = true;
+    }
+    _sync_cond.notify_all();
+    _sync_thread.join();
+}
+
+
+void
+StreamingSessionImpl::_request_order_cache_sync()
+{
+    {
+        std::lock_guard<mutex> _(_sync_mtx);
+        _sync_now = true;
+    }
+    _sync_cond.notify_all();
+}
+
+
+conn::WebSocketClientInterface*
+StreamingSessionImpl::_new_client()
+{
+    if( !_replay_path.empty() )
+        return new conn::FrameReplayClient( _replay_path, _replay_speed );
+
+    switch( _overflow_policy ){
+    case StreamingOverflowPolicy::drop_oldest:
+        return new conn::WebSocketClient( _streamer_info.url,
+            _high_water_mark, conn::OverflowPolicy::drop_oldest, &_in_stats,
+            &_recorder );
+    case StreamingOverflowPolicy::conflate:
+        /* the listener conflates batches at the mark; block well past it */
+        return new conn::WebSocketClient( _streamer_info.url,
+            _high_water_mark * CONFLATE_HEADROOM, conn::OverflowPolicy::block,
+            &_in_stats, &_recorder );
+    default:
+        return new conn::WebSocketClient( _streamer_info.url,
+            _high_water_mark, conn::OverflowPolicy::block, &_in_stats,
+            &_recorder );
+    }
+}
+
+
+bool
+StreamingSessionImpl::_reconnect()
+{
+    if( !_auto_reconnect || _stopping )
+        return false;
+
+    unsigned long long gap_start = _last_recv_ms;
+    milliseconds backoff = StreamingSession::RECONNECT_MIN_BACKOFF;
+
+    for( unsigned int attempt = 1;
+         attempt <= StreamingSession::RECONNECT_MAX_ATTEMPTS;
+         ++attempt )
+    {
+        {
+            std::unique_lock<mutex> lock(_reconnect_mtx);
+            if( _reconnect_cond.wait_for( lock, backoff,
+                                          [this](){ return _stopping.load(); } ) )
+            {
+                return false;
+            }
+        }
+        backoff = std::min( backoff * 2, StreamingSession::RECONNECT_MAX_BACKOFF );
+
+        D("reconnect attempt " + to_string(attempt), this);
+        std::unique_ptr<conn::WebSocketClientInterface> client;
+        try{
+            client.reset( _new_client() );
+            client->connect( _connect_timeout );
+            if( !client->is_connected() || !_login(*client) )
+                continue;
+        }catch( std::exception& e ){
+            D(string("reconnect failed: ") + e.what(), this);
+            continue;
+        }
+
+        std::unique_ptr<conn::WebSocketClientInterface> old;
+        std::unordered_map<int, PendingResponse> dropped;
+        {
+            std::lock_guard<mutex> _(_send_mtx);
+            if( _stopping ){
+                client->close();
+                return false;
+            }
+            old = std::move(_client);
+            _client = std::move(client);
+            _logged_in = true;
+            dropped = _responses_pending.take_all();
+            _sub_manager.reset_live(); // new server session has nothing
+        }
+        _fail_responses( std::move(dropped) );
+        try{
+            if( old )
+                old->close(false); // it's dead or silent, don't wait on it
+        }catch(...){
+        }
+
+        /* responses come back through the listener once we return */
+        try{
+            _send_subscription_diff();
+            if( _qos != QOSType::fast ){
+                PendingResponse::response_cb_ty cb =
+                    [this]( int id, string serv, string cmd,
+                            unsigned long long ts, int code, string msg )
+                    {
+                        json j = {
+                            {"request_id", id},
+                            {"command ", cmd},
+                            {"code", code},
+                            {"message", msg}
+                        };
+                        this->_exec_callback(
+                            StreamingCallbackType::request_response,
+                            streamer_service_from_str(serv), ts, j );
+                    };
+                AdminSubscriptionImpl sub(
+                    CommandType::QOS,
+                    {{"qoslevel", to_string(static_cast<int>(_qos.load()))}}
+                );
+                std::lock_guard<mutex> _(_send_mtx);
+                _send_requests( {sub}, cb );
+            }
+        }catch( std::exception& e ){
+            /* exec() will find the connection down and we'll be back */
+            D(string("replay failed: ") + e.what(), this);
+        }
+
+        unsigned long long gap_end =
+            util::get_msec_since_epoch<std::chrono::system_clock>().count();
+        if( !gap_start )
+            gap_start = gap_end;
+        _last_recv_ms = gap_end;
+
+        /* order events in the gap are gone; get them from the REST side */
+        _request_order_cache_sync();
+
+        json j = {
+            {"gap_start", gap_start},
+            {"gap_end", gap_end},
+            {"gap_msec", gap_end - gap_start},
+            {"attempts", attempt}
+        };
+        _exec_callback( StreamingCallbackType::reconnected,
+                        StreamerServiceType::NONE, gap_end, j );
+        return true;
+    }
+
+    D("reconnect gave up", this);
+    return false;
+}
+
+
+deque<bool>
+StreamingSessionImpl::start(
+    const vector<StreamingSubscriptionImpl>& subscriptions
+    )
+{
+    D("start", this);
+
+    if( _has_client() )
+        TDMA_API_THROW(StreamingException,"session has already started");
+
+    if( subscriptions.empty() )
+        TDMA_API_THROW(StreamingException,"subscriptions is empty");
+
+    for( auto& sub : subscriptions ){
+        if( sub.get_command_str() != to_string(CommandType::SUBS) )
+            TDMA_API_THROW(StreamingException, "can only start() session "
+                "using Subscriptions with command 'SUBS'");
+    }
+
+    D("check unique session", this);
+    string acct = get_primary_account_id();
+    if( !is_replay() && active_accounts.count(acct) ){
+        TDMA_API_THROW( StreamingException,
+                        "Can not start Session; one is already active "
+                        "for this primary account: " + acct );
+    }
+
+    D("_client->reset", this);
+    _stopping = false;
+    _client.reset( _new_client() );
+
+    D("_client->connect", this);
+    _client->connect( _connect_timeout );
+    if( !_client->is_connected() ){
+        _client.reset();
+        TDMA_API_THROW( StreamingException,
+                        "streaming session failed to connect" );
+    }
+
+    _logged_in = _login(*_client);
+    if( !_logged_in )
+        TDMA_API_THROW(StreamingException,"login failed");
+
+    /* only after connect AND login do we consider this an active session */
+    if( !is_replay() )
+        active_accounts.insert(acct);
+    _start_listener_thread();
+    _start_flush_thread();
+    return add_subscriptions(subscriptions);
+}
+
+
+void
+StreamingSessionImpl::stop()
+{
+    D("stop", this);
+
+    /* before we look at _client; a reconnect may be swapping it */
+    {
+        std::lock_guard<mutex> _(_reconnect_mtx);
+        _stopping = true;
+    }
+    _reconnect_cond.notify_all();
+
+    _stop_flush_thread();
+    _stop_listener_thread();
+    try{
+        if( _client && _client->is_connected() ){
+            if( _logged_in )
+                _logged_in = !_logout();
+            _client->close();
+        }
+    }catch(...){
+        _reset();
+        throw;
+    }
+
+    _reset();
+}
+
+
+void
+StreamingSessionImpl::_reset()
+{
+    D("_reset", this);
+    {
+        std::lock_guard<mutex> _(_send_mtx);
+        _client.reset();
+    }
+    _fail_responses( _responses_pending.take_all() );
+    _sub_manager.clear();
+    _server_id.clear();
+    try{
+        if( !is_replay() )
+            active_accounts.erase( get_primary_account_id() );
+    }catch(...){}
+}
+
+
+void
+StreamingSessionImpl::_start_listener_thread()
+{
+    D("start listener thread", this);
+    assert( !_listening );
+
+    D("join listener thread", this);
+    if( _listener_thread.joinable() )
+        _listener_thread.join();
+
+    D("move new listener thread", this);
+    _listener_thread = std::move( std::thread(ListenerThreadTarget(this)) );
+}
+
+
+void
 StreamingSessionImpl::_stop_listener_thread()
 {
     D("stop listening thread", this);
@@ -1080,8 +2828,11 @@ StreamingSessionImpl::_stop_listener_thread()
      * force listeners thread out of a wait, but allow it to consume messages
      * up to *this* point first by setting _listening to false in loop
      */
-    if( _listening && _client )
-        _client->push_empty_message();
+    {
+        std::lock_guard<mutex> _(_send_mtx);
+        if( _listening && _client )
+            _client->push_empty_message();
+    }
 
     D("join listener thread", this);
     if( _listener_thread.joinable() )
@@ -1298,27 +3049,98 @@ StreamingSession_AddSubscriptions_ABI( StreamingSession_C *psession,
 }
 
 int
-StreamingSession_SetQOS_ABI( StreamingSession_C *psession,
-                             int qos,
-                             int *result,
-                             int allow_exceptions )
+StreamingSession_AddSubscriptionsAsync_ABI( StreamingSession_C *psession,
+                                            StreamingSubscription_C **subs,
+                                            size_t nsubs,
+                                            streaming_request_cb_ty callback,
+                                            void *ctx,
+                                            int allow_exceptions )
 {
     int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
     if( err )
         return err;
 
-    CHECK_ENUM(QOSType, qos, allow_exceptions);
+    CHECK_PTR(callback, "callback", allow_exceptions);
 
-    auto meth = +[](void *obj, int q){
-        return static_cast<int>(
-            reinterpret_cast<StreamingSessionImpl*>(obj)
-                ->set_qos( static_cast<QOSType>(q) )
-            );
-    };
+    if( nsubs > STREAMING_MAX_SUBSCRIPTIONS ){
+        return HANDLE_ERROR( ValueException,
+                             "nsubs > STREAMING_MAX_SUBSCRIPTIONS",
+                             allow_exceptions );
+    }
 
-    tie(*result, err) = CallImplFromABI(allow_exceptions, meth,
-                                        psession->obj, qos);
-    return err;
+    if( nsubs == 0 )
+        return HANDLE_ERROR(ValueException,"nsubs == 0", allow_exceptions);
+
+    vector<StreamingSubscriptionImpl> res;
+    try{
+        res = create_impl_subs(psession, subs, nsubs);
+    }catch(std::exception& e){
+        return HANDLE_ERROR(StreamingException, e.what(), allow_exceptions);
+    }
+
+    auto meth = +[]( void *obj, const vector<StreamingSubscriptionImpl>& s,
+                     streaming_request_cb_ty cb, void *c ){
+        reinterpret_cast<StreamingSessionImpl*>(obj)->add_subscriptions_async(
+            s,
+            [cb, c](size_t i, int code, const string& msg){
+                cb(i, code, msg.c_str(), c);
+            }
+        );
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj, res,
+                           callback, ctx);
+}
+
+int
+StreamingSession_SetQOS_ABI( StreamingSession_C *psession,
+                             int qos,
+                             int *result,
+                             int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_ENUM(QOSType, qos, allow_exceptions);
+
+    auto meth = +[](void *obj, int q){
+        return static_cast<int>(
+            reinterpret_cast<StreamingSessionImpl*>(obj)
+                ->set_qos( static_cast<QOSType>(q) )
+            );
+    };
+
+    tie(*result, err) = CallImplFromABI(allow_exceptions, meth,
+                                        psession->obj, qos);
+    return err;
+}
+
+int
+StreamingSession_SetQOSAsync_ABI( StreamingSession_C *psession,
+                                  int qos,
+                                  streaming_request_cb_ty callback,
+                                  void *ctx,
+                                  int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_ENUM(QOSType, qos, allow_exceptions);
+    CHECK_PTR(callback, "callback", allow_exceptions);
+
+    auto meth = +[](void *obj, int q, streaming_request_cb_ty cb, void *c){
+        reinterpret_cast<StreamingSessionImpl*>(obj)->set_qos_async(
+            static_cast<QOSType>(q),
+            [cb, c](size_t i, int code, const string& msg){
+                cb(i, code, msg.c_str(), c);
+            }
+        );
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj, qos,
+                           callback, ctx);
 }
 
 int
@@ -1339,3 +3161,653 @@ StreamingSession_GetQOS_ABI( StreamingSession_C *psession,
     tie(*qos, err) = CallImplFromABI(allow_exceptions, meth, psession->obj);
     return err;
 }
+
+int
+StreamingSession_SetOverflowPolicy_ABI( StreamingSession_C *psession,
+                                        size_t high_water_mark,
+                                        int policy,
+                                        int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_ENUM(StreamingOverflowPolicy, policy, allow_exceptions);
+
+    auto meth = +[](void *obj, size_t hwm, int p){
+        reinterpret_cast<StreamingSessionImpl*>(obj)
+            ->set_overflow_policy( hwm, static_cast<StreamingOverflowPolicy>(p) );
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj,
+                           high_water_mark, policy);
+}
+
+int
+StreamingSession_GetOverflowPolicy_ABI( StreamingSession_C *psession,
+                                        size_t *high_water_mark,
+                                        int *policy,
+                                        int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(high_water_mark, "high_water_mark", allow_exceptions);
+    CHECK_PTR(policy, "policy", allow_exceptions);
+
+    auto meth = +[](void *obj){
+        return reinterpret_cast<StreamingSessionImpl*>(obj)
+            ->get_overflow_policy();
+    };
+
+    std::pair<size_t, StreamingOverflowPolicy> p;
+    tie(p, err) = CallImplFromABI(allow_exceptions, meth, psession->obj);
+    if( err )
+        return err;
+
+    *high_water_mark = p.first;
+    *policy = static_cast<int>(p.second);
+    return 0;
+}
+
+int
+StreamingSession_GetOverflowStats_ABI( StreamingSession_C *psession,
+                                       StreamingOverflowStats_C *stats,
+                                       int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(stats, "stats", allow_exceptions);
+
+    auto meth = +[](void *obj){
+        return reinterpret_cast<StreamingSessionImpl*>(obj)
+            ->get_overflow_stats();
+    };
+
+    tie(*stats, err) = CallImplFromABI(allow_exceptions, meth, psession->obj);
+    return err;
+}
+
+int
+StreamingSession_SetQuoteBookEnabled_ABI( StreamingSession_C *psession,
+                                          int enabled,
+                                          int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    auto meth = +[](void *obj, int e){
+        reinterpret_cast<StreamingSessionImpl*>(obj)
+            ->set_quote_book_enabled( static_cast<bool>(e) );
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj, enabled);
+}
+
+int
+StreamingSession_IsQuoteBookEnabled_ABI( StreamingSession_C *psession,
+                                         int *enabled,
+                                         int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(enabled, "enabled", allow_exceptions);
+
+    auto meth = +[](void *obj){
+        return static_cast<int>(
+            reinterpret_cast<StreamingSessionImpl*>(obj)->is_quote_book_enabled()
+            );
+    };
+
+    tie(*enabled, err) = CallImplFromABI(allow_exceptions, meth, psession->obj);
+    return err;
+}
+
+int
+StreamingSession_GetQuoteBook_ABI( StreamingSession_C *psession,
+                                   int service,
+                                   const char *symbol,
+                                   unsigned long long since_seq,
+                                   StreamingRecord_C **records,
+                                   size_t *nrecords,
+                                   unsigned long long *seq,
+                                   int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_ENUM(StreamerServiceType, service, allow_exceptions);
+    CHECK_PTR(records, "records", allow_exceptions);
+    CHECK_PTR(nrecords, "nrecords", allow_exceptions);
+    CHECK_PTR(seq, "seq", allow_exceptions);
+
+    if( !QuoteBook::is_supported(static_cast<StreamerServiceType>(service)) ){
+        return HANDLE_ERROR( ValueException,
+                             "service not supported by quote book",
+                             allow_exceptions );
+    }
+
+    auto meth = +[]( void *obj, int s, const char* sym,
+                     unsigned long long since, size_t *n,
+                     unsigned long long *sq ){
+        return reinterpret_cast<StreamingSessionImpl*>(obj)
+            ->get_quote_book().export_records(
+                static_cast<StreamerServiceType>(s), sym, since, n, sq );
+    };
+
+    tie(*records, err) = CallImplFromABI( allow_exceptions, meth,
+                                          psession->obj, service, symbol,
+                                          since_seq, nrecords, seq );
+    return err;
+}
+
+int
+StreamingSession_SetOrderCacheEnabled_ABI( StreamingSession_C *psession,
+                                           int enabled,
+                                           int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    auto meth = +[](void *obj, int e){
+        reinterpret_cast<StreamingSessionImpl*>(obj)
+            ->set_order_cache_enabled( static_cast<bool>(e) );
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj, enabled);
+}
+
+int
+StreamingSession_IsOrderCacheEnabled_ABI( StreamingSession_C *psession,
+                                          int *enabled,
+                                          int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(enabled, "enabled", allow_exceptions);
+
+    auto meth = +[](void *obj){
+        return static_cast<int>(
+            reinterpret_cast<StreamingSessionImpl*>(obj)->is_order_cache_enabled()
+            );
+    };
+
+    tie(*enabled, err) = CallImplFromABI(allow_exceptions, meth, psession->obj);
+    return err;
+}
+
+int
+StreamingSession_SetOrderEventCallback_ABI( StreamingSession_C *psession,
+                                            order_event_cb_ty callback,
+                                            int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    auto meth = +[](void *obj, order_event_cb_ty cb){
+        reinterpret_cast<StreamingSessionImpl*>(obj)->set_order_event_callback(cb);
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj, callback);
+}
+
+int
+StreamingSession_GetOrderState_ABI( StreamingSession_C *psession,
+                                    const char *order_id,
+                                    OrderState_C *state,
+                                    int *found,
+                                    int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(order_id, "order_id", allow_exceptions);
+    CHECK_PTR(state, "state", allow_exceptions);
+    CHECK_PTR(found, "found", allow_exceptions);
+
+    auto meth = +[](void *obj, const char *id, OrderState_C *st){
+        return static_cast<int>(
+            reinterpret_cast<StreamingSessionImpl*>(obj)
+                ->get_order_cache().get(id, st)
+            );
+    };
+
+    tie(*found, err) = CallImplFromABI( allow_exceptions, meth, psession->obj,
+                                        order_id, state );
+    return err;
+}
+
+int
+StreamingSession_GetOrderStates_ABI( StreamingSession_C *psession,
+                                     unsigned long long since_seq,
+                                     OrderState_C **states,
+                                     size_t *n,
+                                     unsigned long long *seq,
+                                     int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(states, "states", allow_exceptions);
+    CHECK_PTR(n, "n", allow_exceptions);
+    CHECK_PTR(seq, "seq", allow_exceptions);
+
+    auto meth = +[]( void *obj, unsigned long long since, size_t *pn,
+                     unsigned long long *sq ){
+        return reinterpret_cast<StreamingSessionImpl*>(obj)
+            ->get_order_cache().export_states(since, pn, sq);
+    };
+
+    tie(*states, err) = CallImplFromABI( allow_exceptions, meth, psession->obj,
+                                         since_seq, n, seq );
+    return err;
+}
+
+int
+StreamingSession_StartOrderCacheSync_ABI( StreamingSession_C *psession,
+                                          struct Credentials *pcreds,
+                                          const char *account_id,
+                                          unsigned long resync_msec,
+                                          unsigned int lookback_days,
+                                          int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(pcreds, "credentials", allow_exceptions);
+
+    auto meth = +[]( void *obj, struct Credentials *c, const char *acct,
+                     unsigned long msec, unsigned int days ){
+        reinterpret_cast<StreamingSessionImpl*>(obj)
+            ->start_order_cache_sync( *c, acct ? acct : "",
+                                      milliseconds(msec), days );
+    };
+
+    return CallImplFromABI( allow_exceptions, meth, psession->obj, pcreds,
+                            account_id, resync_msec, lookback_days );
+}
+
+int
+StreamingSession_StopOrderCacheSync_ABI( StreamingSession_C *psession,
+                                         int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    auto meth = +[](void *obj){
+        reinterpret_cast<StreamingSessionImpl*>(obj)->stop_order_cache_sync();
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj);
+}
+
+int
+StreamingSession_IsOrderCacheSyncing_ABI( StreamingSession_C *psession,
+                                          int *syncing,
+                                          int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(syncing, "syncing", allow_exceptions);
+
+    auto meth = +[](void *obj){
+        return static_cast<int>(
+            reinterpret_cast<StreamingSessionImpl*>(obj)->is_order_cache_syncing()
+            );
+    };
+
+    tie(*syncing, err) = CallImplFromABI(allow_exceptions, meth, psession->obj);
+    return err;
+}
+
+int
+StreamingSession_GetOpenOrders_ABI( StreamingSession_C *psession,
+                                    const char *symbol,
+                                    OrderState_C **states,
+                                    size_t *n,
+                                    int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(states, "states", allow_exceptions);
+    CHECK_PTR(n, "n", allow_exceptions);
+
+    auto meth = +[](void *obj, const char *sym, size_t *pn){
+        return reinterpret_cast<StreamingSessionImpl*>(obj)
+            ->get_order_cache().export_open(sym, pn);
+    };
+
+    tie(*states, err) = CallImplFromABI( allow_exceptions, meth, psession->obj,
+                                         symbol, n );
+    return err;
+}
+
+int
+StreamingSession_SetDispatchThreads_ABI( StreamingSession_C *psession,
+                                         unsigned int nthreads,
+                                         int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    auto meth = +[](void *obj, unsigned int n){
+        reinterpret_cast<StreamingSessionImpl*>(obj)->set_dispatch_threads(n);
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj, nthreads);
+}
+
+int
+StreamingSession_GetDispatchThreads_ABI( StreamingSession_C *psession,
+                                         unsigned int *nthreads,
+                                         int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(nthreads, "nthreads", allow_exceptions);
+
+    auto meth = +[](void *obj){
+        return reinterpret_cast<StreamingSessionImpl*>(obj)
+            ->get_dispatch_threads();
+    };
+
+    tie(*nthreads, err) = CallImplFromABI(allow_exceptions, meth,
+                                          psession->obj);
+    return err;
+}
+
+int
+StreamingSession_SetTypedCallback_ABI( StreamingSession_C *psession,
+                                       streaming_typed_cb_ty callback,
+                                       int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    auto meth = +[](void *obj, streaming_typed_cb_ty cb){
+        reinterpret_cast<StreamingSessionImpl*>(obj)->set_typed_callback(cb);
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj, callback);
+}
+
+int
+StreamingSession_Subscribe_ABI( StreamingSession_C *psession,
+                                StreamingSubscription_C *sub,
+                                int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(sub, "subscription", allow_exceptions);
+
+    auto meth = +[](StreamingSession_C *ps, StreamingSubscription_C *s){
+        reinterpret_cast<StreamingSessionImpl*>(ps->obj)
+            ->subscribe( create_impl_sub(ps, s) );
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession, sub);
+}
+
+int
+StreamingSession_Unsubscribe_ABI( StreamingSession_C *psession,
+                                  StreamingSubscription_C *sub,
+                                  int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(sub, "subscription", allow_exceptions);
+
+    auto meth = +[](StreamingSession_C *ps, StreamingSubscription_C *s){
+        reinterpret_cast<StreamingSessionImpl*>(ps->obj)
+            ->unsubscribe( create_impl_sub(ps, s) );
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession, sub);
+}
+
+int
+StreamingSession_FlushSubscriptions_ABI( StreamingSession_C *psession,
+                                         int *result,
+                                         int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(result, "result", allow_exceptions);
+
+    auto meth = +[](void *obj){
+        return static_cast<int>( reinterpret_cast<StreamingSessionImpl*>(obj)
+                                     ->flush_subscriptions() );
+    };
+
+    tie(*result, err) = CallImplFromABI(allow_exceptions, meth, psession->obj);
+    return err;
+}
+
+int
+StreamingSession_GetSubscribedSymbols_ABI( StreamingSession_C *psession,
+                                           int service,
+                                           char ***buffers,
+                                           size_t *n,
+                                           int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_ENUM(StreamerServiceType, service, allow_exceptions);
+    CHECK_PTR(buffers, "buffers", allow_exceptions);
+    CHECK_PTR(n, "n", allow_exceptions);
+
+    auto meth = +[](void *obj, int s){
+        return reinterpret_cast<StreamingSessionImpl*>(obj)
+            ->get_subscribed_symbols( static_cast<StreamerServiceType>(s) );
+    };
+
+    set<string> strs;
+    tie(strs, err) = CallImplFromABI(allow_exceptions, meth, psession->obj,
+                                     service);
+    if( err )
+        return err;
+
+    return to_new_char_buffers(strs, buffers, n, allow_exceptions);
+}
+
+int
+StreamingSession_SetSubscriptionWindow_ABI( StreamingSession_C *psession,
+                                            unsigned long msec,
+                                            int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    auto meth = +[](void *obj, unsigned long ms){
+        reinterpret_cast<StreamingSessionImpl*>(obj)
+            ->set_subscription_window( milliseconds(ms) );
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj, msec);
+}
+
+int
+StreamingSession_GetSubscriptionWindow_ABI( StreamingSession_C *psession,
+                                            unsigned long *msec,
+                                            int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(msec, "msec", allow_exceptions);
+
+    auto meth = +[](void *obj){
+        return static_cast<unsigned long>(
+            reinterpret_cast<StreamingSessionImpl*>(obj)
+                ->get_subscription_window().count() );
+    };
+
+    tie(*msec, err) = CallImplFromABI(allow_exceptions, meth, psession->obj);
+    return err;
+}
+
+int
+StreamingSession_SetAutoReconnect_ABI( StreamingSession_C *psession,
+                                       int enabled,
+                                       int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    auto meth = +[](void *obj, int e){
+        reinterpret_cast<StreamingSessionImpl*>(obj)
+            ->set_auto_reconnect( static_cast<bool>(e) );
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj, enabled);
+}
+
+int
+StreamingSession_CreateReplay_ABI( const char *path,
+                                   double speed,
+                                   streaming_cb_ty callback,
+                                   unsigned long listening_timeout,
+                                   StreamingSession_C *psession,
+                                   int allow_exceptions )
+{
+    CHECK_PTR(psession, "session", allow_exceptions);
+    CHECK_PTR_KILL_PROXY(path, "path", allow_exceptions, psession);
+    CHECK_PTR_KILL_PROXY(callback, "callback", allow_exceptions, psession);
+
+    if( !(speed >= 0.0) ){
+        return HANDLE_ERROR_EX( ValueException, "invalid replay speed",
+                                allow_exceptions, psession );
+    }
+
+    if( !conn::FrameReplayClient::is_capture_file(path) ){
+        return HANDLE_ERROR_EX( ValueException,
+                                "invalid capture file: " + string(path),
+                                allow_exceptions, psession );
+    }
+
+    static auto meth = +[]( const char *p, double s, streaming_cb_ty cb,
+                            unsigned long lto ){
+        return new StreamingSessionImpl( p, s, cb, milliseconds(lto) );
+    };
+
+    int err;
+    StreamingSessionImpl *obj;
+    tie(obj, err) = CallImplFromABI( allow_exceptions, meth, path, speed,
+                                     callback, listening_timeout );
+    if( err ){
+        kill_proxy(psession);
+        return err;
+    }
+
+    psession->obj = reinterpret_cast<void*>(obj);
+    psession->ctx = nullptr;
+    psession->type_id = StreamingSessionImpl::TYPE_ID_LOW;
+    return 0;
+}
+
+int
+StreamingSession_StartCapture_ABI( StreamingSession_C *psession,
+                                   const char *path,
+                                   int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(path, "path", allow_exceptions);
+
+    auto meth = +[](void *obj, const char *p){
+        reinterpret_cast<StreamingSessionImpl*>(obj)->start_capture(p);
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj, path);
+}
+
+int
+StreamingSession_StopCapture_ABI( StreamingSession_C *psession,
+                                  int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    auto meth = +[](void *obj){
+        reinterpret_cast<StreamingSessionImpl*>(obj)->stop_capture();
+    };
+
+    return CallImplFromABI(allow_exceptions, meth, psession->obj);
+}
+
+int
+StreamingSession_IsCapturing_ABI( StreamingSession_C *psession,
+                                  int *capturing,
+                                  int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(capturing, "capturing", allow_exceptions);
+
+    auto meth = +[](void *obj){
+        return static_cast<int>( reinterpret_cast<StreamingSessionImpl*>(obj)
+                                     ->is_capturing() );
+    };
+
+    tie(*capturing, err) = CallImplFromABI(allow_exceptions, meth, psession->obj);
+    return err;
+}
+
+int
+StreamingSession_IsAutoReconnect_ABI( StreamingSession_C *psession,
+                                      int *enabled,
+                                      int allow_exceptions )
+{
+    int err = proxy_is_callable<StreamingSessionImpl>(psession, allow_exceptions);
+    if( err )
+        return err;
+
+    CHECK_PTR(enabled, "enabled", allow_exceptions);
+
+    auto meth = +[](void *obj){
+        return static_cast<int>( reinterpret_cast<StreamingSessionImpl*>(obj)
+                                     ->is_auto_reconnect() );
+    };
+
+    tie(*enabled, err) = CallImplFromABI(allow_exceptions, meth, psession->obj);
+    return err;
+}
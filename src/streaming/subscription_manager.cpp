@@ -0,0 +1,311 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <iterator>
+
+#include "../../include/_streaming.h"
+#include "../../include/util.h"
+
+using std::string;
+using std::vector;
+using std::map;
+using std::set;
+using std::mutex;
+using std::lock_guard;
+
+namespace {
+
+using namespace tdma;
+
+class DiffSubscriptionImpl
+        : public StreamingSubscriptionImpl {
+public:
+    DiffSubscriptionImpl( const string& service,
+                          CommandType command,
+                          const map<string, string>& parameters )
+        :
+            StreamingSubscriptionImpl( service, to_string(command) )
+        {
+            set_parameters(parameters);
+        }
+};
+
+
+set<string>
+split_keys(const map<string, string>& parameters)
+{
+    set<string> keys;
+    auto f = parameters.find("keys");
+    if( f == parameters.cend() )
+        return keys;
+
+    std::stringstream ss(f->second);
+    string k;
+    while( std::getline(ss, k, ',') ){
+        if( !k.empty() )
+            keys.insert(k);
+    }
+    return keys;
+}
+
+
+bool
+split_fields(const map<string, string>& parameters, set<int>& fields)
+{
+    auto f = parameters.find("fields");
+    if( f == parameters.cend() )
+        return false;
+
+    fields.clear();
+    std::stringstream ss(f->second);
+    string v;
+    while( std::getline(ss, v, ',') ){
+        try{
+            fields.insert( std::stoi(v) );
+        }catch(std::exception&){
+        }
+    }
+    return true;
+}
+
+
+template<typename T>
+set<T>
+difference(const set<T>& a, const set<T>& b)
+{
+    set<T> d;
+    std::set_difference( a.begin(), a.end(), b.begin(), b.end(),
+                         std::inserter(d, d.begin()) );
+    return d;
+}
+
+} /* namespace */
+
+
+namespace tdma {
+
+SubscriptionManager::Service::Service()
+    :
+        live_keys(),
+        live_fields(),
+        wanted_keys(),
+        wanted_fields(),
+        resync(false)
+    {
+    }
+
+
+SubscriptionManager::SubscriptionManager()
+    :
+        _mtx(),
+        _services()
+    {
+    }
+
+
+void
+SubscriptionManager::observe(const StreamingSubscriptionImpl& sub, bool from_diff)
+{
+    string service = sub.get_service_str();
+    if( service == to_string(StreamerServiceType::ADMIN) )
+        return;
+
+    string cmd = sub.get_command_str();
+    auto params = sub.get_parameters();
+    set<string> keys = split_keys(params);
+    set<int> fields;
+    bool has_fields = split_fields(params, fields);
+
+    lock_guard<mutex> _(_mtx);
+    Service& s = _services[service];
+
+    if( cmd == to_string(CommandType::SUBS) ){
+        s.live_keys = keys;
+        if( has_fields )
+            s.live_fields = fields;
+        s.resync = false;
+    }else if( cmd == to_string(CommandType::ADD) ){
+        s.live_keys.insert(keys.begin(), keys.end());
+        if( has_fields )
+            s.live_fields = fields;
+    }else if( cmd == to_string(CommandType::UNSUBS) ){
+        if( keys.empty() ){
+            s.live_keys.clear();
+        }else{
+            for( auto& k : keys )
+                s.live_keys.erase(k);
+        }
+        if( s.live_keys.empty() )
+            s.resync = false;
+    }else if( cmd == to_string(CommandType::VIEW) ){
+        if( has_fields )
+            s.live_fields = fields;
+    }
+
+    if( from_diff )
+        return;
+
+    /* what's wanted follows requests made outside diff() */
+    if( cmd == to_string(CommandType::SUBS) ){
+        s.wanted_keys = keys;
+        if( has_fields )
+            s.wanted_fields = fields;
+    }else if( cmd == to_string(CommandType::ADD) ){
+        s.wanted_keys.insert(keys.begin(), keys.end());
+        if( has_fields )
+            s.wanted_fields = fields;
+    }else if( cmd == to_string(CommandType::UNSUBS) ){
+        if( keys.empty() ){
+            s.wanted_keys.clear();
+        }else{
+            for( auto& k : keys )
+                s.wanted_keys.erase(k);
+        }
+    }else if( cmd == to_string(CommandType::VIEW) ){
+        if( has_fields )
+            s.wanted_fields = fields;
+    }
+}
+
+
+void
+SubscriptionManager::subscribe(const StreamingSubscriptionImpl& sub)
+{
+    auto params = sub.get_parameters();
+    set<string> keys = split_keys(params);
+    set<int> fields;
+    bool has_fields = split_fields(params, fields);
+
+    lock_guard<mutex> _(_mtx);
+    Service& s = _services[sub.get_service_str()];
+    s.wanted_keys.insert(keys.begin(), keys.end());
+    if( has_fields )
+        s.wanted_fields = fields;
+}
+
+
+void
+SubscriptionManager::unsubscribe(const StreamingSubscriptionImpl& sub)
+{
+    set<string> keys = split_keys( sub.get_parameters() );
+
+    lock_guard<mutex> _(_mtx);
+    auto f = _services.find( sub.get_service_str() );
+    if( f == _services.end() )
+        return;
+
+    for( auto& k : keys )
+        f->second.wanted_keys.erase(k);
+}
+
+
+void
+SubscriptionManager::invalidate(const std::string& service)
+{
+    lock_guard<mutex> _(_mtx);
+    auto f = _services.find(service);
+    if( f != _services.end() )
+        f->second.resync = true;
+}
+
+
+vector<StreamingSubscriptionImpl>
+SubscriptionManager::diff() const
+{
+    vector<StreamingSubscriptionImpl> subs;
+
+    lock_guard<mutex> _(_mtx);
+    for( auto& p : _services ){
+        const string& service = p.first;
+        const Service& s = p.second;
+        string wanted_keys = util::join(s.wanted_keys, ',');
+        string wanted_fields = util::join(s.wanted_fields, ',');
+
+        if( s.wanted_keys.empty() ){
+            if( !s.live_keys.empty() ){
+                subs.emplace_back( DiffSubscriptionImpl(service,
+                    CommandType::UNSUBS,
+                    {{"keys", util::join(s.live_keys, ',')}}) );
+            }
+            continue;
+        }
+
+        set<string> added = difference(s.wanted_keys, s.live_keys);
+        set<string> removed = difference(s.live_keys, s.wanted_keys);
+
+        /* re-SUBS when it's no more keys than the deltas */
+        if( s.resync || s.live_keys.empty()
+            || added.size() + removed.size() >= s.wanted_keys.size() )
+        {
+            subs.emplace_back( DiffSubscriptionImpl(service, CommandType::SUBS,
+                {{"keys", wanted_keys}, {"fields", wanted_fields}}) );
+            continue;
+        }
+
+        if( s.live_fields != s.wanted_fields ){
+            subs.emplace_back( DiffSubscriptionImpl(service, CommandType::VIEW,
+                {{"fields", wanted_fields}}) );
+        }
+
+        if( !removed.empty() ){
+            subs.emplace_back( DiffSubscriptionImpl(service,
+                CommandType::UNSUBS, {{"keys", util::join(removed, ',')}}) );
+        }
+
+        if( !added.empty() ){
+            subs.emplace_back( DiffSubscriptionImpl(service, CommandType::ADD,
+                {{"keys", util::join(added, ',')},
+                 {"fields", wanted_fields}}) );
+        }
+    }
+
+    return subs;
+}
+
+
+set<string>
+SubscriptionManager::get_keys(const std::string& service) const
+{
+    lock_guard<mutex> _(_mtx);
+    auto f = _services.find(service);
+    return (f == _services.end()) ? set<string>() : f->second.live_keys;
+}
+
+
+void
+SubscriptionManager::reset_live()
+{
+    lock_guard<mutex> _(_mtx);
+    for( auto& p : _services ){
+        p.second.live_keys.clear();
+        p.second.live_fields.clear();
+        p.second.resync = false;
+    }
+}
+
+
+void
+SubscriptionManager::clear()
+{
+    lock_guard<mutex> _(_mtx);
+    _services.clear();
+}
+
+} /* tdma */
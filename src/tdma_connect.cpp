@@ -20,6 +20,9 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <regex>
 #include <cctype>
 #include <mutex>
+#include <memory>
+#include <thread>
+#include <unordered_map>
 #include <string.h>
 
 #include "../include/_tdma_api.h"
@@ -52,6 +55,140 @@ error_msg_about_token_expiration(const string& msg)
         && std::regex_search(msg, EXPIRE_RX);
 }
 
+/*
+ * cache access tokens across calls by client_id so all cred structs
+ * of the same account are linked but different client_ids aren't
+ *
+ * NOTE - the cached token takes priority to avoid refresh 'thrashing'
+ *        between unsynced callers
+ */
+std::unordered_map<string, string> token_cache;
+std::mutex token_cache_mtx;
+
+string
+get_cached_token(const Credentials& creds)
+{
+    std::lock_guard<std::mutex> _(token_cache_mtx);
+    return token_cache.insert(
+        {creds.client_id, creds.access_token}
+    ).first->second;
+}
+
+/*
+ * put 'token' in the cred struct AND the cache; the swap happens under the
+ * cache lock so get_cached_token/check_connect_creds never see a freed token
+ */
+void
+set_token(Credentials& creds, const string& token)
+{
+    char *t = new char[token.size() + 1];
+    strcpy(t, token.c_str());
+
+    char *old;
+    {
+        std::lock_guard<std::mutex> _(token_cache_mtx);
+        old = creds.access_token;
+        creds.access_token = t;
+        token_cache[creds.client_id] = token;
+    }
+    delete[] old;
+}
+
+/*
+ * one refresh at a time per client_id: getters/sessions on other threads
+ * that hit the same expired token wait here and pick up the new one
+ */
+std::unordered_map<string, std::unique_ptr<std::mutex>> refresh_mtxs;
+
+std::mutex&
+refresh_mutex(const Credentials& creds)
+{
+    std::lock_guard<std::mutex> _(token_cache_mtx);
+    std::unique_ptr<std::mutex>& m = refresh_mtxs[creds.client_id];
+    if( !m )
+        m.reset( new std::mutex );
+    return *m;
+}
+
+/* refresh 'creds' unless someone else already replaced 'expired' */
+string
+refresh_token(Credentials& creds, const string& expired)
+{
+    std::lock_guard<std::mutex> _(refresh_mutex(creds));
+
+    string cached = get_cached_token(creds);
+    if( cached != expired ){
+        set_token(creds, cached);
+        return cached;
+    }
+
+    cerr<< "access token expired; try to refresh..." << endl;
+
+    /* refresh a copy so 'creds.access_token' is only swapped in set_token */
+    std::unique_ptr<Credentials> tmp;
+    {
+        std::lock_guard<std::mutex> _(token_cache_mtx);
+        tmp.reset( new Credentials(creds) );
+    }
+    tdma::RefreshAccessToken(*tmp);
+
+    string token(tmp->access_token);
+    set_token(creds, token);
+    return token;
+}
+
+/*
+ * async requests that hit an expired token queue up here so a batch of them
+ * costs one refresh: the first waiter for a client_id starts a thread to do
+ * the (blocking) refresh, everyone gets called when it's done
+ */
+typedef std::function<void(std::exception_ptr)> on_refresh_ty;
+
+std::unordered_map<string, vector<on_refresh_ty>> refresh_waiters; // token_cache_mtx
+
+void
+refresh_token_async( std::shared_ptr<Credentials> creds,
+                     const string& expired,
+                     on_refresh_ty on_refresh )
+{
+    string client_id(creds->client_id);
+    {
+        std::lock_guard<std::mutex> _(token_cache_mtx);
+        vector<on_refresh_ty>& w = refresh_waiters[client_id];
+        w.push_back( std::move(on_refresh) );
+        if( w.size() > 1 )
+            return;
+    }
+
+    std::thread( [=](){
+        std::exception_ptr e;
+        try{
+            refresh_token(*creds, expired);
+        }catch(...){
+            e = std::current_exception();
+        }
+
+        vector<on_refresh_ty> w;
+        {
+            std::lock_guard<std::mutex> _(token_cache_mtx);
+            auto iter = refresh_waiters.find(client_id);
+            w.swap(iter->second);
+            refresh_waiters.erase(iter);
+        }
+        for( auto& f : w )
+            f(e);
+    }).detach();
+}
+
+const vector<pair<string,string>> GET_STATIC_HEADERS = {
+    {"Accept", "application/json"}
+};
+
+const vector<pair<string,string>> EXECUTE_STATIC_HEADERS = {
+    {"Accept", "*/*"},
+    {"Content-Type", "application/json"}
+};
+
 } /* namespace */
 
 
@@ -147,7 +284,7 @@ query_api_on_error_callback(long code, const string& data)
 }
 
 
-tuple<long, string, string, conn::clock_ty::time_point>
+tuple<long, conn::ResponseBuffer, string, conn::clock_ty::time_point>
 curl_execute(conn::HTTPConnectionInterface& connection, bool return_header_data)
 {   /*
      * Curl exceptions are not exposed publicly so we catch and wrap
@@ -193,6 +330,19 @@ on_return( long code,
     return false;
 }
 
+/* only builds a string from the body on failure */
+bool
+on_return( long code,
+           long success_code,
+           const conn::ResponseBuffer& data,
+           bool allow_refresh,
+           api_on_error_cb_ty on_error_cb )
+{
+    if( code == success_code )
+        return true;
+    return on_return(code, success_code, data.str(), allow_refresh, on_error_cb);
+}
+
 
 vector<pair<string,string>>
 build_auth_headers( const vector<pair<string,string>>& headers,
@@ -204,37 +354,48 @@ build_auth_headers( const vector<pair<string,string>>& headers,
 }
 
 
-tuple<string, string, conn::clock_ty::time_point>
-connect( conn::HTTPConnectionInterface& connection,
-         Credentials& creds,
-         const vector<pair<string,string>>& static_headers,
-         api_on_error_cb_ty on_error_cb,
-         bool return_headers,
-         long success_code )
+void
+check_connect_creds( Credentials& creds )
 {
-    if( !creds.access_token || !creds.client_id )
+    if( !creds.client_id )
         TDMA_API_THROW( LocalCredentialException, "invalid credentials" );
 
-    if( creds.access_token[0] == '\0' )
-        TDMA_API_THROW( LocalCredentialException, "empty access_token" );
+    {
+        /* another thread may be swapping in a refreshed token */
+        std::lock_guard<std::mutex> _(token_cache_mtx);
+        if( !creds.access_token )
+            TDMA_API_THROW( LocalCredentialException, "invalid credentials" );
+        if( creds.access_token[0] == '\0' )
+            TDMA_API_THROW( LocalCredentialException, "empty access_token" );
+    }
 
     if( creds.client_id[0] == '\0' )
         TDMA_API_THROW( LocalCredentialException, "empty client_id");
+}
+
+
+void
+check_connect_args( conn::HTTPConnectionInterface& connection,
+                    Credentials& creds )
+{
+    check_connect_creds(creds);
 
     if( connection.is_closed() )
         TDMA_API_THROW( APIException, "connection is closed");
+}
 
-    /*
-     * cache access tokens across calls by client_id so all cred structs
-     * of the same account are linked but different client_ids aren't
-     *
-     * NOTE - the cached token takes priority to avoid refresh 'thrashing'
-     *        between unsynced callers
-     */
-    static std::unordered_map<string, string> token_cache;
-    string& cached_token = token_cache.insert(
-        {creds.client_id, creds.access_token}
-    ).first->second;
+
+tuple<conn::ResponseBuffer, string, conn::clock_ty::time_point>
+connect( conn::HTTPConnectionInterface& connection,
+         Credentials& creds,
+         const vector<pair<string,string>>& static_headers,
+         api_on_error_cb_ty on_error_cb,
+         bool return_headers,
+         long success_code )
+{
+    check_connect_args(connection, creds);
+
+    string cached_token = get_cached_token(creds);
 
     /* only add headers if we don't already have them */
     if( !connection.has_headers() ){
@@ -243,7 +404,8 @@ connect( conn::HTTPConnectionInterface& connection,
     }
 
     long r_code;
-    string r_data, r_head;
+    conn::ResponseBuffer r_data;
+    string r_head;
     conn::clock_ty::time_point r_tp;
     tie(r_code, r_data, r_head, r_tp) = curl_execute(connection, return_headers);
 
@@ -269,17 +431,12 @@ connect( conn::HTTPConnectionInterface& connection,
         /* first check that header token is same as cached version */
         if( old_headers.back().second != ("Bearer " + cached_token) ){
 
-            /* overwrite the token in creds w/ cached */
-            if( strcmp(creds.access_token, cached_token.c_str()) ){
-                /*
-                 * should only get in here if client is using references
-                 * to different cred structs (not recommended)
-                 */
-                delete[] creds.access_token;
-                creds.access_token = new char[cached_token.size() + 1];
-                creds.access_token[cached_token.size()] = 0;
-                strcpy(creds.access_token, cached_token.c_str());
-            }
+            /*
+             * overwrite the token in creds w/ cached; should only matter if
+             * client is using references to different cred structs (not
+             * recommended)
+             */
+            set_token(creds, cached_token);
 
             /* update headers w/ cached */
             connection.reset_headers();
@@ -292,14 +449,11 @@ connect( conn::HTTPConnectionInterface& connection,
 
             /* if still FALSE, expired token IN CACHE, continue to refresh */
             if( on_return(r_code, success_code, r_data, true, on_error_cb) )
-                return make_tuple(r_data, r_head, r_tp);
+                return make_tuple(std::move(r_data), std::move(r_head), r_tp);
         }
 
-        cerr<< "access token expired; try to refresh..." << endl;
-        RefreshAccessToken(creds); // updates creds.access_token
-
-        /* update the cache */
-        cached_token = creds.access_token;
+        /* updates creds.access_token and the cache */
+        cached_token = refresh_token(creds, cached_token);
 
         /* update the header */
         connection.reset_headers();
@@ -315,28 +469,136 @@ connect( conn::HTTPConnectionInterface& connection,
         cerr<< "...successfully refreshed access token" << endl;
     } 
 
-    return make_tuple(r_data, r_head, r_tp);
+    return make_tuple(std::move(r_data), std::move(r_head), r_tp);
 }
 
 
-pair<string, conn::clock_ty::time_point>
+pair<conn::ResponseBuffer, conn::clock_ty::time_point>
 connect_get( conn::HTTPConnectionInterface& connection,
              Credentials& creds,
              api_on_error_cb_ty on_error_cb )
 {
-    static const vector<pair<string,string>> STATIC_HEADERS = {
-        {"Accept", "application/json"}
-    };
-
     assert( connection.get_method() == conn::HttpMethod::http_get );
 
-    string r_data, r_head;
+    conn::ResponseBuffer r_data;
+    string r_head;
     conn::clock_ty::time_point r_tp;
-    tie(r_data, r_head, r_tp) = connect(connection, creds, STATIC_HEADERS,
+    tie(r_data, r_head, r_tp) = connect(connection, creds, GET_STATIC_HEADERS,
                                         on_error_cb, false,
                                         conn::HTTP_RESPONSE_OK);
 
-    return make_pair(r_data, r_tp);
+    return make_pair(std::move(r_data), r_tp);
+}
+
+
+/*
+ * a request run by the CurlMultiEngine; it holds its own copy of the
+ * credentials since the caller's may be gone by the time we need to refresh
+ */
+struct AsyncCall{
+    conn::HTTPRequest request; // w/o the auth header
+    const vector<pair<string,string>>& static_headers;
+    vector<conn::CurlMultiEngine::gate_ty> gates;
+    std::shared_ptr<Credentials> creds;
+    long success_code;
+    api_on_error_cb_ty on_error_cb;
+    std::function<void(conn::HTTPResponse&&)> on_success;
+    std::function<void(std::exception_ptr)> on_error;
+};
+
+std::shared_ptr<Credentials>
+copy_connect_creds(const Credentials& creds)
+{
+    std::lock_guard<std::mutex> _(token_cache_mtx);
+    return std::make_shared<Credentials>(creds);
+}
+
+/*
+ * on an expired token wait for the (shared) refresh and resubmit, back
+ * through the gates, w/ the new one
+ */
+unsigned long long
+submit_async(std::shared_ptr<const AsyncCall> call, bool allow_refresh)
+{
+    string token = get_cached_token(*call->creds);
+
+    conn::HTTPRequest req(call->request);
+    req.headers = build_auth_headers(call->static_headers, token);
+
+    auto on_done = [=](conn::HTTPResponse&& r){
+        bool ok;
+        try{
+            if( r.curl_code != CURLE_OK ){
+                string msg = r.error + "(curl code="
+                           + std::to_string(r.curl_code) + ')';
+                if( r.curl_code == CURLE_OPERATION_TIMEDOUT )
+                    TDMA_API_THROW( TimeoutError, msg );
+                TDMA_API_THROW( ConnectException, msg );
+            }
+            ok = on_return(r.code, call->success_code, r.body, allow_refresh,
+                           call->on_error_cb);
+        }catch(...){
+            call->on_error( std::current_exception() );
+            return;
+        }
+
+        if( ok ){
+            call->on_success( std::move(r) );
+            return;
+        }
+
+        refresh_token_async( call->creds, token,
+            [call](std::exception_ptr e){
+                if( !e ){
+                    try{
+                        submit_async(call, false);
+                        return;
+                    }catch(...){
+                        e = std::current_exception();
+                    }
+                }
+                call->on_error(e);
+            } );
+    };
+
+    return conn::CurlMultiEngine::instance().submit(
+        std::move(req), call->gates, on_done
+        );
+}
+
+
+unsigned long long
+connect_get_async( conn::HTTPConnectionInterface& connection,
+                   Credentials& creds,
+                   api_on_error_cb_ty on_error_cb,
+                   std::vector<conn::CurlMultiEngine::gate_ty> gates,
+                   async_get_cb_ty callback )
+{
+    assert( connection.get_method() == conn::HttpMethod::http_get );
+
+    check_connect_args(connection, creds);
+
+    auto on_success = [=](conn::HTTPResponse&& r){
+        callback( std::move(r.body), nullptr );
+    };
+
+    auto on_error = [=](std::exception_ptr e){
+        callback( conn::ResponseBuffer(), e );
+    };
+
+    std::shared_ptr<const AsyncCall> call( new AsyncCall{
+        {connection.get_url(), conn::HttpMethod::http_get, {}, "",
+         connection.get_timeout(), false},
+        GET_STATIC_HEADERS,
+        std::move(gates),
+        copy_connect_creds(creds),
+        conn::HTTP_RESPONSE_OK,
+        on_error_cb,
+        on_success,
+        on_error
+    } );
+
+    return submit_async(call, true);
 }
 
 
@@ -345,16 +607,13 @@ connect_execute( conn::HTTPConnectionInterface& connection,
                  Credentials& creds,
                  long success_code )
 {
-    static const vector<pair<string,string>> STATIC_HEADERS = {
-        {"Accept", "*/*"},
-        {"Content-Type", "application/json"}
-    };
-
     assert( connection.get_method() != conn::HttpMethod::http_get );
 
-    string r_data, r_head;
+    conn::ResponseBuffer r_data;
+    string r_head;
     conn::clock_ty::time_point r_tp;
-    tie(r_data, r_head, r_tp) = connect( connection, creds, STATIC_HEADERS,
+    tie(r_data, r_head, r_tp) = connect( connection, creds,
+                                         EXECUTE_STATIC_HEADERS,
                                          account_api_on_error_callback,
                                          true, success_code );
 
@@ -362,6 +621,42 @@ connect_execute( conn::HTTPConnectionInterface& connection,
 }
 
 
+unsigned long long
+connect_execute_async( const string& url,
+                       conn::HttpMethod meth,
+                       const string& body,
+                       Credentials& creds,
+                       long success_code,
+                       long timeout,
+                       async_execute_cb_ty callback )
+{
+    assert( meth != conn::HttpMethod::http_get );
+
+    check_connect_creds(creds);
+
+    auto on_success = [=](conn::HTTPResponse&& r){
+        callback( std::move(r.header), r.tp, nullptr );
+    };
+
+    auto on_error = [=](std::exception_ptr e){
+        callback( "", conn::clock_ty::now(), e );
+    };
+
+    std::shared_ptr<const AsyncCall> call( new AsyncCall{
+        {url, meth, {}, body, timeout, true},
+        EXECUTE_STATIC_HEADERS,
+        {},
+        copy_connect_creds(creds),
+        success_code,
+        account_api_on_error_callback,
+        on_success,
+        on_error
+    } );
+
+    return submit_async(call, true);
+}
+
+
 json
 connect_auth(conn::HTTPConnectionInterface& connection, std::string fname)
 {
@@ -374,17 +669,18 @@ connect_auth(conn::HTTPConnectionInterface& connection, std::string fname)
     connection.add_headers(STATIC_HEADERS);
 
     long r_code;
-    string r_data, h_data;
+    conn::ResponseBuffer r_data;
+    string h_data;
     conn::clock_ty::time_point r_tp;
     tie(r_code, r_data, h_data, r_tp) = curl_execute(connection, false);
 
     if( r_code != conn::HTTP_RESPONSE_OK ){
-        string e = fname + " failed: " + r_data;
+        string e = fname + " failed: " + r_data.str();
         cerr<< "error response: " << r_code << endl << e << endl;
         TDMA_API_THROW(AuthenticationException, e, r_code);
     }
 
-    return json::parse(r_data);
+    return json::parse(r_data.data(), r_data.data() + r_data.size());
 }
 
 } /* tdma */
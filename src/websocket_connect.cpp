@@ -18,12 +18,28 @@ along with this program.  If not, see http://www.gnu.org/licenses.
 #include <iostream>
 
 #include "../include/websocket_connect.h"
+#include "../include/frame_capture.h"
 
 using std::string;
 using std::vector;
 using std::lock_guard;
 using std::mutex;
 using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+
+namespace {
+
+/* frames are one object keyed by type: {"data":[..]}, {"notify":[..]} etc. */
+bool
+is_data_frame(const string& frame)
+{
+    static const char KEY[] = "\"data\"";
+    size_t i = frame.find_first_not_of(" \t\r\n{");
+    return i != string::npos && frame.compare(i, sizeof(KEY) - 1, KEY) == 0;
+}
+
+} /* namespace */
 
 
 namespace conn{
@@ -32,23 +48,32 @@ void
 D(string msg, WebSocketClient *obj)
 { util::debug_out("WebSocket", msg, obj, std::cout); }
 
-WebSocketClient *WebSocketClient::Callbacks::wsc = nullptr;
-
-WebSocketClient::WebSocketClient(string url)
+WebSocketClient::WebSocketClient( string url,
+                                  size_t high_water_mark,
+                                  OverflowPolicy overflow_policy,
+                                  InQueueStats *stats,
+                                  FrameRecorder *recorder )
     :
         _hub(),
         _url(url),
         _signal(new uS::Async(_hub.getLoop())),
         _thread(),
-        _in_queue(),
-        _out_queue(),
+        _in_queue(high_water_mark),
+        _out_queue(OUT_QUEUE_CAPACITY),
+        _pool(POOL_CAPACITY),
+        _send_mtx(),
+        _evict_mtx(),
+        _stop_flag(false),
+        _high_water_mark(high_water_mark),
+        _overflow_policy(overflow_policy),
+        _stats(stats),
+        _recorder(recorder),
         _init_cond(),
         _init_flag(false),
         _init_mtx(),
         _ws(nullptr),
         _closing_state( CloseType::none )
     {
-        Callbacks::wsc = this;
         _hub.onConnection( Callbacks::on_connect );
         _hub.onDisconnection( Callbacks::on_disconnect );
         _hub.onError( Callbacks::on_error );
@@ -69,6 +94,7 @@ WebSocketClient::~WebSocketClient()
 void
 WebSocketClient::Callbacks::on_connect( uws_client_ty *ws, uWS::HttpRequest r)
 {
+    WebSocketClient *wsc = from(ws);
     D("on_connect", wsc);
 
     assert(wsc);
@@ -87,6 +113,7 @@ WebSocketClient::Callbacks::on_disconnect( uws_client_ty *ws,
                                            char* msg,
                                            size_t msg_len )
 {
+    WebSocketClient *wsc = from(ws);
     D("on_disconnect", wsc);
 
     assert(wsc);
@@ -94,12 +121,18 @@ WebSocketClient::Callbacks::on_disconnect( uws_client_ty *ws,
 
     D("on_disconnect, _signal->close", wsc);
     wsc->_signal->close();
+
+    /* don't leave the listener (or senders) waiting on a connection that's gone */
+    wsc->_in_queue.close();
+    wsc->_out_queue.close();
 }
 
 
 void
 WebSocketClient::Callbacks::on_error(void *v)
 {
+    /* 'v' is the user data passed to connect */
+    WebSocketClient *wsc = reinterpret_cast<WebSocketClient*>(v);
     D("on_error", wsc);
 
     assert(wsc);
@@ -107,6 +140,8 @@ WebSocketClient::Callbacks::on_error(void *v)
 
     D("on_error, _signal->close", wsc);
     wsc->_signal->close();
+    wsc->_in_queue.close();
+    wsc->_out_queue.close();
     {
         lock_guard<mutex> _(wsc->_init_mtx);
         wsc->_init_flag = true;
@@ -121,25 +156,57 @@ WebSocketClient::Callbacks::on_message( uws_client_ty *ws,
                                         size_t msg_len,
                                         uWS::OpCode op )
 {
+    WebSocketClient *wsc = from(ws);
     D("on_message", wsc);
 
     assert(wsc);
-    string msg_s(msg, msg_len);
-    assert( !msg_s.empty() );
+    assert( msg_len );
+
+    if( wsc->_recorder )
+        wsc->_recorder->write(msg, msg_len);
 
+    /* re-use a buffer from the pool if we can (keeps its capacity) */
+    string msg_s;
+    wsc->_pool.try_pop(msg_s);
+    msg_s.assign(msg, msg_len);
+
+#ifdef DEBUG_VERBOSE_1_
     D("message: " + msg_s, wsc);
-    wsc->_in_queue.emplace( msg_s );
+#endif /* DEBUG_VERBOSE_1_ */
+
+    if( wsc->_overflow_policy == OverflowPolicy::drop_oldest
+        && wsc->_in_queue.size() >= wsc->_high_water_mark )
+    {
+        wsc->_evict_oldest();
+    }
+
+    if( wsc->_stats ){
+        /* we're the only writer */
+        unsigned long long depth = wsc->_in_queue.size() + 1;
+        if( depth > wsc->_stats->max_depth.load(std::memory_order_relaxed) )
+            wsc->_stats->max_depth.store(depth, std::memory_order_relaxed);
+    }
+
+    if( wsc->_in_queue.try_push(msg_s) )
+        return;
+
+    /*
+     * blocks (spin-then-park) until the listener catches up; for drop_oldest
+     * only if there's nothing but responses/notifications in the queue
+     */
+    if( wsc->_stats )
+        ++(wsc->_stats->blocked);
+    wsc->_in_queue.push( std::move(msg_s) );
 }
 
 
 void
 WebSocketClient::Callbacks::on_signal(uS::Async *a)
 {
+    auto wsc = reinterpret_cast<WebSocketClient*>(a->getData());
     D("on_signal", wsc);
 
-    auto wsc = reinterpret_cast<WebSocketClient*>(a->getData());
     assert(wsc);
-    assert(wsc == WebSocketClient::Callbacks::wsc);
     assert(wsc->_ws);
 
     if( wsc->_closing_state == CloseType::immediate ){
@@ -148,9 +215,8 @@ WebSocketClient::Callbacks::on_signal(uS::Async *a)
         return;
     }
 
-    while( !wsc->_out_queue.empty() ){
-        string msg = wsc->_out_queue.front();
-        wsc->_out_queue.pop();
+    string msg;
+    while( wsc->_out_queue.try_pop(msg) ){
         D("on_signal, _ws->send: " + msg, wsc);
         wsc->_ws->send(msg.c_str(), msg.size(), uWS::OpCode::TEXT);
     }
@@ -199,6 +265,12 @@ void
 WebSocketClient::close(bool graceful)
 {
     D("close", this);
+    /*
+     * release the socket thread if it's blocked on a full _in_queue, and
+     * senders parked on a full _out_queue (it still drains)
+     */
+    _in_queue.close();
+    _out_queue.close();
     if( is_connected() ){
         _closing_state = graceful ? CloseType::graceful : CloseType::immediate;
         D("close, _signal->send", this);
@@ -216,34 +288,115 @@ WebSocketClient::close(bool graceful)
 void
 WebSocketClient::send(string msg)
 {
-    if( is_connected() ){
-        _out_queue.emplace(msg);
-        D("send, _signal->send: " + msg, this);
+    /*
+     * _out_queue has one producer so pushes happen under _send_mtx; if it's
+     * full park w/o the lock (so other senders and close aren't held up)
+     * until the socket thread drains it or the queue is closed
+     */
+    while( is_connected() ){
+        {
+            std::lock_guard<mutex> _(_send_mtx);
+            if( _out_queue.try_push(msg) ){
+                D("send, _signal->send: " + msg, this);
+                _signal->send();
+                return;
+            }
+        }
+        if( _out_queue.is_closed() )
+            return;
+        /* full, make sure the socket thread is draining */
         _signal->send();
+        _out_queue.wait_writable();
     }
 }
 
 
+void
+WebSocketClient::_evict_oldest()
+{
+    /* only data; control frames (responses, heartbeats) always get through */
+    lock_guard<mutex> _(_evict_mtx);
+    _in_queue.drop_front_if( 1, is_data_frame,
+        [this](string& s){
+            if( _stats )
+                ++(_stats->dropped);
+            _recycle(s);
+        } );
+}
+
+
+size_t
+WebSocketClient::_drain(vector<string>& out, size_t max)
+{
+    auto _ = _evict_lock();
+    return _in_queue.drain(out, max);
+}
+
+
+bool
+WebSocketClient::_pop_or_wait( string& s,
+                               const steady_clock::time_point *deadline )
+{
+    for( ;; ){
+        {
+            auto _ = _evict_lock();
+            if( _in_queue.try_pop(s) )
+                return true;
+        }
+        if( _in_queue.clear_wake() || _in_queue.is_closed()
+            || (deadline && steady_clock::now() >= *deadline) )
+        {
+            return false;
+        }
+        _in_queue.wait_readable(deadline);
+    }
+}
+
+
+size_t
+WebSocketClient::_drain_or_wait( vector<string>& out,
+                                 const steady_clock::time_point *deadline,
+                                 size_t max )
+{
+    size_t n = _drain(out, max);
+    if( n || max == 0 )
+        return n;
+    out.emplace_back();
+    if( !_pop_or_wait(out.back(), deadline) ){
+        out.pop_back();
+        return 0;
+    }
+    return 1 + _drain(out, max - 1);
+}
+
+
 string
 WebSocketClient::recv()
 {
-    auto p = _in_queue.front_safe();
-    return p.second ? p.first : "";
+    auto _ = _evict_lock();
+    string *p = _in_queue.front();
+    return p ? *p : "";
 }
 
 
 string
 WebSocketClient::recv_or_wait()
 {
-    return _in_queue.pop_front_or_wait();
+    string s;
+    if( !_pop_or_wait(s, nullptr) )
+        _stop_flag = false;
+    return s;
 }
 
 
 string
 WebSocketClient::recv_or_wait_for(milliseconds timeout)
 {
-    auto p = _in_queue.pop_front_or_wait_for(timeout);
-    return p.second ? p.first : "";
+    auto deadline = steady_clock::now() + timeout;
+    string s;
+    if( !_pop_or_wait(s, &deadline) )
+        _stop_flag = false;
+    return s;
 }
 
 
@@ -251,12 +404,8 @@ vector<string>
 WebSocketClient::recv_all()
 {
     vector<string> ret;
-
-    auto p = _in_queue.pop_front_safe();
-    while( p.second ){
-        ret.emplace_back( p.first );
-        p = _in_queue.pop_front_safe();
-    }
+    _drain(ret);
+    _append_stop_message(ret);
     return ret;
 }
 
@@ -265,30 +414,57 @@ WebSocketClient::recv_all()
  *      do (e.g. a bunch of data comes in between recv_all and recv_n_or_wait,
  *      there may be more than n - all_n entries in the queue)
  *      but this is good enough for now
- *
- * also, we don't account for elapsed time in the initial part of the call
  */
 vector<string>
 WebSocketClient::recv_atleast_n_or_wait(size_t n)
 {
-    vector<string> all = recv_all();
-    size_t all_n = all.size();
-    if( all_n >= n )
-        return all;
-
-    return recv_n_or_wait(n - all_n);
+    vector<string> ret;
+    while( ret.size() < n ){
+        ret.emplace_back();
+        if( !_pop_or_wait(ret.back(), nullptr) ){
+            ret.pop_back();
+            break;
+        }
+        _drain(ret);
+    }
+    _append_stop_message(ret);
+    return ret;
 }
 
 
 vector<string>
 WebSocketClient::recv_atleast_n_or_wait_for(size_t n, milliseconds timeout)
 {
-    vector<string> all = recv_all();
-    size_t all_n = all.size();
-    if( all_n >= n )
-        return all;
+    vector<string> ret;
+    recv_atleast_n_or_wait_for(n, timeout, ret);
+    return ret;
+}
+
+
+size_t
+WebSocketClient::recv_atleast_n_or_wait_for( size_t n,
+                                             milliseconds timeout,
+                                             vector<string>& frames )
+{
+    size_t nbeg = frames.size();
+    auto deadline = steady_clock::now() + timeout;
+
+    while( frames.size() - nbeg < n ){
+        if( !_drain_or_wait(frames, &deadline) )
+            break;
+    }
+    _append_stop_message(frames);
+    return frames.size() - nbeg;
+}
 
-    return recv_n_or_wait_for(n - all_n, timeout);
+
+void
+WebSocketClient::recycle(vector<string>& frames)
+{
+    auto _ = _evict_lock();
+    for( string& f : frames )
+        _recycle(f);
+    frames.clear();
 }
 
 
@@ -296,12 +472,9 @@ vector<string>
 WebSocketClient::recv_atmost_n(size_t n)
 {
     vector<string> ret;
-    while( ret.size() < n ){
-        auto p = _in_queue.pop_front_safe();
-        if( !p.second )
-            break;
-        ret.emplace_back(p.first);
-    }
+    _drain(ret, n);
+    if( ret.size() < n )
+        _append_stop_message(ret);
     return ret;
 }
 
@@ -311,9 +484,14 @@ WebSocketClient::recv_n_or_wait(size_t n)
 {
     vector<string> ret;
     while( ret.size() < n ){
-        auto p = _in_queue.pop_front_or_wait();
-        ret.emplace_back(p);
+        ret.emplace_back();
+        if( !_pop_or_wait(ret.back(), nullptr) ){
+            ret.pop_back();
+            break;
+        }
     }
+    if( ret.size() < n )
+        _append_stop_message(ret);
     return ret;
 }
 
@@ -321,21 +499,15 @@ WebSocketClient::recv_n_or_wait(size_t n)
 vector<string>
 WebSocketClient::recv_n_or_wait_for(size_t n, milliseconds timeout)
 {
-    using namespace std::chrono;
-
     vector<string> ret;
-    auto t_beg = steady_clock::now();
-    auto t_left = timeout;
+    auto deadline = steady_clock::now() + timeout;
 
-    while( ret.size() < n && t_left.count() >= 0 ){
-        auto p = _in_queue.pop_front_or_wait_for(t_left);
-        if( !p.second )
+    while( ret.size() < n ){
+        if( !_drain_or_wait(ret, &deadline, n - ret.size()) )
             break;
-        ret.emplace_back(p.first);
-        auto t_elapsed =
-            duration_cast<milliseconds>(steady_clock::now() - t_beg);
-        t_left = timeout - t_elapsed;
     }
+    if( ret.size() < n )
+        _append_stop_message(ret);
     return ret;
 }
 
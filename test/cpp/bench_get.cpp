@@ -0,0 +1,286 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+/*
+ * drives every APIGetter (and order send/cancel) against MockServer;
+ * no credentials or network needed
+ *
+ *   bench_get [iterations] [latency msec] [error every nth] [port]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <cstdlib>
+
+#include "tdma_api_get.h"
+#include "tdma_api_execute.h"
+#include "tdma_api_streaming.h"
+
+#include "mock_server.h"
+
+using namespace tdma;
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+struct Result{
+    string name;
+    vector<double> usec;
+    size_t errors;
+};
+
+double
+percentile(const vector<double>& sorted, double p)
+{
+    if( sorted.empty() )
+        return 0;
+    size_t i = static_cast<size_t>(p * (sorted.size() - 1) + .5);
+    return sorted[i];
+}
+
+Result
+run(const string& name, size_t n, function<void()> f)
+{
+    Result r{name, {}, 0};
+    r.usec.reserve(n);
+    for( size_t i = 0; i < n; ++i ){
+        auto tbeg = steady_clock::now();
+        try{
+            f();
+        }catch( APIException& ){
+            ++r.errors;
+        }
+        auto tend = steady_clock::now();
+        r.usec.push_back( duration_cast<nanoseconds>(tend - tbeg).count()
+                          / 1000.0 );
+    }
+    return r;
+}
+
+void
+report(const Result& r)
+{
+    vector<double> v(r.usec);
+    std::sort(v.begin(), v.end());
+    double sum = 0;
+    for( double d : v )
+        sum += d;
+
+    cout<< left << setw(38) << r.name << right << fixed << setprecision(1)
+        << setw(8) << v.size()
+        << setw(8) << r.errors
+        << setw(12) << (v.empty() ? 0 : sum / v.size())
+        << setw(12) << percentile(v, .5)
+        << setw(12) << percentile(v, .99)
+        << setw(12) << (v.empty() ? 0 : v.back()) << endl;
+}
+
+atomic<size_t> stream_data_count(0);
+
+void
+stream_callback(int cb_type, int ss_type, unsigned long long ts,
+                const char* msg)
+{
+    if( static_cast<StreamingCallbackType>(cb_type)
+        == StreamingCallbackType::data )
+    {
+        ++stream_data_count;
+    }
+}
+
+} /* namespace */
+
+
+int
+main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100;
+    int latency = argc > 2 ? atoi(argv[2]) : 0;
+    unsigned int error_nth = argc > 3 ? strtoul(argv[3], nullptr, 10) : 0;
+    int port = argc > 4 ? atoi(argv[4]) : MockServer::DEF_PORT;
+
+    MockServer server(port);
+    if( !server.is_listening() )
+        return 1;
+
+    server.set_latency( milliseconds(latency) );
+    server.set_error_injection(error_nth, 500);
+
+    SetBaseURLOverride( server.base_url() );
+    SetStreamerURLOverride( server.streamer_url() );
+    APIGetter::set_wait_msec( milliseconds(0) );
+
+    long long expires = duration_cast<seconds>(
+        system_clock::now().time_since_epoch() ).count() + 3600;
+    Credentials c("mockaccesstoken", "mockrefreshtoken", expires,
+                  "MOCKCLIENT@AMER.OAUTHAP");
+    const string id = MockServer::ACCOUNT_ID;
+
+    auto now_msec = duration_cast<milliseconds>(
+        system_clock::now().time_since_epoch() ).count();
+
+    QuoteGetter quote(c, "SPY");
+    QuotesGetter quotes(c, {"SPY", "QQQ", "IWM", "DIA"});
+    MarketHoursGetter hours(c, MarketType::equity, "2019-01-22");
+    MoversGetter movers(c, MoversIndex::compx, MoversDirectionType::up,
+                        MoversChangeType::value);
+    HistoricalPeriodGetter period(c, "SPY", PeriodType::day, 1,
+                                  FrequencyType::minute, 1, true);
+    HistoricalRangeGetter range(c, "SPY", FrequencyType::minute, 1,
+                                now_msec - 86400000, now_msec, true);
+    OptionChainGetter chain(c, "SPY", OptionStrikes::N_ATM(10));
+    OptionChainStrategyGetter strategy(c, "SPY", OptionStrategy::Vertical(),
+                                       OptionStrikes::N_ATM(10));
+    OptionChainAnalyticalGetter analytical(c, "SPY", 30.0, 100.0, 2.5, 30,
+                                           OptionStrikes::N_ATM(10));
+    AccountInfoGetter account(c, id, true, true);
+    PreferencesGetter preferences(c, id);
+    StreamerSubscriptionKeysGetter keys(c, id);
+    TransactionHistoryGetter transactions(c, id, TransactionType::all);
+    IndividualTransactionHistoryGetter transaction(c, id, "10000");
+    UserPrincipalsGetter principals(c, true, true, true, true);
+    InstrumentInfoGetter instrument(c, InstrumentSearchType::symbol_exact,
+                                    "SPY");
+    OrderGetter order(c, id, "1");
+    OrdersGetter orders(c, id, 10, "2019-01-01", "2019-01-31");
+
+    vector<pair<string, APIGetter*>> getters = {
+        {"QuoteGetter", &quote},
+        {"QuotesGetter", &quotes},
+        {"MarketHoursGetter", &hours},
+        {"MoversGetter", &movers},
+        {"HistoricalPeriodGetter", &period},
+        {"HistoricalRangeGetter", &range},
+        {"OptionChainGetter", &chain},
+        {"OptionChainStrategyGetter", &strategy},
+        {"OptionChainAnalyticalGetter", &analytical},
+        {"AccountInfoGetter", &account},
+        {"PreferencesGetter", &preferences},
+        {"StreamerSubscriptionKeysGetter", &keys},
+        {"TransactionHistoryGetter", &transactions},
+        {"IndividualTransactionHistoryGetter", &transaction},
+        {"UserPrincipalsGetter", &principals},
+        {"InstrumentInfoGetter", &instrument},
+        {"OrderGetter", &order},
+        {"OrdersGetter", &orders}
+    };
+
+    cout<< "mock server: " << server.base_url() << " latency(msec): "
+        << latency << " error every: " << error_nth << endl << endl
+        << left << setw(38) << "(usec)" << right
+        << setw(8) << "n" << setw(8) << "errors" << setw(12) << "mean"
+        << setw(12) << "p50" << setw(12) << "p99" << setw(12) << "max"
+        << endl;
+
+    for( auto& g : getters ){
+        APIGetter *p = g.second;
+        report( run(g.first, n, [p]{ p->get(); }) );
+    }
+
+    OrderTicket ticket =
+        SimpleOrderBuilder::Equity::Build("SPY", 1, true, true, 100.00);
+    report( run("Execute_SendOrder", n,
+        [&]{
+            if( Execute_SendOrder(c, id, ticket).empty() )
+                throw APIException("no order id");
+        } ) );
+    report( run("Execute_CancelOrder", n,
+        [&]{ Execute_CancelOrder(c, id, "1001"); } ) );
+
+    report( run("Execute_ReplaceOrder", n,
+        [&]{ Execute_ReplaceOrder(c, id, "1001", ticket); } ) );
+
+    vector<OrderTicket> batch(4, ticket);
+    report( run("Execute_SendOrders(x4)", n,
+        [&]{
+            for( auto& r : Execute_SendOrders(c, id, batch) ){
+                if( r.error )
+                    throw APIException("batch order failed");
+            }
+        } ) );
+
+    try{
+        ExecutionSession session(c, id);
+        report( run("ExecutionSession::send_order", n,
+            [&]{
+                if( session.send_order(ticket).empty() )
+                    throw APIException("no order id");
+            } ) );
+        report( run("ExecutionSession::cancel_order", n,
+            [&]{ session.cancel_order("1001"); } ) );
+        report( run("ExecutionSession::replace_order", n,
+            [&]{ session.replace_order("1001", ticket); } ) );
+
+        OrderTemplate tmpl(ticket);
+        double px = 100.00;
+        report( run("ExecutionSession::send_order(template)", n,
+            [&]{
+                tmpl.set_price(px += .01);
+                if( session.send_order(tmpl).empty() )
+                    throw APIException("no order id");
+            } ) );
+    }catch( APIException& e ){
+        /* e.g an injected error on the session's first request */
+        cout<< "ExecutionSession failed: " << e.what() << endl;
+    }
+
+    try{
+        /* vs. the OrderGetter/OrdersGetter round trips above */
+        auto ss = StreamingSession::Create(c, stream_callback);
+        ss->start_order_cache_sync(c, id, milliseconds(0));
+        report( run("StreamingSession::get_order_state", n,
+            [&]{
+                OrderState_C state;
+                if( !ss->get_order_state("1", state) )
+                    throw APIException("order not cached");
+            } ) );
+        report( run("StreamingSession::get_open_orders", n,
+            [&]{
+                if( ss->get_open_orders("SPY").empty() )
+                    throw APIException("no open orders");
+            } ) );
+    }catch( APIException& e ){
+        /* session setup and the first sync make (injectable) requests */
+        cout<< "order cache failed: " << e.what() << endl;
+    }
+
+    /* login + first subscription round trip */
+    report( run("StreamingSession start/stop", std::min<size_t>(n, 10),
+        [&]{
+            auto ss = StreamingSession::Create(c, stream_callback);
+            ss->start( QuotesSubscription({"SPY", "QQQ"},
+                {QuotesSubscription::FieldType::bid_price,
+                 QuotesSubscription::FieldType::ask_price}) );
+            ss->stop();
+        } ) );
+
+    cout<< endl << "requests: " << server.get_nrequests()
+        << " injected errors: " << server.get_nerrors_injected()
+        << " streaming requests: " << server.get_nstreaming_requests()
+        << " streaming data callbacks: " << stream_data_count << endl;
+
+    SetStreamerURLOverride("");
+    SetBaseURLOverride("");
+    return 0;
+}
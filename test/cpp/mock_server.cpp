@@ -0,0 +1,943 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <map>
+#include <memory>
+
+#include "../../uWebSockets/uWS.h"
+#include "json.hpp"
+
+#include "mock_server.h"
+
+using std::string;
+using std::vector;
+using std::lock_guard;
+using std::mutex;
+using nlohmann::json;
+
+namespace {
+
+const unsigned long long MOCK_EPOCH_MSEC = 1548000000000ULL;
+const double MOCK_PRICE = 100.0;
+const size_t MOCK_NCANDLES = 390;
+const size_t MOCK_NSTRIKES = 20;
+
+/* user data of a muted streaming connection */
+char MUTED;
+
+bool
+is_muted(uWS::WebSocket<uWS::SERVER> *ws)
+{ return ws->getUserData() == &MUTED; }
+
+unsigned long long
+now_msec()
+{
+    using namespace std::chrono;
+    return static_cast<unsigned long long>(
+        duration_cast<milliseconds>(system_clock::now().time_since_epoch())
+            .count() );
+}
+
+const char*
+status_text(int status)
+{
+    switch( status ){
+    case 200: return "OK";
+    case 201: return "Created";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "Status";
+    }
+}
+
+string
+method_str(uWS::HttpMethod m)
+{
+    switch( m ){
+    case uWS::METHOD_GET: return "GET";
+    case uWS::METHOD_POST: return "POST";
+    case uWS::METHOD_PUT: return "PUT";
+    case uWS::METHOD_DELETE: return "DELETE";
+    case uWS::METHOD_PATCH: return "PATCH";
+    default: return "";
+    }
+}
+
+string
+query_param(const string& query, const string& name)
+{
+    std::stringstream ss(query);
+    string kv;
+    while( std::getline(ss, kv, '&') ){
+        size_t i = kv.find('=');
+        if( i != string::npos && kv.substr(0, i) == name )
+            return kv.substr(i + 1);
+    }
+    return "";
+}
+
+vector<string>
+split_list(string s)
+{
+    /* symbols come url-encoded */
+    size_t i;
+    while( (i = s.find("%2C")) != string::npos )
+        s.replace(i, 3, ",");
+
+    vector<string> v;
+    std::stringstream ss(s);
+    string e;
+    while( std::getline(ss, e, ',') ){
+        if( !e.empty() )
+            v.push_back(e);
+    }
+    return v;
+}
+
+json
+quote_json(const string& symbol)
+{
+    return {
+        {"assetType", "EQUITY"},
+        {"symbol", symbol},
+        {"description", symbol + " MOCK"},
+        {"bidPrice", MOCK_PRICE - .01},
+        {"bidSize", 100},
+        {"askPrice", MOCK_PRICE + .01},
+        {"askSize", 200},
+        {"lastPrice", MOCK_PRICE},
+        {"lastSize", 100},
+        {"openPrice", MOCK_PRICE - 1},
+        {"highPrice", MOCK_PRICE + 1},
+        {"lowPrice", MOCK_PRICE - 2},
+        {"closePrice", MOCK_PRICE - .5},
+        {"netChange", .5},
+        {"totalVolume", 1000000},
+        {"quoteTimeInLong", MOCK_EPOCH_MSEC},
+        {"tradeTimeInLong", MOCK_EPOCH_MSEC},
+        {"mark", MOCK_PRICE},
+        {"exchange", "p"},
+        {"exchangeName", "PACIFIC"},
+        {"volatility", .2},
+        {"52WkHigh", MOCK_PRICE + 20},
+        {"52WkLow", MOCK_PRICE - 20},
+        {"delayed", false}
+    };
+}
+
+string
+candles_body(const string& symbol)
+{
+    json candles = json::array();
+    for( size_t i = 0; i < MOCK_NCANDLES; ++i ){
+        double o = MOCK_PRICE + (i % 10) * .1;
+        candles.push_back( {
+            {"open", o},
+            {"high", o + .25},
+            {"low", o - .25},
+            {"close", o + .05},
+            {"volume", 1000 + i},
+            {"datetime", MOCK_EPOCH_MSEC + i * 60000}
+        } );
+    }
+    return json{ {"candles", candles}, {"symbol", symbol},
+                 {"empty", false} }.dump();
+}
+
+json
+contract_json(const string& symbol, bool is_put, double strike)
+{
+    std::stringstream ss;
+    ss << symbol << "_011819" << (is_put ? 'P' : 'C') << strike;
+    double intrinsic = is_put ? strike - MOCK_PRICE : MOCK_PRICE - strike;
+    double mark = (intrinsic > 0 ? intrinsic : 0) + 1.0;
+    return {
+        {"putCall", is_put ? "PUT" : "CALL"},
+        {"symbol", ss.str()},
+        {"description", ss.str() + " MOCK"},
+        {"exchangeName", "OPR"},
+        {"bid", mark - .05},
+        {"ask", mark + .05},
+        {"last", mark},
+        {"mark", mark},
+        {"bidSize", 10},
+        {"askSize", 10},
+        {"lastSize", 1},
+        {"highPrice", mark + .5},
+        {"lowPrice", mark - .5},
+        {"openPrice", mark},
+        {"closePrice", mark},
+        {"totalVolume", 500},
+        {"quoteTimeInLong", MOCK_EPOCH_MSEC},
+        {"tradeTimeInLong", MOCK_EPOCH_MSEC},
+        {"netChange", 0.0},
+        {"volatility", 20.0},
+        {"delta", is_put ? -.5 : .5},
+        {"gamma", .05},
+        {"theta", -.02},
+        {"vega", .1},
+        {"rho", .01},
+        {"openInterest", 1000},
+        {"timeValue", 1.0},
+        {"theoreticalOptionValue", mark},
+        {"theoreticalVolatility", 29.0},
+        {"strikePrice", strike},
+        {"expirationDate", MOCK_EPOCH_MSEC + 86400000ULL * 30},
+        {"daysToExpiration", 30},
+        {"expirationType", "R"},
+        {"lastTradingDay", MOCK_EPOCH_MSEC + 86400000ULL * 30},
+        {"multiplier", 100.0},
+        {"inTheMoney", intrinsic > 0},
+        {"nonStandard", false},
+        {"mini", false}
+    };
+}
+
+/* SINGLE/ANALYTICAL get the contract maps, other strategies a leg list */
+string
+option_chain_body(const string& symbol, const string& strategy)
+{
+    if( !strategy.empty() && strategy != "SINGLE" && strategy != "ANALYTICAL" ){
+        json leg = {
+            {"symbol", symbol + "_011819C100"},
+            {"putCallInd", "C"},
+            {"description", symbol + " Jan 18 2019 Call"},
+            {"bid", 1.0},
+            {"ask", 1.1},
+            {"range", "ITM"},
+            {"strikePrice", MOCK_PRICE},
+            {"totalVolume", 100}
+        };
+        return json{
+            {"symbol", symbol},
+            {"status", "SUCCESS"},
+            {"strategy", strategy},
+            {"isDelayed", false},
+            {"underlyingPrice", MOCK_PRICE},
+            {"monthlyStrategyList", json::array({ {
+                {"month", "Jan"},
+                {"year", 2019},
+                {"day", 18},
+                {"daysToExp", 30},
+                {"optionStrategyList", json::array({ {
+                    {"primaryLeg", leg},
+                    {"secondaryLeg", leg},
+                    {"strategyStrike", "100.0"},
+                    {"strategyBid", 0.5},
+                    {"strategyAsk", 0.6}
+                } })}
+            } })},
+            {"callExpDateMap", json::object()},
+            {"putExpDateMap", json::object()}
+        }.dump();
+    }
+
+    json calls, puts;
+    json call_strikes, put_strikes;
+    for( size_t i = 0; i < MOCK_NSTRIKES; ++i ){
+        double strike = MOCK_PRICE - MOCK_NSTRIKES / 2 + i;
+        string k = std::to_string(strike);
+        call_strikes[k] = json::array({ contract_json(symbol, false, strike) });
+        put_strikes[k] = json::array({ contract_json(symbol, true, strike) });
+    }
+    calls["2019-01-18:30"] = call_strikes;
+    puts["2019-01-18:30"] = put_strikes;
+    return json{
+        {"symbol", symbol},
+        {"status", "SUCCESS"},
+        {"strategy", strategy.empty() ? "SINGLE" : strategy},
+        {"isDelayed", false},
+        {"underlyingPrice", MOCK_PRICE},
+        {"interestRate", 2.5},
+        {"volatility", 29.0},
+        {"numberOfContracts", MOCK_NSTRIKES * 2},
+        {"callExpDateMap", calls},
+        {"putExpDateMap", puts}
+    }.dump();
+}
+
+json
+order_json(const string& account_id, const string& order_id)
+{
+    return {
+        {"session", "NORMAL"},
+        {"duration", "DAY"},
+        {"orderType", "LIMIT"},
+        {"price", MOCK_PRICE},
+        {"quantity", 1.0},
+        {"filledQuantity", 0.0},
+        {"remainingQuantity", 1.0},
+        {"orderStrategyType", "SINGLE"},
+        {"orderId", std::stoll(order_id)},
+        {"cancelable", true},
+        {"editable", true},
+        {"status", "WORKING"},
+        {"enteredTime", "2019-01-20T16:00:00+0000"},
+        {"accountId", std::stoll(account_id)},
+        {"orderLegCollection", json::array({ {
+            {"orderLegType", "EQUITY"},
+            {"legId", 1},
+            {"instrument", {{"assetType", "EQUITY"}, {"symbol", "SPY"}}},
+            {"instruction", "BUY"},
+            {"positionEffect", "OPENING"},
+            {"quantity", 1.0}
+        } })}
+    };
+}
+
+json
+account_json(const string& account_id)
+{
+    return {
+        {"securitiesAccount", {
+            {"type", "MARGIN"},
+            {"accountId", account_id},
+            {"roundTrips", 0},
+            {"isDayTrader", false},
+            {"isClosingOnlyRestricted", false},
+            {"currentBalances", {
+                {"cashBalance", 10000.0},
+                {"liquidationValue", 10000.0},
+                {"buyingPower", 20000.0}
+            }}
+        }}
+    };
+}
+
+json
+transaction_json(unsigned long long id)
+{
+    return {
+        {"type", "TRADE"},
+        {"subAccount", "1"},
+        {"transactionDate", "2019-01-20T16:00:00+0000"},
+        {"netAmount", -MOCK_PRICE},
+        {"transactionId", id},
+        {"transactionItem", {
+            {"amount", 1.0},
+            {"price", MOCK_PRICE},
+            {"instruction", "BUY"},
+            {"instrument", {{"symbol", "SPY"}, {"assetType", "EQUITY"}}}
+        }}
+    };
+}
+
+json
+user_principals_json(const string& account_id)
+{
+    return {
+        {"userId", "mockuser"},
+        {"primaryAccountId", account_id},
+        {"accounts", json::array({ {
+            {"accountId", account_id},
+            {"description", "MOCK"},
+            {"displayName", "mock"},
+            {"accountCdDomainId", "A000000000000000"},
+            {"company", "AMER"},
+            {"segment", "AMER"},
+            {"acl", "AKBPCHDRDTESFMGLMKMOPNQSRFSDTETFTOTRTTWSXX"},
+            {"authorizations", {{"apex", false}, {"streamingNews", false}}}
+        } })},
+        {"streamerInfo", {
+            {"streamerBinaryUrl", "127.0.0.1"},
+            {"streamerSocketUrl", "127.0.0.1"},
+            {"token", "mocktoken"},
+            {"tokenTimestamp", "2019-01-20T16:00:00+0000"},
+            {"userGroup", "ACCT"},
+            {"accessLevel", "ACCT"},
+            {"acl", "AKBPCHDRDTESFMGLMKMOPNQSRFSDTETFTOTRTTWSXX"},
+            {"appId", "mockapp"}
+        }},
+        {"streamerSubscriptionKeys", {
+            {"keys", json::array({ {{"key", "mocksubscriptionkey"}} })}
+        }}
+    };
+}
+
+} /* namespace */
+
+
+const std::string MockServer::ACCOUNT_ID("123456789");
+
+
+MockServer::MockServer(int port)
+    :
+        _port(port),
+        _hub(nullptr),
+        _signal(nullptr),
+        _heartbeat(nullptr),
+        _thread(),
+        _listening(false),
+        _init_mtx(),
+        _init_cond(),
+        _init_flag(false),
+        _routes_mtx(),
+        _routes(),
+        _latency_msec(0),
+        _error_nth(0),
+        _error_status(500),
+        _nrequests(0),
+        _nerrors(0),
+        _nstreaming(0),
+        _nconnections(0),
+        _next_order_id(1000),
+        _pending(),
+        _signal_mtx(),
+        _ws_out(),
+        _ws_drop(false),
+        _ws_mute(false),
+        _stop(false)
+    {
+        _add_default_routes();
+        _thread = std::thread( &MockServer::_run, this );
+
+        std::unique_lock<mutex> lock(_init_mtx);
+        _init_cond.wait( lock, [this]{ return _init_flag; } );
+    }
+
+
+MockServer::~MockServer()
+{
+    {
+        lock_guard<mutex> _(_signal_mtx);
+        _stop = true;
+    }
+    if( _signal )
+        _signal->send();
+    if( _thread.joinable() )
+        _thread.join();
+}
+
+
+void
+MockServer::send_streaming(const string& frame)
+{
+    {
+        lock_guard<mutex> _(_signal_mtx);
+        _ws_out.push_back(frame);
+    }
+    if( _signal )
+        _signal->send();
+}
+
+
+void
+MockServer::drop_streaming_connections()
+{
+    {
+        lock_guard<mutex> _(_signal_mtx);
+        _ws_drop = true;
+    }
+    if( _signal )
+        _signal->send();
+}
+
+
+void
+MockServer::mute_streaming_connections()
+{
+    {
+        lock_guard<mutex> _(_signal_mtx);
+        _ws_mute = true;
+    }
+    if( _signal )
+        _signal->send();
+}
+
+
+void
+MockServer::_on_signal()
+{
+    vector<string> out;
+    bool drop, mute, stop;
+    {
+        lock_guard<mutex> _(_signal_mtx);
+        out.swap(_ws_out);
+        drop = _ws_drop;
+        mute = _ws_mute;
+        stop = _stop;
+        _ws_drop = _ws_mute = false;
+    }
+
+    auto& group = _hub->getDefaultGroup<uWS::SERVER>();
+    if( stop ){
+        group.terminate();
+        for( Pending *p : _pending ){
+            p->timer->stop();
+            p->timer->close();
+            delete p;
+        }
+        _pending.clear();
+        _heartbeat->stop();
+        _heartbeat->close();
+        _signal->close();
+        return;
+    }
+
+    group.forEach(
+        [&](uWS::WebSocket<uWS::SERVER> *ws){
+            if( is_muted(ws) )
+                return;
+            for( auto& f : out )
+                ws->send(f.c_str(), f.size(), uWS::OpCode::TEXT);
+            if( mute )
+                ws->setUserData(&MUTED);
+        } );
+    if( drop ){
+        group.forEach(
+            [](uWS::WebSocket<uWS::SERVER> *ws){ ws->terminate(); } );
+    }
+}
+
+
+void
+MockServer::set_handler( const string& method,
+                         const string& pattern,
+                         handler_ty handler )
+{
+    lock_guard<mutex> _(_routes_mtx);
+    _routes.insert( _routes.begin(),
+                    Route{method, std::regex(pattern), handler} );
+}
+
+
+void
+MockServer::set_response( const string& method,
+                          const string& pattern,
+                          int status,
+                          const string& body )
+{
+    set_handler( method, pattern,
+        [status, body](const Request&, Response& r){
+            r.status = status;
+            r.body = body;
+        } );
+}
+
+
+void
+MockServer::_add_default_routes()
+{
+    /* added in reverse order of precedence */
+    set_response("", ".*", 404, "{\"error\":\"mock: no route\"}");
+
+    set_handler("GET", "^/v1/marketdata/([^/]+)/quotes$",
+        [](const Request& req, Response& r){
+            r.body = json{ {req.match[1].str(), quote_json(req.match[1])} }
+                     .dump();
+        } );
+
+    set_handler("GET", "^/v1/marketdata//?quotes$",
+        [](const Request& req, Response& r){
+            json j = json::object();
+            for( auto& s : split_list( query_param(req.query, "symbol") ) )
+                j[s] = quote_json(s);
+            r.body = j.dump();
+        } );
+
+    /* the big ones are built once so they don't skew timings */
+    auto candles = std::make_shared<std::map<string, string>>();
+    set_handler("GET", "^/v1/marketdata/([^/]+)/pricehistory$",
+        [candles](const Request& req, Response& r){
+            string& b = (*candles)[req.match[1]];
+            if( b.empty() )
+                b = candles_body(req.match[1]);
+            r.body = b;
+        } );
+
+    auto chains = std::make_shared<std::map<string, string>>();
+    set_handler("GET", "^/v1/marketdata/chains$",
+        [chains](const Request& req, Response& r){
+            string symbol = query_param(req.query, "symbol");
+            string strategy = query_param(req.query, "strategy");
+            string& b = (*chains)[symbol + ':' + strategy];
+            if( b.empty() )
+                b = option_chain_body(symbol, strategy);
+            r.body = b;
+        } );
+
+    set_handler("GET", "^/v1/marketdata/([^/]+)/hours$",
+        [](const Request& req, Response& r){
+            string m = req.match[1];
+            r.body = json{ {m, { {m, {
+                {"date", query_param(req.query, "date")},
+                {"marketType", m},
+                {"product", m},
+                {"isOpen", true},
+                {"sessionHours", {
+                    {"regularMarket", json::array({ {
+                        {"start", "2019-01-22T09:30:00-05:00"},
+                        {"end", "2019-01-22T16:00:00-05:00"}
+                    } })}
+                }}
+            } } } } }.dump();
+        } );
+
+    set_handler("GET", "^/v1/marketdata/([^/]+)/movers$",
+        [](const Request&, Response& r){
+            json j = json::array();
+            for( int i = 0; i < 10; ++i ){
+                j.push_back( {
+                    {"change", 1.0 - i * .05},
+                    {"description", "MOCK " + std::to_string(i)},
+                    {"direction", "up"},
+                    {"last", MOCK_PRICE},
+                    {"symbol", "MCK" + std::to_string(i)},
+                    {"totalVolume", 100000}
+                } );
+            }
+            r.body = j.dump();
+        } );
+
+    set_handler("GET", "^/v1/instruments(/.*)?$",
+        [](const Request&, Response& r){
+            r.body = json{ {"SPY", {
+                {"cusip", "78462F103"},
+                {"symbol", "SPY"},
+                {"description", "SPDR S&P 500"},
+                {"exchange", "Pacific"},
+                {"assetType", "ETF"}
+            } } }.dump();
+        } );
+
+    set_handler("GET", "^/v1/userprincipals$",
+        [](const Request&, Response& r){
+            r.body = user_principals_json(ACCOUNT_ID).dump();
+        } );
+
+    set_handler("GET", "^/v1/userprincipals/streamersubscriptionkeys$",
+        [](const Request&, Response& r){
+            r.body = json{ {"keys", json::array({
+                {{"key", "mocksubscriptionkey"}}
+            })} }.dump();
+        } );
+
+    set_handler("GET", "^/v1/accounts/([^/]+)$",
+        [](const Request& req, Response& r){
+            r.body = account_json(req.match[1]).dump();
+        } );
+
+    set_handler("GET", "^/v1/accounts/([^/]+)/preferences$",
+        [](const Request&, Response& r){
+            r.body = json{
+                {"expressTrading", false},
+                {"defaultEquityOrderLegInstruction", "NONE"},
+                {"defaultEquityOrderType", "LIMIT"},
+                {"defaultEquityOrderDuration", "DAY"},
+                {"defaultEquityOrderMarketSession", "NORMAL"},
+                {"defaultEquityQuantity", 0},
+                {"authTokenTimeout", "EIGHT_HOURS"}
+            }.dump();
+        } );
+
+    set_handler("GET", "^/v1/accounts/([^/]+)/transactions$",
+        [](const Request&, Response& r){
+            json j = json::array();
+            for( unsigned long long i = 0; i < 10; ++i )
+                j.push_back( transaction_json(10000 + i) );
+            r.body = j.dump();
+        } );
+
+    set_handler("GET", "^/v1/accounts/([^/]+)/transactions/([0-9]+)$",
+        [](const Request& req, Response& r){
+            r.body = transaction_json( std::stoull(req.match[2]) ).dump();
+        } );
+
+    set_handler("GET", "^/v1/accounts/([0-9]+)/orders$",
+        [](const Request& req, Response& r){
+            json j = json::array();
+            for( int i = 0; i < 10; ++i )
+                j.push_back( order_json(req.match[1], std::to_string(1 + i)) );
+            r.body = j.dump();
+        } );
+
+    set_handler("GET", "^/v1/accounts/([0-9]+)/orders/([0-9]+)$",
+        [](const Request& req, Response& r){
+            r.body = order_json(req.match[1], req.match[2]).dump();
+        } );
+
+    /* the library only accepts an order ID from this host */
+    handler_ty created = [this](const Request& req, Response& r){
+        r.status = 201;
+        r.headers = "Location: https://api.tdameritrade.com/v1/accounts/"
+                  + req.match[1].str() + "/orders/"
+                  + std::to_string(++_next_order_id) + "\r\n";
+    };
+    set_handler("POST", "^/v1/accounts/([0-9]+)/orders$", created);
+    set_handler("PUT", "^/v1/accounts/([0-9]+)/orders/([0-9]+)$", created);
+
+    set_response("DELETE", "^/v1/accounts/([0-9]+)/orders/([0-9]+)$", 200, "");
+
+    set_handler("POST", "^/v1/oauth2/token$",
+        [](const Request&, Response& r){
+            r.body = json{
+                {"access_token", "mockaccesstoken"},
+                {"refresh_token", "mockrefreshtoken"},
+                {"token_type", "Bearer"},
+                {"expires_in", 1800},
+                {"refresh_token_expires_in", 7776000}
+            }.dump();
+        } );
+}
+
+
+MockServer::Response
+MockServer::_route(const string& method, const string& url)
+{
+    Response r{200, "", ""};
+
+    unsigned long long n = ++_nrequests;
+    unsigned int nth = _error_nth;
+    if( nth && n % nth == 0 ){
+        ++_nerrors;
+        r.status = _error_status;
+        r.body = "{\"error\":\"mock: injected error\"}";
+        return r;
+    }
+
+    Request req;
+    req.method = method;
+    size_t q = url.find('?');
+    req.path = url.substr(0, q);
+    req.query = (q == string::npos) ? "" : url.substr(q + 1);
+
+    lock_guard<mutex> _(_routes_mtx);
+    for( auto& route : _routes ){
+        if( !route.method.empty() && route.method != method )
+            continue;
+        if( std::regex_search(req.path, req.match, route.rx) ){
+            try{
+                route.handler(req, r);
+            }catch( std::exception& e ){
+                r.status = 500;
+                r.body = json{ {"error", e.what()} }.dump();
+            }
+            break;
+        }
+    }
+    return r;
+}
+
+
+void
+MockServer::_dispatch(Pending *p)
+{
+    int latency = _latency_msec;
+    if( latency <= 0 ){
+        _finish(p);
+        return;
+    }
+
+    p->timer = new uS::Timer( _hub->getLoop() );
+    p->timer->setData(p);
+    _pending.insert(p);
+    p->timer->start(
+        [](uS::Timer *t){
+            Pending *p = static_cast<Pending*>( t->getData() );
+            p->server->_pending.erase(p);
+            t->stop();
+            t->close();
+            p->timer = nullptr;
+            _finish(p);
+        }, latency, 0 );
+}
+
+
+void
+MockServer::_finish(Pending *p)
+{
+    if( p->res ){
+        p->res->userData = nullptr;
+        p->res->write( p->head.c_str(), p->head.size() );
+        p->res->end( p->body.c_str(), p->body.size() );
+    }
+    delete p;
+}
+
+
+vector<string>
+MockServer::_on_streaming_message(const string& msg)
+{
+    vector<string> out;
+    json resp = json::array();
+    json data = json::array();
+    unsigned long long ts = now_msec();
+
+    try{
+        json j = json::parse(msg);
+        for( auto& r : j.at("requests") ){
+            ++_nstreaming;
+            string service = r.at("service");
+            string command = r.at("command");
+            resp.push_back( {
+                {"service", service},
+                {"requestid", r.at("requestid")},
+                {"command", command},
+                {"timestamp", ts},
+                {"content", {{"code", 0}, {"msg", "mock"}}}
+            } );
+
+            if( command != "SUBS" && command != "ADD" )
+                continue;
+
+            auto params = r.find("parameters");
+            if( params == r.end() || params->find("keys") == params->end() )
+                continue;
+
+            json content = json::array();
+            for( auto& k : split_list( params->at("keys").get<string>() ) )
+                content.push_back( {{"key", k}, {"1", MOCK_PRICE - .01},
+                                    {"2", MOCK_PRICE + .01},
+                                    {"3", MOCK_PRICE}} );
+            if( !content.empty() ){
+                data.push_back( {
+                    {"service", service},
+                    {"timestamp", ts},
+                    {"command", command},
+                    {"content", content}
+                } );
+            }
+        }
+    }catch( json::exception& e ){
+        std::cerr<< "MockServer: invalid streaming request: " << e.what()
+                 << std::endl;
+        return out;
+    }
+
+    out.push_back( json{ {"response", resp} }.dump() );
+    if( !data.empty() )
+        out.push_back( json{ {"data", data} }.dump() );
+    return out;
+}
+
+
+void
+MockServer::_run()
+{
+    uWS::Hub hub;
+    _hub = &hub;
+
+    hub.onHttpRequest(
+        [this](uWS::HttpResponse *res, uWS::HttpRequest req, char *data,
+               size_t length, size_t remaining)
+        {
+            string url = req.getUrl().toString();
+            Response r = _route( method_str(req.getMethod()), url );
+
+            char buf[128];
+            std::snprintf( buf, sizeof(buf),
+                           "HTTP/1.1 %d %s\r\nContent-Type: application/json"
+                           "\r\nContent-Length: %u\r\n",
+                           r.status, status_text(r.status),
+                           static_cast<unsigned int>(r.body.size()) );
+
+            Pending *p = new Pending{ this, res, nullptr,
+                                      buf + r.headers + "\r\n",
+                                      std::move(r.body) };
+            res->userData = p;
+            /* respond once the request body is in */
+            if( !remaining )
+                _dispatch(p);
+        } );
+
+    hub.onHttpData(
+        [this](uWS::HttpResponse *res, char *data, size_t length,
+               size_t remaining)
+        {
+            if( !remaining && res->userData ){
+                Pending *p = static_cast<Pending*>(res->userData);
+                if( !p->timer )
+                    _dispatch(p);
+            }
+        } );
+
+    hub.onCancelledHttpRequest(
+        [this](uWS::HttpResponse *res){
+            Pending *p = static_cast<Pending*>(res->userData);
+            if( !p )
+                return;
+            res->userData = nullptr;
+            p->res = nullptr;
+            /* waiting on the timer, it cleans up */
+            if( !p->timer )
+                delete p;
+        } );
+
+    hub.onConnection(
+        [this](uWS::WebSocket<uWS::SERVER> *ws, uWS::HttpRequest req){
+            ++_nconnections;
+        } );
+
+    hub.onMessage(
+        [this](uWS::WebSocket<uWS::SERVER> *ws, char *msg, size_t length,
+               uWS::OpCode op)
+        {
+            if( is_muted(ws) )
+                return;
+            for( auto& s : _on_streaming_message( string(msg, length) ) )
+                ws->send(s.c_str(), s.size(), uWS::OpCode::TEXT);
+        } );
+
+    _heartbeat = new uS::Timer( hub.getLoop() );
+    _heartbeat->setData(&hub);
+    _heartbeat->start(
+        [](uS::Timer *t){
+            string hb = json{ {"notify", json::array({
+                {{"heartbeat", std::to_string(now_msec())}}
+            })} }.dump();
+            static_cast<uWS::Hub*>( t->getData() )
+                ->getDefaultGroup<uWS::SERVER>()
+                .forEach( [&](uWS::WebSocket<uWS::SERVER> *ws){
+                    if( !is_muted(ws) )
+                        ws->send(hb.c_str(), hb.size(), uWS::OpCode::TEXT);
+                } );
+        }, HEARTBEAT_MSEC, HEARTBEAT_MSEC );
+
+    _signal = new uS::Async( hub.getLoop() );
+    _signal->setData(this);
+    _signal->start(
+        [](uS::Async *a){
+            static_cast<MockServer*>( a->getData() )->_on_signal();
+        } );
+
+    _listening = hub.listen("127.0.0.1", _port);
+    if( !_listening ){
+        std::cerr<< "MockServer: failed to listen on " << _port << std::endl;
+        _heartbeat->stop();
+        _heartbeat->close();
+        _signal->close();
+        _signal = nullptr;
+    }
+
+    {
+        lock_guard<mutex> _(_init_mtx);
+        _init_flag = true;
+    }
+    _init_cond.notify_all();
+
+    if( _listening )
+        hub.run();
+    _hub = nullptr;
+}
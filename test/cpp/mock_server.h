@@ -0,0 +1,233 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+#ifndef TDMA_TEST_MOCK_SERVER_H
+#define TDMA_TEST_MOCK_SERVER_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <regex>
+#include <functional>
+#include <condition_variable>
+
+namespace uWS{
+struct Hub;
+struct HttpResponse;
+}
+
+namespace uS{
+struct Async;
+struct Timer;
+}
+
+/*
+ * loopback stand-in for api.tdameritrade.com and the streamer
+ *
+ *   HTTP  - canned quote, price history, option chain, market hours,
+ *           movers, instrument, account, transaction, user principal
+ *           and order responses; POST/PUT to .../orders return 201 w/ a
+ *           Location header like the real thing, DELETE returns 200
+ *
+ *   WS    - every request gets a successful response; SUBS/ADD on a
+ *           service gets a data frame back for each key; a heartbeat
+ *           goes out every HEARTBEAT_MSEC
+ *
+ *   point the library at it with:
+ *
+ *       SetBaseURLOverride( server.base_url() );
+ *       SetStreamerURLOverride( server.streamer_url() );
+ *
+ *   any credentials will do, it doesn't check the token
+ */
+class MockServer{
+public:
+    struct Request{
+        std::string method;
+        std::string path;
+        std::string query;
+        std::smatch match; // of 'path'
+    };
+
+    struct Response{
+        int status;
+        std::string body;
+        std::string headers; // extra, each ending in "\r\n"
+    };
+
+    typedef std::function<void(const Request&, Response&)> handler_ty;
+
+    static const int DEF_PORT = 18765;
+    static const int HEARTBEAT_MSEC = 10000;
+    static const std::string ACCOUNT_ID;
+
+    explicit MockServer(int port = DEF_PORT);
+
+    MockServer( const MockServer& ) = delete;
+
+    MockServer&
+    operator=( const MockServer& ) = delete;
+
+    ~MockServer();
+
+    /* false if it couldn't listen on 'port' */
+    bool
+    is_listening() const
+    { return _listening; }
+
+    int
+    get_port() const
+    { return _port; }
+
+    std::string
+    base_url() const
+    { return "http://127.0.0.1:" + std::to_string(_port); }
+
+    std::string
+    streamer_url() const
+    { return "ws://127.0.0.1:" + std::to_string(_port) + "/ws"; }
+
+    /* delay before each HTTP response is sent */
+    void
+    set_latency(std::chrono::milliseconds latency)
+    { _latency_msec = static_cast<int>(latency.count()); }
+
+    /* every 'nth' HTTP request (0 for none) fails w/ 'status' */
+    void
+    set_error_injection(unsigned int nth, int status = 500)
+    {
+        _error_status = status;
+        _error_nth = nth;
+    }
+
+    /* 'pattern' is matched against the path (no query); newest first */
+    void
+    set_handler( const std::string& method,
+                 const std::string& pattern,
+                 handler_ty handler );
+
+    void
+    set_response( const std::string& method,
+                  const std::string& pattern,
+                  int status,
+                  const std::string& body );
+
+    unsigned long long
+    get_nrequests() const
+    { return _nrequests; }
+
+    unsigned long long
+    get_nerrors_injected() const
+    { return _nerrors; }
+
+    unsigned long long
+    get_nstreaming_requests() const
+    { return _nstreaming; }
+
+    unsigned long long
+    get_nstreaming_connections() const
+    { return _nconnections; }
+
+    /* send 'frame' to each open (un-muted) streaming connection */
+    void
+    send_streaming(const std::string& frame);
+
+    /* terminate the open streaming connections (no close frame) */
+    void
+    drop_streaming_connections();
+
+    /*
+     * stop answering (and heartbeating) the open streaming connections,
+     * like a server that's gone silent; new connections are served as usual
+     */
+    void
+    mute_streaming_connections();
+
+private:
+    struct Route{
+        std::string method;
+        std::regex rx;
+        handler_ty handler;
+    };
+
+    struct Pending{
+        MockServer *server;
+        uWS::HttpResponse *res;
+        uS::Timer *timer;
+        std::string head;
+        std::string body;
+    };
+
+    int _port;
+    uWS::Hub *_hub;
+    uS::Async *_signal;
+    uS::Timer *_heartbeat;
+    std::thread _thread;
+    std::atomic<bool> _listening;
+
+    std::mutex _init_mtx;
+    std::condition_variable _init_cond;
+    bool _init_flag;
+
+    std::mutex _routes_mtx;
+    std::vector<Route> _routes;
+
+    std::atomic<int> _latency_msec;
+    std::atomic<unsigned int> _error_nth;
+    std::atomic<int> _error_status;
+    std::atomic<unsigned long long> _nrequests;
+    std::atomic<unsigned long long> _nerrors;
+    std::atomic<unsigned long long> _nstreaming;
+    std::atomic<unsigned long long> _nconnections;
+    unsigned long long _next_order_id;
+    std::set<Pending*> _pending; // loop thread only
+
+    /* work for the loop thread, w/ _signal */
+    std::mutex _signal_mtx;
+    std::vector<std::string> _ws_out;
+    bool _ws_drop;
+    bool _ws_mute;
+    bool _stop;
+
+    void
+    _run();
+
+    void
+    _add_default_routes();
+
+    Response
+    _route(const std::string& method, const std::string& url);
+
+    void
+    _dispatch(Pending *p);
+
+    static void
+    _finish(Pending *p);
+
+    /* loop thread */
+    void
+    _on_signal();
+
+    std::vector<std::string>
+    _on_streaming_message(const std::string& msg);
+};
+
+#endif /* TDMA_TEST_MOCK_SERVER_H */
@@ -50,15 +50,37 @@ test_getters(const string& account_id, Credentials& creds)
     if( !APIGetter::is_sharing_connections() )
         throw new std::runtime_error("not sharing connections");
 
+    APIGetter::set_connection_pool_size(2);
+    if( APIGetter::get_connection_pool_size() != 2 )
+        throw std::runtime_error("invalid connection pool size");
+    APIGetter::reset_connection_pool_stats();
+
     cout<< endl <<"*** SET WAIT ***" << endl;
     cout<< APIGetter::get_wait_msec().count() << " --> ";
     APIGetter::set_wait_msec( milliseconds(1500) );
     cout<< APIGetter::get_wait_msec().count() << endl;
 
+    cout<< endl <<"*** SET THROTTLE ***" << endl;
+    APIGetter::set_burst(2);
+    if( APIGetter::get_burst() != 2 )
+        throw std::runtime_error("invalid burst");
+    APIGetter::set_burst(1);
+    APIGetter::set_endpoint_throttle(EndpointClass::history, milliseconds(2000));
+    auto et = APIGetter::get_endpoint_throttle(EndpointClass::history);
+    if( et.first != milliseconds(2000) || et.second != 1 )
+        throw std::runtime_error("invalid endpoint throttle");
+    cout<< "history: " << et.first.count() << "/" << et.second << endl;
+
     cout<< endl << "*** QUOTE DATA ***" << endl;
     quote_getters(creds);
     cout<< "WaitRemaining: " << APIGetter::wait_remaining().count() << endl;
 
+    ConnectionPoolStats ps = APIGetter::get_connection_pool_stats();
+    cout<< "POOL: hits " << ps.hits << ", misses " << ps.misses << ", waits "
+        << ps.waits << ", handles " << ps.nhandles << endl;
+    if( ps.misses == 0 || ps.nhandles > 2 )
+        throw std::runtime_error("invalid connection pool stats");
+
     historical_getters(creds);
     this_thread::sleep_for( seconds(3) );
 
@@ -761,6 +783,19 @@ void option_chain_getter(Credentials& c)
 
     Get(ocg);
 
+    OptionChain chain = ocg.get_chain();
+    if( chain.symbol() != "KORS" )
+        throw std::runtime_error("invalid option chain symbol");
+    for( const OptionContract_C& oc : chain ){
+        if( oc.is_put )
+            throw std::runtime_error("put in option chain (calls only)");
+        if( chain.strike(oc.strike_index).strike_price != oc.strike_price )
+            throw std::runtime_error("invalid option chain strike index");
+    }
+    cout<< "OptionChain: " << chain.size() << " contracts, "
+        << chain.nexpirations() << " expirations, " << chain.nstrikes()
+        << " strikes" << endl;
+
     strikes = OptionStrikes::Single(70.00);
     ocg.set_strikes(strikes);
     ocg.set_exp_month(OptionExpMonth::jul);
@@ -945,6 +980,18 @@ historical_getters(Credentials& c)
 
     Get(hrg);
 
+    HistoricalCandles candles = hrg.get_candles();
+    if( candles.symbol() != "SPY" ){
+        throw runtime_error("invalid candles symbol");
+    }
+    for( size_t i = 1; i < candles.size(); ++i ){
+        if( candles.datetime()[i] <= candles.datetime()[i-1] )
+            throw runtime_error("candles out of order");
+        if( candles.low()[i] > candles.high()[i] )
+            throw runtime_error("invalid candle");
+    }
+    cout<< "HistoricalCandles: " << candles.size() << endl;
+
     try{
         hrg.set_frequency(FrequencyType::minute, 31);
         throw runtime_error("failed to catch exception for bad frequency");
@@ -1055,6 +1102,13 @@ quote_getters(Credentials& c)
     if( qsg.get_symbols() != set<string>{"IWM"})
         throw runtime_error("invalid symbols in quotes getter");
 
+    auto fut = qsg.get_async();
+    qsg.set_symbols({"SPY"}); // shouldn't affect the pending request
+    json j = fut.get();
+    cout<< "ASYNC: " << j << endl;
+    if( !j.count("IWM") )
+        throw runtime_error("invalid async quotes");
+
     Get(qsg);
 
     qsg.remove_symbol("IWM");
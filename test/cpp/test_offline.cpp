@@ -0,0 +1,660 @@
+/*
+Copyright (C) 2018 Jonathon Ogden <jeog.dev@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses.
+*/
+
+/*
+ * streaming tests against MockServer; no credentials or network needed
+ *
+ *   test_offline [port]
+ */
+
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <utility>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <fstream>
+
+#include "tdma_api_get.h"
+#include "tdma_api_streaming.h"
+
+#include "mock_server.h"
+
+using namespace tdma;
+using namespace std;
+using namespace std::chrono;
+using nlohmann::json;
+
+namespace {
+
+int nfailed = 0;
+
+#define CHECK(c) \
+do{ \
+    if( !(c) ){ \
+        cout<< "  FAILED (line " << __LINE__ << "): " << #c << endl; \
+        ++nfailed; \
+    } \
+}while(0)
+
+atomic<size_t> ndata(0);
+atomic<size_t> nreconnected(0);
+atomic<size_t> nstopped(0);
+atomic<size_t> nnotify(0);
+
+/* (service, content) of each data callback; hold() blocks the listener */
+mutex data_mtx;
+condition_variable data_cond;
+vector<pair<StreamerServiceType, json>> data_msgs;
+bool holding = false;
+size_t nheld = 0;
+
+void
+hold(bool on)
+{
+    {
+        lock_guard<mutex> _(data_mtx);
+        holding = on;
+    }
+    data_cond.notify_all();
+}
+
+size_t
+held()
+{
+    lock_guard<mutex> _(data_mtx);
+    return nheld;
+}
+
+void
+reset()
+{
+    lock_guard<mutex> _(data_mtx);
+    data_msgs.clear();
+    nheld = 0;
+    ndata = nreconnected = nstopped = nnotify = 0;
+}
+
+void
+callback(int cb_type, int ss_type, unsigned long long ts, const char* msg)
+{
+    switch( static_cast<StreamingCallbackType>(cb_type) ){
+    case StreamingCallbackType::data:
+    {
+        unique_lock<mutex> l(data_mtx);
+        data_msgs.emplace_back( static_cast<StreamerServiceType>(ss_type),
+                                json::parse(msg) );
+        ++ndata;
+        if( holding ){
+            ++nheld;
+            data_cond.wait( l, []{ return !holding; } );
+        }
+        break;
+    }
+    case StreamingCallbackType::notify:
+        if( string(msg).find("TEST") != string::npos )
+            ++nnotify;
+        break;
+    case StreamingCallbackType::reconnected:
+        cout<< "  reconnected: " << msg << endl;
+        ++nreconnected;
+        break;
+    case StreamingCallbackType::listening_stop:
+    case StreamingCallbackType::timeout:
+    case StreamingCallbackType::error:
+        ++nstopped;
+        break;
+    default:
+        break;
+    }
+}
+
+bool
+wait_until(function<bool()> pred, milliseconds timeout)
+{
+    auto end = steady_clock::now() + timeout;
+    while( !pred() ){
+        if( steady_clock::now() >= end )
+            return false;
+        this_thread::sleep_for( milliseconds(10) );
+    }
+    return true;
+}
+
+string
+quote_frame(const string& symbol, double bid)
+{
+    return "{\"data\":[{\"service\":\"QUOTE\",\"timestamp\":1,"
+           "\"command\":\"SUBS\",\"content\":[{\"key\":\"" + symbol
+           + "\",\"1\":" + to_string(bid) + "}]}]}";
+}
+
+string
+frame(const string& service, const json& rec)
+{
+    return json{ {"data", json::array({ {
+        {"service", service}, {"timestamp", 1}, {"command", "SUBS"},
+        {"content", json::array({rec})}
+    } })} }.dump();
+}
+
+const string NOTIFY_FRAME =
+    "{\"notify\":[{\"service\":\"TEST\",\"content\":{}}]}";
+
+shared_ptr<StreamingSession>
+start_session(Credentials& c,
+              milliseconds listening_timeout
+                  = StreamingSession::DEF_LISTENING_TIMEOUT)
+{
+    auto ss = StreamingSession::Create(c, callback, "",
+        StreamingSession::DEF_CONNECT_TIMEOUT, listening_timeout);
+    ss->set_auto_reconnect(true);
+    ss->start( QuotesSubscription({"SPY"},
+        {QuotesSubscription::FieldType::bid_price}) );
+    return ss;
+}
+
+/* after a reconnect frames sent to the new connection have to get through */
+void
+check_frames_arrive(MockServer& server, StreamingSession& ss)
+{
+    size_t n = ndata;
+    server.send_streaming( quote_frame("SPY", 100.0) );
+    CHECK( wait_until([&]{ return ndata > n; }, seconds(5)) );
+    /* and keep getting through, nothing late from the old socket tore it down */
+    this_thread::sleep_for( milliseconds(1000) );
+    n = ndata;
+    server.send_streaming( quote_frame("SPY", 101.0) );
+    CHECK( wait_until([&]{ return ndata > n; }, seconds(5)) );
+    CHECK( ss.is_active() );
+    CHECK( nstopped == 0 );
+}
+
+void
+test_reconnect_after_drop(MockServer& server, Credentials& c)
+{
+    cout<< "reconnect after the server drops the connection" << endl;
+    reset();
+    unsigned long long nconn = server.get_nstreaming_connections();
+
+    auto ss = start_session(c);
+    /* the mock answers SUBS w/ a data frame */
+    CHECK( wait_until([&]{ return ndata > 0; }, seconds(5)) );
+
+    server.drop_streaming_connections();
+    CHECK( wait_until([&]{ return nreconnected > 0; }, seconds(10)) );
+    CHECK( server.get_nstreaming_connections() == nconn + 2 );
+
+    check_frames_arrive(server, *ss);
+    ss->stop();
+}
+
+void
+test_reconnect_after_silence(MockServer& server, Credentials& c)
+{
+    /*
+     * the old socket is still open when the new client takes over;
+     * closing it mustn't take the new one down
+     */
+    cout<< "reconnect after the server goes silent (listening timeout)"
+        << endl;
+    reset();
+
+    auto ss = start_session(c, StreamingSession::MIN_LISTENING_TIMEOUT);
+    CHECK( wait_until([&]{ return ndata > 0; }, seconds(5)) );
+
+    server.mute_streaming_connections();
+    CHECK( wait_until([&]{ return nreconnected > 0; },
+                      StreamingSession::MIN_LISTENING_TIMEOUT + seconds(10)) );
+
+    check_frames_arrive(server, *ss);
+    ss->stop();
+}
+
+/* fill the inbound queue while the listener is held in the callback */
+shared_ptr<StreamingSession>
+start_held(Credentials& c, size_t hwm, StreamingOverflowPolicy policy)
+{
+    reset();
+    hold(true);
+    auto ss = StreamingSession::Create(c, callback, "",
+        StreamingSession::DEF_CONNECT_TIMEOUT,
+        StreamingSession::DEF_LISTENING_TIMEOUT,
+        StreamingSession::DEF_SUBSCRIBE_TIMEOUT, hwm, policy);
+    /* the mock's data frame for the subscription is the one we hold on */
+    ss->start( QuotesSubscription({"SPY"},
+        {QuotesSubscription::FieldType::bid_price}) );
+    CHECK( wait_until([]{ return held() > 0; }, seconds(5)) );
+    return ss;
+}
+
+void
+test_drop_oldest(MockServer& server, Credentials& c)
+{
+    cout<< "drop_oldest keeps notifications and the newest data" << endl;
+    const size_t HWM = StreamingSession::MIN_HIGH_WATER_MARK;
+    const int NDATA = 40;
+
+    auto ss = start_held(c, HWM, StreamingOverflowPolicy::drop_oldest);
+    for( int i = 1; i <= NDATA; ++i ){
+        server.send_streaming( frame("QUOTE", {{"key","SPY"}, {"1",i}}) );
+        if( i == 10 )
+            server.send_streaming(NOTIFY_FRAME);
+    }
+    /* the notification and the last HWM-1 data frames fit */
+    CHECK( wait_until([&]{
+        return ss->get_overflow_stats().dropped >= NDATA - (HWM - 1); },
+        seconds(5)) );
+
+    size_t n0 = data_msgs.size();
+    hold(false);
+    CHECK( wait_until([&]{
+        lock_guard<mutex> _(data_mtx);
+        return !data_msgs.empty() && data_msgs.back().second[0]["1"] == NDATA;
+        }, seconds(5)) );
+    CHECK( wait_until([]{ return nnotify > 0; }, seconds(5)) );
+
+    lock_guard<mutex> _(data_mtx);
+    auto stats = ss->get_overflow_stats();
+    size_t nsurvived = data_msgs.size() - n0;
+    /* (a heartbeat in the queue can take one more slot) */
+    CHECK( nsurvived == HWM - 1 || nsurvived == HWM - 2 );
+    CHECK( nsurvived + stats.dropped == NDATA );
+    CHECK( stats.max_depth <= HWM );
+    /* the newest ones, in order */
+    for( size_t i = n0; i < data_msgs.size(); ++i ){
+        CHECK( data_msgs[i].second[0]["1"]
+               == NDATA - static_cast<int>(data_msgs.size() - 1 - i) );
+    }
+    ss->stop();
+}
+
+void
+test_conflate(MockServer& server, Credentials& c)
+{
+    cout<< "conflate merges each symbol's queued quotes in place" << endl;
+    const size_t HWM = StreamingSession::MIN_HIGH_WATER_MARK;
+    const int NQUOTES = 20;
+
+    auto ss = start_held(c, HWM, StreamingOverflowPolicy::conflate);
+    server.send_streaming( frame("QUOTE", {{"key","IWM"}, {"1",1}}) );
+    for( int i = 0; i < NQUOTES; ++i ){
+        json rec = { {"key", (i % 2) ? "QQQ" : "SPY"}, {"1", i} };
+        if( i == 0 )
+            rec["2"] = 99; // only in the first, has to survive the merge
+        server.send_streaming( frame("QUOTE", rec) );
+        if( i == NQUOTES / 2 )
+            server.send_streaming( frame("TIMESALE_EQUITY", {{"key","SPY"}}) );
+    }
+    CHECK( wait_until([&]{
+        return ss->get_overflow_stats().max_depth >= NQUOTES + 2; },
+        seconds(5)) );
+
+    size_t n0 = data_msgs.size();
+    hold(false);
+    CHECK( wait_until([&]{
+        lock_guard<mutex> _(data_mtx);
+        return data_msgs.size() >= n0 + 4; }, seconds(5)) );
+    this_thread::sleep_for( milliseconds(100) );
+
+    lock_guard<mutex> _(data_mtx);
+    CHECK( data_msgs.size() == n0 + 4 );
+    if( data_msgs.size() == n0 + 4 ){
+        /* everything keeps its place, the merged quote goes where the last was */
+        const json& iwm = data_msgs[n0].second;
+        const json& ts = data_msgs[n0 + 1].second;
+        const json& spy = data_msgs[n0 + 2].second;
+        const json& qqq = data_msgs[n0 + 3].second;
+        CHECK( data_msgs[n0].first == StreamerServiceType::QUOTE );
+        CHECK( iwm.size() == 1 && iwm[0]["key"] == "IWM" );
+        CHECK( data_msgs[n0 + 1].first == StreamerServiceType::TIMESALE_EQUITY );
+        CHECK( ts.size() == 1 );
+        CHECK( spy.size() == 1 && spy[0]["key"] == "SPY" );
+        CHECK( spy[0]["1"] == NQUOTES - 2 && spy[0]["2"] == 99 );
+        CHECK( qqq.size() == 1 && qqq[0]["key"] == "QQQ" );
+        CHECK( qqq[0]["1"] == NQUOTES - 1 );
+    }
+    CHECK( ss->get_overflow_stats().conflated == NQUOTES - 2 );
+    ss->stop();
+}
+
+/* copied out of the typed callback, the records don't outlive it */
+struct TypedSeen{
+    StreamingQuote_C quote;
+    string quote_symbol;
+    string quote_description;
+    StreamingTimesale_C timesale;
+    StreamingChartEquity_C chart_equity;
+    StreamingChart_C chart;
+    size_t n;
+} typed_seen;
+
+void
+typed_callback( int ss_type,
+                unsigned long long,
+                const StreamingRecord_C *records,
+                size_t nrecords )
+{
+    lock_guard<mutex> _(data_mtx);
+    for( size_t i = 0; i < nrecords; ++i ){
+        const void *t = records[i].typed;
+        switch( static_cast<StreamerServiceType>(ss_type) ){
+        case StreamerServiceType::QUOTE:
+            typed_seen.quote = *static_cast<const StreamingQuote_C*>(t);
+            typed_seen.quote_symbol = typed_seen.quote.symbol;
+            if( typed_seen.quote.description )
+                typed_seen.quote_description = typed_seen.quote.description;
+            break;
+        case StreamerServiceType::TIMESALE_EQUITY:
+            typed_seen.timesale = *static_cast<const StreamingTimesale_C*>(t);
+            break;
+        case StreamerServiceType::CHART_EQUITY:
+            typed_seen.chart_equity =
+                *static_cast<const StreamingChartEquity_C*>(t);
+            break;
+        case StreamerServiceType::CHART_FUTURES:
+            typed_seen.chart = *static_cast<const StreamingChart_C*>(t);
+            break;
+        default:
+            CHECK( t == nullptr );
+        }
+        ++typed_seen.n;
+    }
+}
+
+void
+test_typed_structs(MockServer& server, Credentials& c)
+{
+    cout<< "typed callback decodes QUOTE/TIMESALE/CHART into structs" << endl;
+    typed_seen = TypedSeen();
+
+    auto ss = start_session(c);
+    ss->set_typed_callback(typed_callback);
+
+    server.send_streaming( frame("QUOTE", {{"key","SPY"}, {"1",280.5},
+        {"4",300}, {"10",1234}, {"17",true}, {"25","SPDR"}, {"49",281}}) );
+    server.send_streaming( frame("TIMESALE_EQUITY", {{"key","QQQ"},
+        {"seq",7}, {"1",1546300800000LL}, {"2",170.25}, {"3",100},
+        {"4",42}}) );
+    server.send_streaming( frame("CHART_EQUITY", {{"key","IWM"},
+        {"1",150.0}, {"2",151.5}, {"3",149.75}, {"4",151.0}, {"5",12345.0},
+        {"6",9}, {"7",1546300800000LL}, {"8",17897}}) );
+    server.send_streaming( frame("CHART_FUTURES", {{"key","/ES"},
+        {"1",1546300800000LL}, {"2",2500.25}, {"6",500}}) );
+    server.send_streaming( frame("NEWS_HEADLINE", {{"key","SPY"}}) );
+
+    CHECK( wait_until([&]{
+        lock_guard<mutex> _(data_mtx);
+        return typed_seen.n >= 5; }, seconds(5)) );
+
+    unique_lock<mutex> l(data_mtx);
+    const StreamingQuote_C& q = typed_seen.quote;
+    CHECK( typed_seen.quote_symbol == "SPY" );
+    CHECK( q.bid_price == 280.5 && q.bid_size == 300 );
+    CHECK( q.trade_time == 1234 && q.marginable == 1 && q.mark == 281.0 );
+    CHECK( typed_seen.quote_description == "SPDR" );
+    CHECK( q.ask_price == 0.0 && q.last_price == 0.0 );
+    CHECK( q.fields_set == ( (1ULL << 0) | (1ULL << 1) | (1ULL << 4)
+                             | (1ULL << 10) | (1ULL << 17) | (1ULL << 25)
+                             | (1ULL << 49) ) );
+
+    const StreamingTimesale_C& t = typed_seen.timesale;
+    CHECK( t.trade_time == 1546300800000LL && t.last_price == 170.25 );
+    CHECK( t.last_size == 100 && t.last_sequence == 42 );
+
+    const StreamingChartEquity_C& ce = typed_seen.chart_equity;
+    CHECK( ce.open_price == 150.0 && ce.high_price == 151.5 );
+    CHECK( ce.low_price == 149.75 && ce.close_price == 151.0 );
+    CHECK( ce.volume == 12345 && ce.sequence == 9 );
+    CHECK( ce.chart_time == 1546300800000LL && ce.chart_day == 17897 );
+
+    const StreamingChart_C& ch = typed_seen.chart;
+    CHECK( ch.chart_time == 1546300800000LL && ch.open_price == 2500.25 );
+    CHECK( ch.volume == 500 && ch.close_price == 0.0 );
+    CHECK( ch.fields_set == ( (1ULL << 0) | (1ULL << 1) | (1ULL << 2)
+                              | (1ULL << 6) ) );
+    l.unlock();
+    ss->stop();
+}
+
+/* canned ACCT_ACTIVITY field 3 for an order in SPY */
+string
+acct_activity_xml( const string& type,
+                   const string& order_id,
+                   const string& body,
+                   double limit = 100.50,
+                   int quantity = 10 )
+{
+    return "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+           "<" + type + "Message xmlns=\"urn:xmlns:beb.ameritrade.com\">"
+           "<OrderGroupID><Firm>110</Firm><AccountKey>123456789</AccountKey>"
+           "</OrderGroupID>"
+           "<ActivityTimestamp>2019-01-22T10:00:00.000-06:00</ActivityTimestamp>"
+           "<Order><OrderKey>" + order_id + "</OrderKey><Security>"
+           "<CUSIP>78462F103</CUSIP><Symbol>SPY</Symbol></Security>"
+           "<OrderPricing><Limit>" + to_string(limit) + "</Limit></OrderPricing>"
+           "<OriginalQuantity>" + to_string(quantity) + "</OriginalQuantity>"
+           "</Order>" + body + "</" + type + "Message>";
+}
+
+/* capture file (see frame_capture.h) w/ every frame at t=0 */
+void
+write_capture(const string& path, const vector<string>& frames)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write("TDMACAP1", 8);
+    for( const string& f : frames ){
+        char hdr[12] = {0};
+        for( int i = 0; i < 4; ++i )
+            hdr[8 + i] = static_cast<char>( (f.size() >> (8 * i)) & 0xff );
+        out.write(hdr, sizeof(hdr));
+        out.write(f.data(), f.size());
+    }
+    CHECK( out.good() );
+}
+
+atomic<bool> replay_stopped(false);
+
+void
+replay_callback(int cb_type, int, unsigned long long, const char*)
+{
+    if( static_cast<StreamingCallbackType>(cb_type)
+        == StreamingCallbackType::listening_stop )
+    {
+        replay_stopped = true;
+    }
+}
+
+void
+check_order_state( StreamingSession& ss,
+                   const string& order_id,
+                   OrderStatusType status,
+                   double filled,
+                   double remaining,
+                   double average_price )
+{
+    OrderState_C st;
+    bool cached = ss.get_order_state(order_id, st);
+    CHECK( cached );
+    if( !cached )
+        return;
+    CHECK( st.status == static_cast<int>(status) );
+    CHECK( st.filled_quantity == filled );
+    CHECK( st.remaining_quantity == remaining );
+    CHECK( std::abs(st.average_fill_price - average_price) < 1e-9 );
+}
+
+void
+test_acct_activity()
+{
+    cout<< "acct activity decoder and order cache on canned messages" << endl;
+    string entry = acct_activity_xml("OrderEntryRequest", "1001", "");
+    string partial = acct_activity_xml("OrderPartialFill", "1001",
+        "<ExecutionInformation><Type>Bought</Type><Quantity>4</Quantity>"
+        "<ExecutionPrice>100.25</ExecutionPrice><LeavesQuantity>6"
+        "</LeavesQuantity></ExecutionInformation>");
+    string fill = acct_activity_xml("OrderFill", "1001",
+        "<ExecutionInformation><Type>Bought</Type><Quantity>6</Quantity>"
+        "<ExecutionPrice>100.50</ExecutionPrice><LeavesQuantity>0"
+        "</LeavesQuantity></ExecutionInformation>");
+    string entry2 = acct_activity_xml("OrderEntryRequest", "2001", "");
+    string replace = acct_activity_xml("OrderCancelReplaceRequest", "2002",
+        "<PendingCancelQuantity>10</PendingCancelQuantity>"
+        "<OriginalOrderId>2001</OriginalOrderId>", 99.00, 5);
+    string urout = acct_activity_xml("UROUT", "2001",
+        "<CancelledQuantity>10</CancelledQuantity>");
+
+    OrderEvent_C e = DecodeAcctActivity("OrderEntryRequest", entry);
+    CHECK( e.type == static_cast<int>(OrderEventType::entry) );
+    CHECK( string(e.order_id) == "1001" && string(e.symbol) == "SPY" );
+    CHECK( string(e.account_id) == "123456789" );
+    CHECK( e.order_quantity == 10 && e.price == 100.50 );
+
+    e = DecodeAcctActivity("OrderPartialFill", partial);
+    CHECK( e.type == static_cast<int>(OrderEventType::partial_fill) );
+    CHECK( e.quantity == 4 && e.price == 100.25 && e.leaves_quantity == 6 );
+
+    /* type from the root element if not passed */
+    e = DecodeAcctActivity("", fill);
+    CHECK( e.type == static_cast<int>(OrderEventType::fill) );
+    CHECK( e.quantity == 6 && e.price == 100.50 && e.leaves_quantity == 0 );
+
+    e = DecodeAcctActivity("UROUT", urout);
+    CHECK( e.type == static_cast<int>(OrderEventType::canceled) );
+    CHECK( string(e.order_id) == "2001" && e.quantity == 10 );
+
+    e = DecodeAcctActivity("OrderCancelReplaceRequest", replace);
+    CHECK( e.type == static_cast<int>(OrderEventType::replace_request) );
+    CHECK( string(e.order_id) == "2002" );
+    CHECK( string(e.original_order_id) == "2001" );
+    CHECK( e.order_quantity == 5 && e.price == 99.00 );
+
+    e = DecodeAcctActivity("SUBSCRIBED", "");
+    CHECK( e.type == static_cast<int>(OrderEventType::none) );
+
+    /* same messages through a replay session's order cache */
+    vector<string> frames = {
+        "{\"response\":[{\"service\":\"ADMIN\",\"requestid\":\"0\","
+        "\"command\":\"LOGIN\",\"timestamp\":1,"
+        "\"content\":{\"code\":0,\"msg\":\"\"}}]}"
+    };
+    vector<pair<string, string>> msgs = {
+        {"OrderEntryRequest", entry},
+        {"OrderPartialFill", partial},
+        {"OrderFill", fill},
+        {"OrderEntryRequest", entry2},
+        {"OrderCancelReplaceRequest", replace},
+        {"UROUT", urout}
+    };
+    for( auto& m : msgs ){
+        json d = {{"data", {{
+            {"service", "ACCT_ACTIVITY"},
+            {"timestamp", 1000},
+            {"command", "SUBS"},
+            {"content", {{{"1", "123456789"}, {"2", m.first}, {"3", m.second}}}}
+        }}}};
+        frames.push_back( d.dump() );
+    }
+
+    const string path = "test_acct_activity.cap";
+    write_capture(path, frames);
+
+    replay_stopped = false;
+    auto ss = StreamingSession::CreateReplay( path, replay_callback,
+                                              StreamingSession::REPLAY_UNPACED );
+    ss->set_order_cache_enabled(true);
+    ss->start( AcctActivitySubscription() );
+    CHECK( wait_until([]{ return replay_stopped.load(); }, seconds(10)) );
+    ss->stop();
+    std::remove( path.c_str() );
+
+    check_order_state(*ss, "1001", OrderStatusType::FILLED, 10, 0,
+                      (4 * 100.25 + 6 * 100.50) / 10);
+    check_order_state(*ss, "2001", OrderStatusType::REPLACED, 0, 0, 0);
+    check_order_state(*ss, "2002", OrderStatusType::WORKING, 0, 5, 0);
+    CHECK( ss->get_order_states().size() == 3 );
+}
+
+void
+test_option_chain_strategies(MockServer& server, Credentials& c)
+{
+    cout<< "get_chain decodes analytical chains, rejects strategy chains" << endl;
+    OptionChainAnalyticalGetter ag(c, "SPY", 30.0, 100.0, 2.5, 30,
+                                   OptionStrikes::N_ATM(10));
+    OptionChain chain = ag.get_chain();
+    CHECK( chain.size() > 0 );
+    CHECK( chain.nexpirations() == 1 );
+
+    OptionChainStrategyGetter sg(c, "SPY", OptionStrategy::Vertical(),
+                                 OptionStrikes::N_ATM(10));
+    unsigned long long nreqs = server.get_nrequests();
+    bool threw = false;
+    try{
+        sg.get_chain();
+    }catch(ValueException&){
+        threw = true;
+    }
+    CHECK( threw );
+    CHECK( server.get_nrequests() == nreqs ); // nothing sent
+
+    /* the json is still there */
+    json j = sg.get();
+    CHECK( j["strategy"] == "VERTICAL" && !j["monthlyStrategyList"].empty() );
+}
+
+} /* namespace */
+
+
+int
+main(int argc, char* argv[])
+{
+    int port = argc > 1 ? atoi(argv[1]) : MockServer::DEF_PORT;
+
+    MockServer server(port);
+    if( !server.is_listening() )
+        return 1;
+
+    SetBaseURLOverride( server.base_url() );
+    SetStreamerURLOverride( server.streamer_url() );
+    APIGetter::set_wait_msec( milliseconds(0) );
+
+    long long expires = duration_cast<seconds>(
+        system_clock::now().time_since_epoch() ).count() + 3600;
+    Credentials c("mockaccesstoken", "mockrefreshtoken", expires,
+                  "MOCKCLIENT@AMER.OAUTHAP");
+
+    test_reconnect_after_drop(server, c);
+    test_reconnect_after_silence(server, c);
+    test_drop_oldest(server, c);
+    test_conflate(server, c);
+    test_typed_structs(server, c);
+    test_acct_activity();
+    test_option_chain_strategies(server, c);
+
+    SetStreamerURLOverride("");
+    SetBaseURLOverride("");
+
+    cout<< (nfailed ? "FAILED" : "OK") << endl;
+    return nfailed ? 1 : 0;
+}
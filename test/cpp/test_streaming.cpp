@@ -2,6 +2,7 @@
 
 #include "test.h"
 
+#include "tdma_api_get.h"
 #include "tdma_api_streaming.h"
 
 using namespace tdma;
@@ -20,6 +21,36 @@ callback( int cb_type,
         << "\t content: " << json::parse(string(msg)) << endl << endl;
 };
 
+void
+typed_callback( int ss_type,
+                unsigned long long timestamp,
+                const StreamingRecord_C *records,
+                size_t nrecords )
+{
+    cout<< "typed data" << endl
+        << "\t service: "
+        << to_string(static_cast<StreamerServiceType>(ss_type)) << endl
+        << "\t timestamp: " << timestamp << endl;
+    for( size_t i = 0; i < nrecords; ++i ){
+        const StreamingRecord_C& r = records[i];
+        cout<< "\t " << (r.key ? r.key : "") << " (" << r.seq << "): ";
+        for( size_t j = 0; j < r.nfields; ++j ){
+            const StreamingField_C& f = r.fields[j];
+            cout<< f.field << "=";
+            switch( static_cast<StreamingFieldValueType>(f.value_type) ){
+            case StreamingFieldValueType::integer:
+            case StreamingFieldValueType::boolean: cout<< f.ival; break;
+            case StreamingFieldValueType::real: cout<< f.dval; break;
+            case StreamingFieldValueType::text: cout<< f.sval; break;
+            default: cout<< "?";
+            }
+            cout<< " ";
+        }
+        cout<< endl;
+    }
+    cout<< endl;
+};
+
 
 template<typename S>
 void display_sub( S& sub,
@@ -501,6 +532,25 @@ test_streaming(const string& account_id, Credentials& c)
         ss.reset();
         std::this_thread::sleep_for( seconds(3) );
 
+        ss2->set_overflow_policy(1024, StreamingOverflowPolicy::conflate);
+        if( ss2->get_overflow_policy()
+            != make_pair(size_t(1024), StreamingOverflowPolicy::conflate) )
+        {
+            throw std::runtime_error("get_overflow_policy != set");
+        }
+        ss2->set_typed_callback(typed_callback);
+        ss2->set_dispatch_threads(2);
+        if( ss2->get_dispatch_threads() != 2 )
+            throw std::runtime_error("get_dispatch_threads != 2");
+        ss2->set_quote_book_enabled(true);
+        if( !ss2->is_quote_book_enabled() )
+            throw std::runtime_error("quote book not enabled");
+        ss2->set_auto_reconnect(true);
+        if( !ss2->is_auto_reconnect() )
+            throw std::runtime_error("auto reconnect not enabled");
+        ss2->start_capture("test_streaming.cap");
+        if( !ss2->is_capturing() )
+            throw std::runtime_error("not capturing");
         results = ss2->start( {q11, q13, q14} );
         for(auto r : results)
             cout<< boolalpha << r << ' ';
@@ -513,9 +563,59 @@ test_streaming(const string& account_id, Credentials& c)
             cout<< boolalpha << r << ' ';
         cout<<endl;
 
+        ChartEquitySubscription cm1({"SPY","QQQ"}, {ceft::open_price});
+        ChartEquitySubscription cm2({"IWM"}, {ceft::open_price});
+        ChartEquitySubscription cm3({"QQQ"}, {ceft::open_price});
+        ss2->set_subscription_window( milliseconds(100) );
+        if( ss2->get_subscription_window() != milliseconds(100) )
+            throw std::runtime_error("get_subscription_window != set");
+        ss2->subscribe(cm1);
+        ss2->subscribe(cm2);
+        ss2->unsubscribe(cm3);
+        res = ss2->flush_subscriptions();
+        cout<< "flush subscriptions: " << boolalpha << res << endl;
+        if( ss2->get_subscribed_symbols(StreamerServiceType::CHART_EQUITY)
+            != set<string>{"IWM","SPY"} )
+        {
+            throw std::runtime_error("subscribed symbols != {IWM,SPY}");
+        }
+
+        auto futs = ss2->add_subscriptions_async( {q15, q16, q17} );
+        auto qos_fut = ss2->set_qos_async( QOSType::moderate );
+        for(auto& f : futs)
+            cout<< boolalpha << f.get() << ' ';
+        res = qos_fut.get();
+        cout<< boolalpha << res << endl;
+        if( res && ss2->get_qos() != QOSType::moderate )
+            throw std::runtime_error("get_qos != set_qos_async");
+
         std::this_thread::sleep_for( seconds(5) );
         ss2->stop();
 
+        StreamingOverflowStats_C stats = ss2->get_overflow_stats();
+        cout<< "overflow stats: max_depth=" << stats.max_depth
+            << " blocked=" << stats.blocked << " dropped=" << stats.dropped
+            << " conflated=" << stats.conflated << endl;
+
+        QuoteBookSnapshot book = ss2->get_quote_book(StreamerServiceType::QUOTE);
+        cout<< "quote book: " << book.size() << " symbols, seq="
+            << book.seq() << endl;
+        for( const StreamingRecord_C& r : book ){
+            if( !r.key )
+                throw std::runtime_error("quote book record w/o key");
+        }
+        if( !ss2->get_quote_book(StreamerServiceType::QUOTE, book.seq()).empty() )
+            throw std::runtime_error("quote book changed after stop");
+
+        ss2->stop_capture();
+        auto ssr = StreamingSession::CreateReplay( "test_streaming.cap",
+                                                   callback,
+                                                   StreamingSession::REPLAY_UNPACED );
+        res = ssr->start( q11 );
+        cout<< "replay start: " << boolalpha << res << endl;
+        std::this_thread::sleep_for( seconds(2) );
+        ssr->stop();
+
         ss = ss2;
         auto ss4 = std::move(ss2);
     }
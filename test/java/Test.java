@@ -1755,7 +1755,7 @@ public class Test {
                 "QOSTYpe");
         
         testEnum(CallbackType.values(), Arrays.asList("listening_start", "listening_stop", "data", 
-                "request_response", "notify", "timeout", "error"), "CallbackType"); 
+                "request_response", "notify", "timeout", "error", "reconnected"), "CallbackType"); 
               
         testEnumString(QuotesSubscription.FieldType.SYMBOL, "QuotesSubscriptionField-0", "QuotesSubscription");
         testEnumString(QuotesSubscription.FieldType.REGULAR_MARKET_TRADE_TIME_AS_LONG, "QuotesSubscriptionField-52", "QuotesSubscription");